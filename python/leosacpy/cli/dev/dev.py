@@ -4,7 +4,7 @@ import json
 import click
 from click import UsageError
 
-from leosacpy.cli.dev import run_tests, docker, doc, cc
+from leosacpy.cli.dev import run_tests, docker, doc, cc, ws_load
 from leosacpy.tools.source_formatter import SourceFormatter
 from leosacpy.utils import guess_root_dir, AWAIT, pretty_dict
 from leosacpy.ws import LeosacMessage
@@ -73,3 +73,4 @@ dev_cmd_group.add_command(run_tests.run_tests)
 dev_cmd_group.add_command(docker.docker)
 dev_cmd_group.add_command(doc.doc)
 dev_cmd_group.add_command(cc.cc)
+dev_cmd_group.add_command(ws_load.ws_load)
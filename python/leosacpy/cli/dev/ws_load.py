@@ -0,0 +1,112 @@
+import asyncio
+import json
+import time
+from collections import defaultdict
+
+import click
+
+from leosacpy.utils import AWAIT
+from leosacpy.ws import LeosacMessage, APIStatusCode
+from leosacpy.wsclient import LowLevelWSClient
+
+
+# Commands in this file are added manually
+# in dev.py
+
+
+def percentile(sorted_values, pct):
+    """
+    Nearest-rank percentile of an already sorted list.
+    """
+    if not sorted_values:
+        return 0
+    rank = max(int(round(pct / 100.0 * len(sorted_values))) - 1, 0)
+    return sorted_values[min(rank, len(sorted_values) - 1)]
+
+
+async def run_client(host, username, password, requests, nb_requests,
+                     latencies, errors):
+    """
+    Connect a client, authenticate it if credentials are available, then
+    issue `nb_requests` requests, cycling through `requests`.
+
+    Latencies (in seconds) are appended to `latencies[type]`, and non-successful
+    responses are counted in `errors[type]`.
+    """
+    client = LowLevelWSClient()
+    await client.connect(host)
+    try:
+        if username:
+            rep = await client.req_rep(
+                LeosacMessage('create_auth_token', {'username': username,
+                                                    'password': password}))
+            if rep.status_code != APIStatusCode.SUCCESS or \
+                    rep.content.get('status') != 0:
+                raise click.ClickException('Failed to authenticate as {}'
+                                           .format(username))
+
+        for i in range(nb_requests):
+            msg_type, content = requests[i % len(requests)]
+            start = time.perf_counter()
+            rep = await client.req_rep(LeosacMessage(msg_type, content))
+            latencies[msg_type].append(time.perf_counter() - start)
+            if rep.status_code != APIStatusCode.SUCCESS:
+                errors[msg_type] += 1
+    finally:
+        await client.close()
+
+
+@click.command('ws-load')
+@click.option('--clients', '-c', default=10, show_default=True,
+              help='Number of concurrent clients.')
+@click.option('--requests', '-n', 'nb_requests', default=100, show_default=True,
+              help='Number of requests sent by each client.')
+@click.option('--request', '-r', 'request_specs', multiple=True,
+              help='Request to send, as TYPE or TYPE=JSON_CONTENT. '
+                   'Flag can be repeated. Defaults to get_leosac_version '
+                   'and system_overview.')
+@click.option('--anonymous', is_flag=True,
+              help='Do not authenticate the clients.')
+@click.pass_context
+def ws_load(ctx, clients, nb_requests, request_specs, anonymous):
+    """
+    Load test the websocket API.
+
+    Drives concurrent clients against the configured Leosac server.
+    Each client waits for the response to a request before sending
+    the next one. Reports latency percentiles per request type.
+    """
+    host = ctx.obj.config.host
+    username = None if anonymous else ctx.obj.config.username
+    password = ctx.obj.config.password
+
+    requests = []
+    for spec in request_specs or ['get_leosac_version', 'system_overview']:
+        msg_type, _, content = spec.partition('=')
+        requests.append((msg_type, json.loads(content) if content else {}))
+
+    latencies = defaultdict(list)
+    errors = defaultdict(int)
+
+    loop = asyncio.new_event_loop()
+    asyncio.set_event_loop(loop)
+    start = time.perf_counter()
+    AWAIT(asyncio.gather(*[run_client(host, username, password, requests,
+                                      nb_requests, latencies, errors)
+                           for _ in range(clients)]), loop)
+    elapsed = time.perf_counter() - start
+    loop.close()
+
+    total = sum(len(v) for v in latencies.values())
+    click.echo('{} requests from {} clients in {:.2f}s ({:.1f} req/s)'
+               .format(total, clients, elapsed, total / elapsed))
+    click.echo('{:<32} {:>8} {:>8} {:>10} {:>10} {:>10}'
+               .format('type', 'count', 'errors', 'p50 (ms)', 'p99 (ms)',
+                       'max (ms)'))
+    for msg_type in sorted(latencies):
+        values = sorted(latencies[msg_type])
+        click.echo('{:<32} {:>8} {:>8} {:>10.2f} {:>10.2f} {:>10.2f}'
+                   .format(msg_type, len(values), errors[msg_type],
+                           percentile(values, 50) * 1000,
+                           percentile(values, 99) * 1000,
+                           values[-1] * 1000))
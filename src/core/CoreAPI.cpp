@@ -101,6 +101,21 @@ std::vector<std::string> CoreAPI::modules_names() const
     return out;
 }
 
+std::vector<ModuleStartupInfo> CoreAPI::modules_startup_timeline() const
+{
+    std::vector<ModuleStartupInfo> out;
+    auto task = Tasks::GenericTask::build([&]() {
+        out = kernel_.module_manager().startup_timeline();
+        return true;
+    });
+    kernel_.core_utils()->scheduler().enqueue(task, TargetThread::MAIN);
+    task->wait();
+    ASSERT_LOG(task->succeed(),
+               "Retrieving `modules startup timeline` from CoreAPI failed.");
+
+    return out;
+}
+
 void CoreAPI::restart_server() const
 {
     auto task = Tasks::GenericTask::build([&]() {
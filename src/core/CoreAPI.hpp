@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "core/ModuleStartupInfo.hpp"
 #include "tools/ToolsFwd.hpp"
 #include <boost/property_tree/ptree.hpp>
 #include <cstdint>
@@ -80,6 +81,11 @@ class CoreAPI
      */
     std::vector<std::string> modules_names() const;
 
+    /**
+     * Retrieve the startup timeline of all enabled modules.
+     */
+    std::vector<ModuleStartupInfo> modules_startup_timeline() const;
+
   private:
     Kernel &kernel_;
 };
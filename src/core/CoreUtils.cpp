@@ -75,6 +75,11 @@ zmqpp::context &Leosac::CoreUtils::zmqpp_context()
     return kernel().zmqpp_context();
 }
 
+std::mutex &Leosac::CoreUtils::setup_mutex()
+{
+    return setup_mutex_;
+}
+
 Leosac::ServiceRegistry &Leosac::CoreUtils::service_registry()
 {
     return kernel().service_registry();
@@ -23,6 +23,7 @@
 #include "LeosacFwd.hpp"
 #include "tools/db/db_fwd.hpp"
 #include "tools/service/ServiceFwd.hpp"
+#include <mutex>
 
 namespace zmqpp
 {
@@ -67,6 +68,16 @@ class CoreUtils
      */
     CoreAPI core_api();
 
+    /**
+     * A mutex for setup steps that modules must not run concurrently:
+     * modules of a same level are constructed in parallel.
+     *
+     * Hold it while initializing a process-wide library (eg
+     * `curl_global_init()`) or while creating / migrating a database
+     * schema.
+     */
+    std::mutex &setup_mutex();
+
     /**
      * Are we running in strict mode ?
      */
@@ -78,6 +89,8 @@ class CoreUtils
     ConfigCheckerPtr config_checker_;
     bool strict_mode_;
 
+    std::mutex setup_mutex_;
+
     /**
      * Gives the `Kernel` class full control.
      */
@@ -78,10 +78,40 @@ void MessageBus::handle_pipe(zmqpp::socket *pipe)
     }
 }
 
+constexpr int MessageBus::MAX_BATCH_SIZE;
+
 void MessageBus::handle_pull()
 {
-    zmqpp::message msg;
+    zmq_msg_t frame;
+    zmq_msg_init(&frame);
+    for (int i = 0; i < MAX_BATCH_SIZE && forward_one(&frame); ++i)
+        ;
+    zmq_msg_close(&frame);
+}
 
-    pull_->receive(msg);
-    pub_->send(msg);
+bool MessageBus::forward_one(zmq_msg_t *frame)
+{
+    void *pull = static_cast<void *>(*pull_);
+    void *pub  = static_cast<void *>(*pub_);
+
+    if (zmq_msg_recv(frame, pull, ZMQ_DONTWAIT) == -1)
+    {
+        if (zmq_errno() == EAGAIN)
+            return false;
+        throw zmqpp::zmq_internal_error();
+    }
+
+    while (true)
+    {
+        // Sending transfers the content of the frame and leaves it
+        // empty, ready to receive the next one.
+        bool more = zmq_msg_more(frame);
+        if (zmq_msg_send(frame, pub, more ? ZMQ_SNDMORE : 0) == -1)
+            throw zmqpp::zmq_internal_error();
+        if (!more)
+            return true;
+        // Remaining frames of a multipart message are always available.
+        if (zmq_msg_recv(frame, pull, 0) == -1)
+            throw zmqpp::zmq_internal_error();
+    }
 }
@@ -25,6 +25,10 @@
 *
 * PULL socket to receive message from client (available at `inproc://zmq-bus-pull`)
 * PUB socket to publish everything it received (available at `inproc://zmq-bus-pub`)
+*
+* Messages are only delivered to subscribers whose subscription prefix matches
+* the first frame: the PUB socket filters on its side, so uninterested
+* subscribers never see the message.
 */
 class MessageBus
 {
@@ -32,6 +36,13 @@ class MessageBus
     MessageBus(zmqpp::context &ctx);
     ~MessageBus();
 
+    /**
+     * Maximum number of messages forwarded each time the PULL socket
+     * becomes readable. This bounds the time before we check the actor
+     * pipe again.
+     */
+    static constexpr int MAX_BATCH_SIZE = 256;
+
   private:
     zmqpp::actor *actor_;
 
@@ -48,7 +59,21 @@ class MessageBus
 
 
     void handle_pipe(zmqpp::socket *pipe);
+
+    /**
+     * Forward the pending messages from `pull_` to `pub_`.
+     *
+     * Frames are moved from one socket to the other as raw `zmq_msg_t`,
+     * so the payload is never copied nor reallocated.
+     */
     void handle_pull();
 
+    /**
+     * Forward one (multipart) message, if any is available.
+     *
+     * @return false if no message was pending.
+     */
+    bool forward_one(zmq_msg_t *frame);
+
     bool running_;
 };
\ No newline at end of file
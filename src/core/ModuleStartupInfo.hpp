@@ -0,0 +1,58 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace Leosac
+{
+/**
+ * Startup timeline of a module, as recorded by the ModuleManager.
+ *
+ * Time points are expressed in milliseconds since the ModuleManager
+ * was created, which is when Leosac started.
+ */
+struct ModuleStartupInfo
+{
+    std::string name;
+
+    int level;
+
+    /**
+     * Loading of the shared library.
+     */
+    std::chrono::milliseconds load_begin;
+    std::chrono::milliseconds load_end;
+
+    /**
+     * Construction of the module, in its own thread.
+     */
+    std::chrono::milliseconds init_begin;
+
+    /**
+     * The module signaled it was ready. Only meaningful if `initialized`
+     * is true.
+     */
+    std::chrono::milliseconds ready;
+
+    bool initialized;
+};
+}
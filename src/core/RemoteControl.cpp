@@ -85,6 +85,10 @@ void RemoteControl::process_config(const boost::property_tree::ptree &cfg)
         std::bind(&RemoteControl::handle_config_version, this, std::placeholders::_1,
                   std::placeholders::_2);
 
+    command_handlers_["MODULE_TIMELINE"] =
+        std::bind(&RemoteControl::handle_module_timeline, this,
+                  std::placeholders::_1, std::placeholders::_2);
+
     socket_.set(zmqpp::socket_option::curve_server, true);
     socket_.set(zmqpp::socket_option::curve_secret_key, secret_key_);
     socket_.set(zmqpp::socket_option::curve_public_key, public_key_);
@@ -372,6 +376,33 @@ bool RemoteControl::handle_config_version(zmqpp::message *msg_in,
     return false;
 }
 
+bool RemoteControl::handle_module_timeline(zmqpp::message *msg_in,
+                                           zmqpp::message *msg_out)
+{
+    assert(msg_in);
+    assert(msg_out);
+
+    if (msg_in->remaining() == 0)
+    {
+        for (const auto &info : kernel_.module_manager().startup_timeline())
+        {
+            uint64_t init_begin = 0;
+            uint64_t ready      = 0;
+            if (info.initialized)
+            {
+                init_begin = info.init_begin.count();
+                ready      = info.ready.count();
+            }
+            *msg_out << info.name << static_cast<int32_t>(info.level)
+                     << static_cast<uint64_t>(info.load_begin.count())
+                     << static_cast<uint64_t>(info.load_end.count()) << init_begin
+                     << ready;
+        }
+        return true;
+    }
+    return false;
+}
+
 void RemoteControl::update()
 {
 }
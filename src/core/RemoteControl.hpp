@@ -89,6 +89,13 @@ class RemoteControl
      */
     bool handle_config_version(zmqpp::message *msg_in, zmqpp::message *msg_out);
 
+    /**
+     * Command handler for MODULE_TIMELINE command.
+     *
+     * It returns the startup timeline of the modules.
+     */
+    bool handle_module_timeline(zmqpp::message *msg_in, zmqpp::message *msg_out);
+
     /**
     * Implements the module list command.
     *
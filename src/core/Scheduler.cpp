@@ -25,17 +25,27 @@
 using namespace Leosac;
 using namespace Leosac::Tasks;
 
-void Scheduler::enqueue(TaskPtr t, TargetThread policy)
+constexpr size_t Scheduler::DEFAULT_POOL_SIZE;
+constexpr size_t Scheduler::DEFAULT_POOL_QUEUE_SIZE;
+
+std::shared_future<bool> Scheduler::enqueue(TaskPtr t, TargetThread policy,
+                                            TaskPriority priority)
 {
+    auto future = t->get_future();
     if (policy == TargetThread::POOL)
     {
-        std::thread(std::bind(&Task::run, t)).detach();
+        pool_.enqueue(t, priority);
     }
     else
     {
-        std::lock_guard<std::mutex> lg(mutex_);
-        queues_[policy].push(t);
+        {
+            std::lock_guard<std::mutex> lg(mutex_);
+            queues_[policy].push(t);
+        }
+        if (policy == TargetThread::MAIN)
+            main_wakeup_.notify();
     }
+    return future;
 }
 
 void Scheduler::update(TargetThread me) noexcept
@@ -63,8 +73,9 @@ void Scheduler::register_thread(TargetThread me)
     queues_[me];
 }
 
-Scheduler::Scheduler(Kernel *kptr)
+Scheduler::Scheduler(Kernel *kptr, size_t pool_size, size_t max_pool_queue_size)
     : kptr_(kptr)
+    , pool_(pool_size, max_pool_queue_size)
 {
 }
 
@@ -73,3 +84,13 @@ Kernel &Scheduler::kernel()
     assert(kptr_);
     return *kptr_;
 }
+
+ThreadPool::Stats Scheduler::pool_stats() const
+{
+    return pool_.stats();
+}
+
+Tools::EventFD &Scheduler::main_thread_wakeup()
+{
+    return main_wakeup_;
+}
@@ -20,7 +20,10 @@
 #pragma once
 
 #include "LeosacFwd.hpp"
+#include "core/ThreadPool.hpp"
 #include "core/tasks/GenericTask.hpp"
+#include "tools/EventFD.hpp"
+#include <future>
 #include <map>
 #include <mutex>
 #include <queue>
@@ -39,21 +42,29 @@ enum class TargetThread
  * This is a scheduler that is used internally to schedule asynchronous / long
  * running tasks.
  *
- * It currently support running a task on the main thread, or in some
- * random thread.
+ * It currently support running a task on the main thread, or in a
+ * thread of a fixed size pool (see ThreadPool).
  *
  * The scheduler is fully thread-safe.
  */
 class Scheduler
 {
   public:
+    static constexpr size_t DEFAULT_POOL_SIZE       = 4;
+    static constexpr size_t DEFAULT_POOL_QUEUE_SIZE = 256;
+
     /**
      * Construct a scheduler object (generally 1 per application).
      * The `kptr` pointer should never be null, except when writing test cases.
      *
+     * @param pool_size Number of threads used to run `POOL` tasks.
+     * @param max_pool_queue_size Maximum number of `POOL` tasks waiting to be run.
+     * 0 means unbounded.
+     *
      * @note We use a pointer here to ease testing
      */
-    Scheduler(Kernel *kptr);
+    Scheduler(Kernel *kptr, size_t pool_size = DEFAULT_POOL_SIZE,
+              size_t max_pool_queue_size = DEFAULT_POOL_QUEUE_SIZE);
 
     Scheduler(const Scheduler &) = delete;
     Scheduler(Scheduler &&)      = delete;
@@ -63,16 +74,26 @@ class Scheduler
     template <typename Callable>
     typename std::enable_if<
         !std::is_convertible<Callable, std::shared_ptr<Tasks::Task>>::value,
-        void>::type
-    enqueue(const Callable &call, TargetThread policy)
+        std::shared_future<bool>>::type
+    enqueue(const Callable &call, TargetThread policy,
+            TaskPriority priority = TaskPriority::NORMAL)
     {
-        enqueue(Tasks::GenericTask::build(call), policy);
+        return enqueue(Tasks::GenericTask::build(call), policy, priority);
     }
 
     /**
      * Enqueue a task, a schedule to run on thread `policy`.
+     *
+     * The `priority` is only relevant for `POOL` tasks. When the pool's
+     * queue is full, this call blocks until a slot is available.
+     *
+     * Enqueuing a `MAIN` task wakes up the main thread (see
+     * `main_thread_wakeup()`).
+     *
+     * @return A future that becomes ready when the task completes.
      */
-    void enqueue(Tasks::TaskPtr t, TargetThread policy);
+    std::shared_future<bool> enqueue(Tasks::TaskPtr t, TargetThread policy,
+                                     TaskPriority priority = TaskPriority::NORMAL);
 
     /**
      * This will run queued tasks that are scheduled to run on thread
@@ -94,6 +115,20 @@ class Scheduler
      */
     Kernel &kernel();
 
+    /**
+     * Retrieve statistics about the thread pool.
+     */
+    ThreadPool::Stats pool_stats() const;
+
+    /**
+     * The event file descriptor notified whenever a `MAIN` task is
+     * enqueued.
+     *
+     * The main thread polls it so it doesn't have to periodically
+     * check for new tasks.
+     */
+    Tools::EventFD &main_thread_wakeup();
+
   private:
     using TaskQueue    = std::queue<Tasks::TaskPtr>;
     using TaskQueueMap = std::map<TargetThread, TaskQueue>;
@@ -102,12 +137,21 @@ class Scheduler
      * The internal queues of tasks.
      *
      * Each target thread has its own queue. Tasks scheduled to run
-     * on `POOL` are not queued here, since they run on some detached thread
-     * we don't care about.
+     * on `POOL` are not queued here, but in the thread pool.
      */
     TaskQueueMap queues_;
 
     Kernel *kptr_;
     mutable std::mutex mutex_;
+
+    Tools::EventFD main_wakeup_;
+
+    /**
+     * Runs the `POOL` tasks.
+     *
+     * Declared last so that it is destroyed first: remaining tasks may
+     * still enqueue tasks in `queues_` while the pool drains.
+     */
+    ThreadPool pool_;
 };
 }
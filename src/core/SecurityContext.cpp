@@ -50,6 +50,10 @@ void SecurityContext::enforce_permission(SecurityContext::Action a) const
     return enforce_permission(a, {});
 }
 
+void SecurityContext::reset_cache()
+{
+}
+
 SystemSecurityContext::SystemSecurityContext(DBServicePtr dbsrv)
     : SecurityContext(dbsrv)
 {
@@ -257,6 +257,15 @@ class SecurityContext
      */
     bool check_permission(Action a) const;
 
+    /**
+     * Drop any permission decision the context may have memoized.
+     *
+     * Contexts that cache data derived from the database must forget
+     * it here. Callers invoke this at the boundary of a unit of work
+     * (eg. before each websocket request).
+     */
+    virtual void reset_cache();
+
     /**
      * Similar to check_permission(), but throws is the permission
      * is denied.
@@ -0,0 +1,172 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/ThreadPool.hpp"
+#include "core/tasks/Task.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
+#include <assert.h>
+
+using namespace Leosac;
+
+/**
+ * Is the current thread a thread of a ThreadPool ?
+ */
+static thread_local bool is_pool_thread = false;
+
+bool ThreadPool::EntryCompare::operator()(const Entry &lhs, const Entry &rhs) const
+{
+    // std::priority_queue pops the "biggest" element first.
+    if (lhs.priority != rhs.priority)
+        return lhs.priority < rhs.priority;
+    return lhs.sequence > rhs.sequence;
+}
+
+ThreadPool::ThreadPool(size_t nb_threads, size_t max_queue_size)
+    : max_queue_size_(max_queue_size)
+    , sequence_(0)
+    , stopping_(false)
+    , max_queue_depth_(0)
+    , completed_(0)
+    , rejected_(0)
+    , total_latency_(0)
+    , max_latency_(0)
+    , total_run_time_(0)
+    , max_run_time_(0)
+{
+    nb_threads = std::max<size_t>(nb_threads, 1);
+    workers_.reserve(nb_threads);
+    for (size_t i = 0; i < nb_threads; ++i)
+        workers_.emplace_back(&ThreadPool::worker_main, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    slot_available_.notify_all();
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::enqueue(Tasks::TaskPtr t, TaskPriority priority)
+{
+    assert(t);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!is_pool_thread && is_full())
+    {
+        WARN("ThreadPool queue is full (" << queue_.size()
+                                          << " tasks). Waiting for a free slot.");
+        slot_available_.wait(lock, [this]() { return stopping_ || !is_full(); });
+    }
+    push(lock, t, priority);
+}
+
+bool ThreadPool::try_enqueue(Tasks::TaskPtr t, TaskPriority priority)
+{
+    assert(t);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (is_full())
+    {
+        rejected_++;
+        return false;
+    }
+    push(lock, t, priority);
+    return true;
+}
+
+size_t ThreadPool::size() const
+{
+    return workers_.size();
+}
+
+ThreadPool::Stats ThreadPool::stats() const
+{
+    using namespace std::chrono;
+    std::lock_guard<std::mutex> lg(mutex_);
+    Stats s;
+
+    s.queue_depth      = queue_.size();
+    s.max_queue_depth  = max_queue_depth_;
+    s.completed        = completed_;
+    s.rejected         = rejected_;
+    s.max_latency      = duration_cast<microseconds>(max_latency_);
+    s.max_run_time     = duration_cast<microseconds>(max_run_time_);
+    s.average_latency  = microseconds(0);
+    s.average_run_time = microseconds(0);
+    if (completed_)
+    {
+        s.average_latency = duration_cast<microseconds>(total_latency_ / completed_);
+        s.average_run_time =
+            duration_cast<microseconds>(total_run_time_ / completed_);
+    }
+    return s;
+}
+
+void ThreadPool::push(std::unique_lock<std::mutex> &lock, Tasks::TaskPtr t,
+                      TaskPriority priority)
+{
+    assert(lock.owns_lock());
+    queue_.push(Entry{t, priority, sequence_++, Clock::now()});
+    max_queue_depth_ = std::max(max_queue_depth_, queue_.size());
+    lock.unlock();
+    task_available_.notify_one();
+}
+
+bool ThreadPool::is_full() const
+{
+    return max_queue_size_ && queue_.size() >= max_queue_size_;
+}
+
+void ThreadPool::worker_main()
+{
+    is_pool_thread = true;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        task_available_.wait(lock,
+                             [this]() { return stopping_ || !queue_.empty(); });
+        // Remaining tasks are run even when stopping.
+        if (queue_.empty())
+            break;
+
+        Entry entry = queue_.top();
+        queue_.pop();
+        lock.unlock();
+        slot_available_.notify_one();
+
+        auto start = Clock::now();
+        entry.task->run();
+        auto end = Clock::now();
+
+        lock.lock();
+        auto latency  = start - entry.enqueued_at;
+        auto run_time = end - start;
+
+        completed_++;
+        total_latency_ += latency;
+        total_run_time_ += run_time;
+
+        max_latency_  = std::max(max_latency_, latency);
+        max_run_time_ = std::max(max_run_time_, run_time);
+    }
+}
@@ -0,0 +1,188 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "LeosacFwd.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Leosac
+{
+
+/**
+ * Priority of a task running in the ThreadPool.
+ *
+ * Tasks with a higher priority are started first. Tasks of the same
+ * priority are started in the order they were enqueued.
+ */
+enum class TaskPriority
+{
+    LOW    = 0,
+    NORMAL = 1,
+    HIGH   = 2,
+};
+
+/**
+ * A fixed size pool of threads that run Tasks.
+ *
+ * Tasks are stored in a bounded queue. When the queue is full, `enqueue()`
+ * blocks until a slot is available: this provides back-pressure
+ * to the producers instead of an unbounded memory growth.
+ *
+ * There is one exception to this rule: a task that enqueue an other task
+ * from a thread of the pool never blocks, otherwise the pool could
+ * deadlock itself.
+ *
+ * The pool is fully thread-safe.
+ */
+class ThreadPool
+{
+  public:
+    /**
+     * Some counters about the pool activity.
+     */
+    struct Stats
+    {
+        /**
+         * Number of tasks waiting to be run.
+         */
+        size_t queue_depth;
+
+        /**
+         * Highest value of `queue_depth` ever observed.
+         */
+        size_t max_queue_depth;
+
+        /**
+         * Number of tasks that completed.
+         */
+        uint64_t completed;
+
+        /**
+         * Number of tasks refused by `try_enqueue()`.
+         */
+        uint64_t rejected;
+
+        /**
+         * Average and maximum time spent by tasks in the queue.
+         */
+        std::chrono::microseconds average_latency;
+        std::chrono::microseconds max_latency;
+
+        /**
+         * Average and maximum time spent running tasks.
+         */
+        std::chrono::microseconds average_run_time;
+        std::chrono::microseconds max_run_time;
+    };
+
+    /**
+     * Create a pool and start its threads.
+     *
+     * @param nb_threads Number of thread in the pool. At least one thread
+     * is always created.
+     * @param max_queue_size Maximum number of queued tasks. 0 means unbounded.
+     */
+    ThreadPool(size_t nb_threads, size_t max_queue_size);
+
+    /**
+     * Run all the queued tasks, then stop the threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&)      = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+
+    /**
+     * Enqueue a task, blocking while the queue is full.
+     */
+    void enqueue(Tasks::TaskPtr t, TaskPriority priority);
+
+    /**
+     * Enqueue a task if the queue is not full.
+     *
+     * @return false if the task was not enqueued.
+     */
+    bool try_enqueue(Tasks::TaskPtr t, TaskPriority priority);
+
+    /**
+     * Number of threads in the pool.
+     */
+    size_t size() const;
+
+    Stats stats() const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        Tasks::TaskPtr task;
+        TaskPriority priority;
+        uint64_t sequence;
+        Clock::time_point enqueued_at;
+    };
+
+    /**
+     * Order entries by priority, then by insertion order.
+     */
+    struct EntryCompare
+    {
+        bool operator()(const Entry &lhs, const Entry &rhs) const;
+    };
+
+    /**
+     * Push an entry to the queue. The mutex must be held.
+     */
+    void push(std::unique_lock<std::mutex> &lock, Tasks::TaskPtr t,
+              TaskPriority priority);
+
+    bool is_full() const;
+
+    void worker_main();
+
+    std::priority_queue<Entry, std::vector<Entry>, EntryCompare> queue_;
+    size_t max_queue_size_;
+    uint64_t sequence_;
+    bool stopping_;
+
+    std::vector<std::thread> workers_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable slot_available_;
+
+    // Counters. Protected by `mutex_`.
+    size_t max_queue_depth_;
+    uint64_t completed_;
+    uint64_t rejected_;
+    Clock::duration total_latency_;
+    Clock::duration max_latency_;
+    Clock::duration total_run_time_;
+    Clock::duration max_run_time_;
+};
+}
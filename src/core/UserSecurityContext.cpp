@@ -20,12 +20,14 @@
 #include "UserSecurityContext.hpp"
 #include "core/auth/Group_odb.h"
 #include "core/auth/IDoor.hpp"
+#include "core/auth/UserGroupMembership.hpp"
 #include "core/auth/User_odb.h"
 #include "tools/ScheduleMapping.hpp"
 #include "tools/db/DBService.hpp"
 #include "tools/db/MultiplexedTransaction.hpp"
 #include "tools/db/OptionalTransaction.hpp"
 #include "tools/log.hpp"
+#include <algorithm>
 
 using namespace Leosac;
 
@@ -148,14 +150,19 @@ bool UserSecurityContext::check_permission_impl(SecurityContext::Action action,
     return false;
 }
 
+void UserSecurityContext::reset_cache()
+{
+    user_info_ = boost::none;
+    group_ranks_.clear();
+    mapping_decisions_.clear();
+}
+
 bool UserSecurityContext::can_read_group(
     const SecurityContext::GroupActionParam &gap) const
 {
     if (is_manager() || gap.group_id == 0) // listing group.
         return true;
-    Auth::GroupPtr group =
-        dbsrv_->find_group_by_id(gap.group_id, DBService::THROW_IF_NOT_FOUND);
-    return group->member_has(user_id_);
+    return !!group_rank(gap.group_id);
 }
 
 bool UserSecurityContext::can_administrate_group(
@@ -163,14 +170,8 @@ bool UserSecurityContext::can_administrate_group(
 {
     if (is_manager())
         return true;
-    Auth::GroupRank rank;
-    Auth::GroupPtr group =
-        dbsrv_->find_group_by_id(gap.group_id, DBService::THROW_IF_NOT_FOUND);
-    if (group->member_has(user_id_, &rank))
-    {
-        return rank == Auth::GroupRank::ADMIN;
-    }
-    return false;
+    auto rank = group_rank(gap.group_id);
+    return rank && *rank == Auth::GroupRank::ADMIN;
 }
 
 bool UserSecurityContext::can_read_membership(
@@ -208,12 +209,10 @@ bool UserSecurityContext::can_create_membership(
     if (is_manager())
         return true;
     // If we are at least Operator in the group, we can add someone.
-    Auth::GroupPtr group =
-        dbsrv_->find_group_by_id(map.group_id, DBService::THROW_IF_NOT_FOUND);
-    Auth::GroupRank rank;
-    if (group->member_has(user_id_, &rank))
+    auto rank = group_rank(map.group_id);
+    if (rank)
     {
-        if (rank >= Auth::GroupRank::OPERATOR && map.rank <= rank)
+        if (*rank >= Auth::GroupRank::OPERATOR && map.rank <= *rank)
         {
             // Cannot invite to a rank superior our own rank.
             return true;
@@ -265,7 +264,7 @@ bool UserSecurityContext::can_read_schedule(
 
     for (const auto &mapping : sched->mapping())
     {
-        if (mapping->has_user_indirect(self()))
+        if (mapping_has_user(*mapping))
             return true;
     }
     return false;
@@ -282,8 +281,16 @@ bool UserSecurityContext::can_read_door(
         dbsrv_->find_door_by_id(dap.door_id, DBService::THROW_IF_NOT_FOUND);
     for (const auto &mapping : door->lazy_mapping())
     {
-        auto loaded_mapping = mapping.load();
-        if (loaded_mapping->has_user_indirect(self()))
+        // Only load mappings we haven't evaluated yet. Doors commonly share
+        // mappings, so this saves most of the loads when listing doors.
+        auto decision = mapping_decisions_.find(mapping.object_id());
+        if (decision != mapping_decisions_.end())
+        {
+            if (decision->second)
+                return true;
+            continue;
+        }
+        if (mapping_has_user(*mapping.load()))
             return true;
     }
     return false;
@@ -303,18 +310,73 @@ bool UserSecurityContext::can_read_credential(
 
 bool UserSecurityContext::is_admin() const
 {
-    auto user = dbsrv_->find_user_by_id(user_id_);
-    if (user)
-        return user->rank() == Auth::UserRank::ADMIN;
+    load_user_info();
+    if (user_info_->rank)
+        return *user_info_->rank == Auth::UserRank::ADMIN;
     return false;
 }
 
 bool UserSecurityContext::is_manager() const
 {
+    load_user_info();
+    if (user_info_->rank)
+        return *user_info_->rank >= Auth::UserRank::MANAGER;
+    return false;
+}
+
+void UserSecurityContext::load_user_info() const
+{
+    if (user_info_)
+        return;
+
+    UserInfo info;
     auto user = dbsrv_->find_user_by_id(user_id_);
     if (user)
-        return user->rank() >= Auth::UserRank::MANAGER;
-    return false;
+    {
+        info.rank = user->rank();
+        for (const auto &membership : user->group_memberships())
+            info.group_ids.insert(membership->group_id());
+        for (const auto &lazy_credential : user->lazy_credentials())
+            info.credential_ids.insert(lazy_credential.object_id());
+    }
+    user_info_ = std::move(info);
+}
+
+boost::optional<Auth::GroupRank>
+UserSecurityContext::group_rank(Auth::GroupId gid) const
+{
+    auto itr = group_ranks_.find(gid);
+    if (itr != group_ranks_.end())
+        return itr->second;
+
+    Auth::GroupPtr group =
+        dbsrv_->find_group_by_id(gid, DBService::THROW_IF_NOT_FOUND);
+    boost::optional<Auth::GroupRank> result;
+    Auth::GroupRank rank;
+    if (group->member_has(user_id_, &rank))
+        result = rank;
+    group_ranks_[gid] = result;
+    return result;
+}
+
+bool UserSecurityContext::mapping_has_user(
+    const Tools::ScheduleMapping &mapping) const
+{
+    auto itr = mapping_decisions_.find(mapping.id());
+    if (itr != mapping_decisions_.end())
+        return itr->second;
+
+    load_user_info();
+    const auto &gids = user_info_->group_ids;
+    const auto &cids = user_info_->credential_ids;
+    bool result =
+        mapping.has_user(user_id_) ||
+        std::any_of(gids.begin(), gids.end(),
+                    [&](Auth::GroupId gid) { return mapping.has_group(gid); }) ||
+        std::any_of(cids.begin(), cids.end(),
+                    [&](Cred::CredentialId cid) { return mapping.has_cred(cid); });
+    mapping_decisions_[mapping.id()] = result;
+    return result;
 }
 
 bool UserSecurityContext::is_self(Auth::UserId id) const
@@ -342,3 +404,7 @@ bool NullSecurityContext::check_permission_impl(
 {
     return false;
 }
+
+void NullSecurityContext::reset_cache()
+{
+}
@@ -21,12 +21,23 @@
 
 #include "core/SecurityContext.hpp"
 #include "core/auth/AuthFwd.hpp"
+#include <boost/optional.hpp>
+#include <map>
+#include <set>
 
 namespace Leosac
 {
 
 /**
  * A SecurityContext object for users.
+ *
+ * Permission checks are memoized: the user's rank, its group ranks and
+ * the decision for each schedule mapping are fetched at most once until
+ * reset_cache() is called. Serializing a list of N objects therefore
+ * costs a handful of queries instead of N user lookups.
+ *
+ * The cache is not synchronized: a context must not be used concurrently
+ * from multiple threads.
  */
 class UserSecurityContext : public SecurityContext
 {
@@ -36,6 +47,8 @@ class UserSecurityContext : public SecurityContext
     virtual bool check_permission_impl(Action a,
                                        const ActionParam &ap) const override;
 
+    virtual void reset_cache() override;
+
     /**
      * Return true if the owner of the security context is the user whose id
      * is `id`.
@@ -88,7 +101,38 @@ class UserSecurityContext : public SecurityContext
      */
     bool is_manager() const;
 
+    /**
+     * Load the user's rank, credentials and group memberships, unless
+     * they are already cached.
+     */
+    void load_user_info() const;
+
+    /**
+     * Rank of the user in the group `gid`, or `boost::none` if the user is
+     * not a member of the group.
+     *
+     * Throws if the group doesn't exist.
+     */
+    boost::optional<Auth::GroupRank> group_rank(Auth::GroupId gid) const;
+
+    /**
+     * Does the mapping reference the user, directly or through one of
+     * its groups or credentials?
+     */
+    bool mapping_has_user(const Tools::ScheduleMapping &mapping) const;
+
     Auth::UserId user_id_;
+
+    struct UserInfo
+    {
+        boost::optional<Auth::UserRank> rank;
+        std::set<Auth::GroupId> group_ids;
+        std::set<Cred::CredentialId> credential_ids;
+    };
+
+    mutable boost::optional<UserInfo> user_info_;
+    mutable std::map<Auth::GroupId, boost::optional<Auth::GroupRank>> group_ranks_;
+    mutable std::map<Tools::ScheduleMappingId, bool> mapping_decisions_;
 };
 
 
@@ -102,5 +146,11 @@ class NullSecurityContext : public UserSecurityContext
 
     virtual bool check_permission_impl(Action a,
                                        const ActionParam &ap) const override;
+
+    /**
+     * Nothing is cached. This context is shared by all the sessions that
+     * are not logged in, so this must not touch any state.
+     */
+    virtual void reset_cache() override;
 };
 }
@@ -21,6 +21,7 @@
 #include "core/audit/AuditEntry_odb.h"
 #include "core/auth/User.hpp"
 #include "core/auth/User_odb.h"
+#include "tools/db/ApproximateRowCount.hpp"
 #include "tools/db/OptionalTransaction.hpp"
 #include "tools/log.hpp"
 #include <odb/query.hxx>
@@ -28,6 +29,12 @@
 using namespace Leosac;
 using namespace Leosac::Audit;
 
+static db::ApproximateRowCount &audit_row_count()
+{
+    static db::ApproximateRowCount count;
+    return count;
+}
+
 AuditEntry::AuditEntry()
     : duration_(0)
     , finalized_(false)
@@ -43,6 +50,11 @@ AuditEntryId AuditEntry::id() const
 
 void AuditEntry::odb_callback(odb::callback_event e, odb::database &db) const
 {
+    if (e == odb::callback_event::post_persist)
+        audit_row_count().add(1);
+    else if (e == odb::callback_event::post_erase)
+        audit_row_count().remove(1);
+
     if (e == odb::callback_event::post_update ||
         e == odb::callback_event::post_persist)
     {
@@ -166,3 +178,11 @@ AuditEntryPtr AuditEntry::get_last_audit(DBPtr db)
 
     return db->query_one<AuditEntry>(q);
 }
+
+size_t AuditEntry::approximate_count(DBPtr db)
+{
+    return audit_row_count().get([&]() {
+        db::OptionalTransaction t(db->begin());
+        return db->query_value<AuditEntryCount>().count;
+    });
+}
@@ -92,6 +92,14 @@ class AuditEntry : virtual public IAuditEntry,
      */
     static AuditEntryPtr get_last_audit(DBPtr db);
 
+    /**
+     * Approximate number of audit entries in the database.
+     *
+     * It is seeded with a `count()` the first time it is needed, and
+     * is then updated when entries are persisted.
+     */
+    static size_t approximate_count(DBPtr db);
+
   private:
 #pragma db id auto
     AuditEntryId id_;
@@ -71,11 +71,12 @@ IGroupEventPtr Factory::GroupEvent(const DBPtr &database,
     return Audit::GroupEvent::create(database, target_group, parent_odb);
 }
 
-IWSAPICallPtr Factory::WSAPICall(const DBPtr &database)
+IWSAPICallPtr Factory::WSAPICall(const DBPtr &database,
+                                 const std::function<void(IWSAPICall &)> &init)
 {
     ASSERT_LOG(database, "Database cannot be null.");
 
-    return Audit::WSAPICall::create(database);
+    return Audit::WSAPICall::create(database, init);
 }
 
 IUserGroupMembershipEventPtr
@@ -25,6 +25,7 @@
 #include "tools/ToolsFwd.hpp"
 #include "tools/db/db_fwd.hpp"
 #include <core/update/UpdateFwd.hpp>
+#include <functional>
 
 namespace Leosac
 {
@@ -53,7 +54,14 @@ class Factory
                                      Auth::GroupPtr target_group,
                                      IAuditEntryPtr parent);
 
-    static IWSAPICallPtr WSAPICall(const DBPtr &database);
+    /**
+     * The optional `init` callback is invoked on the new entry before
+     * it is persisted, so that its initial values are saved by the same
+     * query that inserts it.
+     */
+    static IWSAPICallPtr
+    WSAPICall(const DBPtr &database,
+              const std::function<void(IWSAPICall &)> &init = nullptr);
 
 
     static IUserGroupMembershipEventPtr
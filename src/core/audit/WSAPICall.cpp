@@ -32,12 +32,16 @@ WSAPICall::WSAPICall()
 {
 }
 
-WSAPICallPtr WSAPICall::create(const DBPtr &database)
+WSAPICallPtr WSAPICall::create(const DBPtr &database,
+                               const std::function<void(IWSAPICall &)> &init)
 {
     ASSERT_LOG(database, "Database cannot be null.");
 
-    db::MultiplexedTransaction t(database->begin());
     WSAPICallPtr audit(new Audit::WSAPICall());
+    if (init)
+        init(*audit);
+
+    db::MultiplexedTransaction t(database->begin());
     database->persist(audit);
     t.commit();
     audit->database_ = database;
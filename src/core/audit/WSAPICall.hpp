@@ -21,6 +21,7 @@
 
 #include "AuditEntry.hpp"
 #include "core/audit/IWSAPICall.hpp"
+#include <functional>
 
 namespace Leosac
 {
@@ -37,7 +38,9 @@ class WSAPICall : virtual public IWSAPICall, public AuditEntry
 
     friend class Factory;
 
-    static WSAPICallPtr create(const DBPtr &database);
+    static WSAPICallPtr
+    create(const DBPtr &database,
+           const std::function<void(IWSAPICall &)> &init = nullptr);
 
   public:
     virtual ~WSAPICall() = default;
@@ -24,7 +24,7 @@
 #include "core/credentials/RFIDCardPin.hpp"
 #include "tools/enforce.hpp"
 #include "tools/log.hpp"
-#include <boost/algorithm/string.hpp>
+#include <algorithm>
 
 namespace Leosac
 {
@@ -40,10 +40,11 @@ Cred::ICredentialPtr AuthSourceBuilder::create_simple_csn(const std::string &nam
 
     *msg >> card_id;
     INFO("Building an AuthSource object (SIMPLE_CSN):" << card_id);
-    auto raw_csn = boost::replace_all_copy(card_id, ":", "");
-    LEOSAC_ENFORCE(raw_csn.length() % 2 == 0, "CSN has invalid length.");
+    auto nb_separators = std::count(card_id.begin(), card_id.end(), ':');
+    auto nb_digits     = card_id.size() - nb_separators;
+    LEOSAC_ENFORCE(nb_digits % 2 == 0, "CSN has invalid length.");
 
-    auto bits = raw_csn.length() * 8;
+    auto bits = nb_digits * 8;
     ASSERT_LOG(bits < std::numeric_limits<int>::max(), "Too many bits.");
 
     return std::make_shared<Cred::RFIDCard>(card_id, bits);
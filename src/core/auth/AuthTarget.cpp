@@ -18,6 +18,7 @@
 */
 
 #include "AuthTarget.hpp"
+#include "tools/CompiledSchedule.hpp"
 #include "tools/log.hpp"
 
 using namespace Leosac::Auth;
@@ -61,9 +62,10 @@ void AuthTarget::gpio(std::unique_ptr<Leosac::Hardware::FGPIO> new_gpio)
 bool AuthTarget::is_always_open(
     const std::chrono::system_clock::time_point &tp) const
 {
+    const auto minute_of_week = Tools::CompiledSchedule::minute_of_week(tp);
     for (const auto &sched : always_open_)
     {
-        if (sched->is_in_schedule(tp))
+        if (sched->is_in_schedule(minute_of_week))
             return true;
     }
     return false;
@@ -72,9 +74,10 @@ bool AuthTarget::is_always_open(
 bool AuthTarget::is_always_closed(
     const std::chrono::system_clock::time_point &tp) const
 {
+    const auto minute_of_week = Tools::CompiledSchedule::minute_of_week(tp);
     for (const auto &sched : always_close_)
     {
-        if (sched->is_in_schedule(tp))
+        if (sched->is_in_schedule(minute_of_week))
             return true;
     }
     return false;
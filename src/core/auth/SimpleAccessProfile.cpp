@@ -18,6 +18,7 @@
 */
 
 #include "SimpleAccessProfile.hpp"
+#include "tools/CompiledSchedule.hpp"
 #include <assert.h>
 #include <tools/log.hpp>
 
@@ -27,10 +28,13 @@ using SingleTimeFrame = Leosac::Tools::SingleTimeFrame;
 bool SimpleAccessProfile::isAccessGranted(
     const std::chrono::system_clock::time_point &date, AuthTargetPtr target)
 {
+    // Convert the date once, and check all schedules against it.
+    const auto minute_of_week = Tools::CompiledSchedule::minute_of_week(date);
+
     // check "general" permissions that apply to all target
     for (const auto &sched : default_schedule_)
     {
-        if (sched->is_in_schedule(date))
+        if (sched->is_in_schedule(minute_of_week))
         {
             INFO("Access is granted through schedule '" << sched->name() << "'");
             return true;
@@ -38,11 +42,14 @@ bool SimpleAccessProfile::isAccessGranted(
     }
 
     // check door specific permissions.
-    if (target && schedules_[target->name()].size())
+    // Do not use operator[] here: profiles may be shared between
+    // concurrent authentication requests and must not be modified.
+    auto itr = target ? schedules_.find(target->name()) : schedules_.end();
+    if (itr != schedules_.end())
     {
-        for (const auto &sched : schedules_[target->name()])
+        for (const auto &sched : itr->second)
         {
-            if (sched->is_in_schedule(date))
+            if (sched->is_in_schedule(minute_of_week))
             {
                 INFO("Access is granted through schedule '" << sched->name() << "'");
                 return true;
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/credentials/CardKey.hpp"
+
+using namespace Leosac;
+using namespace Leosac::Cred;
+
+boost::optional<CardKey> CardKey::from_card_id(const std::string &card_id)
+{
+    CardKey key{0, 0};
+    for (char c : card_id)
+    {
+        uint64_t digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else if (c == ':')
+            continue;
+        else
+            return boost::none;
+
+        if (key.bits == 64)
+            return boost::none;
+        key.value = (key.value << 4) | digit;
+        key.bits += 4;
+    }
+    if (key.bits == 0)
+        return boost::none;
+    return key;
+}
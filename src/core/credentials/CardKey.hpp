@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <string>
+
+namespace Leosac
+{
+namespace Cred
+{
+/**
+ * A card number, packed into an integer.
+ *
+ * `bits` is the width of the card id as written (4 bits per hexadecimal
+ * digit), not the number of meaningful bits of the card. This way, two
+ * card ids map to the same key only if they have the same digits: "ab"
+ * and "00:ab" remain different cards.
+ *
+ * A key whose `bits` is 0 is not a valid card number.
+ */
+struct CardKey
+{
+    uint64_t value;
+    uint8_t bits;
+
+    bool operator==(const CardKey &o) const
+    {
+        return value == o.value && bits == o.bits;
+    }
+
+    bool operator!=(const CardKey &o) const
+    {
+        return !(*this == o);
+    }
+
+    size_t hash() const
+    {
+        // Finalizer of splitmix64: card numbers are often sequential, so
+        // the low bits must depend on all the bits of the value.
+        uint64_t h = value ^ (static_cast<uint64_t>(bits) << 58);
+        h          = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h          = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+
+    /**
+     * Parse a card id, in the "aa:bb:cc:11" format.
+     *
+     * Returns nothing if the card id is empty, contains something else than
+     * hexadecimal digits and colons, or doesn't fit in 64 bits.
+     */
+    static boost::optional<CardKey> from_card_id(const std::string &card_id);
+};
+}
+}
@@ -0,0 +1,207 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/credentials/CardKey.hpp"
+#include <cassert>
+#include <cctype>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Leosac
+{
+namespace Cred
+{
+/**
+ * Maps card ids to T.
+ *
+ * Card ids are converted to a CardKey, and stored in an open-addressing
+ * hash table (linear probing). A slot is 16 bytes: the key and the index
+ * of the value in a dense array. Lookups don't allocate, and a miss
+ * usually costs a single cache line.
+ *
+ * Card ids that don't fit in 64 bits are stored in a regular map, keyed
+ * by their normalized (lowercase, without separators) digits.
+ *
+ * There is no removal: a table is built once, and replaced as a whole.
+ */
+template <typename T>
+class CardTable
+{
+  public:
+    CardTable()
+        : slots_(MIN_CAPACITY)
+    {
+    }
+
+    /**
+     * Returns the value mapped to `card_id`, inserting a default
+     * constructed one if needed.
+     *
+     * @note Unlike with std::unordered_map, inserting a card invalidates
+     * references to the values.
+     */
+    T &operator[](const std::string &card_id)
+    {
+        if (auto key = CardKey::from_card_id(card_id))
+            return (*this)[*key];
+        return wide_[normalize(card_id)];
+    }
+
+    T &operator[](const CardKey &key)
+    {
+        assert(key.bits);
+        auto &slot = slots_[find_slot(key)];
+        if (slot.bits)
+            return values_[slot.index];
+
+        if ((values_.size() + 1) * MAX_LOAD_DEN > slots_.size() * MAX_LOAD_NUM)
+        {
+            grow();
+            return (*this)[key];
+        }
+        slot.value = key.value;
+        slot.bits  = key.bits;
+        slot.index = static_cast<uint32_t>(values_.size());
+        values_.emplace_back();
+        return values_.back();
+    }
+
+    /**
+     * Returns the value mapped to `card_id`, or nullptr.
+     */
+    const T *find(const std::string &card_id) const
+    {
+        if (auto key = CardKey::from_card_id(card_id))
+            return find(*key);
+        if (wide_.empty())
+            return nullptr;
+        auto itr = wide_.find(normalize(card_id));
+        return itr != wide_.end() ? &itr->second : nullptr;
+    }
+
+    const T *find(const CardKey &key) const
+    {
+        const auto &slot = slots_[find_slot(key)];
+        return slot.bits ? &values_[slot.index] : nullptr;
+    }
+
+    size_t size() const
+    {
+        return values_.size() + wide_.size();
+    }
+
+    /**
+     * Invoke `f` on each value.
+     */
+    template <typename F>
+    void for_each(F &&f) const
+    {
+        for (const auto &value : values_)
+            f(value);
+        for (const auto &entry : wide_)
+            f(entry.second);
+    }
+
+    /**
+     * Memory used by the table itself, in bytes. This ignores the memory
+     * owned by the values and by the wide card ids.
+     */
+    size_t memory_usage() const
+    {
+        return slots_.capacity() * sizeof(Slot) + values_.capacity() * sizeof(T) +
+               wide_.bucket_count() * sizeof(void *) +
+               wide_.size() * sizeof(typename decltype(wide_)::value_type);
+    }
+
+  private:
+    struct Slot
+    {
+        uint64_t value;
+        /**
+         * 0 for an empty slot.
+         */
+        uint32_t bits;
+        uint32_t index;
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    /**
+     * The table grows when it is more than 3/4 full.
+     */
+    static constexpr size_t MAX_LOAD_NUM = 3;
+    static constexpr size_t MAX_LOAD_DEN = 4;
+
+    /**
+     * Index of the slot holding `key`, or of the empty slot where it
+     * would be inserted.
+     */
+    size_t find_slot(const CardKey &key) const
+    {
+        size_t mask = slots_.size() - 1;
+        for (size_t i = key.hash() & mask;; i = (i + 1) & mask)
+        {
+            const auto &slot = slots_[i];
+            if (!slot.bits || (slot.value == key.value && slot.bits == key.bits))
+                return i;
+        }
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old(slots_.size() * 2);
+        old.swap(slots_);
+        for (const auto &slot : old)
+        {
+            if (slot.bits)
+            {
+                CardKey key{slot.value, static_cast<uint8_t>(slot.bits)};
+                slots_[find_slot(key)] = slot;
+            }
+        }
+    }
+
+    static std::string normalize(const std::string &card_id)
+    {
+        std::string digits;
+        digits.reserve(card_id.size());
+        for (char c : card_id)
+        {
+            if (c != ':')
+                digits.push_back(static_cast<char>(std::tolower(c)));
+        }
+        return digits;
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<T> values_;
+    std::unordered_map<std::string, T> wide_;
+};
+
+template <typename T>
+constexpr size_t CardTable<T>::MIN_CAPACITY;
+template <typename T>
+constexpr size_t CardTable<T>::MAX_LOAD_NUM;
+template <typename T>
+constexpr size_t CardTable<T>::MAX_LOAD_DEN;
+}
+}
@@ -18,9 +18,9 @@
 */
 
 #include "core/credentials/RFIDCard.hpp"
+#include "core/credentials/CardKey.hpp"
 #include "exception/ModelException.hpp"
 #include "tools/log.hpp"
-#include <boost/algorithm/string.hpp>
 
 using namespace Leosac;
 using namespace Leosac::Cred;
@@ -43,16 +43,12 @@ int RFIDCard::nb_bits() const
 
 uint64_t RFIDCard::to_raw_int() const
 {
-    auto card_num_hex = boost::replace_all_copy(card_id_, ":", "");
+    auto key = CardKey::from_card_id(card_id_);
+    if (!key)
+        throw std::out_of_range("Card id " + card_id_ + " doesn't fit in 64 bits.");
 
-    static_assert(sizeof(decltype(std::stoull(card_num_hex, nullptr, 16))) ==
-                      sizeof(uint64_t),
-                  "stoul not big enough");
-
-    uint64_t tmp      = std::stoull(card_num_hex, nullptr, 16);
     int trailing_zero = (64 - nb_bits_) % 8;
-    tmp >>= trailing_zero;
-    return tmp;
+    return key->value >> trailing_zero;
 }
 
 uint64_t RFIDCard::to_int() const
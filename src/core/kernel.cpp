@@ -63,8 +63,25 @@ using namespace Leosac;
 
 Kernel *Kernel::instance_ = nullptr;
 
+/**
+ * Build the scheduler, sizing its thread pool from the optional
+ * `<scheduler>` configuration node.
+ */
+static SchedulerPtr make_scheduler(Kernel *kptr, const ptree &config)
+{
+    size_t pool_size  = Scheduler::DEFAULT_POOL_SIZE;
+    size_t queue_size = Scheduler::DEFAULT_POOL_QUEUE_SIZE;
+
+    if (auto sched_cfg_node = config.get_child_optional("scheduler"))
+    {
+        pool_size  = sched_cfg_node->get<size_t>("pool_size", pool_size);
+        queue_size = sched_cfg_node->get<size_t>("max_queue_size", queue_size);
+    }
+    return std::make_shared<Scheduler>(kptr, pool_size, queue_size);
+}
+
 Kernel::Kernel(const boost::property_tree::ptree &config, bool strict)
-    : utils_(std::make_shared<CoreUtils>(this, std::make_shared<Scheduler>(this),
+    : utils_(std::make_shared<CoreUtils>(this, make_scheduler(this, config),
                                          std::make_shared<ConfigChecker>(), strict))
     , config_manager_(config)
     , ctx_()
@@ -163,9 +180,14 @@ bool Kernel::run()
             remote_controller_->socket_,
             std::bind(&RemoteControl::handle_msg, remote_controller_.get()));
 
+    // Woken up when a task is scheduled on the main thread, or when
+    // a signal is received.
+    auto &wakeup = utils_->scheduler().main_thread_wakeup();
+    reactor_.add(wakeup.fd(), [&wakeup]() { wakeup.drain(); });
+
     while (is_running_)
     {
-        reactor_.poll(25); // this is good enough. May be improved later tho.
+        reactor_.poll();
         utils_->scheduler().update(TargetThread::MAIN);
         if (send_sighup_)
         {
@@ -367,10 +389,16 @@ std::string Kernel::factory_config_directory() const
 
 void Kernel::configure_logger()
 {
-    bool use_syslog              = true;
-    bool use_database            = false;
-    std::string syslog_min_level = "WARNING";
+    bool use_syslog               = true;
+    bool use_database             = false;
+    std::string syslog_min_level  = "WARNING";
+    std::string console_min_level = "DEBUG";
+    size_t async_queue_size       = 0;
     std::shared_ptr<spdlog::logger> console;
+    std::shared_ptr<spdlog::logger> syslog;
+    auto db_flush_interval = Tools::DatabaseLogSink::DEFAULT_FLUSH_INTERVAL;
+    auto db_buffer_size    = Tools::DatabaseLogSink::DEFAULT_BUFFER_SIZE;
+    auto db_overflow       = Tools::DatabaseLogSink::OverflowPolicy::DROP;
 
     // Drop existing logger, if any. (This is for the case of a "in process" restart)
     spdlog::drop("syslog");
@@ -382,10 +410,30 @@ void Kernel::configure_logger()
         use_syslog       = log_cfg_node->get<bool>("enable_syslog", true);
         use_database     = log_cfg_node->get<bool>("enable_database", false);
         syslog_min_level = log_cfg_node->get<std::string>("min_syslog", "WARNING");
+        console_min_level =
+            log_cfg_node->get<std::string>("min_console", console_min_level);
+        async_queue_size = log_cfg_node->get<size_t>("async_queue_size", 0);
+
+        db_flush_interval = std::chrono::milliseconds(log_cfg_node->get<int64_t>(
+            "database_flush_interval", db_flush_interval.count()));
+        db_buffer_size =
+            log_cfg_node->get<size_t>("database_buffer_size", db_buffer_size);
+        if (auto overflow =
+                log_cfg_node->get_optional<std::string>("database_overflow"))
+        {
+            db_overflow =
+                Tools::DatabaseLogSink::overflow_policy_from_string(*overflow);
+        }
     }
+    // Must be set before creating the loggers.
+    if (async_queue_size)
+        spdlog::set_async_mode(async_queue_size);
+    else
+        spdlog::set_sync_mode();
+
     if (use_syslog)
     {
-        auto syslog = spdlog::create(
+        syslog = spdlog::create(
             "syslog", {std::make_shared<spdlog::sinks::syslog_sink>()});
         syslog->set_level(static_cast<spdlog::level::level_enum>(
             LogHelper::log_level_from_string(syslog_min_level)));
@@ -394,12 +442,16 @@ void Kernel::configure_logger()
     {
         console = spdlog::create(
             "console", {std::make_shared<spdlog::sinks::stdout_sink_mt>(),
-                        std::make_shared<Tools::DatabaseLogSink>(database_)});
+                        std::make_shared<Tools::DatabaseLogSink>(
+                            database_, db_flush_interval, db_buffer_size,
+                            db_overflow)});
     }
     else
         console = spdlog::create(
             "console", {std::make_shared<spdlog::sinks::stdout_sink_mt>()});
-    console->set_level(spdlog::level::debug);
+    console->set_level(static_cast<spdlog::level::level_enum>(
+        LogHelper::log_level_from_string(console_min_level)));
+    LogHelper::set_loggers(console, syslog);
 }
 
 const ModuleManager &Kernel::module_manager() const
@@ -442,6 +494,7 @@ void Kernel::restart_later()
 {
     want_restart_ = true;
     is_running_   = false;
+    utils_->scheduler().main_thread_wakeup().notify();
 }
 
 CoreUtilsPtr Kernel::core_utils()
@@ -466,9 +519,13 @@ void Kernel::shutdown()
     // should be improved. This may require important changes
     // to the module subsystem.
     Tools::ElapsedTimeCounter etc;
-    while (etc.elapsed() < 5000)
+    while (true)
     {
-        reactor_.poll(25);
+        // elapsed() is unsigned: read it once, the remaining time must not wrap.
+        auto elapsed = static_cast<long>(etc.elapsed());
+        if (elapsed >= 5000)
+            break;
+        reactor_.poll(5000 - elapsed);
         utils_->scheduler().update(TargetThread::MAIN);
     }
 }
@@ -733,7 +790,11 @@ void Kernel::connect_to_db(const boost::property_tree::ptree &db_cfg_node)
 
 void Kernel::configure_signal_handler()
 {
-    SignalHandler::registerCallback(Signal::SigInt, [this](Signal) {
+    // The callbacks run in signal context: they only set flags and
+    // wake the main loop up.
+    auto &wakeup = utils_->scheduler().main_thread_wakeup();
+
+    SignalHandler::registerCallback(Signal::SigInt, [this, &wakeup](Signal) {
         if (!this->is_running_)
         {
             std::cerr << "SIGINT received a second time. Exiting abruptly."
@@ -743,14 +804,19 @@ void Kernel::configure_signal_handler()
         else
         {
             this->is_running_ = false;
+            wakeup.notify();
         }
     });
 
-    SignalHandler::registerCallback(Signal::SigTerm,
-                                    [this](Signal) { this->is_running_ = false; });
+    SignalHandler::registerCallback(Signal::SigTerm, [this, &wakeup](Signal) {
+        this->is_running_ = false;
+        wakeup.notify();
+    });
 
-    SignalHandler::registerCallback(Signal::SigHup,
-                                    [this](Signal) { this->send_sighup_ = true; });
+    SignalHandler::registerCallback(Signal::SigHup, [this, &wakeup](Signal) {
+        this->send_sighup_ = true;
+        wakeup.notify();
+    });
 }
 
 void Kernel::create_update_schema()
@@ -778,4 +844,14 @@ void Kernel::create_update_schema()
         odb::schema_catalog::migrate(*database_, cv, "core");
         t.commit();
     }
+
+    {
+        // audit.get filters on the entry's type and pages by id. The type
+        // discriminator is managed by ODB and cannot carry an index pragma,
+        // so the index is created here. This also covers existing databases.
+        odb::transaction t(database_->begin());
+        database_->execute("CREATE INDEX IF NOT EXISTS \"AuditEntry_typeid_id_i\" "
+                           "ON \"AuditEntry\" (\"typeid\", \"id\")");
+        t.commit();
+    }
 }
@@ -22,14 +22,26 @@
 #include "exception/ExceptionsTools.hpp"
 #include "tools/log.hpp"
 #include "tools/unixfs.hpp"
+#include <future>
+#include <tuple>
 
 using Leosac::Tools::UnixFs;
 using namespace Leosac;
 
+namespace
+{
+std::chrono::milliseconds elapsed(std::chrono::steady_clock::time_point from,
+                                  std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from);
+}
+}
+
 ModuleManager::ModuleManager(zmqpp::context &ctx, Leosac::Kernel &k)
     : ctx_(ctx)
     , config_manager_(k.config_manager())
     , core_utils_(k.core_utils())
+    , start_time_(std::chrono::steady_clock::now())
 {
 }
 
@@ -68,11 +80,51 @@ void ModuleManager::unloadLibraries()
 
 void ModuleManager::initModules()
 {
-    for (const ModuleInfo &module_info : modules_)
+    auto begin = std::chrono::steady_clock::now();
+    auto itr   = modules_.begin();
+    while (itr != modules_.end())
+    {
+        // modules_ is ordered by level: collect the modules of the current one.
+        std::vector<ModuleInfo *> level;
+        int level_value = itr->level_;
+        for (; itr != modules_.end() && itr->level_ == level_value; ++itr)
+        {
+            // fixme ... that cast.
+            level.push_back(const_cast<ModuleInfo *>(&(*itr)));
+        }
+        init_level(level);
+    }
+    INFO("Modules initialized in "
+         << elapsed(begin, std::chrono::steady_clock::now()).count() << "ms.");
+}
+
+void ModuleManager::init_level(const std::vector<ModuleInfo *> &modules)
+{
+    if (modules.size() == 1)
+        return initModule(modules.front());
+
+    std::vector<std::future<void>> results;
+    for (ModuleInfo *modinfo : modules)
+    {
+        results.push_back(std::async(std::launch::async,
+                                     [this, modinfo]() { initModule(modinfo); }));
+    }
+
+    std::exception_ptr error;
+    for (auto &result : results)
     {
-        // fixme ... that cast.
-        initModule(const_cast<ModuleInfo *>(&module_info));
+        try
+        {
+            result.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
     }
+    if (error)
+        std::rethrow_exception(error);
 }
 
 void ModuleManager::initModule(ModuleInfo *modinfo)
@@ -108,16 +160,20 @@ void ModuleManager::initModule(ModuleInfo *modinfo)
             actor_fun = ((bool (*)(zmqpp::socket *, boost::property_tree::ptree,
                                    zmqpp::context &, CoreUtilsPtr))symptr);
 
-        auto new_module = std::unique_ptr<zmqpp::actor>(
+        // The actor's constructor returns once the module signaled
+        // that it is ready.
+        modinfo->init_begin_ = std::chrono::steady_clock::now();
+        auto new_module      = std::unique_ptr<zmqpp::actor>(
             new zmqpp::actor(std::bind(actor_fun, std::placeholders::_1,
                                        config_manager_.load_config(modinfo->name_),
                                        std::ref(ctx_), core_utils_)));
-        modinfo->actor_ = std::move(new_module);
+        modinfo->actor_       = std::move(new_module);
+        modinfo->ready_       = std::chrono::steady_clock::now();
+        modinfo->initialized_ = true;
 
-        INFO("Module "
-             << green(modinfo->name_) << " initialized. (level = "
-             << config_manager_.load_config(modinfo->name_).get<int>("level", 100)
-             << ")");
+        INFO("Module " << green(modinfo->name_) << " initialized in "
+                       << elapsed(modinfo->init_begin_, modinfo->ready_).count()
+                       << "ms. (level = " << modinfo->level_ << ")");
     }
     catch (std::exception &e)
     {
@@ -163,12 +219,14 @@ bool ModuleManager::loadModule(const std::string &module_name)
         // fixme not clean enough.
         if (UnixFs::fileExists(path_entry + "/" + filename))
         {
-            ModuleInfo module_info(config_manager_);
-
-            module_info.name_ = module_name;
+            ModuleInfo module_info;
 
+            module_info.name_       = module_name;
+            module_info.level_      = cfg.get<int>("level", 100);
+            module_info.load_begin_ = std::chrono::steady_clock::now();
             if (!(module_info.lib_ = load_library_file(path_entry + "/" + filename)))
                 return false;
+            module_info.load_end_ = std::chrono::steady_clock::now();
             modules_.insert(std::move(module_info));
             DEBUG("library file loaded (not init yet)");
             return true;
@@ -257,19 +315,25 @@ ModuleManager::ModuleInfo::~ModuleInfo()
 {
 }
 
-ModuleManager::ModuleInfo::ModuleInfo(const Leosac::ConfigManager &cfg)
-    : lib_(nullptr)
+ModuleManager::ModuleInfo::ModuleInfo()
+    : level_(100)
+    , lib_(nullptr)
     , actor_(nullptr)
-    , cfg_(cfg)
+    , initialized_(false)
 {
 }
 
 ModuleManager::ModuleInfo::ModuleInfo(ModuleManager::ModuleInfo &&o)
-    : cfg_(o.cfg_)
 {
-    actor_ = std::move(o.actor_);
-    lib_   = o.lib_;
-    name_  = o.name_;
+    actor_       = std::move(o.actor_);
+    lib_         = o.lib_;
+    name_        = o.name_;
+    level_       = o.level_;
+    load_begin_  = o.load_begin_;
+    load_end_    = o.load_end_;
+    init_begin_  = o.init_begin_;
+    ready_       = o.ready_;
+    initialized_ = o.initialized_;
 
     o.actor_ = nullptr;
     o.lib_   = nullptr;
@@ -308,10 +372,28 @@ std::vector<std::string> const &ModuleManager::get_module_path() const
     return path_;
 }
 
-bool ModuleManager::ModuleInfo::operator<(const ModuleInfo &o) const
+std::vector<ModuleStartupInfo> ModuleManager::startup_timeline() const
 {
-    int level_me = cfg_.load_config(name_).get<int>("level", 100);
-    int level_o  = cfg_.load_config(o.name_).get<int>("level", 100);
+    std::vector<ModuleStartupInfo> ret;
+
+    ret.reserve(modules_.size());
+    for (auto const &module : modules_)
+    {
+        ModuleStartupInfo info;
+        info.name        = module.name_;
+        info.level       = module.level_;
+        info.load_begin  = elapsed(start_time_, module.load_begin_);
+        info.load_end    = elapsed(start_time_, module.load_end_);
+        info.init_begin  = elapsed(start_time_, module.init_begin_);
+        info.ready       = elapsed(start_time_, module.ready_);
+        info.initialized = module.initialized_;
+        ret.push_back(info);
+    }
+    return ret;
+}
 
-    return level_me < level_o;
+bool ModuleManager::ModuleInfo::operator<(const ModuleInfo &o) const
+{
+    // The name breaks ties, so that modules sharing a level are all kept.
+    return std::tie(level_, name_) < std::tie(o.level_, o.name_);
 }
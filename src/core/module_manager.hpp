@@ -21,8 +21,10 @@
 
 #include "LeosacFwd.hpp"
 #include "boost/property_tree/ptree.hpp"
+#include "core/ModuleStartupInfo.hpp"
 #include "core/config/ConfigManager.hpp"
 #include "dynlib/dynamiclibrary.hpp"
+#include <chrono>
 #include <list>
 #include <map>
 #include <set>
@@ -50,6 +52,9 @@ class ConfigManager;
 * @note: Use the "level" property to define module initialization order.
 * This initialization order is mandatory, and the lower the value is, the sooner the
 * module is loaded.
+* Modules that share the same level are initialized in parallel, and a level
+* is fully initialized before the next one starts. A module that depends on
+* another one must therefore use a strictly greater level.
 */
 class ModuleManager
 {
@@ -73,7 +78,7 @@ class ModuleManager
     struct ModuleInfo
     {
         ~ModuleInfo();
-        ModuleInfo(const Leosac::ConfigManager &cfg);
+        ModuleInfo();
 
         ModuleInfo(const ModuleInfo &) = delete;
         ModuleInfo &operator=(const ModuleInfo &) = delete;
@@ -90,6 +95,12 @@ class ModuleManager
         */
         std::string name_;
 
+        /**
+        * Initialization level, read from the module's configuration
+        * when it is loaded.
+        */
+        int level_;
+
         /**
         * Pointer to the library object.
         */
@@ -100,15 +111,26 @@ class ModuleManager
         */
         mutable std::unique_ptr<zmqpp::actor> actor_;
 
-        bool operator<(const ModuleInfo &o) const;
+        /**
+        * Startup timestamps. `ready_` is only set once the module
+        * has been successfully initialized.
+        */
+        std::chrono::steady_clock::time_point load_begin_;
+        std::chrono::steady_clock::time_point load_end_;
+        std::chrono::steady_clock::time_point init_begin_;
+        std::chrono::steady_clock::time_point ready_;
+        bool initialized_;
 
-      private:
-        const Leosac::ConfigManager &cfg_;
+        /**
+        * Order by level, then by name.
+        */
+        bool operator<(const ModuleInfo &o) const;
     };
 
     /**
     * Actually call the init_module() function of each library we loaded.
     * The module initialization order is honored because the modules_ set is ordered.
+    * Modules of a same level are initialized concurrently.
     * @throws: may throw ModuleException if init_module() fails for a library (or
     * actor init exception).
     */
@@ -167,7 +189,22 @@ class ModuleManager
     */
     const std::vector<std::string> &get_module_path() const;
 
+    /**
+    * Returns the startup timeline of the loaded modules, in
+    * initialization order.
+    */
+    std::vector<Leosac::ModuleStartupInfo> startup_timeline() const;
+
   private:
+    /**
+    * Initialize modules that share the same level, each in its own
+    * thread, and wait until all of them are done.
+    *
+    * If some modules fail to initialize, the first error is rethrown
+    * once all the others have completed.
+    */
+    void init_level(const std::vector<ModuleInfo *> &modules);
+
     /**
     * Close library handler.
     *
@@ -216,4 +253,9 @@ class ModuleManager
     zmqpp::context &ctx_;
     Leosac::ConfigManager &config_manager_;
     Leosac::CoreUtilsPtr core_utils_;
+
+    /**
+    * Origin of the startup timeline.
+    */
+    const std::chrono::steady_clock::time_point start_time_;
 };
\ No newline at end of file
@@ -32,6 +32,7 @@ Task::Task()
     , eptr_(nullptr)
     , complete_(false)
     , guid_(Leosac::gen_uuid())
+    , future_(promise_.get_future().share())
 {
 }
 
@@ -73,6 +74,10 @@ void Task::run()
         mutex_.unlock();
         cv_.notify_all();
     }
+    if (eptr_)
+        promise_.set_exception(eptr_);
+    else
+        promise_.set_value(success_);
     INFO("Task ~" << guid_ << "~ completed "
                   << (success_ ? "successfully" : "with error."));
 }
@@ -95,6 +100,11 @@ std::exception_ptr Task::get_exception() const
     return eptr_;
 }
 
+std::shared_future<bool> Task::get_future() const
+{
+    return future_;
+}
+
 const std::string &Task::get_guid() const
 {
     return guid_;
@@ -21,7 +21,11 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <string>
 
 namespace Leosac
 {
@@ -59,6 +63,15 @@ class Task
      */
     void wait();
 
+    /**
+     * Retrieve a future that becomes ready when the task completes.
+     *
+     * The future holds the task's success status, or the exception
+     * the task threw. This lets callers chain work (eg from an other task)
+     * without polling `is_complete()`.
+     */
+    std::shared_future<bool> get_future() const;
+
     void run();
 
     bool succeed() const;
@@ -118,6 +131,9 @@ class Task
     std::atomic_bool complete_;
     std::condition_variable cv_;
     std::string guid_;
+
+    std::promise<bool> promise_;
+    std::shared_future<bool> future_;
 };
 }
 }
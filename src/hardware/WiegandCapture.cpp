@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hardware/WiegandCapture.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
+
+using namespace Leosac::Hardware;
+
+constexpr int WiegandCapture::MAX_BITS;
+constexpr std::chrono::milliseconds WiegandCapture::DEFAULT_FRAME_GAP;
+
+WiegandCapture::WiegandCapture(const std::string &high_gpio,
+                               const std::string &low_gpio,
+                               std::chrono::milliseconds frame_gap)
+    : high_gpio_(high_gpio)
+    , low_gpio_(low_gpio)
+    , topic_(topic(high_gpio, low_gpio))
+    , frame_gap_(frame_gap)
+    , counter_(0)
+{
+    std::fill(buffer_.begin(), buffer_.end(), 0);
+}
+
+std::string WiegandCapture::topic(const std::string &high_gpio,
+                                  const std::string &low_gpio)
+{
+    return "S_WIEGAND_FRAME:" + high_gpio + ":" + low_gpio;
+}
+
+const std::string &WiegandCapture::high_gpio() const
+{
+    return high_gpio_;
+}
+
+const std::string &WiegandCapture::low_gpio() const
+{
+    return low_gpio_;
+}
+
+void WiegandCapture::push_bit(bool value, const TimePoint &when)
+{
+    if (counter_ == MAX_BITS)
+    {
+        WARN("Wiegand capture on " << high_gpio_ << "/" << low_gpio_
+                                   << " received too many bits. Resetting.");
+        counter_ = 0;
+        std::fill(buffer_.begin(), buffer_.end(), 0);
+    }
+
+    if (counter_ == 0)
+        first_bit_ = when;
+    last_bit_ = when;
+
+    if (value)
+        buffer_[counter_ / 8] |= (1 << (7 - counter_ % 8));
+    counter_++;
+}
+
+WiegandCapture::TimePoint WiegandCapture::next_update() const
+{
+    if (counter_ == 0)
+        return TimePoint::max();
+    return last_bit_ + frame_gap_;
+}
+
+bool WiegandCapture::frame_complete(const TimePoint &now) const
+{
+    return counter_ != 0 && now >= last_bit_ + frame_gap_;
+}
+
+zmqpp::message WiegandCapture::take_frame()
+{
+    using namespace std::chrono;
+    zmqpp::message msg;
+
+    msg << topic_ << static_cast<int32_t>(counter_)
+        << std::string(buffer_.begin(), buffer_.begin() + (counter_ + 7) / 8)
+        << static_cast<int64_t>(
+               duration_cast<microseconds>(first_bit_.time_since_epoch()).count())
+        << static_cast<int64_t>(
+               duration_cast<microseconds>(last_bit_.time_since_epoch()).count());
+
+    counter_ = 0;
+    std::fill(buffer_.begin(), buffer_.end(), 0);
+    return msg;
+}
@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <zmqpp/message.hpp>
+
+namespace Leosac
+{
+namespace Hardware
+{
+/**
+ * Decode the data lines of a Wiegand reader directly in a GPIO module.
+ *
+ * GPIO modules normally publish one `S_INT:<gpio>` message per interrupt,
+ * which means one bus message per Wiegand bit. When a capture is configured
+ * for a pair of input GPIOs, the module instead feeds interrupts on those
+ * pins to the capture, and publishes a single message per frame.
+ *
+ * A frame is complete when no bit has been received for `frame_gap`.
+ *
+ * The frame message is:
+ *     + `S_WIEGAND_FRAME:<high_gpio>:<low_gpio>` (see `topic()`).
+ *     + Number of bits (`int32_t`).
+ *     + The bits, packed MSB first (`std::string`).
+ *     + Timestamp of the first bit, in microseconds since epoch (`int64_t`).
+ *     + Timestamp of the last bit, in microseconds since epoch (`int64_t`).
+ *
+ * @note This class is not thread-safe. It is meant to be owned by the
+ * module's thread.
+ */
+class WiegandCapture
+{
+  public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    static constexpr int MAX_BITS = 128;
+
+    static constexpr std::chrono::milliseconds DEFAULT_FRAME_GAP{50};
+
+    WiegandCapture(const std::string &high_gpio, const std::string &low_gpio,
+                   std::chrono::milliseconds frame_gap = DEFAULT_FRAME_GAP);
+
+    /**
+     * Topic of the frame message for the given pair of GPIOs.
+     */
+    static std::string topic(const std::string &high_gpio,
+                             const std::string &low_gpio);
+
+    const std::string &high_gpio() const;
+
+    const std::string &low_gpio() const;
+
+    /**
+     * Record a bit. This is called by the GPIO interrupt handler.
+     *
+     * If the frame is larger than `MAX_BITS`, it is discarded.
+     */
+    void push_bit(bool value, const TimePoint &when = TimePoint::clock::now());
+
+    /**
+     * Time point at which the current frame is complete, or
+     * `TimePoint::max()` if no bit is pending.
+     */
+    TimePoint next_update() const;
+
+    /**
+     * Is there a complete frame, waiting to be published?
+     */
+    bool frame_complete(const TimePoint &now = TimePoint::clock::now()) const;
+
+    /**
+     * Build the frame message and reset the capture.
+     */
+    zmqpp::message take_frame();
+
+  private:
+    std::string high_gpio_;
+    std::string low_gpio_;
+    std::string topic_;
+    std::chrono::milliseconds frame_gap_;
+
+    std::array<uint8_t, MAX_BITS / 8> buffer_;
+    int counter_;
+    TimePoint first_bit_;
+    TimePoint last_bit_;
+};
+}
+}
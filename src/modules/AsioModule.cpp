@@ -47,49 +47,82 @@ void AsioModule::run()
     service_event_listener_.disconnect();
 }
 
-void AsioModule::install_async_handlers()
+void AsioModule::watch_zmq_socket(zmqpp::socket &sock)
 {
-    auto stop_watcher(std::make_shared<StopWatcher>(*this));
-    stop_watcher->schedule_wait();
+    watched_sockets_.push_back(&sock);
+}
 
+void AsioModule::install_async_handlers()
+{
     auto reactor_poller(std::make_shared<AsyncReactorPoller>(*this));
-    reactor_poller->schedule_wait();
+    reactor_poller->watch(control_);
+    reactor_poller->watch(pipe_);
+    for (auto sock : watched_sockets_)
+        reactor_poller->watch(*sock);
+    reactor_poller->start();
 }
 
-void AsioModule::StopWatcher::wait(const boost::system::error_code &ec)
+AsioModule::AsyncReactorPoller::AsyncReactorPoller(AsioModule &self)
+    : self_(self)
 {
-    if (ec)
-    {
-        WARN("AsioModule StopWatcher timer has errored: " << ec.message());
-        ASSERT_LOG(0, "Failed.");
-    }
-    if (!self_.is_running_)
-        self_.work_.reset();
-    else
-        schedule_wait();
 }
 
-void AsioModule::StopWatcher::schedule_wait()
+AsioModule::AsyncReactorPoller::~AsyncReactorPoller()
+{
+    for (auto &desc : descriptors_)
+        desc->release();
+}
+
+void AsioModule::AsyncReactorPoller::watch(zmqpp::socket &sock)
 {
-    timer_.expires_from_now(std::chrono::milliseconds(1000));
-    timer_.async_wait(std::bind(&AsioModule::StopWatcher::wait, shared_from_this(),
-                                std::placeholders::_1));
+    int fd;
+    sock.get(zmqpp::socket_option::file_descriptor, fd);
+    descriptors_.push_back(std::make_unique<Descriptor>(self_.io_service_, fd));
 }
 
-void AsioModule::AsyncReactorPoller::schedule_wait()
+void AsioModule::AsyncReactorPoller::start()
 {
-    timer_.expires_from_now(std::chrono::milliseconds(25));
-    timer_.async_wait(std::bind(&AsioModule::AsyncReactorPoller::wait_handler,
-                                shared_from_this(), std::placeholders::_1));
+    // Messages may have been queued before we started watching: the
+    // descriptors will not signal them.
+    process();
+    if (!self_.is_running_)
+        return;
+    for (auto &desc : descriptors_)
+        schedule_wait(*desc);
+}
+
+void AsioModule::AsyncReactorPoller::schedule_wait(Descriptor &desc)
+{
+    desc.async_read_some(boost::asio::null_buffers(),
+                         std::bind(&AsioModule::AsyncReactorPoller::wait_handler,
+                                   shared_from_this(), std::ref(desc),
+                                   std::placeholders::_1));
 }
 
 void AsioModule::AsyncReactorPoller::wait_handler(
-    const boost::system::error_code &ec)
+    Descriptor &desc, const boost::system::error_code &ec)
 {
-    ASSERT_LOG(ec == 0, "Error while processing wait_handler: " << ec.message());
-    self_.reactor_.poll(0);
+    if (ec == boost::asio::error::operation_aborted)
+        return;
+    ASSERT_LOG(!ec, "Error while processing wait_handler: " << ec.message());
+    process();
     if (self_.is_running_)
-        schedule_wait();
+        schedule_wait(desc);
+}
+
+void AsioModule::AsyncReactorPoller::process()
+{
+    // poll() re-reads ZMQ_EVENTS of every socket, which also
+    // re-arms the edge-triggered descriptors.
+    while (self_.reactor_.poll(0))
+        ;
+
+    if (!self_.is_running_)
+    {
+        for (auto &desc : descriptors_)
+            desc->cancel();
+        self_.work_.reset();
+    }
 }
 }
 }
@@ -21,7 +21,8 @@
 #include "tools/bs2.hpp"
 #include "tools/service/ServiceRegistry.hpp"
 #include <boost/asio/io_service.hpp>
-#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <vector>
 
 namespace Leosac
 {
@@ -71,49 +72,68 @@ class AsioModule : public BaseModule
      */
     virtual void on_service_event(const service_event::Event &) = 0;
 
+    /**
+     * Register a socket whose activity should trigger a poll of the
+     * `reactor_`.
+     *
+     * The `control_` and `pipe_` sockets are always watched. Subclasses
+     * that add sockets to `reactor_` must also register them here,
+     * before `run()` is called.
+     */
+    void watch_zmq_socket(zmqpp::socket &sock);
+
   private:
     std::unique_ptr<boost::asio::io_service::work> work_;
     bs2::connection service_event_listener_;
+    std::vector<zmqpp::socket *> watched_sockets_;
 
     /**
-     * Install handlers that periodically poll for activity on the
-     * ZMQ reactor from BaseModule.
-     *
-     * While this impedes reactivity, it is the less complicated
-     * solution for now.
+     * Install the handlers that poll the ZMQ reactor from BaseModule
+     * when one of its sockets becomes readable.
      */
     void install_async_handlers();
 
-    struct StopWatcher : public std::enable_shared_from_this<StopWatcher>
-    {
-        StopWatcher(AsioModule &self)
-            : self_(self)
-            , timer_(self.io_service_){};
-
-        void schedule_wait();
-
-      private:
-        AsioModule &self_;
-        boost::asio::steady_timer timer_;
-        void wait(const boost::system::error_code &ec);
-    };
-
     /**
-     * Poll the zmq reactor from BaseModule.
+     * Integrates the zmq sockets of the `reactor_` into the asio event loop.
+     *
+     * The `ZMQ_FD` of each watched socket is monitored by the io_service.
+     * Those file descriptors are edge-triggered: they only signal that
+     * the socket state may have changed. When one of them fires, the
+     * reactor is polled until no socket has pending events.
+     *
+     * When the module stops (`is_running_` set to false by `handle_pipe()`),
+     * the watcher releases the io_service so that `run()` returns.
      */
     struct AsyncReactorPoller
         : public std::enable_shared_from_this<AsyncReactorPoller>
     {
-        AsyncReactorPoller(AsioModule &self)
-            : self_(self)
-            , timer_(self.io_service_){};
+        AsyncReactorPoller(AsioModule &self);
+
+        /**
+         * Release the descriptors. They are owned by zmq.
+         */
+        ~AsyncReactorPoller();
 
-        void schedule_wait();
+        void watch(zmqpp::socket &sock);
+
+        /**
+         * Process pending events and start waiting on the descriptors.
+         */
+        void start();
 
       private:
+        using Descriptor = boost::asio::posix::stream_descriptor;
+
         AsioModule &self_;
-        boost::asio::steady_timer timer_;
-        void wait_handler(const boost::system::error_code &ec);
+        std::vector<std::unique_ptr<Descriptor>> descriptors_;
+
+        void schedule_wait(Descriptor &desc);
+        void wait_handler(Descriptor &desc, const boost::system::error_code &ec);
+
+        /**
+         * Poll the reactor until all pending messages are handled.
+         */
+        void process();
     };
 };
 }
@@ -53,6 +53,11 @@ void BaseModule::run()
     }
 }
 
+bool BaseModule::handle_control_request(const std::string &, zmqpp::message &)
+{
+    return false;
+}
+
 void BaseModule::handle_pipe()
 {
     zmqpp::message msg;
@@ -116,7 +121,7 @@ void BaseModule::handle_control()
         dump_config(format, &response);
         control_.send(response);
     }
-    else
+    else if (!handle_control_request(frame1, msg))
     {
         ERROR("Module received invalid request (" << frame1 << "). Aborting.");
         assert(0);
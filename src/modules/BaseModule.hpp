@@ -140,6 +140,20 @@ class BaseModule
     */
     virtual void handle_control();
 
+    /**
+    * Handle a module specific request on the control socket.
+    *
+    * This is called by `handle_control()` for requests the base class
+    * doesn't know about. Implementation must send a response on `control_`.
+    *
+    * @param request The first frame of the request.
+    * @param msg The request message. Its first frame has already been read.
+    * @return false if the request is unknown. The default implementation
+    * always returns false.
+    */
+    virtual bool handle_control_request(const std::string &request,
+                                        zmqpp::message &msg);
+
     /**
     * Dump additional configuration (for example module specific
     * config file).
@@ -0,0 +1,516 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AuthDBCache.hpp"
+#include "core/audit/AuditEntry_odb.h"
+#include "core/audit/ICredentialEvent.hpp"
+#include "core/audit/IDoorEvent.hpp"
+#include "core/audit/IGroupEvent.hpp"
+#include "core/audit/IScheduleEvent.hpp"
+#include "core/audit/IUserEvent.hpp"
+#include "core/audit/IUserGroupMembershipEvent.hpp"
+#include "core/auth/Door_odb.h"
+#include "core/auth/Group_odb.h"
+#include "core/auth/UserGroupMembership_odb.h"
+#include "core/auth/User_odb.h"
+#include "core/credentials/Credential_odb.h"
+#include "core/credentials/PinCode.hpp"
+#include "core/credentials/RFIDCard.hpp"
+#include "core/credentials/RFIDCardPin.hpp"
+#include "tools/ScheduleMapping_odb.h"
+#include "tools/Schedule_odb.h"
+#include "tools/db/OptionalTransaction.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
+
+using namespace Leosac;
+using namespace Leosac::Module;
+using namespace Leosac::Module::Auth;
+
+namespace
+{
+/**
+ * Number of ids below a newly seen audit entry that may still be committed.
+ */
+constexpr Audit::AuditEntryId AUDIT_GAP_WINDOW = 64;
+
+/**
+ * How long a missing audit id is waited for before we assume its
+ * transaction was rolled back.
+ */
+constexpr std::chrono::seconds AUDIT_GAP_GRACE_PERIOD(60);
+}
+
+AuthDBCache::AuthDBCache(DBPtr database)
+    : database_(database)
+    , last_audit_id_(0)
+{
+}
+
+void AuthDBCache::load()
+{
+    using Query = odb::query<Audit::AuditEntry>;
+    State state;
+    Audit::AuditEntryId last_audit_id = 0;
+    std::map<Audit::AuditEntryId, std::chrono::steady_clock::time_point> gaps;
+
+    db::OptionalTransaction t(database_->begin());
+    // Read the last audit id first: changes committed while we load are
+    // replayed by the next sync(), which is harmless.
+    if (auto last_audit = Audit::AuditEntry::get_last_audit(database_))
+    {
+        last_audit_id = last_audit->id();
+        // Lower ids that are not visible yet may still be committed.
+        auto now   = std::chrono::steady_clock::now();
+        auto first = last_audit_id > AUDIT_GAP_WINDOW
+                         ? last_audit_id - AUDIT_GAP_WINDOW
+                         : Audit::AuditEntryId(0);
+        for (auto id = first + 1; id < last_audit_id; ++id)
+            gaps.emplace(id, now);
+        for (const auto &entry : database_->query<Audit::AuditEntry>(
+                 Query::id > first && Query::id < last_audit_id))
+            gaps.erase(entry.id());
+    }
+    for (const auto &user : database_->query<::Leosac::Auth::User>())
+        state.users[user.id()] = UserEntry{user.username(), user.validity(), {}};
+    for (const auto &membership :
+         database_->query<::Leosac::Auth::UserGroupMembership>())
+    {
+        auto user = state.users.find(membership.user_id());
+        if (user != state.users.end())
+            user->second.groups.insert(membership.group_id());
+    }
+    for (const auto &credential : database_->query<Cred::Credential>())
+    {
+        auto entry = make_credential(credential);
+        if (!entry.card_id.empty())
+            state.cards[entry.card_id] = credential.id();
+        if (!entry.pin_code.empty())
+            state.pin_codes.emplace(entry.pin_code, credential.id());
+        state.credentials[credential.id()] = std::move(entry);
+    }
+    for (const auto &schedule : database_->query<Tools::Schedule>())
+    {
+        state.schedules[schedule.id()] =
+            Tools::CompiledSchedule(schedule.timeframes());
+    }
+    for (const auto &mapping : database_->query<Tools::ScheduleMapping>())
+        state.mappings[mapping.id()] = make_mapping(mapping);
+    t.commit();
+
+    INFO("AuthDB cache loaded: " << state.users.size() << " users, "
+                                 << state.credentials.size() << " credentials, "
+                                 << state.mappings.size() << " mappings.");
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    state_         = std::move(state);
+    last_audit_id_ = last_audit_id;
+    audit_gaps_    = std::move(gaps);
+}
+
+size_t AuthDBCache::sync()
+{
+    using Query = odb::query<Audit::AuditEntry>;
+    std::vector<Audit::AuditEntryPtr> entries;
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto itr = audit_gaps_.begin(); itr != audit_gaps_.end();)
+    {
+        if (now - itr->second > AUDIT_GAP_GRACE_PERIOD)
+            itr = audit_gaps_.erase(itr);
+        else
+            ++itr;
+    }
+
+    Query query(Query::id > last_audit_id_);
+    if (!audit_gaps_.empty())
+    {
+        std::vector<Audit::AuditEntryId> gaps;
+        for (const auto &gap : audit_gaps_)
+            gaps.push_back(gap.first);
+        query = query || Query::id.in_range(gaps.begin(), gaps.end());
+    }
+
+    db::OptionalTransaction t(database_->begin());
+    auto result =
+        database_->query<Audit::AuditEntry>(query + "ORDER BY" + Query::id);
+    // load() returns the most derived type, which is what we dispatch on.
+    for (auto itr = result.begin(); itr != result.end(); ++itr)
+        entries.push_back(itr.load());
+    t.commit();
+
+    bool reload = false;
+    for (const auto &entry : entries)
+    {
+        auto id = entry->id();
+        if (id > last_audit_id_)
+        {
+            auto first = id > AUDIT_GAP_WINDOW ? id - AUDIT_GAP_WINDOW : 1;
+            for (auto gap = std::max(last_audit_id_ + 1, first); gap < id; ++gap)
+                audit_gaps_.emplace(gap, now);
+            last_audit_id_ = id;
+        }
+        else
+            audit_gaps_.erase(id);
+
+        if (!apply_audit(*entry))
+            reload = true;
+    }
+    if (reload)
+    {
+        INFO("AuthDB cache: an audit entry has no target, reloading.");
+        load();
+    }
+    return entries.size();
+}
+
+bool AuthDBCache::apply_audit(const Audit::AuditEntry &entry)
+{
+    if (auto event = dynamic_cast<const Audit::IUserEvent *>(&entry))
+    {
+        if (!event->target_id())
+            return false;
+        user_changed(event->target_id());
+    }
+    else if (auto event = dynamic_cast<const Audit::IGroupEvent *>(&entry))
+    {
+        if (!event->target_id())
+            return false;
+        group_changed(event->target_id());
+    }
+    else if (auto event =
+                 dynamic_cast<const Audit::IUserGroupMembershipEvent *>(&entry))
+    {
+        if (!event->target_group_id())
+            return false;
+        group_changed(event->target_group_id());
+    }
+    else if (auto event = dynamic_cast<const Audit::ICredentialEvent *>(&entry))
+    {
+        if (!event->target_id())
+            return false;
+        credential_changed(event->target_id());
+    }
+    else if (auto event = dynamic_cast<const Audit::IScheduleEvent *>(&entry))
+    {
+        if (!event->target_id())
+            return false;
+        schedule_changed(event->target_id());
+    }
+    else if (auto event = dynamic_cast<const Audit::IDoorEvent *>(&entry))
+    {
+        if (!event->target_id())
+            return false;
+        door_changed(event->target_id());
+    }
+    return true;
+}
+
+AuthDBCache::Decision
+AuthDBCache::check(const Cred::ICredential &credential,
+                   ::Leosac::Auth::DoorId door_id,
+                   const std::chrono::system_clock::time_point &tp) const
+{
+    const auto minute = Tools::CompiledSchedule::minute_of_week(tp);
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+
+    if (auto card_pin = dynamic_cast<const Cred::RFIDCardPin *>(&credential))
+    {
+        // The PIN code must belong to the owner of the card. A card
+        // without owner cannot be paired with a PIN code.
+        auto card_id = find_card(card_pin->card().card_id());
+        if (!card_id)
+            return Decision{false, 0, {}};
+        auto owner_id = state_.credentials.at(card_id).owner_id;
+        if (!owner_id)
+            return Decision{false, 0, {}};
+        auto pin_id = find_pin_code(card_pin->pin().pin_code(), owner_id);
+        if (!pin_id)
+            return Decision{false, 0, {}};
+        return decide({card_id, pin_id}, door_id, minute);
+    }
+    else if (auto card = dynamic_cast<const Cred::IRFIDCard *>(&credential))
+    {
+        if (auto id = find_card(card->card_id()))
+            return decide({id}, door_id, minute);
+    }
+    else if (auto pin = dynamic_cast<const Cred::IPinCode *>(&credential))
+    {
+        // A PIN code alone may match several users: grant access if
+        // any of them is allowed through.
+        Decision decision{false, 0, {}};
+        auto range = state_.pin_codes.equal_range(pin->pin_code());
+        for (auto itr = range.first; itr != range.second; ++itr)
+        {
+            decision = decide({itr->second}, door_id, minute);
+            if (decision.granted)
+                break;
+        }
+        return decision;
+    }
+    return Decision{false, 0, {}};
+}
+
+AuthDBCache::Decision
+AuthDBCache::decide(const std::vector<Cred::CredentialId> &credential_ids,
+                    ::Leosac::Auth::DoorId door_id, uint16_t minute_of_week) const
+{
+    for (const auto &id : credential_ids)
+    {
+        if (!state_.credentials.at(id).validity.is_valid())
+            return Decision{false, 0, {}};
+    }
+
+    auto owner_id = state_.credentials.at(credential_ids.front()).owner_id;
+    Decision decision{false, owner_id, {}};
+    if (owner_id)
+    {
+        auto owner = state_.users.find(owner_id);
+        // The owner was removed: its credentials are no longer usable.
+        if (owner == state_.users.end() || !owner->second.validity.is_valid())
+            return decision;
+        decision.username = owner->second.username;
+    }
+    decision.granted = is_granted(owner_id, credential_ids, door_id, minute_of_week);
+    return decision;
+}
+
+bool AuthDBCache::is_granted(::Leosac::Auth::UserId user_id,
+                             const std::vector<Cred::CredentialId> &credential_ids,
+                             ::Leosac::Auth::DoorId door_id,
+                             uint16_t minute_of_week) const
+{
+    const std::set<::Leosac::Auth::GroupId> *groups = nullptr;
+    auto user = state_.users.find(user_id);
+    if (user != state_.users.end())
+        groups = &user->second.groups;
+
+    for (const auto &id_mapping : state_.mappings)
+    {
+        const auto &mapping = id_mapping.second;
+        if (!mapping.doors.count(door_id))
+            continue;
+
+        bool mapped = user_id && mapping.users.count(user_id);
+        for (const auto &credential_id : credential_ids)
+            mapped = mapped || mapping.credentials.count(credential_id);
+        if (groups)
+        {
+            for (const auto &group_id : *groups)
+                mapped = mapped || mapping.groups.count(group_id);
+        }
+        if (!mapped)
+            continue;
+
+        auto schedule = state_.schedules.find(mapping.schedule_id);
+        if (schedule != state_.schedules.end() &&
+            schedule->second.is_in_schedule(minute_of_week))
+            return true;
+    }
+    return false;
+}
+
+void AuthDBCache::user_changed(::Leosac::Auth::UserId user_id)
+{
+    db::OptionalTransaction t(database_->begin());
+    auto user = database_->find<::Leosac::Auth::User>(user_id);
+    t.commit();
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    if (!user)
+    {
+        state_.users.erase(user_id);
+        for (auto &mapping : state_.mappings)
+            mapping.second.users.erase(user_id);
+        return;
+    }
+    // Memberships are kept: they are updated by group_changed().
+    auto &entry    = state_.users[user_id];
+    entry.username = user->username();
+    entry.validity = user->validity();
+}
+
+void AuthDBCache::group_changed(::Leosac::Auth::GroupId group_id)
+{
+    db::OptionalTransaction t(database_->begin());
+    auto group = database_->find<::Leosac::Auth::Group>(group_id);
+    std::set<::Leosac::Auth::UserId> members;
+    if (group)
+    {
+        for (const auto &membership : group->user_memberships())
+            members.insert(membership->user_id());
+    }
+    t.commit();
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    for (auto &user : state_.users)
+    {
+        if (members.count(user.first))
+            user.second.groups.insert(group_id);
+        else
+            user.second.groups.erase(group_id);
+    }
+    if (!group)
+    {
+        for (auto &mapping : state_.mappings)
+            mapping.second.groups.erase(group_id);
+    }
+}
+
+void AuthDBCache::credential_changed(Cred::CredentialId credential_id)
+{
+    db::OptionalTransaction t(database_->begin());
+    auto credential = database_->find<Cred::Credential>(credential_id);
+    t.commit();
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    erase_credential(credential_id);
+    if (credential)
+    {
+        store_credential(credential_id, make_credential(*credential));
+        return;
+    }
+    for (auto &mapping : state_.mappings)
+        mapping.second.credentials.erase(credential_id);
+}
+
+void AuthDBCache::schedule_changed(Tools::ScheduleId schedule_id)
+{
+    db::OptionalTransaction t(database_->begin());
+    auto schedule = database_->find<Tools::Schedule>(schedule_id);
+    std::map<Tools::ScheduleMappingId, Mapping> mappings;
+    Tools::CompiledSchedule compiled;
+    if (schedule)
+    {
+        compiled = Tools::CompiledSchedule(schedule->timeframes());
+        for (const auto &mapping_ptr : schedule->mapping())
+        {
+            auto mapping        = make_mapping(*mapping_ptr);
+            mapping.schedule_id = schedule_id;
+            mappings[mapping_ptr->id()] = std::move(mapping);
+        }
+    }
+    t.commit();
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    for (auto itr = state_.mappings.begin(); itr != state_.mappings.end();)
+    {
+        if (itr->second.schedule_id == schedule_id)
+            itr = state_.mappings.erase(itr);
+        else
+            ++itr;
+    }
+    state_.schedules.erase(schedule_id);
+    if (!schedule)
+        return;
+    state_.schedules[schedule_id] = std::move(compiled);
+    for (auto &mapping : mappings)
+        state_.mappings[mapping.first] = std::move(mapping.second);
+}
+
+void AuthDBCache::door_changed(::Leosac::Auth::DoorId door_id)
+{
+    db::OptionalTransaction t(database_->begin());
+    auto door = database_->find<::Leosac::Auth::Door>(door_id);
+    t.commit();
+
+    // Changes to a door's mappings are audited as schedule changes.
+    if (door)
+        return;
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    for (auto &mapping : state_.mappings)
+        mapping.second.doors.erase(door_id);
+}
+
+Cred::CredentialId AuthDBCache::find_card(const std::string &card_id) const
+{
+    auto id = state_.cards.find(card_id);
+    return id ? *id : 0;
+}
+
+Cred::CredentialId AuthDBCache::find_pin_code(const std::string &pin_code,
+                                              ::Leosac::Auth::UserId owner_id) const
+{
+    auto range = state_.pin_codes.equal_range(pin_code);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+        if (state_.credentials.at(itr->second).owner_id == owner_id)
+            return itr->second;
+    }
+    return 0;
+}
+
+void AuthDBCache::store_credential(Cred::CredentialId credential_id,
+                                   CredentialEntry entry)
+{
+    if (!entry.card_id.empty())
+        state_.cards[entry.card_id] = credential_id;
+    if (!entry.pin_code.empty())
+        state_.pin_codes.emplace(entry.pin_code, credential_id);
+    state_.credentials[credential_id] = std::move(entry);
+}
+
+void AuthDBCache::erase_credential(Cred::CredentialId credential_id)
+{
+    auto itr = state_.credentials.find(credential_id);
+    if (itr == state_.credentials.end())
+        return;
+
+    const auto &entry = itr->second;
+    if (!entry.card_id.empty() && find_card(entry.card_id) == credential_id)
+        state_.cards[entry.card_id] = 0;
+    auto range = state_.pin_codes.equal_range(entry.pin_code);
+    for (auto pin = range.first; pin != range.second; ++pin)
+    {
+        if (pin->second == credential_id)
+        {
+            state_.pin_codes.erase(pin);
+            break;
+        }
+    }
+    state_.credentials.erase(itr);
+}
+
+AuthDBCache::Mapping AuthDBCache::make_mapping(const Tools::ScheduleMapping &mapping)
+{
+    Mapping m;
+    m.schedule_id = mapping.schedule_id();
+    for (const auto &user : mapping.users())
+        m.users.insert(user.object_id());
+    for (const auto &group : mapping.groups())
+        m.groups.insert(group.object_id());
+    for (const auto &credential : mapping.credentials())
+        m.credentials.insert(credential.object_id());
+    for (const auto &door : mapping.doors())
+        m.doors.insert(door.object_id());
+    return m;
+}
+
+AuthDBCache::CredentialEntry
+AuthDBCache::make_credential(const Cred::Credential &credential)
+{
+    CredentialEntry entry;
+    entry.owner_id = credential.owner_id();
+    entry.validity = credential.validity();
+    if (auto card = dynamic_cast<const Cred::RFIDCard *>(&credential))
+        entry.card_id = card->card_id();
+    else if (auto pin = dynamic_cast<const Cred::PinCode *>(&credential))
+        entry.pin_code = pin->pin_code();
+    return entry;
+}
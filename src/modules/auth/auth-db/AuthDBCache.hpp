@@ -0,0 +1,227 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/audit/AuditFwd.hpp"
+#include "core/auth/AuthFwd.hpp"
+#include "core/auth/ValidityInfo.hpp"
+#include "core/credentials/CardTable.hpp"
+#include "core/credentials/CredentialFwd.hpp"
+#include "tools/CompiledSchedule.hpp"
+#include "tools/ToolsFwd.hpp"
+#include "tools/db/db_fwd.hpp"
+#include <chrono>
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace Auth
+{
+/**
+ * An in-memory copy of the part of the database that decides access.
+ *
+ * The cache holds credentials (indexed by card id and PIN code), users'
+ * validity and group memberships, schedule mappings and compiled
+ * schedules. An access decision is made from memory only.
+ *
+ * The cache is loaded once, then kept up to date by `sync()`, which reads
+ * the audit entries written since the previous call. Every modification
+ * made through the websocket API is audited: each relevant entry reloads
+ * the one entity it targets. When the target of an entry is unknown,
+ * the whole cache is reloaded.
+ *
+ * Database queries are performed without holding the lock: `check()` never
+ * waits for the database.
+ *
+ * Audit entries do not necessarily become visible in the order of their
+ * ids: a transaction may commit after another one that got a higher id.
+ * The ids that are skipped are watched for a grace period, and applied
+ * if they show up.
+ *
+ * @note `check()` is thread-safe. `load()` and `sync()` must not be
+ *       called concurrently.
+ */
+class AuthDBCache
+{
+  public:
+    struct Decision
+    {
+        bool granted;
+
+        /**
+         * The owner of the credential, or 0 if unknown.
+         */
+        ::Leosac::Auth::UserId user_id;
+
+        /**
+         * Username of the owner, may be empty.
+         */
+        std::string username;
+    };
+
+    explicit AuthDBCache(DBPtr database);
+
+    AuthDBCache(const AuthDBCache &) = delete;
+    AuthDBCache &operator=(const AuthDBCache &) = delete;
+
+    /**
+     * Load everything from the database, replacing the current content.
+     */
+    void load();
+
+    /**
+     * Apply the changes recorded in the audit log since the previous
+     * call to `sync()` or `load()`.
+     *
+     * Returns the number of audit entries that were applied.
+     */
+    size_t sync();
+
+    /**
+     * Is `credential` allowed through `door_id` at `tp` ?
+     *
+     * `credential` is a credential built from an auth source message:
+     * it is matched against the cached credentials by card id and/or
+     * PIN code.
+     */
+    Decision check(const Cred::ICredential &credential,
+                   ::Leosac::Auth::DoorId door_id,
+                   const std::chrono::system_clock::time_point &tp) const;
+
+    void user_changed(::Leosac::Auth::UserId user_id);
+    void group_changed(::Leosac::Auth::GroupId group_id);
+    void credential_changed(Cred::CredentialId credential_id);
+    void schedule_changed(Tools::ScheduleId schedule_id);
+    void door_changed(::Leosac::Auth::DoorId door_id);
+
+  private:
+    struct UserEntry
+    {
+        std::string username;
+        ::Leosac::Auth::ValidityInfo validity;
+        std::set<::Leosac::Auth::GroupId> groups;
+    };
+
+    struct CredentialEntry
+    {
+        ::Leosac::Auth::UserId owner_id;
+        ::Leosac::Auth::ValidityInfo validity;
+
+        /**
+         * Lookup keys, at most one of them is set.
+         */
+        std::string card_id;
+        std::string pin_code;
+    };
+
+    struct Mapping
+    {
+        Tools::ScheduleId schedule_id;
+        std::set<::Leosac::Auth::UserId> users;
+        std::set<::Leosac::Auth::GroupId> groups;
+        std::set<Cred::CredentialId> credentials;
+        std::set<::Leosac::Auth::DoorId> doors;
+    };
+
+    struct State
+    {
+        std::unordered_map<::Leosac::Auth::UserId, UserEntry> users;
+        std::unordered_map<Cred::CredentialId, CredentialEntry> credentials;
+
+        /**
+         * Card id to credential id. 0 marks a removed card: the table
+         * does not support removal.
+         */
+        Cred::CardTable<Cred::CredentialId> cards;
+
+        /**
+         * PIN code to credential ids. PIN codes are not unique: several
+         * users may share the same one.
+         */
+        std::unordered_multimap<std::string, Cred::CredentialId> pin_codes;
+
+        std::unordered_map<Tools::ScheduleId, Tools::CompiledSchedule> schedules;
+        std::map<Tools::ScheduleMappingId, Mapping> mappings;
+    };
+
+    /**
+     * Dispatch an audit entry to the matching `*_changed()` method.
+     *
+     * Returns false if the entry does not target a known entity.
+     */
+    bool apply_audit(const Audit::AuditEntry &entry);
+
+    /**
+     * Credential id of a card, or 0.
+     */
+    Cred::CredentialId find_card(const std::string &card_id) const;
+
+    /**
+     * Credential id of a PIN code owned by `owner_id`, or 0.
+     */
+    Cred::CredentialId find_pin_code(const std::string &pin_code,
+                                     ::Leosac::Auth::UserId owner_id) const;
+
+    /**
+     * Decide for a set of credentials that belong to the same owner.
+     */
+    Decision decide(const std::vector<Cred::CredentialId> &credential_ids,
+                    ::Leosac::Auth::DoorId door_id, uint16_t minute_of_week) const;
+
+    bool is_granted(::Leosac::Auth::UserId user_id,
+                    const std::vector<Cred::CredentialId> &credential_ids,
+                    ::Leosac::Auth::DoorId door_id, uint16_t minute_of_week) const;
+
+    /**
+     * Insert or replace a credential. Must be called with an exclusive lock.
+     */
+    void store_credential(Cred::CredentialId credential_id, CredentialEntry entry);
+    void erase_credential(Cred::CredentialId credential_id);
+
+    static Mapping make_mapping(const Tools::ScheduleMapping &mapping);
+    static CredentialEntry make_credential(const Cred::Credential &credential);
+
+    DBPtr database_;
+
+    mutable std::shared_timed_mutex mutex_;
+    State state_;
+
+    /**
+     * Id of the last audit entry that was applied.
+     */
+    Audit::AuditEntryId last_audit_id_;
+
+    /**
+     * Ids below `last_audit_id_` that were not visible yet, and when we
+     * started waiting for them.
+     */
+    std::map<Audit::AuditEntryId, std::chrono::steady_clock::time_point>
+        audit_gaps_;
+};
+}
+}
+}
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <memory>
+
 namespace Leosac
 {
 namespace Module
@@ -26,6 +28,12 @@ namespace Module
 namespace Auth
 {
 using AuthDBInstanceId = unsigned long long;
+
+class AuthDBInstance;
+using AuthDBInstancePtr = std::shared_ptr<AuthDBInstance>;
+
+class AuthDBCache;
+using AuthDBCachePtr = std::shared_ptr<AuthDBCache>;
 }
 }
 }
@@ -3,3 +3,96 @@
 //
 
 #include "AuthDBInstance.hpp"
+#include "AuthDBCache.hpp"
+#include "core/auth/Auth.hpp"
+#include "core/auth/AuthSourceBuilder.hpp"
+#include "core/auth/Door.hpp"
+#include "tools/Colorize.hpp"
+#include "tools/log.hpp"
+#include <boost/algorithm/string/join.hpp>
+#include <chrono>
+
+using namespace Leosac;
+using namespace Leosac::Module::Auth;
+
+AuthDBInstance::AuthDBInstance()
+    : id_(0)
+    , odb_version_(0)
+    , door_id_(0)
+{
+}
+
+AuthDBInstance::AuthDBInstance(zmqpp::context &ctx, const std::string &auth_ctx_name,
+                               const std::list<std::string> &auth_sources_names,
+                               ::Leosac::Auth::DoorPtr door, AuthDBCachePtr cache)
+    : id_(0)
+    , door_(door)
+    , odb_version_(0)
+    , name_(auth_ctx_name)
+    , door_alias_(door->alias())
+    , door_id_(door->id())
+    , cache_(cache)
+    , bus_push_(std::make_unique<zmqpp::socket>(ctx, zmqpp::socket_type::push))
+    , bus_sub_(std::make_unique<zmqpp::socket>(ctx, zmqpp::socket_type::sub))
+{
+    bus_push_->connect("inproc://zmq-bus-pull");
+    bus_sub_->connect("inproc://zmq-bus-pub");
+
+    INFO("AuthDB instance (" << auth_ctx_name << ") subscribe to "
+                             << boost::algorithm::join(auth_sources_names, ", "));
+    for (const auto &auth_source : auth_sources_names)
+        bus_sub_->subscribe("S_" + auth_source);
+}
+
+AuthDBInstance::~AuthDBInstance()
+{
+}
+
+void AuthDBInstance::handle_bus_msg()
+{
+    zmqpp::message msg;
+    zmqpp::message auth_result_msg;
+
+    bus_sub_->receive(msg);
+    auth_result_msg << ("S_" + name_);
+
+    AuthDBCache::Decision decision{false, 0, {}};
+    try
+    {
+        ::Leosac::Auth::AuthSourceBuilder build;
+        Cred::ICredentialPtr auth_source = build.create(&msg);
+        decision = cache_->check(*auth_source, door_id_,
+                                 std::chrono::system_clock::now());
+    }
+    catch (const std::exception &e)
+    {
+        ERROR("Exception while processing authentication request: " << e.what());
+    }
+
+    std::string log_user;
+    if (!decision.username.empty())
+        log_user = Colorize::green(decision.username);
+    else
+        log_user = Colorize::red("UNKNOWN_USER");
+
+    if (decision.granted)
+    {
+        auth_result_msg << Leosac::Auth::AccessStatus::GRANTED;
+        INFO(Colorize::bold(name_)
+             << " " << Colorize::green("GRANTED") << " access to target "
+             << Colorize::underline(door_alias_) << " for " << log_user);
+    }
+    else
+    {
+        auth_result_msg << Leosac::Auth::AccessStatus::DENIED;
+        INFO(Colorize::bold(name_)
+             << " " << Colorize::red("DENIED") << " access to target "
+             << Colorize::underline(door_alias_) << " for " << log_user);
+    }
+    bus_push_->send(auth_result_msg);
+}
+
+zmqpp::socket &AuthDBInstance::bus_sub()
+{
+    return *bus_sub_;
+}
@@ -21,6 +21,10 @@
 
 #include "core/auth/AuthFwd.hpp"
 #include "modules/auth/auth-db/AuthDBFwd.hpp"
+#include <list>
+#include <memory>
+#include <string>
+#include <zmqpp/zmqpp.hpp>
 
 namespace Leosac
 {
@@ -31,11 +35,48 @@ namespace Auth
 /**
  * An instance of authentication handler that use the database
  * to verify credentials and permissions.
+ *
+ * Requests from the auth sources are answered from an AuthDBCache,
+ * shared by all instances of the module: handling a request never
+ * queries the database.
  */
 #pragma db object optimistic
 class AuthDBInstance
 {
+  public:
+    /**
+     * Create an instance that answers the requests of `auth_sources_names`
+     * for `door`.
+     *
+     * @param ctx the ZeroMQ context
+     * @param auth_ctx_name name of this authentication context.
+     * @param auth_sources_names names of the sources devices we watch (ie wiegand
+     * reader).
+     * @param door the door we authenticate against.
+     * @param cache the cache used to make access decisions.
+     */
+    AuthDBInstance(zmqpp::context &ctx, const std::string &auth_ctx_name,
+                   const std::list<std::string> &auth_sources_names,
+                   ::Leosac::Auth::DoorPtr door, AuthDBCachePtr cache);
+
+    ~AuthDBInstance();
+
+    AuthDBInstance(const AuthDBInstance &) = delete;
+    AuthDBInstance &operator=(const AuthDBInstance &) = delete;
+
+    /**
+     * Something happened on the bus that we have interest into.
+     */
+    void handle_bus_msg();
+
+    /**
+     * Returns the socket subscribed to the message bus.
+     */
+    zmqpp::socket &bus_sub();
+
   private:
+    AuthDBInstance();
+
 #pragma db id auto
     AuthDBInstanceId id_;
 
@@ -47,6 +88,29 @@ class AuthDBInstance
 #pragma db version
     size_t odb_version_;
 
+#pragma db transient
+    std::string name_;
+
+#pragma db transient
+    std::string door_alias_;
+
+#pragma db transient
+    ::Leosac::Auth::DoorId door_id_;
+
+#pragma db transient
+    AuthDBCachePtr cache_;
+
+    /**
+     * Socket to write to the bus. Null for objects loaded by ODB.
+     */
+#pragma db transient
+    std::unique_ptr<zmqpp::socket> bus_push_;
+
+    /**
+     * Socket to read from the bus. Null for objects loaded by ODB.
+     */
+#pragma db transient
+    std::unique_ptr<zmqpp::socket> bus_sub_;
 
     friend odb::access;
 
@@ -19,7 +19,13 @@
 
 #include "modules/auth/auth-db/AuthDBModule.hpp"
 #include "core/CoreUtils.hpp"
+#include "core/Scheduler.hpp"
+#include "core/auth/Door_odb.h"
 #include "core/kernel.hpp"
+#include "exception/moduleexception.hpp"
+#include "modules/auth/auth-db/AuthDBCache.hpp"
+#include "modules/auth/auth-db/AuthDBInstance.hpp"
+#include "tools/db/OptionalTransaction.hpp"
 #include <tools/db/database.hpp>
 
 using namespace Leosac;
@@ -29,14 +35,17 @@ AuthDBModule::AuthDBModule(zmqpp::context &ctx, zmqpp::socket *pipe,
                            const boost::property_tree::ptree &cfg,
                            CoreUtilsPtr utils)
     : AsioModule(ctx, pipe, cfg, utils)
+    , sync_timer_(io_service_)
 {
     process_config();
 
-    /*   for (auto authenticator : authenticators_)
-       {
-           reactor_.add(authenticator->bus_sub(),
-                        std::bind(&AuthDBInstance::handle_bus_msg, authenticator));
-       }*/
+    for (auto authenticator : authenticators_)
+    {
+        reactor_.add(authenticator->bus_sub(),
+                     std::bind(&AuthDBInstance::handle_bus_msg, authenticator));
+        watch_zmq_socket(authenticator->bus_sub());
+    }
+    schedule_sync();
 }
 
 AuthDBModule::~AuthDBModule()
@@ -46,16 +55,92 @@ AuthDBModule::~AuthDBModule()
 void AuthDBModule::process_config()
 {
     setup_database();
+
+    boost::property_tree::ptree module_config;
+    if (auto child = config_.get_child_optional("module_config"))
+        module_config = *child;
+    sync_interval_ =
+        std::chrono::milliseconds(module_config.get<int>("sync_interval", 1000));
+
+    auto database = utils_->database();
+    cache_        = std::make_shared<AuthDBCache>(database);
+    cache_->load();
+
+    auto instances = module_config.get_child_optional("instances");
+    if (!instances)
+        return;
+    for (auto &node : *instances)
+    {
+        boost::property_tree::ptree auth_instance_cfg = node.second;
+        std::string auth_ctx_name = auth_instance_cfg.get_child("name").data();
+        std::string door_alias    = auth_instance_cfg.get_child("door").data();
+        std::list<std::string> auth_sources_names;
+
+        for (const auto &subnode : auth_instance_cfg)
+        {
+            if (subnode.first == "auth_source")
+                auth_sources_names.push_back(subnode.second.data());
+        }
+
+        using Query = odb::query<::Leosac::Auth::Door>;
+        db::OptionalTransaction t(database->begin());
+        auto door =
+            database->query_one<::Leosac::Auth::Door>(Query::alias == door_alias);
+        t.commit();
+        if (!door)
+            throw ModuleException("AuthDB: no door with alias " + door_alias);
+
+        INFO("Creating AuthDB instance " << auth_ctx_name
+                                         << ". Target door = " << door_alias);
+        authenticators_.push_back(std::make_shared<AuthDBInstance>(
+            ctx_, auth_ctx_name, auth_sources_names, door, cache_));
+    }
 }
 
 void AuthDBModule::on_service_event(const service_event::Event &)
 {
 }
 
+void AuthDBModule::schedule_sync()
+{
+    sync_timer_.expires_from_now(sync_interval_);
+    sync_timer_.async_wait([this](const boost::system::error_code &ec) {
+        if (ec)
+            return;
+        sync_cache();
+        schedule_sync();
+    });
+}
+
+void AuthDBModule::sync_cache()
+{
+    if (sync_done_.valid() &&
+        sync_done_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    // The task owns a reference to the cache: it may outlive the module.
+    auto cache = cache_;
+    sync_done_ = utils_->scheduler().enqueue(
+        [cache]() {
+            try
+            {
+                cache->sync();
+            }
+            catch (const std::exception &e)
+            {
+                WARN("Failed to synchronize the AuthDB cache: " << e.what());
+            }
+            return true;
+        },
+        TargetThread::POOL);
+}
+
 void AuthDBModule::setup_database()
 {
     using namespace odb;
     using namespace odb::core;
+    // Schema creation and migration must not run concurrently.
+    std::lock_guard<std::mutex> guard(utils_->setup_mutex());
     auto db          = utils_->database();
     schema_version v = db->schema_version("module_auth-db");
     schema_version cv(schema_catalog::current_version(*db, "module_auth-db"));
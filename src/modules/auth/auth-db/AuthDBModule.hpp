@@ -20,7 +20,11 @@
 #pragma once
 
 #include "modules/AsioModule.hpp"
+#include "modules/auth/auth-db/AuthDBFwd.hpp"
+#include <boost/asio/steady_timer.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <future>
 #include <vector>
 #include <zmqpp/zmqpp.hpp>
 
@@ -30,11 +34,13 @@ namespace Module
 {
 namespace Auth
 {
-class AuthDBInstance;
-
 /**
 * This implements a authentication module that uses Leosac database
 * to validate access.
+*
+* Decisions are made from an AuthDBCache, loaded when the module starts.
+* The cache is refreshed from the audit log every `sync_interval`
+* milliseconds, on the thread pool.
 */
 class AuthDBModule : public AsioModule
 {
@@ -54,10 +60,32 @@ class AuthDBModule : public AsioModule
 
     void setup_database();
 
+    /**
+     * Arm the timer for the next synchronization of the cache.
+     */
+    void schedule_sync();
+
+    /**
+     * Enqueue a synchronization of the cache, unless the previous one
+     * is still running.
+     */
+    void sync_cache();
+
+    AuthDBCachePtr cache_;
+
+    std::chrono::milliseconds sync_interval_;
+
+    boost::asio::steady_timer sync_timer_;
+
+    /**
+     * Completion of the last synchronization task.
+     */
+    std::shared_future<bool> sync_done_;
+
     /**
     * Authenticator instance.
     */
-    // std::vector<AuthDBInstancePtr> authenticators_;
+    std::vector<AuthDBInstancePtr> authenticators_;
 };
 }
 }
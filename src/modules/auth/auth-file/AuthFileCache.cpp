@@ -0,0 +1,470 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AuthFileCache.hpp"
+#include "tools/log.hpp"
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+using namespace Leosac;
+using namespace Leosac::Module::Auth;
+
+constexpr uint32_t AuthFileCache::VERSION;
+
+namespace
+{
+using Data = AuthFileData;
+
+/**
+ * Fixed size header of the cache file. The encoded AuthFileData follows.
+ */
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_size;
+    int64_t source_mtime_ns;
+    uint64_t source_hash;
+    uint64_t body_size;
+};
+static_assert(std::is_trivially_copyable<Header>::value, "Header is copied raw");
+
+constexpr char MAGIC[8]            = {'L', 'S', 'A', 'C', 'A', 'U', 'T', 'H'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/**
+ * Read-only mapping of a whole file.
+ */
+class MappedFile
+{
+  public:
+    explicit MappedFile(const std::string &path)
+        : data_(nullptr)
+        , size_(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open " + path + ": " +
+                                     std::strerror(errno));
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            size_   = static_cast<size_t>(st.st_size);
+            void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            data_   = p == MAP_FAILED ? nullptr : static_cast<const char *>(p);
+        }
+        ::close(fd);
+        if (size_ && !data_)
+            throw std::runtime_error("Cannot map " + path);
+    }
+
+    ~MappedFile()
+    {
+        if (data_)
+            ::munmap(const_cast<char *>(data_), size_);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    const char *data_;
+    size_t size_;
+};
+
+class Encoder
+{
+  public:
+    template <typename T>
+    void pod(const T &value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                      "Not a scalar");
+        buf_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void str(const std::string &s)
+    {
+        pod(static_cast<uint32_t>(s.size()));
+        buf_.append(s);
+    }
+
+    void strs(const std::vector<std::string> &v)
+    {
+        pod(static_cast<uint32_t>(v.size()));
+        for (const auto &s : v)
+            str(s);
+    }
+
+    template <typename T, typename F>
+    void records(const std::vector<T> &v, F &&encode_one)
+    {
+        pod(static_cast<uint32_t>(v.size()));
+        for (const auto &record : v)
+            encode_one(record);
+    }
+
+    const std::string &buffer() const
+    {
+        return buf_;
+    }
+
+  private:
+    std::string buf_;
+};
+
+class Decoder
+{
+  public:
+    Decoder(const char *begin, const char *end)
+        : cur_(begin)
+        , end_(end)
+    {
+    }
+
+    template <typename T>
+    void pod(T &value)
+    {
+        need(sizeof(value));
+        std::memcpy(&value, cur_, sizeof(value));
+        cur_ += sizeof(value);
+    }
+
+    void str(std::string &s)
+    {
+        uint32_t size;
+        pod(size);
+        need(size);
+        s.assign(cur_, size);
+        cur_ += size;
+    }
+
+    void strs(std::vector<std::string> &v)
+    {
+        uint32_t count;
+        pod(count);
+        v.resize(count);
+        for (auto &s : v)
+            str(s);
+    }
+
+    template <typename T, typename F>
+    void records(std::vector<T> &v, F &&decode_one)
+    {
+        uint32_t count;
+        pod(count);
+        // Every record takes at least one byte: this bounds the allocation
+        // if the count is garbage.
+        need(count);
+        v.resize(count);
+        for (auto &record : v)
+            decode_one(record);
+    }
+
+    bool done() const
+    {
+        return cur_ == end_;
+    }
+
+  private:
+    void need(size_t n) const
+    {
+        if (static_cast<size_t>(end_ - cur_) < n)
+            throw std::runtime_error("Truncated auth file cache.");
+    }
+
+    const char *cur_;
+    const char *end_;
+};
+
+void encode(Encoder &e, const Data::Validity &v)
+{
+    e.str(v.start);
+    e.str(v.end);
+    e.pod(static_cast<uint8_t>(v.enabled));
+}
+
+void decode(Decoder &d, Data::Validity &v)
+{
+    uint8_t enabled;
+    d.str(v.start);
+    d.str(v.end);
+    d.pod(enabled);
+    v.enabled = enabled;
+}
+
+std::string encode(const Data &data)
+{
+    Encoder e;
+    e.records(data.users, [&](const Data::User &u) {
+        e.str(u.name);
+        e.str(u.firstname);
+        e.str(u.lastname);
+        e.str(u.email);
+        encode(e, u.validity);
+    });
+    e.records(data.groups, [&](const Data::Group &g) {
+        e.str(g.name);
+        e.strs(g.members);
+    });
+    e.records(data.credentials, [&](const Data::Credential &c) {
+        e.pod(c.type);
+        e.str(c.owner);
+        e.str(c.alias);
+        e.str(c.card_id);
+        e.pod(c.bits);
+        e.str(c.pin);
+        encode(e, c.validity);
+    });
+    e.records(data.schedules, [&](const Data::Schedule &s) {
+        e.str(s.name);
+        e.records(s.timeframes, [&](const Data::TimeFrame &tf) {
+            e.pod(tf.day);
+            e.pod(tf.start_hour);
+            e.pod(tf.start_min);
+            e.pod(tf.end_hour);
+            e.pod(tf.end_min);
+        });
+    });
+    e.records(data.mappings, [&](const Data::Mapping &m) {
+        e.str(m.door);
+        e.strs(m.schedules);
+        e.strs(m.users);
+        e.strs(m.groups);
+        e.strs(m.credentials);
+    });
+    return e.buffer();
+}
+
+Data decode(const char *begin, const char *end)
+{
+    Decoder d(begin, end);
+    Data data;
+    d.records(data.users, [&](Data::User &u) {
+        d.str(u.name);
+        d.str(u.firstname);
+        d.str(u.lastname);
+        d.str(u.email);
+        decode(d, u.validity);
+    });
+    d.records(data.groups, [&](Data::Group &g) {
+        d.str(g.name);
+        d.strs(g.members);
+    });
+    d.records(data.credentials, [&](Data::Credential &c) {
+        d.pod(c.type);
+        if (c.type > Data::Credential::Type::WIEGAND_CARD_PIN)
+            throw std::runtime_error("Invalid credential type in auth file cache.");
+        d.str(c.owner);
+        d.str(c.alias);
+        d.str(c.card_id);
+        d.pod(c.bits);
+        d.str(c.pin);
+        decode(d, c.validity);
+    });
+    d.records(data.schedules, [&](Data::Schedule &s) {
+        d.str(s.name);
+        d.records(s.timeframes, [&](Data::TimeFrame &tf) {
+            d.pod(tf.day);
+            d.pod(tf.start_hour);
+            d.pod(tf.start_min);
+            d.pod(tf.end_hour);
+            d.pod(tf.end_min);
+        });
+    });
+    d.records(data.mappings, [&](Data::Mapping &m) {
+        d.str(m.door);
+        d.strs(m.schedules);
+        d.strs(m.users);
+        d.strs(m.groups);
+        d.strs(m.credentials);
+    });
+    if (!d.done())
+        throw std::runtime_error("Trailing data in auth file cache.");
+    return data;
+}
+
+/**
+ * Size and modification time of a file, or nothing if it cannot be stat'ed.
+ */
+boost::optional<AuthFileCache::SourceInfo> stat_file(const std::string &path)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return boost::none;
+
+    AuthFileCache::SourceInfo info;
+    info.size     = static_cast<uint64_t>(st.st_size);
+    info.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                    st.st_mtim.tv_nsec;
+    return info;
+}
+}
+
+AuthFileCache::AuthFileCache(const std::string &cache_path)
+    : cache_path_(cache_path)
+{
+}
+
+AuthFileData AuthFileCache::load(const std::string &source_path) const
+{
+    auto source = stat_file(source_path);
+    if (!source)
+    {
+        // Let the parser report the problem.
+        return AuthFileData::from_xml(source_path);
+    }
+
+    auto try_write = [&](const AuthFileData &data) {
+        try
+        {
+            write(*source, data);
+        }
+        catch (const std::exception &e)
+        {
+            WARN("Cannot write auth file cache " << cache_path_ << ": "
+                                                 << e.what());
+        }
+    };
+
+    boost::optional<AuthFileData> cached;
+    try
+    {
+        cached = read(source_path, *source);
+    }
+    catch (const std::exception &e)
+    {
+        WARN("Ignoring auth file cache " << cache_path_ << ": " << e.what());
+    }
+    if (cached)
+    {
+        INFO("Loaded auth file " << source_path << " from cache " << cache_path_);
+        // The file was hashed because its modification time changed:
+        // record the new one, so we don't hash it again next time.
+        if (source->hash)
+            try_write(*cached);
+        return std::move(*cached);
+    }
+
+    INFO("Auth file cache " << cache_path_ << " is out of date. Parsing "
+                            << source_path);
+    if (!source->hash)
+        source->hash = hash_file(source_path);
+    auto data = AuthFileData::from_xml(source_path);
+    try_write(data);
+    return data;
+}
+
+uint64_t AuthFileCache::hash_file(const std::string &path)
+{
+    MappedFile file(path);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < file.size(); ++i)
+    {
+        hash ^= static_cast<unsigned char>(file.data()[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+boost::optional<AuthFileData> AuthFileCache::read(const std::string &source_path,
+                                                  SourceInfo &source) const
+{
+    if (::access(cache_path_.c_str(), F_OK) != 0)
+        return boost::none;
+
+    MappedFile cache(cache_path_);
+    Header header;
+    if (cache.size() < sizeof(header))
+        throw std::runtime_error("Truncated auth file cache.");
+    std::memcpy(&header, cache.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("Not an auth file cache.");
+    if (header.version != VERSION || header.byte_order != BYTE_ORDER_MARK)
+        return boost::none;
+    if (header.body_size != cache.size() - sizeof(header))
+        throw std::runtime_error("Truncated auth file cache.");
+
+    if (header.source_size != source.size)
+        return boost::none;
+    if (header.source_mtime_ns != source.mtime_ns)
+    {
+        // The file was touched, or rewritten with the same size.
+        if (!source.hash)
+            source.hash = hash_file(source_path);
+        if (*source.hash != header.source_hash)
+            return boost::none;
+    }
+
+    const char *body = cache.data() + sizeof(header);
+    return decode(body, body + header.body_size);
+}
+
+void AuthFileCache::write(const SourceInfo &source, const AuthFileData &data) const
+{
+    assert(source.hash);
+    auto body = encode(data);
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version         = VERSION;
+    header.byte_order      = BYTE_ORDER_MARK;
+    header.source_size     = source.size;
+    header.source_mtime_ns = source.mtime_ns;
+    header.source_hash     = *source.hash;
+    header.body_size       = body.size();
+
+    // Write then rename, so that a concurrent reader, or a crash, never
+    // sees a partial file.
+    auto tmp_path = cache_path_ + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        ofs.write(body.data(), body.size());
+        if (!ofs)
+            throw std::runtime_error("Cannot write " + tmp_path);
+    }
+    if (std::rename(tmp_path.c_str(), cache_path_.c_str()) != 0)
+        throw std::runtime_error("Cannot rename " + tmp_path + ": " +
+                                 std::strerror(errno));
+}
@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "AuthFileData.hpp"
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <string>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace Auth
+{
+/**
+ * Binary cache of a parsed auth file.
+ *
+ * Parsing a big XML auth file takes a while, and happens on startup and
+ * on each reload. The cache stores the resulting AuthFileData in a flat
+ * binary file, that is memory mapped and decoded in a single pass.
+ *
+ * The XML file remains the source of truth: the cache records the size,
+ * modification time and hash of the file it was built from, and is only
+ * used if it still matches. If only the modification time changed, the
+ * file is hashed to tell whether its content changed.
+ *
+ * The cache file is written in native byte order, and starts with
+ * a format version. A cache written by another version, or on another
+ * architecture, is ignored and rebuilt.
+ */
+class AuthFileCache
+{
+  public:
+    /**
+     * Bumped whenever the layout of the cache file, or AuthFileData,
+     * changes.
+     */
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @param cache_path Path of the cache file. It is created when needed.
+     */
+    explicit AuthFileCache(const std::string &cache_path);
+
+    /**
+     * Retrieve the content of the auth file at `source_path`.
+     *
+     * The cache is used if it is up to date. Otherwise, the XML file is
+     * parsed and the cache is rewritten.
+     *
+     * Throws if the XML file has to be parsed and is invalid. Problems with
+     * the cache file itself are only logged.
+     */
+    AuthFileData load(const std::string &source_path) const;
+
+    /**
+     * Identify the content of a source file.
+     */
+    struct SourceInfo
+    {
+        uint64_t size;
+        int64_t mtime_ns;
+
+        /**
+         * Only computed when needed, because it requires reading the
+         * whole file.
+         */
+        boost::optional<uint64_t> hash;
+    };
+
+    /**
+     * Hash of a file content (FNV-1a, 64 bits).
+     */
+    static uint64_t hash_file(const std::string &path);
+
+  private:
+    /**
+     * Decode the cache file, if it matches `source`.
+     *
+     * Throws if the cache file is corrupted.
+     */
+    boost::optional<AuthFileData> read(const std::string &source_path,
+                                       SourceInfo &source) const;
+
+    void write(const SourceInfo &source, const AuthFileData &data) const;
+
+    std::string cache_path_;
+};
+}
+}
+}
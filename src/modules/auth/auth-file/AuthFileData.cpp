@@ -0,0 +1,266 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AuthFileData.hpp"
+#include "XmlRecordStream.hpp"
+#include "exception/configexception.hpp"
+#include "exception/moduleexception.hpp"
+#include "tools/XmlNodeNameEnforcer.hpp"
+#include "tools/XmlScheduleLoader.hpp"
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <tuple>
+
+using namespace Leosac;
+using namespace Leosac::Module::Auth;
+
+namespace
+{
+using boost::property_tree::ptree;
+
+AuthFileData::Validity parse_validity(const ptree &node)
+{
+    AuthFileData::Validity v;
+    v.start   = node.get<std::string>("validity_start", "");
+    v.end     = node.get<std::string>("validity_end", "");
+    v.enabled = node.get<bool>("enabled", true);
+    return v;
+}
+
+/**
+ * Parse a "HH:MM" time.
+ */
+void parse_time(const std::string &str, int32_t &hour, int32_t &min)
+{
+    std::vector<std::string> temp;
+    boost::split(temp, str, boost::is_any_of(":"));
+    if (temp.size() != 2)
+        throw ModuleException("AuthFail schedule building error.");
+    hour = std::stoi(temp[0]);
+    min  = std::stoi(temp[1]);
+}
+
+AuthFileData::User parse_user(const ptree &node)
+{
+    AuthFileData::User u;
+    u.name      = node.get<std::string>("name");
+    u.firstname = node.get<std::string>("firstname", "");
+    u.lastname  = node.get<std::string>("lastname", "");
+    u.email     = node.get<std::string>("email", "");
+    u.validity  = parse_validity(node);
+    return u;
+}
+
+AuthFileData::Group parse_group(const ptree &node)
+{
+    AuthFileData::Group g;
+    g.name = node.get<std::string>("group");
+    for (const auto &membership : node)
+    {
+        if (membership.first == "user")
+            g.members.push_back(membership.second.data());
+    }
+    return g;
+}
+
+AuthFileData::Credential parse_credential(const std::string &path,
+                                          const ptree &mapping)
+{
+    using Type = AuthFileData::Credential::Type;
+
+    AuthFileData::Credential c;
+    c.owner = mapping.get<std::string>("user");
+    c.bits  = 0;
+
+    const ptree *node;
+    if (auto card = mapping.get_child_optional("WiegandCard"))
+    {
+        node      = &*card;
+        c.type    = Type::WIEGAND_CARD;
+        c.card_id = node->get<std::string>("card_id");
+        c.bits    = node->get<int>("bits");
+    }
+    else if (auto pin = mapping.get_child_optional("PINCode"))
+    {
+        node   = &*pin;
+        c.type = Type::PIN_CODE;
+        c.pin  = node->get<std::string>("pin");
+    }
+    else if (auto card_pin = mapping.get_child_optional("WiegandCardPin"))
+    {
+        node      = &*card_pin;
+        c.type    = Type::WIEGAND_CARD_PIN;
+        c.card_id = node->get<std::string>("card_id");
+        c.pin     = node->get<std::string>("pin");
+        c.bits    = node->get<int>("bits");
+    }
+    else
+    {
+        throw ConfigException(path, "Unknown credential type for user " +
+                                        c.owner);
+    }
+    c.alias    = node->get<std::string>("id", "");
+    c.validity = parse_validity(*node);
+    return c;
+}
+
+AuthFileData::Schedule parse_schedule(const ptree &node)
+{
+    AuthFileData::Schedule s;
+    s.name = node.get<std::string>("name");
+    for (const auto &sched_data : node)
+    {
+        if (sched_data.first == "name")
+            continue;
+        AuthFileData::TimeFrame tf;
+        tf.day = Tools::XmlScheduleLoader::week_day_to_int(sched_data.first);
+        parse_time(sched_data.second.get<std::string>("start"), tf.start_hour,
+                   tf.start_min);
+        parse_time(sched_data.second.get<std::string>("end"), tf.end_hour,
+                   tf.end_min);
+        s.timeframes.push_back(tf);
+    }
+    return s;
+}
+
+AuthFileData::Mapping parse_mapping(const ptree &node)
+{
+    AuthFileData::Mapping m;
+    m.door = node.get<std::string>("door", "");
+    for (const auto &mapping_data : node)
+    {
+        if (mapping_data.first == "schedule")
+            m.schedules.push_back(mapping_data.second.data());
+        else if (mapping_data.first == "user")
+            m.users.push_back(mapping_data.second.data());
+        else if (mapping_data.first == "group")
+            m.groups.push_back(mapping_data.second.data());
+        else if (mapping_data.first == "credential")
+            m.credentials.push_back(mapping_data.second.data());
+    }
+    return m;
+}
+}
+
+AuthFileData AuthFileData::from_xml(const std::string &path)
+{
+    Tools::XmlNodeNameEnforcer xmlnne(path);
+    AuthFileData data;
+
+    // Records are the children of the sections (<users>, <credentials>, ...),
+    // which are themselves children of <root>.
+    auto on_record = [&](const std::vector<std::string> &ancestors,
+                         const std::string &name, const ptree &node) {
+        if (ancestors[0] != "root")
+            return;
+        const std::string &section = ancestors[1];
+
+        if (section == "users")
+        {
+            xmlnne("user", name);
+            data.users.push_back(parse_user(node));
+        }
+        else if (section == "group_mapping")
+        {
+            xmlnne("map", name);
+            data.groups.push_back(parse_group(node));
+        }
+        else if (section == "credentials")
+        {
+            xmlnne("map", name);
+            data.credentials.push_back(parse_credential(path, node));
+        }
+        else if (section == "schedules")
+        {
+            if (name != "schedule")
+            {
+                throw ConfigException(path,
+                                      "Expected a XML node named 'schedule' but "
+                                      "found " +
+                                          name + " instead.");
+            }
+            data.schedules.push_back(parse_schedule(node));
+        }
+        else if (section == "schedules_mapping")
+        {
+            xmlnne("map", name);
+            data.mappings.push_back(parse_mapping(node));
+        }
+    };
+
+    auto root = streamXmlRecords(path, 3, on_record);
+    if (root != "root")
+    {
+        throw ConfigException(path, "Expected a XML root node named 'root' but "
+                                    "found " +
+                                        root + " instead.");
+    }
+    return data;
+}
+
+namespace Leosac
+{
+namespace Module
+{
+namespace Auth
+{
+bool operator==(const AuthFileData::Validity &a, const AuthFileData::Validity &b)
+{
+    return std::tie(a.start, a.end, a.enabled) ==
+           std::tie(b.start, b.end, b.enabled);
+}
+
+bool operator==(const AuthFileData::User &a, const AuthFileData::User &b)
+{
+    return std::tie(a.name, a.firstname, a.lastname, a.email, a.validity) ==
+           std::tie(b.name, b.firstname, b.lastname, b.email, b.validity);
+}
+
+bool operator==(const AuthFileData::Group &a, const AuthFileData::Group &b)
+{
+    return std::tie(a.name, a.members) == std::tie(b.name, b.members);
+}
+
+bool operator==(const AuthFileData::Credential &a,
+                const AuthFileData::Credential &b)
+{
+    return std::tie(a.type, a.owner, a.alias, a.card_id, a.bits, a.pin,
+                    a.validity) == std::tie(b.type, b.owner, b.alias, b.card_id,
+                                            b.bits, b.pin, b.validity);
+}
+
+bool operator==(const AuthFileData::TimeFrame &a, const AuthFileData::TimeFrame &b)
+{
+    return std::tie(a.day, a.start_hour, a.start_min, a.end_hour, a.end_min) ==
+           std::tie(b.day, b.start_hour, b.start_min, b.end_hour, b.end_min);
+}
+
+bool operator==(const AuthFileData::Schedule &a, const AuthFileData::Schedule &b)
+{
+    return std::tie(a.name, a.timeframes) == std::tie(b.name, b.timeframes);
+}
+
+bool operator==(const AuthFileData::Mapping &a, const AuthFileData::Mapping &b)
+{
+    return std::tie(a.door, a.schedules, a.users, a.groups, a.credentials) ==
+           std::tie(b.door, b.schedules, b.users, b.groups, b.credentials);
+}
+}
+}
+}
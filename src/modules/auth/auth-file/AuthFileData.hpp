@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace Auth
+{
+/**
+ * Content of an auth file, as plain records.
+ *
+ * This is what remains of the XML once it has been parsed and checked
+ * for syntax errors. Names are not resolved yet: references between
+ * users, groups, credentials and schedules are checked by
+ * FileAuthSourceMapper when it builds its objects.
+ *
+ * Records are stored in the order they appear in the file, because
+ * later definitions override earlier ones.
+ */
+struct AuthFileData
+{
+    struct Validity
+    {
+        std::string start;
+        std::string end;
+        bool enabled;
+    };
+
+    struct User
+    {
+        std::string name;
+        std::string firstname;
+        std::string lastname;
+        std::string email;
+        Validity validity;
+    };
+
+    struct Group
+    {
+        std::string name;
+        std::vector<std::string> members;
+    };
+
+    struct Credential
+    {
+        enum class Type : uint8_t
+        {
+            WIEGAND_CARD,
+            PIN_CODE,
+            WIEGAND_CARD_PIN
+        };
+
+        Type type;
+        std::string owner;
+        /**
+         * The `id` of the credential in the file. May be empty.
+         */
+        std::string alias;
+        std::string card_id;
+        int32_t bits;
+        std::string pin;
+        Validity validity;
+    };
+
+    struct TimeFrame
+    {
+        int32_t day;
+        int32_t start_hour;
+        int32_t start_min;
+        int32_t end_hour;
+        int32_t end_min;
+    };
+
+    struct Schedule
+    {
+        std::string name;
+        std::vector<TimeFrame> timeframes;
+    };
+
+    struct Mapping
+    {
+        std::string door;
+        std::vector<std::string> schedules;
+        std::vector<std::string> users;
+        std::vector<std::string> groups;
+        std::vector<std::string> credentials;
+    };
+
+    std::vector<User> users;
+    std::vector<Group> groups;
+    std::vector<Credential> credentials;
+    std::vector<Schedule> schedules;
+    std::vector<Mapping> mappings;
+
+    /**
+     * Parse an auth file.
+     *
+     * The file is streamed (see streamXmlRecords()): only one record
+     * (a user, a credential, ...) is held as a property tree at a time.
+     *
+     * Throws if the file cannot be read, or if it is not a valid auth file.
+     */
+    static AuthFileData from_xml(const std::string &path);
+};
+
+/**
+ * Field by field comparison of records, used to tell what changed
+ * between two versions of an auth file.
+ */
+bool operator==(const AuthFileData::Validity &a, const AuthFileData::Validity &b);
+bool operator==(const AuthFileData::User &a, const AuthFileData::User &b);
+bool operator==(const AuthFileData::Group &a, const AuthFileData::Group &b);
+bool operator==(const AuthFileData::Credential &a,
+                const AuthFileData::Credential &b);
+bool operator==(const AuthFileData::TimeFrame &a, const AuthFileData::TimeFrame &b);
+bool operator==(const AuthFileData::Schedule &a, const AuthFileData::Schedule &b);
+bool operator==(const AuthFileData::Mapping &a, const AuthFileData::Mapping &b);
+}
+}
+}
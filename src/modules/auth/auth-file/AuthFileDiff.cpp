@@ -0,0 +1,141 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AuthFileDiff.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace Leosac::Module::Auth;
+
+namespace
+{
+/**
+ * Identify a credential by what the mapper looks it up by.
+ */
+std::string credential_key(const AuthFileData::Credential &c)
+{
+    return std::to_string(static_cast<int>(c.type)) + '\n' + c.card_id + '\n' +
+           c.pin;
+}
+
+/**
+ * Index records by key. Returns false if two records share a key.
+ */
+template <typename T, typename KeyFct>
+bool index_by(const std::vector<T> &records, KeyFct key,
+              std::unordered_map<std::string, const T *> &index)
+{
+    index.reserve(records.size());
+    for (const auto &record : records)
+    {
+        if (!index.emplace(key(record), &record).second)
+            return false;
+    }
+    return true;
+}
+}
+
+AuthFileDiff::AuthFileDiff(const AuthFileData &from, const AuthFileData &to)
+    : incremental(from.groups == to.groups && from.schedules == to.schedules &&
+                  from.mappings == to.mappings)
+{
+    using User       = AuthFileData::User;
+    using Credential = AuthFileData::Credential;
+    if (!incremental)
+        return;
+
+    auto user_name = [](const User &u) { return u.name; };
+    std::unordered_map<std::string, const User *> old_users;
+    std::unordered_map<std::string, const User *> new_users;
+    std::unordered_map<std::string, const Credential *> old_creds;
+    std::unordered_map<std::string, const Credential *> new_creds;
+    if (!index_by(from.users, user_name, old_users) ||
+        !index_by(to.users, user_name, new_users) ||
+        !index_by(from.credentials, credential_key, old_creds) ||
+        !index_by(to.credentials, credential_key, new_creds))
+    {
+        incremental = false;
+        return;
+    }
+
+    for (const auto &user : to.users)
+    {
+        auto itr = old_users.find(user.name);
+        if (itr == old_users.end())
+            added_users.push_back(&user);
+        else if (!(*itr->second == user))
+            modified_users.push_back(&user);
+    }
+    for (const auto &user : from.users)
+    {
+        if (!new_users.count(user.name))
+            removed_users.push_back(user.name);
+    }
+
+    for (const auto &cred : to.credentials)
+    {
+        auto itr = old_creds.find(credential_key(cred));
+        if (itr == old_creds.end() || !(*itr->second == cred))
+            added_credentials.push_back(&cred);
+    }
+    for (const auto &cred : from.credentials)
+    {
+        auto itr = new_creds.find(credential_key(cred));
+        if (itr == new_creds.end() || !(*itr->second == cred))
+            removed_credentials.push_back(&cred);
+    }
+
+    // Groups and mappings link to users and credentials by name. They did
+    // not change, but what their names resolve to did.
+    std::unordered_set<std::string> referenced_users;
+    std::unordered_set<std::string> referenced_creds;
+    std::unordered_set<std::string> owners;
+    for (const auto &group : to.groups)
+        referenced_users.insert(group.members.begin(), group.members.end());
+    for (const auto &mapping : to.mappings)
+    {
+        referenced_users.insert(mapping.users.begin(), mapping.users.end());
+        referenced_creds.insert(mapping.credentials.begin(),
+                                mapping.credentials.end());
+    }
+    for (const auto &cred : to.credentials)
+        owners.insert(cred.owner);
+
+    for (const auto &user : added_users)
+        incremental = incremental && !referenced_users.count(user->name);
+    for (const auto &name : removed_users)
+    {
+        incremental = incremental && !referenced_users.count(name) &&
+                      !owners.count(name);
+    }
+    auto is_referenced = [&](const Credential *cred) {
+        return !cred->alias.empty() && referenced_creds.count(cred->alias);
+    };
+    for (const auto &cred : added_credentials)
+        incremental = incremental && !is_referenced(cred);
+    for (const auto &cred : removed_credentials)
+        incremental = incremental && !is_referenced(cred);
+}
+
+bool AuthFileDiff::empty() const
+{
+    return incremental && added_users.empty() && modified_users.empty() &&
+           removed_users.empty() && added_credentials.empty() &&
+           removed_credentials.empty();
+}
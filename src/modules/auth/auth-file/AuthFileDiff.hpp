@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "AuthFileData.hpp"
+#include <string>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace Auth
+{
+/**
+ * What changed between two versions of an auth file.
+ *
+ * Users and credentials are compared one by one: they are what changes
+ * most often (a card is issued or revoked, a PIN is changed, an account
+ * expires). Users are identified by name, credentials by what they are
+ * looked up by (type, card id and PIN). A credential whose other fields
+ * changed is reported as removed, then added.
+ *
+ * Groups, schedules and schedule mappings are only compared as a whole.
+ *
+ * Records are referenced by pointer: both AuthFileData must outlive
+ * the diff.
+ */
+struct AuthFileDiff
+{
+    AuthFileDiff(const AuthFileData &from, const AuthFileData &to);
+
+    /**
+     * Both versions are identical.
+     */
+    bool empty() const;
+
+    /**
+     * Whether the changes can be applied entity by entity.
+     *
+     * This is false when groups, schedules or schedule mappings changed,
+     * when names are not unique, or when an added or removed user or
+     * credential is referenced by name elsewhere in the file. The lists
+     * below are incomplete in that case, and everything must be rebuilt
+     * from `to`.
+     */
+    bool incremental;
+
+    std::vector<const AuthFileData::User *> added_users;
+    std::vector<const AuthFileData::User *> modified_users;
+    std::vector<std::string> removed_users;
+
+    std::vector<const AuthFileData::Credential *> added_credentials;
+
+    /**
+     * Point into the `from` version.
+     */
+    std::vector<const AuthFileData::Credential *> removed_credentials;
+};
+}
+}
+}
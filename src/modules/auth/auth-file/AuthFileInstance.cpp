@@ -39,13 +39,15 @@ AuthFileInstance::AuthFileInstance(zmqpp::context &ctx,
                                    const std::list<std::string> &auth_sources_names,
                                    std::string const &auth_target_name,
                                    std::string const &input_file,
-                                   CoreUtilsPtr core_utils)
-    : mapper_(std::make_shared<FileAuthSourceMapper>(input_file))
+                                   std::string const &cache_file,
+                                   bool auto_reload, CoreUtilsPtr core_utils)
+    : mapper_(std::make_shared<FileAuthSourceMapper>(input_file, cache_file))
     , bus_push_(ctx, zmqpp::socket_type::push)
     , bus_sub_(ctx, zmqpp::socket_type::sub)
     , name_(auth_ctx_name)
     , target_name_(auth_target_name)
     , file_path_(input_file)
+    , cache_path_(cache_file)
     , core_utils_(core_utils)
 {
     bus_push_.connect("inproc://zmq-bus-pull");
@@ -57,10 +59,29 @@ AuthFileInstance::AuthFileInstance(zmqpp::context &ctx,
                            << boost::algorithm::join(auth_sources_names, ", "));
     for (const auto &auth_source : auth_sources_names)
         bus_sub_.subscribe("S_" + auth_source);
+
+    if (auto_reload)
+    {
+        file_changed_ = std::make_unique<Tools::EventFD>();
+        watcher_      = std::make_unique<Tools::UnixFileWatcher>();
+        watcher_->watchFile(file_path_);
+        auto event = file_changed_.get();
+        watcher_->setChangeCallback([event]() { event->notify(); });
+        watcher_->start();
+    }
 }
 
 AuthFileInstance::~AuthFileInstance()
 {
+    try
+    {
+        if (watcher_)
+            watcher_->stop();
+    }
+    catch (const std::exception &e)
+    {
+        WARN("Failed to stop watching " << file_path_ << ": " << e.what());
+    }
     INFO("AuthFileInstance down");
 }
 
@@ -110,19 +131,25 @@ AuthResult AuthFileInstance::handle_auth(zmqpp::message *msg) noexcept
 {
     try
     {
-        std::lock_guard<std::mutex> guard(mutex_);
+        // The mapper is immutable once built: we only need the lock
+        // to grab the current instance, not while using it.
+        FileAuthSourceMapperPtr mapper;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            mapper = mapper_;
+        }
 
         AuthSourceBuilder build;
         Cred::ICredentialPtr auth_source = build.create(msg);
         DEBUG("Auth source OK... will map");
-        mapper_->mapToUser(auth_source);
+        mapper->mapToUser(auth_source);
         DEBUG("Mapping done");
         assert(auth_source);
 
         auto cred_serialized = PolymorphicCredentialJSONStringSerializer::serialize(
             *auth_source, SystemSecurityContext::instance());
         INFO("Using Credential: " << cred_serialized);
-        auto profile = mapper_->buildProfile(auth_source);
+        auto profile = mapper->buildProfile(auth_source);
 
         if (!profile)
         {
@@ -171,16 +198,31 @@ void AuthFileInstance::reload_auth_config()
     // The idea is to build a new mapper in an other thread
     // and swap it with the current mapper once it is built.
     // This is because building a new mapper can take a while.
+    // The new mapper is derived from the current one: only what
+    // changed in the file is rebuilt.
 
     // We keep a shared_ptr to "this" in order to avoid dangling pointer to
     // a non-existent instance (for example if the module was shutdown between
     // the scheduling of the task and its execution).
-    auto self      = shared_from_this();
-    auto file_path = file_path_;
-    auto task      = Tasks::GenericTask::build([self, file_path]() {
+    auto self       = shared_from_this();
+    auto file_path  = file_path_;
+    auto cache_path = cache_path_;
+    auto task = Tasks::GenericTask::build([self, file_path, cache_path]() {
         try
         {
-            auto mapper = std::make_shared<FileAuthSourceMapper>(file_path);
+            std::lock_guard<std::mutex> reload_guard(self->reload_mutex_);
+            FileAuthSourceMapperPtr current;
+            {
+                std::lock_guard<std::mutex> guard(self->mutex_);
+                current = self->mapper_;
+            }
+
+            auto mapper = current->reload(cache_path);
+            if (!mapper)
+            {
+                INFO("AuthFileInstance config unchanged (" << file_path << ").");
+                return true;
+            }
             {
                 std::lock_guard<std::mutex> guard(self->mutex_);
                 self->mapper_ = mapper;
@@ -198,6 +240,24 @@ void AuthFileInstance::reload_auth_config()
     core_utils_->scheduler().enqueue(task, TargetThread::POOL);
 }
 
+Leosac::Tools::EventFD *AuthFileInstance::file_changed()
+{
+    return file_changed_.get();
+}
+
+void AuthFileInstance::check_auth_file()
+{
+    if (!watcher_)
+        return;
+
+    file_changed_->drain();
+    if (watcher_->consumeFileChange(file_path_))
+    {
+        INFO("Auth file " << file_path_ << " was modified.");
+        reload_auth_config();
+    }
+}
+
 bool AuthFileInstance::handle_kernel_message(const zmqpp::message &msg)
 {
     auto cp = msg.copy();
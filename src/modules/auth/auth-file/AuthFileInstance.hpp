@@ -23,7 +23,11 @@
 #include "LeosacFwd.hpp"
 #include "core/auth/AuthFwd.hpp"
 #include "core/tasks/Task.hpp"
+#include "tools/EventFD.hpp"
+#include "tools/unixfilewatcher.hpp"
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <zmqpp/zmqpp.hpp>
 
 namespace Leosac
@@ -79,12 +83,15 @@ class AuthFileInstance : public std::enable_shared_from_this<AuthFileInstance>
     * reader).
     * @param auth_target_name name of the target (ie door) we auth against.
     * @param input_file path to file contain auth configuration
+    * @param cache_file path to the binary cache of `input_file`, or empty.
+    * @param auto_reload reload the configuration when `input_file` is written to.
     * @param core_utils Core utilities
     */
     AuthFileInstance(zmqpp::context &ctx, const std::string &auth_ctx_name,
                      const std::list<std::string> &auth_sources_names,
                      const std::string &auth_target_name,
-                     const std::string &input_file, CoreUtilsPtr core_utils);
+                     const std::string &input_file, const std::string &cache_file,
+                     bool auto_reload, CoreUtilsPtr core_utils);
 
     ~AuthFileInstance();
 
@@ -113,6 +120,21 @@ class AuthFileInstance : public std::enable_shared_from_this<AuthFileInstance>
     */
     std::string auth_file_content() const;
 
+    /**
+     * Readable when the file watcher saw the auth file being written to.
+     *
+     * Null if `auto_reload` is disabled.
+     */
+    Tools::EventFD *file_changed();
+
+    /**
+     * Schedule a reload of the configuration if the file watcher
+     * saw the auth file being written to.
+     *
+     * Does nothing if `auto_reload` is disabled.
+     */
+    void check_auth_file();
+
   private:
     /**
      * Handle the message if its from Leosac's kernel, or
@@ -124,6 +146,9 @@ class AuthFileInstance : public std::enable_shared_from_this<AuthFileInstance>
 
     /**
      * Schedule an asynchronous reload of the module configuration file.
+     *
+     * The new configuration is diffed against the current one, and only
+     * the changes are applied to a copy of the current mapper.
      */
     void reload_auth_config();
 
@@ -147,6 +172,23 @@ class AuthFileInstance : public std::enable_shared_from_this<AuthFileInstance>
      */
     std::mutex mutex_;
 
+    /**
+     * Serializes reloads, so that each one is diffed against the
+     * result of the previous one.
+     */
+    std::mutex reload_mutex_;
+
+    /**
+     * Notified by `watcher_`. Declared before it, so it outlives the watcher
+     * thread.
+     */
+    std::unique_ptr<Tools::EventFD> file_changed_;
+
+    /**
+     * Watches `file_path_` when `auto_reload` is enabled, null otherwise.
+     */
+    std::unique_ptr<Tools::UnixFileWatcher> watcher_;
+
     /**
     * Authentication config file parser.
     */
@@ -177,6 +219,11 @@ class AuthFileInstance : public std::enable_shared_from_this<AuthFileInstance>
     */
     std::string file_path_;
 
+    /**
+    * Path to the binary cache of the auth data file. May be empty.
+    */
+    std::string cache_path_;
+
     CoreUtilsPtr core_utils_;
 };
 }
@@ -35,6 +35,13 @@ AuthFileModule::AuthFileModule(zmqpp::context &ctx, zmqpp::socket *pipe,
     {
         reactor_.add(authenticator->bus_sub(),
                      std::bind(&AuthFileInstance::handle_bus_msg, authenticator));
+        // Auth files are only watched with `auto_reload`.
+        if (auto file_changed = authenticator->file_changed())
+        {
+            reactor_.add(file_changed->fd(),
+                         std::bind(&AuthFileInstance::check_auth_file,
+                                   authenticator));
+        }
     }
 }
 
@@ -53,6 +60,9 @@ void AuthFileModule::process_config()
         std::string config_file = auth_instance_cfg.get_child("config_file").data();
         std::string auth_target_name =
             auth_instance_cfg.get<std::string>("target", "");
+        std::string cache_file =
+            auth_instance_cfg.get<std::string>("cache_file", "");
+        bool auto_reload = auth_instance_cfg.get<bool>("auto_reload", false);
         std::list<std::string> auth_sources_names;
 
         for (const auto &subnode : auth_instance_cfg)
@@ -69,7 +79,8 @@ void AuthFileModule::process_config()
              << auth_ctx_name << ". Target door = " << auth_target_name);
         authenticators_.push_back(AuthFileInstancePtr(
             new AuthFileInstance(ctx_, auth_ctx_name, auth_sources_names,
-                                 auth_target_name, config_file, utils_)));
+                                 auth_target_name, config_file, cache_file,
+                                 auto_reload, utils_)));
     }
 }
 
@@ -18,6 +18,7 @@
 */
 
 #include "FileAuthSourceMapper.hpp"
+#include "AuthFileCache.hpp"
 #include "core/auth/Auth.hpp"
 #include "core/auth/Door.hpp"
 #include "core/auth/Group.hpp"
@@ -28,59 +29,108 @@
 #include "core/credentials/PinCode.hpp"
 #include "core/credentials/RFIDCard.hpp"
 #include "core/credentials/RFIDCardPin.hpp"
+#include "exception/configexception.hpp"
 #include "exception/moduleexception.hpp"
 #include "tools/AssertCast.hpp"
 #include "tools/Schedule.hpp"
-#include "tools/XmlPropertyTree.hpp"
 #include "tools/log.hpp"
-#include <boost/algorithm/string.hpp>
 #include <tools/enforce.hpp>
+#include <algorithm>
 
 using namespace Leosac::Module::Auth;
 using namespace Leosac::Auth;
 
-FileAuthSourceMapper::FileAuthSourceMapper(const std::string &auth_file)
+FileAuthSourceMapper::FileAuthSourceMapper(const std::string &auth_file,
+                                           const std::string &cache_file)
     : config_file_(auth_file)
-    , xmlnne_(config_file_)
+    , next_user_id_(1)
+    , next_cred_id_(1)
 {
     try
     {
-        // Loading order:
-        //          - Users
-        //          - Groups
-        //          - Credentials
-        //          - Schedule, and schedule mapping
+        build(load_data(auth_file, cache_file));
+    }
+    catch (std::exception &e)
+    {
+        ERROR("Exception: " << e.what());
+        std::throw_with_nested(
+            ModuleException("AuthFile cannot load configuration"));
+    }
+}
 
-        DEBUG("Will load tree");
-        auto &&additional_config = Tools::propertyTreeFromXmlFile(auth_file);
-        additional_config        = additional_config.get_child("root");
-        DEBUG("Tree loaded");
+FileAuthSourceMapper::FileAuthSourceMapper(const std::string &auth_file,
+                                           std::shared_ptr<const AuthFileData> data)
+    : config_file_(auth_file)
+    , next_user_id_(1)
+    , next_cred_id_(1)
+{
+    try
+    {
+        build(data);
+    }
+    catch (std::exception &e)
+    {
+        ERROR("Exception: " << e.what());
+        std::throw_with_nested(
+            ModuleException("AuthFile cannot load configuration"));
+    }
+}
 
-        const auto &users_tree = additional_config.get_child_optional("users");
-        if (users_tree)
-            load_users(*users_tree);
+std::shared_ptr<const AuthFileData>
+FileAuthSourceMapper::load_data(const std::string &auth_file,
+                                const std::string &cache_file)
+{
+    DEBUG("Will load auth file");
+    auto data = std::make_shared<AuthFileData>(
+        cache_file.empty() ? AuthFileData::from_xml(auth_file)
+                           : AuthFileCache(cache_file).load(auth_file));
+    DEBUG("Auth file loaded");
+    return data;
+}
 
-        const auto &groups_tree =
-            additional_config.get_child_optional("group_mapping");
-        if (groups_tree)
-            load_groups(*groups_tree);
+void FileAuthSourceMapper::build(std::shared_ptr<const AuthFileData> data)
+{
+    // Loading order:
+    //          - Users
+    //          - Groups
+    //          - Credentials
+    //          - Schedule, and schedule mapping
+    data_ = data;
+    load_users(data->users);
+    load_groups(data->groups);
+    load_credentials(data->credentials);
+    load_schedules(data->schedules);
+    map_schedules(data->mappings);
+
+    build_access_index();
+    DEBUG("Ready");
+}
 
-        const auto &credentials_tree =
-            additional_config.get_child_optional("credentials");
-        if (credentials_tree)
-            load_credentials(*credentials_tree);
+FileAuthSourceMapperPtr
+FileAuthSourceMapper::reload(const std::string &cache_file) const
+{
+    return update(load_data(config_file_, cache_file));
+}
 
-        const auto &schedules_tree =
-            additional_config.get_child_optional("schedules");
-        if (schedules_tree)
-            load_schedules(*schedules_tree);
+FileAuthSourceMapperPtr
+FileAuthSourceMapper::update(std::shared_ptr<const AuthFileData> data) const
+{
+    AuthFileDiff diff(*data_, *data);
+    if (diff.empty())
+        return nullptr;
 
-        const auto &schedule_mapping_tree =
-            additional_config.get_child_optional("schedules_mapping");
-        if (schedule_mapping_tree)
-            map_schedules(*schedule_mapping_tree);
+    if (!diff.incremental)
+    {
+        INFO("Groups, schedules or mappings of " << config_file_
+                                                 << " changed. Full rebuild.");
+        return std::make_shared<FileAuthSourceMapper>(config_file_, data);
+    }
 
-        DEBUG("Ready");
+    FileAuthSourceMapperPtr mapper(new FileAuthSourceMapper(*this));
+    try
+    {
+        mapper->data_ = data;
+        mapper->apply(diff);
     }
     catch (std::exception &e)
     {
@@ -88,14 +138,75 @@ FileAuthSourceMapper::FileAuthSourceMapper(const std::string &auth_file)
         std::throw_with_nested(
             ModuleException("AuthFile cannot load configuration"));
     }
+    INFO("Incremental update of "
+         << config_file_ << ": users +" << diff.added_users.size() << " ~"
+         << diff.modified_users.size() << " -" << diff.removed_users.size()
+         << ", credentials +" << diff.added_credentials.size() << " -"
+         << diff.removed_credentials.size());
+    return mapper;
+}
+
+void FileAuthSourceMapper::apply(const AuthFileDiff &diff)
+{
+    // Remove first: a modified credential is removed then added back
+    // under the same key.
+    for (const auto &entry : diff.removed_credentials)
+        remove_credential(*entry);
+
+    for (const auto &name : diff.removed_users)
+    {
+        auto itr = users_.find(name);
+        if (itr == users_.end())
+            continue;
+        if (itr->second)
+        {
+            user_profiles_.erase(itr->second->id());
+            user_groups_.erase(itr->second->id());
+        }
+        users_.erase(itr);
+    }
+
+    // A modified user keeps its id, so the profiles computed for it, and
+    // the mappings referencing it, remain valid. Objects holding a pointer
+    // to the previous User object must be replaced.
+    ReplacedUsers replaced;
+    for (const auto &entry : diff.modified_users)
+    {
+        UserPtr &user = users_.at(entry->name);
+        user          = make_user(*entry, user->id());
+        replaced[user->id()] = user;
+    }
+    if (!replaced.empty())
+    {
+        reown_credentials(replaced);
+        rebuild_groups(replaced);
+    }
+
+    // New users are referenced by no group nor mapping: they get
+    // no access until credentials of their own are mapped.
+    for (const auto &entry : diff.added_users)
+    {
+        UserPtr user = make_user(*entry, next_user_id_++);
+        users_[entry->name]        = user;
+        user_profiles_[user->id()] = nullptr;
+    }
+
+    for (const auto &entry : diff.added_credentials)
+    {
+        auto cred  = add_credential(*entry);
+        auto owner = cred->owner().get_eager();
+        auto itr   = user_profiles_.find(owner->id());
+        cred_profiles_[cred->id()] =
+            itr != user_profiles_.end() ? itr->second : nullptr;
+    }
 }
 
 void FileAuthSourceMapper::visit(::Leosac::Cred::RFIDCard &src)
 {
-    auto it = rfid_cards_.find(src.card_id());
-    if (it != rfid_cards_.end())
+    auto creds = cards_.find(src.card_id());
+    if (creds && creds->card)
     {
-        auto cred = it->second;
+        auto cred = creds->card;
 
         // By copying our instance of the credential to the
         // caller credential object, we store additional info we gathered
@@ -120,10 +231,12 @@ void FileAuthSourceMapper::visit(::Leosac::Cred::PinCode &src)
 
 void FileAuthSourceMapper::visit(::Leosac::Cred::RFIDCardPin &src)
 {
-    auto key = std::make_pair(src.card().card_id(), src.pin().pin_code());
+    auto creds = cards_.find(src.card().card_id());
+    if (!creds)
+        return;
 
-    auto it = rfid_cards_pin.find(key);
-    if (it != rfid_cards_pin.end())
+    auto it = creds->with_pin.find(src.pin().pin_code());
+    if (it != creds->with_pin.end())
     {
         auto cred = it->second;
 
@@ -149,33 +262,58 @@ void FileAuthSourceMapper::mapToUser(Cred::ICredentialPtr cred)
 }
 
 void FileAuthSourceMapper::load_groups(
-    const boost::property_tree::ptree &group_mapping)
+    const std::vector<AuthFileData::Group> &groups)
 {
     GroupId group_id =
         1; // Similar to user, we need ID to identify group in mapping.
-    for (const auto &group_info : group_mapping)
-    {
-        const boost::property_tree::ptree &node = group_info.second;
-        const std::string &group_name           = node.get<std::string>("group");
+    for (const auto &group_info : groups)
+        groups_[group_info.name] = make_group(group_info, group_id++);
+}
 
-        xmlnne_("map", group_info.first);
+GroupPtr FileAuthSourceMapper::make_group(const AuthFileData::Group &entry,
+                                          GroupId id)
+{
+    GroupPtr grp(new Group(entry.name));
+    grp->id(id);
+    grp->profile(SimpleAccessProfilePtr(new SimpleAccessProfile()));
+
+    for (const auto &user_name : entry.members)
+    {
+        UserPtr user = users_[user_name];
+        if (!user)
+        {
+            ERROR("Unknown user " << user_name);
+            throw ConfigException(config_file_, "Unknown user " + user_name);
+        }
+        grp->member_add(user);
+    }
+    return grp;
+}
 
-        GroupPtr grp = groups_[group_name] = GroupPtr(new Group(group_name));
-        grp->id(group_id++);
-        grp->profile(SimpleAccessProfilePtr(new SimpleAccessProfile()));
+void FileAuthSourceMapper::rebuild_groups(const ReplacedUsers &users)
+{
+    // When a name is used twice, the last group wins.
+    std::map<std::string, const AuthFileData::Group *> entries;
+    for (const auto &entry : data_->groups)
+        entries[entry.name] = &entry;
 
-        for (const auto &membership : node)
+    for (auto &grp_map : groups_)
+    {
+        GroupPtr old_grp    = grp_map.second;
+        const auto &members = old_grp->members();
+        bool affected =
+            std::any_of(members.begin(), members.end(), [&](const UserPtr &m) {
+                return m && users.count(m->id());
+            });
+        if (!affected)
+            continue;
+
+        GroupPtr grp   = make_group(*entries.at(grp_map.first), old_grp->id());
+        grp_map.second = grp;
+        for (const auto &member : grp->members())
         {
-            if (membership.first != "user")
-                continue;
-            std::string user_name = membership.second.data();
-            UserPtr user          = users_[user_name];
-            if (!user)
-            {
-                ERROR("Unknown user " << user_name);
-                throw ConfigException(config_file_, "Unknown user " + user_name);
-            }
-            grp->member_add(user);
+            auto &member_groups = user_groups_[member->id()];
+            std::replace(member_groups.begin(), member_groups.end(), old_grp, grp);
         }
     }
 }
@@ -195,23 +333,10 @@ std::vector<GroupPtr> FileAuthSourceMapper::groups() const
 std::vector<GroupPtr> FileAuthSourceMapper::get_user_groups(Leosac::Auth::UserPtr u)
 {
     assert(u);
-    std::vector<GroupPtr> grps;
-    auto lambda_cmp = [&](UserPtr user) -> bool {
-        return user->username() == u->username();
-    };
-
-    for (const auto &grp_map : groups_)
-    {
-        GroupPtr grp;
-        std::tie(std::ignore, grp) = grp_map;
-
-        if (std::find_if(grp->members().begin(), grp->members().end(), lambda_cmp) !=
-            grp->members().end())
-        {
-            grps.push_back(grp);
-        }
-    }
-    return grps;
+    auto itr = user_groups_.find(u->id());
+    if (itr != user_groups_.end())
+        return itr->second;
+    return {};
 }
 
 IAccessProfilePtr
@@ -231,145 +356,227 @@ FileAuthSourceMapper::merge_profiles(const std::vector<IAccessProfilePtr> profil
 }
 
 void FileAuthSourceMapper::load_credentials(
-    const boost::property_tree::ptree &credentials)
+    const std::vector<AuthFileData::Credential> &credentials)
+{
+    for (const auto &entry : credentials)
+        add_credential(entry);
+}
+
+Leosac::Cred::ICredentialPtr
+FileAuthSourceMapper::add_credential(const AuthFileData::Credential &entry)
 {
-    Cred::CredentialId cred_id = 1;
-    for (const auto &mapping : credentials)
+    using Type = AuthFileData::Credential::Type;
+
+    UserPtr user = users_[entry.owner];
+    if (!user)
     {
-        const std::string &node_name            = mapping.first;
-        const boost::property_tree::ptree &node = mapping.second;
+        throw ConfigException(config_file_,
+                              "Credentials defined for undefined user " +
+                                  entry.owner);
+    }
+    assert(user);
 
-        xmlnne_("map", node_name);
+    Cred::ICredentialPtr credential;
 
-        std::string user_id = node.get<std::string>("user");
-        UserPtr user        = users_[user_id];
-        if (!user)
-            throw ConfigException(
-                config_file_, "Credentials defined for undefined user " + user_id);
-        assert(user);
+    if (entry.type == Type::WIEGAND_CARD)
+    {
+        Cred::RFIDCardPtr c = std::make_shared<Cred::RFIDCard>();
+        c->card_id(entry.card_id);
+        c->nb_bits(entry.bits);
+        cards_[entry.card_id].card = c;
+        credential                 = c;
+    }
+    else if (entry.type == Type::PIN_CODE)
+    {
+        Cred::PinCodePtr p = std::make_shared<Cred::PinCode>();
+        p->pin_code(entry.pin);
+        pin_codes_[entry.pin] = p;
+        credential            = p;
+    }
+    else
+    {
+        auto c = std::make_shared<Cred::RFIDCard>();
+        c->id(next_cred_id_++);
+        c->card_id(entry.card_id);
+        c->nb_bits(entry.bits);
+
+        auto p = std::make_shared<Cred::PinCode>();
+        p->id(next_cred_id_++);
+        p->pin_code(entry.pin);
+        credential = std::make_shared<Cred::RFIDCardPin>(c, p);
+        cards_[entry.card_id].with_pin[entry.pin] =
+            assert_cast<Cred::RFIDCardPinPtr>(credential);
+    }
+    credential->id(next_cred_id_++);
+    credential->validity(make_validity(entry.validity));
+    credential->owner(user);
+
+    // Alias in place of id, so that it can be a string (making it easier to
+    // configure from the a XML file)
+    credential->alias(entry.alias);
+    add_cred_to_id_map(credential);
+    return credential;
+}
 
-        Cred::ICredentialPtr credential;
+void FileAuthSourceMapper::remove_credential(const AuthFileData::Credential &entry)
+{
+    using Type = AuthFileData::Credential::Type;
 
-        // does this entry map a wiegand card?
-        auto opt_child = node.get_child_optional("WiegandCard");
-        if (opt_child)
+    Cred::ICredentialPtr credential;
+    if (entry.type == Type::WIEGAND_CARD)
+    {
+        auto &creds = cards_[entry.card_id];
+        credential  = creds.card;
+        creds.card  = nullptr;
+    }
+    else if (entry.type == Type::PIN_CODE)
+    {
+        auto itr = pin_codes_.find(entry.pin);
+        if (itr != pin_codes_.end())
         {
-            std::string card_id = opt_child->get<std::string>("card_id");
-            int bits            = opt_child->get<int>("bits");
-
-            Cred::RFIDCardPtr c = std::make_shared<Cred::RFIDCard>();
-            c->card_id(card_id);
-            c->nb_bits(bits);
-            rfid_cards_[card_id] = c;
-            credential           = c;
+            credential = itr->second;
+            pin_codes_.erase(itr);
         }
-        else if (opt_child = node.get_child_optional("PINCode"))
+    }
+    else
+    {
+        auto &with_pin = cards_[entry.card_id].with_pin;
+        auto itr       = with_pin.find(entry.pin);
+        if (itr != with_pin.end())
         {
-            // or to a PIN code ?
-            std::string pin = opt_child->get<std::string>("pin");
+            credential = itr->second;
+            with_pin.erase(itr);
+        }
+    }
+    if (!credential)
+        return;
+
+    auto alias_itr = id_to_cred_.find(entry.alias);
+    if (alias_itr != id_to_cred_.end() && alias_itr->second == credential)
+        id_to_cred_.erase(alias_itr);
+    cred_profiles_.erase(credential->id());
+}
+
+namespace
+{
+/**
+ * Copy a credential, with a new owner.
+ */
+template <typename T>
+std::shared_ptr<T> reowned(const std::shared_ptr<T> &cred, const UserPtr &owner)
+{
+    auto copy = std::make_shared<T>(*cred);
+    copy->owner(owner);
+    return copy;
+}
+}
 
-            Cred::PinCodePtr p = std::make_shared<Cred::PinCode>();
-            p->pin_code(pin);
-            pin_codes_[pin] = p;
-            credential      = p;
+void FileAuthSourceMapper::reown_credentials(const ReplacedUsers &users)
+{
+    using Type = AuthFileData::Credential::Type;
+
+    // Maps replaced credentials to their copy, to fix the alias map.
+    std::map<Cred::ICredentialPtr, Cred::ICredentialPtr> copies;
+    auto new_owner = [&](const Cred::ICredentialPtr &cred) -> UserPtr {
+        if (!cred)
+            return nullptr;
+        auto itr = users.find(cred->owner_id());
+        return itr != users.end() ? itr->second : nullptr;
+    };
+
+    // Walk the (new) file content rather than the lookup tables: it tells
+    // which key each credential is stored under.
+    for (const auto &entry : data_->credentials)
+    {
+        if (entry.type == Type::WIEGAND_CARD)
+        {
+            auto &card = cards_[entry.card_id].card;
+            if (auto owner = new_owner(card))
+                card = assert_cast<Cred::RFIDCardPtr>(
+                    copies[card] = reowned(card, owner));
+        }
+        else if (entry.type == Type::PIN_CODE)
+        {
+            auto itr = pin_codes_.find(entry.pin);
+            if (itr == pin_codes_.end())
+                continue;
+            if (auto owner = new_owner(itr->second))
+                itr->second = assert_cast<Cred::PinCodePtr>(
+                    copies[itr->second] = reowned(itr->second, owner));
         }
-        else if (opt_child = node.get_child_optional("WiegandCardPin"))
+        else
         {
-            std::string card_id = opt_child->get<std::string>("card_id");
-            std::string pin     = opt_child->get<std::string>("pin");
-            int bits            = opt_child->get<int>("bits");
-
-            auto c = std::make_shared<Cred::RFIDCard>();
-            c->id(cred_id++);
-            c->card_id(card_id);
-            c->nb_bits(bits);
-
-            auto p = std::make_shared<Cred::PinCode>();
-            p->id(cred_id++);
-            p->pin_code(pin);
-            credential = std::make_shared<Cred::RFIDCardPin>(c, p);
-            rfid_cards_pin[std::make_pair(card_id, pin)] =
-                assert_cast<Cred::RFIDCardPinPtr>(credential);
+            auto &with_pin = cards_[entry.card_id].with_pin;
+            auto itr       = with_pin.find(entry.pin);
+            if (itr == with_pin.end())
+                continue;
+            if (auto owner = new_owner(itr->second))
+                itr->second = assert_cast<Cred::RFIDCardPinPtr>(
+                    copies[itr->second] = reowned(itr->second, owner));
         }
-        assert(opt_child);
-        credential->id(cred_id++);
-        credential->validity(extract_credentials_validity(*opt_child));
-        credential->owner(user);
+    }
 
-        // Alias in place of id, so that it can be a string (making it easier to
-        // configure from the a XML file)
-        credential->alias(opt_child->get<std::string>("id", ""));
-        add_cred_to_id_map(credential);
+    for (auto &alias : id_to_cred_)
+    {
+        auto itr = copies.find(alias.second);
+        if (itr != copies.end())
+            alias.second = itr->second;
     }
 }
 
 void FileAuthSourceMapper::load_schedules(
-    const boost::property_tree::ptree &schedules)
+    const std::vector<AuthFileData::Schedule> &schedules)
 {
-    bool ret = xml_schedules_.load(schedules);
-    ASSERT_LOG(ret, "Failed to load schedules");
+    for (const auto &entry : schedules)
+    {
+        auto sched = std::make_shared<Tools::Schedule>(entry.name);
+        for (const auto &tf : entry.timeframes)
+        {
+            sched->add_timeframe(Tools::SingleTimeFrame(
+                tf.day, tf.start_hour, tf.start_min, tf.end_hour, tf.end_min));
+        }
+        if (schedules_.count(entry.name))
+        {
+            INFO("A schedule with name "
+                 << entry.name << " already exists. It will be overridden.");
+        }
+        schedules_[entry.name] = sched;
+    }
 }
 
 void FileAuthSourceMapper::map_schedules(
-    const boost::property_tree::ptree &schedules_mapping)
+    const std::vector<AuthFileData::Mapping> &mappings)
 {
-    for (const auto &mapping_entry : schedules_mapping)
+    for (const auto &mapping_entry : mappings)
     {
-        const std::string &node_name            = mapping_entry.first;
-        const boost::property_tree::ptree &node = mapping_entry.second;
-
-        xmlnne_("map", node_name);
-
-        // we can map multiple schedule at once.
-        std::list<std::string> schedule_names;
-        std::list<std::string> user_names;
-        std::list<std::string> group_names;
-        std::list<std::string> credential_names;
-        std::string target_door;
-        target_door = node.get<std::string>("door", "");
         auto door(std::make_shared<Leosac::Auth::Door>());
-        door->alias(target_door);
+        door->alias(mapping_entry.door);
         doors_.push_back(door);
 
-        // lets loop over all the info we have
-        for (const auto &mapping_data : node)
-        {
-            if (mapping_data.first == "door")
-                continue;
-            if (mapping_data.first == "schedule")
-                schedule_names.push_back(mapping_data.second.data());
-            if (mapping_data.first == "user")
-                user_names.push_back(mapping_data.second.data());
-            if (mapping_data.first == "group")
-                group_names.push_back(mapping_data.second.data());
-            if (mapping_data.first == "credential")
-                credential_names.push_back(mapping_data.second.data());
-        }
-
         // now build object based on what we extracted.
-        for (const auto &schedule_name : schedule_names)
+        for (const auto &schedule_name : mapping_entry.schedules)
         {
             // Each schedule can be mapped once per ScheduleMapping, but can be
             // referenced by multiple schedule mapping. What we do here is for each
             // schedule in the mapping entry, we create a ScheduleMapping object.
             Tools::ScheduleMappingPtr sm(std::make_shared<Tools::ScheduleMapping>());
-            xml_schedules_.schedules().at(schedule_name)->add_mapping(sm);
+            schedules_.at(schedule_name)->add_mapping(sm);
 
             if (!door->alias().empty())
                 sm->add_door(door);
 
-            for (const auto &user_name : user_names)
+            for (const auto &user_name : mapping_entry.users)
             {
                 UserPtr user = users_[user_name];
                 sm->add_user(user);
             }
             // now for groups
-            for (const auto &group_name : group_names)
+            for (const auto &group_name : mapping_entry.groups)
             {
                 GroupPtr grp = groups_[group_name];
                 sm->add_group(grp);
             }
-            for (const auto &cred_id : credential_names)
+            for (const auto &cred_id : mapping_entry.credentials)
             {
                 DEBUG("CRED  = " << cred_id);
                 Cred::ICredentialPtr cred = find_cred_by_alias(cred_id);
@@ -381,53 +588,48 @@ void FileAuthSourceMapper::map_schedules(
     }
 }
 
-void FileAuthSourceMapper::load_users(const boost::property_tree::ptree &users)
+void FileAuthSourceMapper::load_users(const std::vector<AuthFileData::User> &users)
 {
-    // We use the user id internally to uniquely identify user
-    // through ScheduleMapping.
-    UserId user_id = 1;
-    for (const auto &user : users)
+    for (const auto &entry : users)
     {
-        const std::string &node_name            = user.first;
-        const boost::property_tree::ptree &node = user.second;
-
-        xmlnne_("user", node_name);
-
-        std::string username  = node.get<std::string>("name");
-        std::string firstname = node.get<std::string>("firstname", "");
-        std::string lastname  = node.get<std::string>("lastname", "");
-        std::string email     = node.get<std::string>("email", "");
-
-        if (username == "UNKNOWN_USER") // reserved username
-            throw ConfigException(config_file_,
-                                  "'UNKNOWN_USER' is a reserved name. Do not use.");
-
-        UserPtr uptr(std::make_unique<User>(user_id++));
-        uptr->username(username);
-        uptr->firstname(firstname);
-        uptr->lastname(lastname);
-        uptr->email(email);
-        uptr->validity(extract_credentials_validity(node));
-
-        // create an empty profile
-        uptr->profile(SimpleAccessProfilePtr(new SimpleAccessProfile()));
-
-        if (users_.count(username))
+        // We use the user id internally to uniquely identify user
+        // through ScheduleMapping.
+        UserPtr uptr = make_user(entry, next_user_id_++);
+        if (users_.count(entry.name))
         {
-            WARN("User " << username << " was already defined. Will overwrite.");
+            WARN("User " << entry.name << " was already defined. Will overwrite.");
         }
-        users_[username] = uptr;
+        users_[entry.name] = uptr;
     }
 }
 
-Leosac::Auth::ValidityInfo FileAuthSourceMapper::extract_credentials_validity(
-    const boost::property_tree::ptree &node)
+UserPtr FileAuthSourceMapper::make_user(const AuthFileData::User &entry,
+                                        UserId id) const
+{
+    if (entry.name == "UNKNOWN_USER") // reserved username
+        throw ConfigException(config_file_,
+                              "'UNKNOWN_USER' is a reserved name. Do not use.");
+
+    UserPtr uptr(std::make_unique<User>(id));
+    uptr->username(entry.name);
+    uptr->firstname(entry.firstname);
+    uptr->lastname(entry.lastname);
+    uptr->email(entry.email);
+    uptr->validity(make_validity(entry.validity));
+
+    // create an empty profile
+    uptr->profile(SimpleAccessProfilePtr(new SimpleAccessProfile()));
+    return uptr;
+}
+
+Leosac::Auth::ValidityInfo
+FileAuthSourceMapper::make_validity(const AuthFileData::Validity &validity)
 {
     ValidityInfo v;
 
-    v.set_start_date(node.get<std::string>("validity_start", ""));
-    v.set_end_date(node.get<std::string>("validity_end", ""));
-    v.set_enabled(node.get<bool>("enabled", true));
+    v.set_start_date(validity.start);
+    v.set_end_date(validity.end);
+    v.set_enabled(validity.enabled);
 
     return v;
 }
@@ -460,8 +662,6 @@ Leosac::Auth::IAccessProfilePtr
 FileAuthSourceMapper::buildProfile(Leosac::Cred::ICredentialPtr cred)
 {
     assert(cred);
-    std::vector<GroupPtr> grps;
-    std::vector<IAccessProfilePtr> profiles; // profiles that apply to the user.
 
     // Sanity check
     if (cred->owner())
@@ -482,20 +682,105 @@ FileAuthSourceMapper::buildProfile(Leosac::Cred::ICredentialPtr cred)
         return nullptr;
     }
 
-    // First, create the profile for the user, if any
+    // Profiles are precomputed by build_access_index(): the credential
+    // profile already includes the owner's and its groups' schedules.
+    auto cred_itr = cred_profiles_.find(cred->id());
+    if (cred_itr != cred_profiles_.end())
+        return cred_itr->second;
+
+    // Credential unknown to the index, fallback to the owner's profile.
     if (cred_owner)
     {
-        profiles.push_back(build_user_profile(cred_owner));
+        auto user_itr = user_profiles_.find(cred_owner->id());
+        if (user_itr != user_profiles_.end())
+            return user_itr->second;
+    }
+    return nullptr;
+}
 
-        // Profile for user's groups.
-        grps = get_user_groups(cred_owner);
-        for (auto &grp : grps)
-            profiles.push_back(build_group_profile(grp));
+void FileAuthSourceMapper::build_access_index()
+{
+    user_groups_.clear();
+    user_profiles_.clear();
+    cred_profiles_.clear();
+
+    // Membership: a single walk over each group's members, instead of
+    // a walk over all groups for each authentication request.
+    for (const auto &grp_map : groups_)
+    {
+        const GroupPtr &grp = grp_map.second;
+        for (const auto &member : grp->members())
+        {
+            if (member)
+                user_groups_[member->id()].push_back(grp);
+        }
+    }
+
+    // Reverse the mappings so that each entity knows which mappings
+    // reference it directly.
+    std::unordered_map<UserId, std::vector<Tools::ScheduleMappingPtr>> user_mappings;
+    std::unordered_map<GroupId, std::vector<Tools::ScheduleMappingPtr>>
+        group_mappings;
+    std::unordered_map<Cred::CredentialId, std::vector<Tools::ScheduleMappingPtr>>
+        cred_mappings;
+    for (const auto &mapping : mappings_)
+    {
+        for (const auto &lazy_weak_user : mapping->users())
+            user_mappings[lazy_weak_user.object_id()].push_back(mapping);
+        for (const auto &lazy_weak_group : mapping->groups())
+            group_mappings[lazy_weak_group.object_id()].push_back(mapping);
+        for (const auto &lazy_weak_cred : mapping->credentials())
+            cred_mappings[lazy_weak_cred.object_id()].push_back(mapping);
+    }
+
+    for (const auto &user_map : users_)
+    {
+        const UserPtr &user = user_map.second;
+        if (!user || user_profiles_.count(user->id()))
+            continue;
+
+        std::vector<IAccessProfilePtr> profiles;
+        profiles.push_back(build_mappings_profile(user_mappings[user->id()]));
+        for (const auto &grp : get_user_groups(user))
+            profiles.push_back(build_mappings_profile(group_mappings[grp->id()]));
+        user_profiles_[user->id()] = merge_profiles(profiles);
     }
 
-    profiles.push_back(build_cred_profile(cred));
+    auto index_credential = [&](const Cred::ICredentialPtr &cred) {
+        IAccessProfilePtr owner_profile;
+        auto owner = cred->owner().get_eager();
+        if (owner)
+        {
+            auto user_itr = user_profiles_.find(owner->id());
+            if (user_itr != user_profiles_.end())
+                owner_profile = user_itr->second;
+        }
+
+        auto cred_itr = cred_mappings.find(cred->id());
+        if (cred_itr == cred_mappings.end())
+        {
+            // Most credentials have no mapping of their own: share
+            // the owner's profile instead of building a copy.
+            cred_profiles_[cred->id()] = owner_profile;
+        }
+        else
+        {
+            cred_profiles_[cred->id()] = merge_profiles(
+                {owner_profile, build_mappings_profile(cred_itr->second)});
+        }
+    };
 
-    return merge_profiles(profiles);
+    cards_.for_each([&](const CardCredentials &creds) {
+        if (creds.card)
+            index_credential(creds.card);
+        for (const auto &card_pin : creds.with_pin)
+            index_credential(card_pin.second);
+    });
+    for (const auto &pin : pin_codes_)
+        index_credential(pin.second);
+
+    DEBUG("Access index built for " << user_profiles_.size() << " users and "
+                                    << cred_profiles_.size() << " credentials.");
 }
 
 static void
@@ -529,48 +814,13 @@ add_schedule_from_mapping_to_profile(Leosac::Tools::ScheduleMappingPtr mapping,
     }
 }
 
-SimpleAccessProfilePtr FileAuthSourceMapper::build_user_profile(UserPtr u)
+SimpleAccessProfilePtr FileAuthSourceMapper::build_mappings_profile(
+    const std::vector<Tools::ScheduleMappingPtr> &mappings)
 {
-    ASSERT_LOG(u, "User is null");
-
     auto profile(std::make_shared<SimpleAccessProfile>());
-    for (const auto &mapping : mappings_)
+    for (const auto &mapping : mappings)
     {
-        if (mapping->has_user(u->id()))
-        {
-            add_schedule_from_mapping_to_profile(mapping, profile);
-        }
-    }
-    return profile;
-}
-
-SimpleAccessProfilePtr FileAuthSourceMapper::build_group_profile(GroupPtr g)
-{
-    ASSERT_LOG(g, "Group is null");
-
-    auto profile(std::make_shared<SimpleAccessProfile>());
-    for (const auto &mapping : mappings_)
-    {
-        if (mapping->has_group(g->id()))
-        {
-            add_schedule_from_mapping_to_profile(mapping, profile);
-        }
-    }
-    return profile;
-}
-
-Leosac::Auth::SimpleAccessProfilePtr
-FileAuthSourceMapper::build_cred_profile(Leosac::Cred::ICredentialPtr c)
-{
-    ASSERT_LOG(c, "Credential is null");
-
-    auto profile(std::make_shared<SimpleAccessProfile>());
-    for (const auto &mapping : mappings_)
-    {
-        if (mapping->has_cred(c->id()))
-        {
-            add_schedule_from_mapping_to_profile(mapping, profile);
-        }
+        add_schedule_from_mapping_to_profile(mapping, profile);
     }
     return profile;
 }
@@ -19,17 +19,18 @@
 
 #pragma once
 
+#include "AuthFileData.hpp"
+#include "AuthFileDiff.hpp"
 #include "core/auth/AuthFwd.hpp"
 #include "core/auth/AuthFwd.hpp"
 #include "core/auth/Interfaces/IAuthSourceMapper.hpp"
 #include "core/auth/Interfaces/IAuthenticationSource.hpp"
 #include "core/auth/SimpleAccessProfile.hpp"
+#include "core/credentials/CardTable.hpp"
 #include "core/credentials/CredentialFwd.hpp"
+#include "tools/ISchedule.hpp"
 #include "tools/ScheduleMapping.hpp"
 #include "tools/SingleTimeFrame.hpp"
-#include "tools/XmlNodeNameEnforcer.hpp"
-#include "tools/XmlScheduleLoader.hpp"
-#include <boost/property_tree/ptree.hpp>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -41,8 +42,14 @@ namespace Module
 {
 namespace Auth
 {
+class FileAuthSourceMapper;
+using FileAuthSourceMapperPtr = std::shared_ptr<FileAuthSourceMapper>;
+
 /**
 * Use a file to map auth source (card, PIN, etc) to user.
+*
+* A mapper is never modified once built. Reloading the file produces
+* a new mapper (see reload()).
 */
 class FileAuthSourceMapper
     : public ::Leosac::Auth::IAuthSourceMapper,
@@ -51,7 +58,44 @@ class FileAuthSourceMapper
       public ::Leosac::Tools::Visitor<::Leosac::Cred::RFIDCardPin>
 {
   public:
-    FileAuthSourceMapper(const std::string &auth_file);
+    /**
+    * Load the auth file.
+    *
+    * @param auth_file Path to the XML auth file.
+    * @param cache_file Path to a binary cache of the auth file, see
+    * AuthFileCache. If empty, the XML file is always parsed.
+    */
+    FileAuthSourceMapper(const std::string &auth_file,
+                         const std::string &cache_file = "");
+
+    /**
+    * Build the mapper from already parsed content.
+    *
+    * @param auth_file Path to the XML auth file, for error reporting.
+    * @param data Content of the auth file.
+    */
+    FileAuthSourceMapper(const std::string &auth_file,
+                         std::shared_ptr<const AuthFileData> data);
+
+    /**
+    * Load the current content of the auth file and build the
+    * corresponding mapper.
+    *
+    * See update().
+    */
+    FileAuthSourceMapperPtr reload(const std::string &cache_file = "") const;
+
+    /**
+    * Build a mapper for a new version of the auth file content.
+    *
+    * When only users and credentials changed (see AuthFileDiff), the new
+    * mapper is a copy of this one with only the affected objects replaced:
+    * everything else is shared between both mappers. Other changes
+    * rebuild the mapper from scratch.
+    *
+    * Returns nullptr if the content did not change.
+    */
+    FileAuthSourceMapperPtr update(std::shared_ptr<const AuthFileData> data) const;
 
     /**
     * Try to map a wiegand card_id to a user.
@@ -76,24 +120,45 @@ class FileAuthSourceMapper
     std::vector<Leosac::Auth::GroupPtr> groups() const override;
 
   private:
+    /**
+    * Maps the id of a modified user to its new object.
+    */
+    using ReplacedUsers = std::map<Leosac::Auth::UserId, Leosac::Auth::UserPtr>;
+
+    /**
+    * Copy of the mapper, used to apply incremental changes.
+    */
+    FileAuthSourceMapper(const FileAuthSourceMapper &) = default;
+
+    static std::shared_ptr<const AuthFileData>
+    load_data(const std::string &auth_file, const std::string &cache_file);
+
+    /**
+    * Build all objects from `data`.
+    */
+    void build(std::shared_ptr<const AuthFileData> data);
+
+    /**
+    * Apply the changes to users and credentials described by `diff`.
+    *
+    * Objects that are shared with the mapper this one was copied from
+    * are never modified, but replaced.
+    */
+    void apply(const AuthFileDiff &diff);
+
     /**
     * Lookup a credentials by ID.
     */
     Cred::ICredentialPtr find_cred_by_alias(const std::string &alias);
 
     /**
-     * Build an access for a user.
+     * Build an access profile from a list of mappings.
      *
-     * This simply check for mapping which are linked directly to
-     * the given user.
+     * Each mapping contributes its schedule, either against its doors
+     * or against the default target.
      */
-    Leosac::Auth::SimpleAccessProfilePtr build_user_profile(Leosac::Auth::UserPtr u);
-
     Leosac::Auth::SimpleAccessProfilePtr
-    build_group_profile(Leosac::Auth::GroupPtr g);
-
-    Leosac::Auth::SimpleAccessProfilePtr
-    build_cred_profile(Leosac::Cred::ICredentialPtr c);
+    build_mappings_profile(const std::vector<Tools::ScheduleMappingPtr> &mappings);
 
     /**
     * Store the credential to the id <-> credential map if the id is
@@ -102,43 +167,87 @@ class FileAuthSourceMapper
     void add_cred_to_id_map(Leosac::Cred::ICredentialPtr credential);
 
     /**
-    * Load users from configuration tree, storing them
-    * in the `users_` map.
+    * Create the users, storing them in the `users_` map.
     */
-    void load_users(const boost::property_tree::ptree &users);
+    void load_users(const std::vector<AuthFileData::User> &users);
+
+    Leosac::Auth::UserPtr make_user(const AuthFileData::User &entry,
+                                    Leosac::Auth::UserId id) const;
 
     /**
-    * Load the schedules information from the config tree.
-    * @param schedules The `<schedules>` subtree.
+    * Create the schedules, storing them in the `schedules_` map.
     */
-    void load_schedules(const boost::property_tree::ptree &schedules);
+    void load_schedules(const std::vector<AuthFileData::Schedule> &schedules);
 
     /**
     * Interpret the schedule mapping content of the config file.
     * This effectively build access profile for user.
     */
-    void map_schedules(const boost::property_tree::ptree &schedules_mapping);
+    void map_schedules(const std::vector<AuthFileData::Mapping> &mappings);
+
+    /**
+    * Create the groups, and their membership.
+    */
+    void load_groups(const std::vector<AuthFileData::Group> &groups);
+
+    /**
+    * Create a group. Its members must already exist.
+    */
+    Leosac::Auth::GroupPtr make_group(const AuthFileData::Group &entry,
+                                      Leosac::Auth::GroupId id);
 
     /**
-    * Extract group membership.
+    * Replace the groups that have one of `users` as a member, so that
+    * they reference the up to date User objects.
     */
-    void load_groups(const boost::property_tree::ptree &group_mapping);
+    void rebuild_groups(const ReplacedUsers &users);
 
     /**
     * Eager loading of credentials to avoid walking through the
-    * ptree whenever we have to grant/deny an access.
+    * configuration whenever we have to grant/deny an access.
+    */
+    void load_credentials(const std::vector<AuthFileData::Credential> &credentials);
+
+    /**
+    * Create a credential and store it in the lookup tables.
     */
-    void load_credentials(const boost::property_tree::ptree &credentials);
+    Leosac::Cred::ICredentialPtr
+    add_credential(const AuthFileData::Credential &entry);
 
     /**
-    * Naive method that bruteforce groups to try to find
-    * membership for an user.
+    * Remove a credential from the lookup tables.
+    */
+    void remove_credential(const AuthFileData::Credential &entry);
+
+    /**
+    * Replace the credentials owned by one of `users` by copies that
+    * reference the up to date User objects.
+    */
+    void reown_credentials(const ReplacedUsers &users);
+
+    /**
+    * Lookup the groups an user is member of.
+    *
+    * This relies on the membership index built by `build_access_index()`.
     *
     * @param u a non-null pointer to user.
     * @return all group the user is a member of.
     */
     std::vector<Leosac::Auth::GroupPtr> get_user_groups(Leosac::Auth::UserPtr u);
 
+    /**
+     * Precompute the access profile of each user and each credential.
+     *
+     * This is called once, at the end of the constructor, when everything
+     * has been loaded. Because the mapper is never modified afterward, the
+     * index is replaced together with the mapper when the configuration
+     * is reloaded.
+     *
+     * The resulting profiles are shared between authentication requests and
+     * must therefore not be modified.
+     */
+    void build_access_index();
+
     /**
     * Merge a bunch of profiles together and returns a new profile.
      *
@@ -148,14 +257,26 @@ class FileAuthSourceMapper
     Leosac::Auth::IAccessProfilePtr
     merge_profiles(const std::vector<Leosac::Auth::IAccessProfilePtr> profiles);
 
-    Leosac::Auth::ValidityInfo
-    extract_credentials_validity(const boost::property_tree::ptree &node);
+    static Leosac::Auth::ValidityInfo
+    make_validity(const AuthFileData::Validity &validity);
 
     /**
     * Store the name of the configuration file.
     */
     std::string config_file_;
 
+    /**
+    * Content of the file this mapper was built from. Kept to compute
+    * what changed on reload.
+    */
+    std::shared_ptr<const AuthFileData> data_;
+
+    /**
+    * Next id to give to a new user or credential.
+    */
+    Leosac::Auth::UserId next_user_id_;
+    Leosac::Cred::CredentialId next_cred_id_;
+
     /**
     * Maps user id (or name) to object.
     */
@@ -167,21 +288,28 @@ class FileAuthSourceMapper
     std::map<std::string, Leosac::Auth::GroupPtr> groups_;
 
     /**
-    * Maps card_id to object.
-    */
-    std::unordered_map<std::string, Leosac::Cred::RFIDCardPtr> rfid_cards_;
+     * Credentials that involve a given card.
+     */
+    struct CardCredentials
+    {
+        Leosac::Cred::RFIDCardPtr card;
 
+        /**
+         * Maps PIN code to card + PIN code object.
+         */
+        std::map<std::string, Leosac::Cred::RFIDCardPinPtr> with_pin;
+    };
 
     /**
-    * Maps PIN code to object.
+    * Maps card_id to the credentials of the card, alone or with
+    * a PIN code.
     */
-    std::unordered_map<std::string, Leosac::Cred::PinCodePtr> pin_codes_;
+    Leosac::Cred::CardTable<CardCredentials> cards_;
 
     /**
-    * Maps WiegandCard + PIN code to object.
+    * Maps PIN code to object.
     */
-    std::map<std::pair<std::string, std::string>, Leosac::Cred::RFIDCardPinPtr>
-        rfid_cards_pin;
+    std::unordered_map<std::string, Leosac::Cred::PinCodePtr> pin_codes_;
 
     /**
     * Maps credentials ID (from XML) to object.
@@ -189,7 +317,10 @@ class FileAuthSourceMapper
     */
     std::unordered_map<std::string, Leosac::Cred::ICredentialPtr> id_to_cred_;
 
-    Tools::XmlScheduleLoader xml_schedules_;
+    /**
+     * Maps schedule name to object.
+     */
+    std::map<std::string, Tools::ISchedulePtr> schedules_;
 
     /**
      * List of mappings defined in the configuration file.
@@ -203,9 +334,29 @@ class FileAuthSourceMapper
      */
     std::vector<Leosac::Auth::DoorPtr> doors_;
 
-    Tools::XmlNodeNameEnforcer xmlnne_;
+    /**
+     * Maps user id to the groups the user is member of.
+     */
+    std::unordered_map<Leosac::Auth::UserId, std::vector<Leosac::Auth::GroupPtr>>
+        user_groups_;
+
+    /**
+     * Maps user id to a precomputed profile (user and groups schedules).
+     *
+     * A null profile means that the user has no schedule at all.
+     */
+    std::unordered_map<Leosac::Auth::UserId, Leosac::Auth::IAccessProfilePtr>
+        user_profiles_;
+
+    /**
+     * Maps credential id to a precomputed profile (credential, owner and
+     * owner's groups schedules).
+     *
+     * A null profile means that the credential grants no access at all.
+     */
+    std::unordered_map<Cred::CredentialId, Leosac::Auth::IAccessProfilePtr>
+        cred_profiles_;
 };
-using FileAuthSourceMapperPtr = std::shared_ptr<FileAuthSourceMapper>;
 }
 }
 }
@@ -0,0 +1,265 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "XmlRecordStream.hpp"
+#include "exception/configexception.hpp"
+#include <cassert>
+#include <exception>
+#include <expat.h>
+#include <fstream>
+#include <memory>
+
+using namespace Leosac;
+using namespace Leosac::Module::Auth;
+using boost::property_tree::ptree;
+
+namespace
+{
+/**
+ * Size of the buffer the file is read into.
+ */
+constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Append `text` to `out`, mimicking the `trim_whitespace` flag of boost's
+ * read_xml(): leading and trailing whitespace is stripped and inner runs
+ * are collapsed into a single space.
+ */
+void append_normalized(std::string &out, const std::string &text)
+{
+    bool pending_space = false;
+    bool empty         = true;
+    for (char c : text)
+    {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            pending_space = !empty;
+            continue;
+        }
+        if (pending_space)
+            out.push_back(' ');
+        pending_space = false;
+        empty         = false;
+        out.push_back(c);
+    }
+}
+
+/**
+ * State shared by the expat callbacks.
+ */
+struct StreamState
+{
+    StreamState(XML_Parser p, size_t d, const XmlRecordHandler &h)
+        : parser(p)
+        , depth(d)
+        , handler(h)
+        , level(0)
+    {
+    }
+
+    XML_Parser parser;
+    size_t depth;
+    const XmlRecordHandler &handler;
+
+    /**
+     * Current nesting level. The root element is at level 1.
+     */
+    size_t level;
+
+    std::string root_name;
+    std::vector<std::string> ancestors;
+
+    std::string record_name;
+    ptree record;
+
+    /**
+     * Elements of the current record that are still open. The first one
+     * is `record` itself.
+     */
+    std::vector<ptree *> open_nodes;
+
+    /**
+     * Text seen since the last tag, in the current record.
+     */
+    std::string text;
+
+    /**
+     * Exception raised by a callback, to be rethrown once expat
+     * has returned.
+     */
+    std::exception_ptr error;
+
+    void flush_text()
+    {
+        if (!text.empty())
+        {
+            assert(!open_nodes.empty());
+            append_normalized(open_nodes.back()->data(), text);
+            text.clear();
+        }
+    }
+
+    /**
+     * Stop the parser because of the exception currently being handled.
+     */
+    void abort()
+    {
+        error = std::current_exception();
+        XML_StopParser(parser, XML_FALSE);
+    }
+};
+
+void add_attributes(ptree &node, const XML_Char **attrs)
+{
+    if (!attrs[0])
+        return;
+    ptree &xmlattr = node.push_back({"<xmlattr>", ptree()})->second;
+    for (size_t i = 0; attrs[i]; i += 2)
+        xmlattr.push_back({attrs[i], ptree(attrs[i + 1])});
+}
+
+void XMLCALL on_start(void *data, const XML_Char *name, const XML_Char **attrs)
+{
+    auto &state = *static_cast<StreamState *>(data);
+    try
+    {
+        ++state.level;
+        if (state.level == 1)
+            state.root_name = name;
+
+        if (state.level < state.depth)
+        {
+            state.ancestors.push_back(name);
+        }
+        else if (state.level == state.depth)
+        {
+            state.record_name = name;
+            state.open_nodes.assign(1, &state.record);
+            add_attributes(state.record, attrs);
+        }
+        else
+        {
+            state.flush_text();
+            ptree &child =
+                state.open_nodes.back()->push_back({name, ptree()})->second;
+            add_attributes(child, attrs);
+            state.open_nodes.push_back(&child);
+        }
+    }
+    catch (...)
+    {
+        state.abort();
+    }
+}
+
+void XMLCALL on_end(void *data, const XML_Char *)
+{
+    auto &state = *static_cast<StreamState *>(data);
+    try
+    {
+        if (state.level >= state.depth)
+        {
+            state.flush_text();
+            state.open_nodes.pop_back();
+            if (state.level == state.depth)
+            {
+                state.handler(state.ancestors, state.record_name, state.record);
+                state.record = ptree();
+            }
+        }
+        else
+        {
+            state.ancestors.pop_back();
+        }
+        --state.level;
+    }
+    catch (...)
+    {
+        state.abort();
+    }
+}
+
+void XMLCALL on_text(void *data, const XML_Char *s, int len)
+{
+    auto &state = *static_cast<StreamState *>(data);
+    if (state.level < state.depth)
+        return;
+    try
+    {
+        state.text.append(s, static_cast<size_t>(len));
+    }
+    catch (...)
+    {
+        state.abort();
+    }
+}
+
+struct ParserDeleter
+{
+    void operator()(XML_Parser p) const
+    {
+        XML_ParserFree(p);
+    }
+};
+}
+
+std::string Leosac::Module::Auth::streamXmlRecords(const std::string &path,
+                                                   size_t depth,
+                                                   const XmlRecordHandler &handler)
+{
+    assert(depth > 0);
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.good())
+        throw ConfigException(path, "Could not open file {" + path + "}");
+
+    std::unique_ptr<XML_ParserStruct, ParserDeleter> parser(
+        XML_ParserCreate(nullptr));
+    if (!parser)
+        throw std::bad_alloc();
+
+    StreamState state(parser.get(), depth, handler);
+    XML_SetUserData(parser.get(), &state);
+    XML_SetElementHandler(parser.get(), &on_start, &on_end);
+    XML_SetCharacterDataHandler(parser.get(), &on_text);
+
+    bool done = false;
+    while (!done)
+    {
+        void *buffer = XML_GetBuffer(parser.get(), CHUNK_SIZE);
+        if (!buffer)
+            throw std::bad_alloc();
+        ifs.read(static_cast<char *>(buffer), CHUNK_SIZE);
+        if (ifs.bad())
+            throw ConfigException(path, "Failed to read file {" + path + "}");
+        auto len = ifs.gcount();
+        done     = len == 0;
+
+        if (XML_ParseBuffer(parser.get(), static_cast<int>(len), done) !=
+            XML_STATUS_OK)
+        {
+            if (state.error)
+                std::rethrow_exception(state.error);
+            throw ConfigException(
+                path, "Invalid XML at line " +
+                          std::to_string(XML_GetCurrentLineNumber(parser.get())) +
+                          ": " + XML_ErrorString(XML_GetErrorCode(parser.get())));
+        }
+    }
+    return state.root_name;
+}
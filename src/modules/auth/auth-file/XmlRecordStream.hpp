@@ -0,0 +1,67 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <boost/property_tree/ptree.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace Auth
+{
+/**
+ * Called for each record found by streamXmlRecords().
+ *
+ * @param ancestors Names of the elements enclosing the record, starting
+ * with the root element.
+ * @param name Name of the record element.
+ * @param record Content of the record.
+ */
+using XmlRecordHandler =
+    std::function<void(const std::vector<std::string> &ancestors,
+                       const std::string &name,
+                       const boost::property_tree::ptree &record)>;
+
+/**
+ * Parse a XML file without building a tree for the whole document.
+ *
+ * The file is read by chunks and fed to a SAX parser. Only the elements
+ * nested `depth` levels deep (the root element being at depth 1) are
+ * materialized: each of them is turned into a small property tree and
+ * passed to `handler`, then discarded. Memory usage is thus bounded by the
+ * size of the biggest record rather than by the size of the file.
+ *
+ * A record has the layout that Tools::propertyTreeFromXmlFile() would
+ * give it: comments are dropped, whitespace is trimmed, and attributes are
+ * stored under a `<xmlattr>` child.
+ *
+ * Exceptions thrown by `handler` stop the parsing and are propagated.
+ *
+ * @return The name of the root element.
+ */
+std::string streamXmlRecords(const std::string &path, size_t depth,
+                             const XmlRecordHandler &handler);
+}
+}
+}
@@ -23,6 +23,7 @@
 #include "core/GetServiceRegistry.hpp"
 #include "exception/EntityNotFound.hpp"
 #include "exception/ModelException.hpp"
+#include "exception/configexception.hpp"
 #include "exception/gpioexception.hpp"
 #include "hardware/GPIO_odb.h"
 #include "hardware/facades/FGPIO.hpp"
@@ -117,15 +118,29 @@ void PFDigitalModule::run()
             return p.next_update();
         };
 
+        auto capture_transform =
+            [](const std::unique_ptr<Hardware::WiegandCapture> &c) {
+                return c->next_update();
+            };
+
         auto timeout = Tools::compute_timeout(
             boost::make_transform_iterator(gpios_.begin(), itr_transform),
             boost::make_transform_iterator(gpios_.end(), itr_transform));
+        auto capture_timeout = Tools::compute_timeout(
+            boost::make_transform_iterator(wiegand_captures_.begin(),
+                                           capture_transform),
+            boost::make_transform_iterator(wiegand_captures_.end(),
+                                           capture_transform));
+        if (timeout == -1 || (capture_timeout != -1 && capture_timeout < timeout))
+            timeout = capture_timeout;
+
         reactor_.poll(timeout);
         for (auto &gpio_pin : gpios_)
         {
             if (gpio_pin.next_update() < std::chrono::system_clock::now())
                 gpio_pin.update();
         }
+        publish_wiegand_frames();
     }
 
     auto ws_service = get_service_registry().get_service<WebSockAPI::Service>();
@@ -146,6 +161,7 @@ void PFDigitalModule::handle_interrupt()
     ASSERT_LOG(ret >= 0,
                "Lseeking on interrupt_fd gave unexpected return value: " << ret);
 
+    auto now = std::chrono::system_clock::now();
     for (uint8_t hwaddr = 0; hwaddr < 4; ++hwaddr)
     {
         uint8_t states = pifacedigital_read_reg(0x11, hwaddr);
@@ -154,29 +170,85 @@ void PFDigitalModule::handle_interrupt()
             if (((states >> i) & 0x01) == 0)
             {
                 // signal interrupt if needed (ie the pin is registered in config)
-                std::string gpio_name;
-                if (get_input_pin_name(gpio_name, i, hwaddr))
+                PFDigitalPin *pin = get_input_pin(i, hwaddr);
+                if (pin && pin->wiegand_capture_)
+                {
+                    pin->wiegand_capture_->push_bit(pin->wiegand_bit_, now);
+                }
+                else if (pin)
                 {
                     bus_push_.send(zmqpp::message()
-                                   << std::string("S_INT:" + gpio_name));
+                                   << std::string("S_INT:" + pin->name_));
                 }
             }
         }
     }
 }
 
-bool PFDigitalModule::get_input_pin_name(std::string &dest, int idx, uint8_t hw_addr)
+PFDigitalPin *PFDigitalModule::get_input_pin(int idx, uint8_t hw_addr)
 {
-    for (const auto &gpio : gpios_)
+    for (auto &gpio : gpios_)
     {
         if (gpio.gpio_no_ == idx && gpio.direction_ == PFDigitalPin::Direction::In &&
             gpio.hardware_address_ == hw_addr)
         {
-            dest = gpio.name_;
-            return true;
+            return &gpio;
+        }
+    }
+    return nullptr;
+}
+
+void PFDigitalModule::process_wiegand_captures(
+    const boost::property_tree::ptree &cfg)
+{
+    using Hardware::WiegandCapture;
+    auto find_input_pin = [this](const std::string &name) {
+        for (auto &gpio : gpios_)
+        {
+            if (gpio.name_ == name && gpio.direction_ == PFDigitalPin::Direction::In)
+                return &gpio;
+        }
+        throw ConfigException("main",
+                              "Wiegand capture: no input GPIO named " + name);
+    };
+
+    auto captures_cfg = cfg.get_child_optional("wiegand_captures");
+    if (!captures_cfg)
+        return;
+
+    for (auto &node : *captures_cfg)
+    {
+        const auto &capture_cfg = node.second;
+        std::string high        = capture_cfg.get<std::string>("high");
+        std::string low         = capture_cfg.get<std::string>("low");
+        auto frame_gap          = std::chrono::milliseconds(capture_cfg.get<int>(
+            "frame_gap", WiegandCapture::DEFAULT_FRAME_GAP.count()));
+
+        INFO("Decoding Wiegand frames from GPIO " << high << " and " << low);
+        wiegand_captures_.push_back(
+            std::make_unique<WiegandCapture>(high, low, frame_gap));
+
+        PFDigitalPin *high_pin     = find_input_pin(high);
+        high_pin->wiegand_capture_ = wiegand_captures_.back().get();
+        high_pin->wiegand_bit_     = true;
+
+        PFDigitalPin *low_pin     = find_input_pin(low);
+        low_pin->wiegand_capture_ = wiegand_captures_.back().get();
+        low_pin->wiegand_bit_     = false;
+    }
+}
+
+void PFDigitalModule::publish_wiegand_frames()
+{
+    auto now = std::chrono::system_clock::now();
+    for (auto &capture : wiegand_captures_)
+    {
+        if (capture->frame_complete(now))
+        {
+            auto msg = capture->take_frame();
+            bus_push_.send(msg);
         }
     }
-    return false;
 }
 
 void PFDigitalModule::process_xml_config(const boost::property_tree::ptree &cfg)
@@ -208,6 +280,7 @@ void PFDigitalModule::process_xml_config(const boost::property_tree::ptree &cfg)
         utils_->config_checker().register_object(gpio_name,
                                                  ConfigChecker::ObjectType::GPIO);
     }
+    process_wiegand_captures(module_config);
 }
 
 void PFDigitalModule::process_config()
@@ -247,6 +320,8 @@ void PFDigitalModule::setup_database()
 {
     using namespace odb;
     using namespace odb::core;
+    // Schema creation and migration must not run concurrently.
+    std::lock_guard<std::mutex> guard(utils_->setup_mutex());
     auto db          = utils_->database();
     schema_version v = db->schema_version("module_pifacedigital");
     schema_version cv(schema_catalog::current_version(*db, "module_pifacedigital"));
@@ -133,7 +133,26 @@ class PFDigitalModule : public BaseModule
      * @param hw_addr The underlying hardware address of the pifacedigital.
      * @return True if we found the pin, false otherwise.
      */
-    bool get_input_pin_name(std::string &dest, int idx, uint8_t hw_addr);
+    /**
+     * Find the input pin `idx` of the board at `hw_addr`.
+     *
+     * @return nullptr if the pin is not configured.
+     */
+    PFDigitalPin *get_input_pin(int idx, uint8_t hw_addr);
+
+    /**
+     * Process the optional `wiegand_captures` XML configuration.
+     *
+     * Must be called once the GPIO pins are created.
+     */
+    void process_wiegand_captures(const boost::property_tree::ptree &cfg);
+
+    /**
+     * Publish the frames of the Wiegand captures that are complete.
+     */
+    void publish_wiegand_frames();
+
+    std::vector<std::unique_ptr<Hardware::WiegandCapture>> wiegand_captures_;
 
     /**
     * File descriptor of the PIN that triggers interrupts. This is card and will not
@@ -31,6 +31,8 @@ PFDigitalPin::PFDigitalPin(zmqpp::context &ctx, const std::string &name, int gpi
     , default_value_(value)
     , hardware_address_(hardware_address)
     , want_update_(false)
+    , wiegand_capture_(nullptr)
+    , wiegand_bit_(false)
 {
     DEBUG("trying to bind to " << ("inproc://" + name));
     sock_.bind("inproc://" + name);
@@ -57,6 +59,8 @@ PFDigitalPin::PFDigitalPin(PFDigitalPin &&o)
     this->bus_push_         = o.bus_push_;
     this->want_update_      = o.want_update_;
     this->hardware_address_ = o.hardware_address_;
+    this->wiegand_capture_  = o.wiegand_capture_;
+    this->wiegand_bit_      = o.wiegand_bit_;
 
     o.bus_push_ = nullptr;
 }
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "hardware/GPIO.hpp"
+#include "hardware/WiegandCapture.hpp"
 #include <chrono>
 #include <string>
 #include <zmqpp/zmqpp.hpp>
@@ -142,4 +143,15 @@ struct PFDigitalPin
     * Does this object wants to be `update()`d ?
     */
     bool want_update_;
+
+    /**
+    * Wiegand capture this pin is a data line of, if any. When set, interrupts
+    * on this pin are fed to the capture instead of being published.
+    */
+    Leosac::Hardware::WiegandCapture *wiegand_capture_;
+
+    /**
+    * Value of the Wiegand bit an interrupt on this pin stands for.
+    */
+    bool wiegand_bit_;
 };
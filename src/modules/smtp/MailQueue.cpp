@@ -0,0 +1,520 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MailQueue.hpp"
+#include "tools/Colorize.hpp"
+#include "tools/MyTime.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <curl/curl.h>
+#include <fstream>
+#include <json.hpp>
+#include <sstream>
+
+using namespace Leosac;
+using namespace Leosac::Module;
+using namespace Leosac::Module::SMTP;
+
+constexpr std::chrono::milliseconds MailQueue::MAX_RETRY_DELAY;
+constexpr size_t MailQueue::MAX_DIGEST_ENTRIES;
+
+/**
+ * A server, and the curl handle that holds the connection to it.
+ */
+struct MailQueue::Connection
+{
+    SMTPServerInfo server;
+    CURL *easy;
+};
+
+namespace
+{
+/**
+ * The mail, as it is uploaded to the server.
+ */
+struct UploadStatus
+{
+    std::string content;
+    size_t offset;
+};
+
+std::string build_mail_str(const MailInfo &mail)
+{
+    std::stringstream ss;
+
+    ss << "Date: " << to_local_rfc2822(std::chrono::system_clock::now()) << "\r\n";
+    ss << "To: " << mail.to.at(0) << "\r\n";
+
+    ss << "Subject: " << mail.title << "\r\n";
+    ss << "\r\n"; // empty line to divide headers from body, see RFC5322
+    ss << mail.body << "\r\n\r\n";
+
+    return ss.str();
+}
+
+/**
+ * Callback for libcurl.
+ *
+ * CURL invokes this to get the data it should send to the server.
+ */
+size_t read_callback(void *ptr, size_t size, size_t nmemb, void *userp)
+{
+    auto st          = static_cast<UploadStatus *>(userp);
+    auto available   = st->content.size() - st->offset;
+    auto to_transfer = std::min(available, size * nmemb);
+
+    std::memcpy(ptr, st->content.data() + st->offset, to_transfer);
+    st->offset += to_transfer;
+    return to_transfer;
+}
+
+/**
+ * Configure a handle to send mails through `server`.
+ */
+void setup_handle(CURL *curl, const SMTPServerInfo &server)
+{
+    if (!server.CA_info_file_.empty())
+        curl_easy_setopt(curl, CURLOPT_CAINFO, server.CA_info_file_.c_str());
+    if (!server.verify_host)
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    if (!server.verify_peer)
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    if (server.username.size())
+        curl_easy_setopt(curl, CURLOPT_USERNAME, server.username.c_str());
+    if (server.password.size())
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, server.password.c_str());
+    if (server.from.size())
+        curl_easy_setopt(curl, CURLOPT_MAIL_FROM, server.from.c_str());
+    curl_easy_setopt(curl, CURLOPT_URL, server.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(server.ms_timeout));
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, &read_callback);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+}
+}
+
+MailQueue::MailQueue(const Config &config,
+                     const std::vector<SMTPServerInfo> &servers)
+    : config_(config)
+    , next_id_(1)
+    , servers_(servers)
+    , servers_generation_(1)
+    , stats_()
+    , total_latency_(Clock::duration::zero())
+    , stopping_(false)
+{
+    if (!config_.spool_dir.empty())
+    {
+        boost::filesystem::create_directories(config_.spool_dir);
+        spool_load();
+    }
+    thread_ = std::thread([this]() { run(); });
+}
+
+MailQueue::~MailQueue()
+{
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    size_t lost = 0;
+    for (auto &pending : queue_)
+    {
+        if (pending.result)
+            pending.result->set_value(false);
+        else if (config_.spool_dir.empty())
+            ++lost;
+    }
+    if (lost)
+        WARN("SMTP module shutting down: " << lost << " queued mails are lost.");
+}
+
+void MailQueue::set_servers(const std::vector<SMTPServerInfo> &servers)
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    servers_ = servers;
+    ++servers_generation_;
+}
+
+void MailQueue::enqueue(const MailInfo &mail)
+{
+    if (mail.to.empty())
+    {
+        WARN("No recipient for mail titled " << Colorize::cyan(mail.title) << '.');
+        return;
+    }
+
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lg(mutex_);
+    if (config_.digest_window.count())
+    {
+        // Mails wait in the queue until the end of their digest window,
+        // so a similar mail still waiting is one we can merge into.
+        auto similar = std::find_if(
+            queue_.begin(), queue_.end(), [&](const PendingMail &pending) {
+                return !pending.result && pending.attempt == 0 &&
+                       pending.send_at > now && pending.to == mail.to &&
+                       pending.title == mail.title;
+            });
+        if (similar != queue_.end())
+        {
+            if (similar->bodies.size() < MAX_DIGEST_ENTRIES)
+                similar->bodies.push_back(mail.body);
+            similar->count++;
+            stats_.coalesced++;
+            spool_write(*similar);
+            return;
+        }
+    }
+
+    if (queue_.size() >= config_.max_queue_size)
+    {
+        WARN("SMTP queue is full. Dropping mail titled "
+             << Colorize::cyan(mail.title) << '.');
+        stats_.dropped++;
+        return;
+    }
+
+    PendingMail pending;
+    pending.id        = next_id_++;
+    pending.to        = mail.to;
+    pending.title     = mail.title;
+    pending.bodies    = {mail.body};
+    pending.count     = 1;
+    pending.queued_at = now;
+    pending.send_at   = now + config_.digest_window;
+    pending.attempt   = 0;
+    spool_write(pending);
+    queue_.push_back(std::move(pending));
+    stats_.max_queue_depth = std::max(stats_.max_queue_depth, queue_.size());
+    cv_.notify_one();
+}
+
+std::future<bool> MailQueue::send(const MailInfo &mail)
+{
+    PendingMail pending;
+    pending.to        = mail.to;
+    pending.title     = mail.title;
+    pending.bodies    = {mail.body};
+    pending.count     = 1;
+    pending.queued_at = Clock::now();
+    pending.send_at   = pending.queued_at;
+    pending.attempt   = 0;
+    pending.result    = std::make_shared<std::promise<bool>>();
+    auto future       = pending.result->get_future();
+
+    if (mail.to.empty())
+    {
+        WARN("No recipient for mail titled " << Colorize::cyan(mail.title) << '.');
+        pending.result->set_value(false);
+        return future;
+    }
+
+    std::lock_guard<std::mutex> lg(mutex_);
+    pending.id = next_id_++;
+    queue_.push_front(std::move(pending));
+    stats_.max_queue_depth = std::max(stats_.max_queue_depth, queue_.size());
+    cv_.notify_one();
+    return future;
+}
+
+MailQueue::Stats MailQueue::stats() const
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    Stats stats       = stats_;
+    stats.queue_depth = queue_.size();
+    if (stats.sent)
+    {
+        stats.average_latency =
+            std::chrono::duration_cast<std::chrono::microseconds>(total_latency_) /
+            stats.sent;
+    }
+    return stats;
+}
+
+void MailQueue::run()
+{
+    std::vector<Connection> connections;
+    uint64_t generation = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        // Mails from send() are due as soon as they are queued, and have a
+        // caller waiting on them: they go before any queued mail.
+        auto now  = Clock::now();
+        auto next = std::min_element(queue_.begin(), queue_.end(),
+                                     [](const PendingMail &a, const PendingMail &b) {
+                                         if (!a.result != !b.result)
+                                             return !!a.result;
+                                         return a.send_at < b.send_at;
+                                     });
+        if (next == queue_.end())
+        {
+            cv_.wait(lock);
+            continue;
+        }
+        if (next->send_at > now)
+        {
+            cv_.wait_until(lock, next->send_at);
+            continue;
+        }
+
+        PendingMail pending = std::move(*next);
+        queue_.erase(next);
+
+        if (generation != servers_generation_)
+        {
+            for (auto &connection : connections)
+                curl_easy_cleanup(connection.easy);
+            connections.clear();
+            for (const auto &server : servers_)
+            {
+                if (!server.enabled)
+                    continue;
+                CURL *easy = curl_easy_init();
+                if (!easy)
+                {
+                    ERROR("Cannot initialize curl_easy.");
+                    continue;
+                }
+                setup_handle(easy, server);
+                connections.push_back({server, easy});
+            }
+            generation = servers_generation_;
+        }
+
+        lock.unlock();
+        auto mail = build_mail(pending);
+        bool sent = deliver(connections, mail);
+        lock.lock();
+
+        if (sent)
+        {
+            auto latency = Clock::now() - pending.queued_at;
+            stats_.sent++;
+            total_latency_ += latency;
+            stats_.max_latency = std::max(
+                stats_.max_latency,
+                std::chrono::duration_cast<std::chrono::microseconds>(latency));
+        }
+
+        if (pending.result)
+        {
+            if (!sent)
+                stats_.failed++;
+            pending.result->set_value(sent);
+        }
+        else if (sent)
+        {
+            spool_remove(pending.id);
+        }
+        else if (pending.attempt < config_.max_retries)
+        {
+            auto delay = std::min<std::chrono::milliseconds>(
+                config_.retry_delay * (1 << std::min(pending.attempt, 16u)),
+                MAX_RETRY_DELAY);
+            pending.attempt++;
+            pending.send_at = Clock::now() + delay;
+            stats_.retries++;
+            queue_.push_back(std::move(pending));
+        }
+        else
+        {
+            WARN("Giving up on mail titled " << Colorize::cyan(pending.title)
+                                             << " after " << pending.attempt + 1
+                                             << " attempts.");
+            stats_.failed++;
+            spool_remove(pending.id);
+        }
+    }
+    lock.unlock();
+
+    for (auto &connection : connections)
+        curl_easy_cleanup(connection.easy);
+}
+
+bool MailQueue::deliver(std::vector<Connection> &connections, const MailInfo &mail)
+{
+    if (connections.empty())
+    {
+        WARN("Cannot send mail titled " << Colorize::cyan(mail.title)
+                                        << ". No SMTP server configured.");
+        return false;
+    }
+
+    struct curl_slist *recipients = nullptr;
+    for (const auto &recipient : mail.to)
+        recipients = curl_slist_append(recipients, recipient.c_str());
+
+    UploadStatus status{build_mail_str(mail), 0};
+    for (auto &connection : connections)
+    {
+        CURL *curl    = connection.easy;
+        status.offset = 0;
+        curl_easy_setopt(curl, CURLOPT_MAIL_RCPT, recipients);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &status);
+
+        auto res         = curl_easy_perform(curl);
+        long nb_connects = 0;
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &nb_connects);
+        {
+            std::lock_guard<std::mutex> lg(mutex_);
+            stats_.connections += nb_connects;
+        }
+
+        if (res == CURLE_OK)
+        {
+            curl_slist_free_all(recipients);
+            INFO("Mail titled " << Colorize::cyan(mail.title) << " has been sent.");
+            return true;
+        }
+        WARN("Failed to send mail titled "
+             << Colorize::cyan(mail.title) << " through "
+             << connection.server.url << ": " << curl_easy_strerror(res));
+    }
+    curl_slist_free_all(recipients);
+    return false;
+}
+
+MailInfo MailQueue::build_mail(const PendingMail &pending)
+{
+    MailInfo mail;
+    mail.to = pending.to;
+    if (pending.count == 1)
+    {
+        mail.title = pending.title;
+        mail.body  = pending.bodies.front();
+        return mail;
+    }
+
+    std::stringstream ss;
+    mail.title = pending.title + " (" + std::to_string(pending.count) + " alerts)";
+    ss << pending.count << " alerts were raised:";
+    for (const auto &body : pending.bodies)
+        ss << "\r\n\r\n----\r\n\r\n" << body;
+    if (pending.count > pending.bodies.size())
+    {
+        ss << "\r\n\r\n----\r\n\r\n"
+           << pending.count - pending.bodies.size() << " more alerts omitted.";
+    }
+    mail.body = ss.str();
+    return mail;
+}
+
+std::string MailQueue::spool_path(uint64_t id) const
+{
+    return config_.spool_dir + "/" + std::to_string(id) + ".mail";
+}
+
+void MailQueue::spool_write(const PendingMail &pending) const
+{
+    if (config_.spool_dir.empty())
+        return;
+
+    nlohmann::json content = {{"to", pending.to},
+                              {"title", pending.title},
+                              {"bodies", pending.bodies},
+                              {"count", pending.count}};
+    // Write then rename, so a crash never leaves a truncated file behind.
+    auto path = spool_path(pending.id);
+    {
+        std::ofstream ofs(path + ".tmp", std::ios::trunc);
+        ofs << content.dump();
+        if (!ofs)
+        {
+            WARN("Cannot write spooled mail " << path << '.');
+            return;
+        }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(path + ".tmp", path, ec);
+    if (ec)
+        WARN("Cannot write spooled mail " << path << ": " << ec.message());
+}
+
+void MailQueue::spool_remove(uint64_t id) const
+{
+    if (config_.spool_dir.empty())
+        return;
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(spool_path(id), ec);
+    if (ec)
+    {
+        WARN("Cannot remove spooled mail " << spool_path(id) << ": "
+                                           << ec.message());
+    }
+}
+
+void MailQueue::spool_load()
+{
+    namespace fs = boost::filesystem;
+
+    std::vector<uint64_t> ids;
+    for (const auto &entry : fs::directory_iterator(config_.spool_dir))
+    {
+        const auto &path = entry.path();
+        if (path.extension() != ".mail")
+            continue;
+        try
+        {
+            ids.push_back(std::stoull(path.stem().string()));
+        }
+        catch (const std::exception &)
+        {
+            WARN("Ignoring unexpected file " << path.string() << " in SMTP spool.");
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    auto now = Clock::now();
+    for (auto id : ids)
+    {
+        try
+        {
+            std::ifstream ifs(spool_path(id));
+            auto content = nlohmann::json::parse(ifs);
+
+            PendingMail pending;
+            pending.id        = id;
+            pending.to        = content.at("to").get<std::vector<std::string>>();
+            pending.title     = content.at("title").get<std::string>();
+            pending.bodies    = content.at("bodies").get<std::vector<std::string>>();
+            pending.count     = content.at("count").get<size_t>();
+            pending.queued_at = now;
+            pending.send_at   = now;
+            pending.attempt   = 0;
+            queue_.push_back(std::move(pending));
+        }
+        catch (const std::exception &e)
+        {
+            WARN("Cannot load spooled mail " << spool_path(id) << ": " << e.what());
+        }
+        next_id_ = std::max(next_id_, id + 1);
+    }
+    stats_.max_queue_depth = queue_.size();
+    if (!queue_.empty())
+        INFO("SMTP module loaded " << queue_.size() << " spooled mails.");
+}
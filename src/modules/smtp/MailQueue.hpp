@@ -0,0 +1,284 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SMTPConfig.hpp"
+#include "tools/Mail.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace SMTP
+{
+/**
+ * Outgoing mail queue of the SMTP module.
+ *
+ * Mails are delivered by a dedicated thread, so that queuing a mail never
+ * blocks on the network. The thread keeps one curl handle per server for
+ * its whole lifetime: libcurl then reuses the SMTP connection (and its TLS
+ * session) from one mail to the next.
+ *
+ * Mails sent to the same recipients with the same subject within
+ * `digest_window` are coalesced into a single digest mail. This prevents
+ * an alert storm from flooding mailboxes (and the SMTP server).
+ *
+ * If a spool directory is configured, each queued mail is also written
+ * there until it is delivered, and mails left by a previous run are
+ * queued again on startup.
+ *
+ * Delivery is retried with an exponential backoff when no server accepts
+ * the mail.
+ */
+class MailQueue
+{
+  public:
+    struct Config
+    {
+        Config()
+            : digest_window(0)
+            , max_queue_size(1000)
+            , max_retries(5)
+            , retry_delay(5000)
+        {
+        }
+
+        /**
+         * Directory where queued mails are persisted. Empty means the
+         * queue lives in memory only.
+         */
+        std::string spool_dir;
+
+        /**
+         * How long a mail waits for similar mails before being sent.
+         * Zero disables coalescing.
+         */
+        std::chrono::milliseconds digest_window;
+
+        /**
+         * Maximum number of mails waiting for delivery. Mails are dropped
+         * when the queue is full.
+         */
+        size_t max_queue_size;
+
+        /**
+         * How many times delivery of a mail is retried before giving up.
+         */
+        unsigned max_retries;
+
+        /**
+         * Delay before the first retry. It doubles after each failure.
+         */
+        std::chrono::milliseconds retry_delay;
+    };
+
+    struct Stats
+    {
+        /**
+         * Number of mails waiting for delivery, excluding the one
+         * being sent.
+         */
+        size_t queue_depth;
+
+        /**
+         * Highest value of `queue_depth` ever observed.
+         */
+        size_t max_queue_depth;
+
+        /**
+         * Number of mails successfully delivered. A digest counts as
+         * one mail.
+         */
+        uint64_t sent;
+
+        /**
+         * Number of mails merged into a digest instead of being
+         * queued on their own.
+         */
+        uint64_t coalesced;
+
+        /**
+         * Number of mails given up on after the last retry.
+         */
+        uint64_t failed;
+
+        /**
+         * Number of mails refused because the queue was full.
+         */
+        uint64_t dropped;
+
+        /**
+         * Number of delivery attempts that failed and were retried.
+         */
+        uint64_t retries;
+
+        /**
+         * Number of connections opened to the SMTP servers.
+         */
+        uint64_t connections;
+
+        /**
+         * Average and maximum time between the moment a mail is queued
+         * and its delivery.
+         */
+        std::chrono::microseconds average_latency;
+        std::chrono::microseconds max_latency;
+    };
+
+    /**
+     * Load the spooled mails, if any, and start the delivery thread.
+     *
+     * curl must have been globally initialized, and must outlive the queue.
+     */
+    MailQueue(const Config &config, const std::vector<SMTPServerInfo> &servers);
+
+    /**
+     * Stop the delivery thread.
+     *
+     * Mails still queued are lost, unless they are spooled.
+     */
+    ~MailQueue();
+
+    MailQueue(const MailQueue &) = delete;
+    MailQueue &operator=(const MailQueue &) = delete;
+
+    /**
+     * Replace the servers used to deliver mails. They are tried in order
+     * until one accepts the mail.
+     *
+     * @note This method is thread-safe.
+     */
+    void set_servers(const std::vector<SMTPServerInfo> &servers);
+
+    /**
+     * Queue a mail for delivery, possibly coalescing it with a similar
+     * queued mail.
+     *
+     * @note This method is thread-safe.
+     */
+    void enqueue(const MailInfo &mail);
+
+    /**
+     * Send a mail ahead of the queued ones, without coalescing it and
+     * without retrying.
+     *
+     * The future is set to whether or not the mail was accepted by
+     * a server.
+     *
+     * @note This method is thread-safe.
+     */
+    std::future<bool> send(const MailInfo &mail);
+
+    /**
+     * @note This method is thread-safe.
+     */
+    Stats stats() const;
+
+    /**
+     * Upper bound of the delay between two attempts.
+     */
+    static constexpr std::chrono::milliseconds MAX_RETRY_DELAY{300000};
+
+    /**
+     * Maximum number of mail bodies included in a digest. Further
+     * mails are only counted.
+     */
+    static constexpr size_t MAX_DIGEST_ENTRIES = 50;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingMail
+    {
+        uint64_t id;
+        std::vector<std::string> to;
+        std::string title;
+
+        /**
+         * Bodies of the coalesced mails, and how many mails were
+         * coalesced in total.
+         */
+        std::vector<std::string> bodies;
+        size_t count;
+
+        Clock::time_point queued_at;
+        Clock::time_point send_at;
+        unsigned attempt;
+
+        /**
+         * Set for mails queued through send().
+         */
+        std::shared_ptr<std::promise<bool>> result;
+    };
+
+    struct Connection;
+
+    void run();
+
+    /**
+     * Try each server in turn until one accepts the mail.
+     */
+    bool deliver(std::vector<Connection> &connections, const MailInfo &mail);
+
+    /**
+     * The mail, as it should be sent. A coalesced mail becomes a digest.
+     */
+    static MailInfo build_mail(const PendingMail &pending);
+
+    std::string spool_path(uint64_t id) const;
+    void spool_write(const PendingMail &pending) const;
+    void spool_remove(uint64_t id) const;
+    void spool_load();
+
+    Config config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+
+    std::deque<PendingMail> queue_;
+    uint64_t next_id_;
+
+    std::vector<SMTPServerInfo> servers_;
+
+    /**
+     * Incremented by set_servers(), so the delivery thread knows it has
+     * to rebuild its connections.
+     */
+    uint64_t servers_generation_;
+
+    Stats stats_;
+    Clock::duration total_latency_;
+
+    bool stopping_;
+    std::thread thread_;
+};
+}
+}
+}
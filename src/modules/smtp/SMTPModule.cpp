@@ -32,7 +32,6 @@
 #include "modules/websock-api/ExceptionConverter.hpp"
 #include "modules/websock-api/Exceptions.hpp"
 #include "modules/websock-api/Service.hpp"
-#include "tools/MyTime.hpp"
 #include "tools/registry/GlobalRegistry.hpp"
 #include <boost/asio.hpp>
 
@@ -49,10 +48,14 @@ SMTPModule::SMTPModule(zmqpp::context &ctx, zmqpp::socket *pipe,
 
     if (config_.get<bool>("module_config.want_ssl", true))
         flags |= CURL_GLOBAL_SSL;
-    if ((ret = curl_global_init(flags)) != 0)
     {
-        throw std::runtime_error("Failed to initialize curl: return code: " +
-                                 std::to_string(ret));
+        // curl_global_init() is not thread-safe.
+        std::lock_guard<std::mutex> guard(utils_->setup_mutex());
+        if ((ret = curl_global_init(flags)) != 0)
+        {
+            throw std::runtime_error("Failed to initialize curl: return code: " +
+                                     std::to_string(ret));
+        }
     }
     process_config();
 
@@ -73,7 +76,11 @@ SMTPModule::SMTPModule(zmqpp::context &ctx, zmqpp::socket *pipe,
 
 SMTPModule::~SMTPModule()
 {
-    curl_global_cleanup();
+    queue_ = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(utils_->setup_mutex());
+        curl_global_cleanup();
+    }
     auto audit_serializer_service =
         utils_->service_registry().get_service<Audit::Serializer::JSONService>();
     ASSERT_LOG(audit_serializer_service,
@@ -135,140 +142,51 @@ void SMTPModule::process_config()
         }
     }
 
+    using ms = std::chrono::milliseconds;
+    MailQueue::Config queue;
+    queue.spool_dir      = config_.get("module_config.spool_dir", "");
+    queue.digest_window  = ms(config_.get("module_config.digest_window", 0));
+    queue.max_queue_size = config_.get<size_t>("module_config.max_queue_size", 1000);
+    queue.max_retries    = config_.get<unsigned>("module_config.max_retries", 5);
+    queue.retry_delay    = ms(config_.get("module_config.retry_delay", 5000));
+    INFO("SMTP module queue: spool_dir: "
+         << Colorize::green(queue.spool_dir.empty() ? "none" : queue.spool_dir)
+         << ", digest_window: " << Colorize::green(queue.digest_window.count())
+         << "ms");
+
+    queue_ = std::make_unique<MailQueue>(queue, smtp_config_->servers());
+
     if (use_database_)
         register_ws_handlers();
 }
 
-bool SMTPModule::prepare_curl(const MailInfo &mail)
+bool SMTPModule::handle_control_request(const std::string &request,
+                                        zmqpp::message &)
 {
-    if (smtp_config_->servers().size() == 0)
-        WARN("Cannot send mail titled " << Colorize::cyan(mail.title)
-                                        << ". No SMTP server configured.");
-    if (mail.to.size() == 0)
-    {
-        WARN("No recipient for mail titled " << Colorize::cyan(mail.title) << '.');
+    if (request != "MAIL_QUEUE_STATS")
         return false;
-    }
-
-    for (const auto &target : smtp_config_->servers())
-    {
-        if (!target.enabled)
-            continue;
-
-        auto curl = curl_easy_init();
-        if (curl)
-        {
-            if (!target.CA_info_file_.empty())
-                curl_easy_setopt(curl, CURLOPT_CAINFO, target.CA_info_file_.c_str());
-            if (!target.verify_host)
-                curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-            if (!target.verify_peer)
-                curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            if (target.username.size())
-                curl_easy_setopt(curl, CURLOPT_USERNAME, target.username.c_str());
-            if (target.password.size())
-                curl_easy_setopt(curl, CURLOPT_PASSWORD, target.password.c_str());
-            if (target.from.size())
-                curl_easy_setopt(curl, CURLOPT_MAIL_FROM, target.from.c_str());
-
-            ASSERT_LOG(target.url.size(), "No mail server url.");
-            curl_easy_setopt(curl, CURLOPT_URL, target.url.c_str());
-
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, target.ms_timeout);
-
-            bool sent = send_mail(curl, mail);
-            curl_easy_cleanup(curl);
-            if (sent)
-                return true;
-        }
-        else
-        {
-            ERROR("Cannot initialize curl_easy.");
-        }
-    }
-    return false;
-}
-
-struct UploadStatus
-{
-    const MailInfo &mail;
-    int counter;
-};
-
-/**
- * Return a string representation of what the whole mail would look like.
- */
-static std::string build_mail_str(const MailInfo &mail)
-{
-    std::stringstream ss;
-
-    ASSERT_LOG(mail.to.size(), "No recipients for mail.");
-    ss << "Date: " << to_local_rfc2822(std::chrono::system_clock::now()) << "\r\n";
-    ss << "To: " << mail.to.at(0) << "\r\n";
 
-    ss << "Subject: " << mail.title << "\r\n";
-    ss << "\r\n"; // empty line to divide headers from body, see RFC5322
-    ss << mail.body << "\r\n\r\n";
-
-    return ss.str();
-}
-
-/**
- * Callback for libcurl.
- *
- * CURL invokes this to get the data it should send to the server.
- */
-static size_t read_callback(void *ptr, size_t size, size_t nmemb, void *userp)
-{
-    UploadStatus *st = static_cast<UploadStatus *>(userp);
-    ASSERT_LOG(st, "UploadStatus is null.");
-
-    std::string content = build_mail_str(st->mail);
-    auto wanted         = size * nmemb;
-    auto available      = content.size() - st->counter;
-    auto to_transfer    = std::min(available, wanted);
-
-    std::memset(ptr, 0, wanted);
-    std::memcpy(ptr, &content[0] + st->counter, to_transfer);
-    st->counter += to_transfer;
-
-    return to_transfer;
-}
-
-bool SMTPModule::send_mail(CURL *curl, const MailInfo &mail)
-{
-    ASSERT_LOG(curl, "CURL pointer is null.");
-
-    struct curl_slist *recipients = NULL;
-    for (const auto &recipient : mail.to)
-        recipients = curl_slist_append(recipients, recipient.c_str());
-    curl_easy_setopt(curl, CURLOPT_MAIL_RCPT, recipients);
-
-    UploadStatus status{.mail = mail, .counter = 0};
-
-    curl_easy_setopt(curl, CURLOPT_READFUNCTION, &read_callback);
-    curl_easy_setopt(curl, CURLOPT_READDATA, &status);
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-
-    auto res = curl_easy_perform(curl);
-    curl_slist_free_all(recipients);
-    if (res != CURLE_OK)
-    {
-        WARN("curl_easy_perform() failed: " << curl_easy_strerror(res));
-        return false;
-    }
-    else
-    {
-        INFO("Mail titled " << Colorize::cyan(mail.title) << " has been sent.");
-        return true;
-    }
+    auto s     = queue_->stats();
+    json stats = {{"queue_depth", s.queue_depth},
+                  {"max_queue_depth", s.max_queue_depth},
+                  {"sent", s.sent},
+                  {"coalesced", s.coalesced},
+                  {"failed", s.failed},
+                  {"dropped", s.dropped},
+                  {"retries", s.retries},
+                  {"connections", s.connections},
+                  {"average_latency_us", s.average_latency.count()},
+                  {"max_latency_us", s.max_latency.count()}};
+    control_.send(stats.dump());
+    return true;
 }
 
 void SMTPModule::setup_database()
 {
     using namespace odb;
     using namespace odb::core;
+    // Schema creation and migration must not run concurrently.
+    std::lock_guard<std::mutex> guard(utils_->setup_mutex());
     auto db          = utils_->database();
     schema_version v = db->schema_version("module_smtp");
     schema_version cv(schema_catalog::current_version(*db, "module_smtp"));
@@ -334,6 +252,7 @@ json SMTPModule::handle_ws_smtp_setconfig(const WebSockAPI::RequestContext &req_
         t.commit();
         smtp_config_ = std::move(cfg);
     }
+    queue_->set_servers(smtp_config_->servers());
 
     return {};
 }
@@ -348,7 +267,7 @@ json SMTPModule::handle_ws_smtp_sendmail(const WebSockAPI::RequestContext &,
     for (const auto &recipient : req.at("to"))
         mail.to.push_back(recipient);
 
-    return {{"sent", (prepare_curl(mail))}};
+    return {{"sent", queue_->send(mail).get()}};
 }
 
 void SMTPModule::on_service_event(const service_event::Event &e)
@@ -424,5 +343,5 @@ void SMTPModule::register_ws_handlers()
 
 void SMTPModule::async_send_mail(const MailInfo &mail)
 {
-    io_service_.post([this, mail]() { prepare_curl(mail); });
+    queue_->enqueue(mail);
 }
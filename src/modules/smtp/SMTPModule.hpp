@@ -20,6 +20,7 @@
 #pragma once
 
 #include "core/audit/serializers/PolymorphicAuditSerializer.hpp"
+#include "modules/smtp/MailQueue.hpp"
 #include "modules/AsioModule.hpp"
 #include "modules/smtp/SMTPFwd.hpp"
 #include "modules/websock-api/RequestContext.hpp"
@@ -51,11 +52,19 @@ class SMTPModule : public AsioModule
     /**
      * Asynchronously and thread-safely send an email.
      *
-     * This method doesn't provide a way to inform the caller of
-     * completion of his operation.
+     * The mail is queued into the MailQueue. This method doesn't provide
+     * a way to inform the caller of completion of his operation.
      */
     void async_send_mail(const MailInfo &mail);
 
+  protected:
+    /**
+     * Supports the `MAIL_QUEUE_STATS` request, that returns the
+     * MailQueue counters as JSON.
+     */
+    bool handle_control_request(const std::string &request,
+                                zmqpp::message &msg) override;
+
   private:
     /**
      * Process the websocket request "smtp.getconfig".
@@ -84,11 +93,10 @@ class SMTPModule : public AsioModule
      */
     SMTPConfigUPtr smtp_config_;
 
-    void setup_database();
+    std::unique_ptr<MailQueue> queue_;
 
-    bool prepare_curl(const MailInfo &mail);
+    void setup_database();
 
-    bool send_mail(CURL *curl, const MailInfo &mail);
     static constexpr const char *wshandler_getconfig = "module.smtp.getconfig";
     static constexpr const char *wshandler_setconfig = "module.smtp.setconfig";
     static constexpr const char *wshandler_sendmail  = "module.smtp.sendmail";
@@ -37,6 +37,8 @@ SysFsGpioPin::SysFsGpioPin(zmqpp::context &ctx, const std::string &name, int gpi
     , module_(module)
     , path_cfg_(module.general_config())
     , next_update_time_(std::chrono::system_clock::time_point::max())
+    , wiegand_capture_(nullptr)
+    , wiegand_bit_(false)
 {
     sock_.bind("inproc://" + name);
 
@@ -174,7 +176,22 @@ void SysFsGpioPin::handle_interrupt()
     ret = ::lseek(file_fd_, 0, SEEK_SET);
     ASSERT_LOG(ret >= 0, "Lseek failed on GPIO pin.");
 
-    module_.publish_on_bus(zmqpp::message() << "S_INT:" + name_);
+    if (wiegand_capture_)
+        wiegand_capture_->push_bit(wiegand_bit_);
+    else
+        module_.publish_on_bus(zmqpp::message() << "S_INT:" + name_);
+}
+
+void SysFsGpioPin::set_wiegand_capture(Hardware::WiegandCapture *capture,
+                                       bool bit_value)
+{
+    wiegand_capture_ = capture;
+    wiegand_bit_     = bit_value;
+}
+
+const std::string &SysFsGpioPin::name() const
+{
+    return name_;
 }
 
 void SysFsGpioPin::register_sockets(zmqpp::reactor *reactor)
@@ -21,6 +21,7 @@
 
 #include "SysFsGpioModule.hpp"
 #include "hardware/GPIO.hpp"
+#include "hardware/WiegandCapture.hpp"
 #include <zmqpp/zmqpp.hpp>
 
 namespace Leosac
@@ -76,6 +77,17 @@ class SysFsGpioPin
     */
     std::chrono::system_clock::time_point next_update() const;
 
+    /**
+     * Feed interrupts on this pin to a Wiegand capture instead of publishing
+     * them on the bus.
+     *
+     * @param capture The capture object, owned by the module.
+     * @param bit_value The value of the bit an interrupt represents.
+     */
+    void set_wiegand_capture(Hardware::WiegandCapture *capture, bool bit_value);
+
+    const std::string &name() const;
+
     /**
      * Update the PIN.
      *
@@ -165,6 +177,16 @@ class SysFsGpioPin
     * Time point of next wished update. (Used for timeout on `ON`)
     */
     std::chrono::system_clock::time_point next_update_time_;
+
+    /**
+    * Wiegand capture this pin is a data line of, if any.
+    */
+    Hardware::WiegandCapture *wiegand_capture_;
+
+    /**
+    * Value of the Wiegand bit an interrupt on this pin stands for.
+    */
+    bool wiegand_bit_;
 };
 }
 }
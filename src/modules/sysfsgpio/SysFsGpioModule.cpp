@@ -20,6 +20,7 @@
 #include "SysFsGpioModule.hpp"
 #include "SysFsGpioConfig.hpp"
 #include "core/kernel.hpp"
+#include "exception/configexception.hpp"
 #include "tools/log.hpp"
 #include "tools/timeout.hpp"
 #include "tools/unixfs.hpp"
@@ -105,6 +106,55 @@ void SysFsGpioModule::process_config(const boost::property_tree::ptree &cfg)
         utils_->config_checker().register_object(gpio_name,
                                                  ConfigChecker::ObjectType::GPIO);
     }
+    process_wiegand_captures(module_config);
+}
+
+void SysFsGpioModule::process_wiegand_captures(
+    const boost::property_tree::ptree &cfg)
+{
+    auto find_input_pin = [this](const std::string &name) {
+        for (auto &gpio : gpios_)
+        {
+            if (gpio->name() == name)
+                return gpio;
+        }
+        throw ConfigException("main", "Wiegand capture: no GPIO named " + name);
+    };
+
+    using Hardware::WiegandCapture;
+    auto captures_cfg = cfg.get_child_optional("wiegand_captures");
+    if (!captures_cfg)
+        return;
+
+    for (auto &node : *captures_cfg)
+    {
+        const auto &capture_cfg = node.second;
+        std::string high        = capture_cfg.get<std::string>("high");
+        std::string low         = capture_cfg.get<std::string>("low");
+        auto frame_gap          = std::chrono::milliseconds(capture_cfg.get<int>(
+            "frame_gap", WiegandCapture::DEFAULT_FRAME_GAP.count()));
+
+        INFO("Decoding Wiegand frames from GPIO " << high << " and " << low);
+        wiegand_captures_.push_back(
+            std::make_unique<WiegandCapture>(high, low, frame_gap));
+        find_input_pin(high)->set_wiegand_capture(wiegand_captures_.back().get(),
+                                                  true);
+        find_input_pin(low)->set_wiegand_capture(wiegand_captures_.back().get(),
+                                                 false);
+    }
+}
+
+void SysFsGpioModule::publish_wiegand_frames()
+{
+    auto now = std::chrono::system_clock::now();
+    for (auto &capture : wiegand_captures_)
+    {
+        if (capture->frame_complete(now))
+        {
+            auto msg = capture->take_frame();
+            publish_on_bus(msg);
+        }
+    }
 }
 
 void SysFsGpioModule::export_gpio(int gpio_no)
@@ -144,14 +194,28 @@ void SysFsGpioModule::run()
             return p->next_update();
         };
 
+        auto capture_transform =
+            [](const std::unique_ptr<Hardware::WiegandCapture> &c) {
+                return c->next_update();
+            };
+
         auto timeout = Tools::compute_timeout(
             boost::make_transform_iterator(gpios_.begin(), itr_transform),
             boost::make_transform_iterator(gpios_.end(), itr_transform));
+        auto capture_timeout = Tools::compute_timeout(
+            boost::make_transform_iterator(wiegand_captures_.begin(),
+                                           capture_transform),
+            boost::make_transform_iterator(wiegand_captures_.end(),
+                                           capture_transform));
+        if (timeout == -1 || (capture_timeout != -1 && capture_timeout < timeout))
+            timeout = capture_timeout;
+
         reactor_.poll(timeout);
         for (auto &gpio_pin : gpios_)
         {
             if (gpio_pin->next_update() < std::chrono::system_clock::now())
                 gpio_pin->update();
         }
+        publish_wiegand_frames();
     }
 }
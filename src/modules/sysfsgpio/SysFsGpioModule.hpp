@@ -21,6 +21,7 @@
 
 #include "SysFSGPIOPin.hpp"
 #include "SysFsGpioConfig.hpp"
+#include "hardware/WiegandCapture.hpp"
 #include <boost/property_tree/ptree.hpp>
 #include <modules/BaseModule.hpp>
 #include <zmqpp/reactor.hpp>
@@ -88,6 +89,18 @@ class SysFsGpioModule : public BaseModule
     */
     void export_gpio(int gpio_no);
 
+    /**
+    * Process the optional `wiegand_captures` configuration.
+    *
+    * Must be called once the GPIO pins are created.
+    */
+    void process_wiegand_captures(const boost::property_tree::ptree &cfg);
+
+    /**
+    * Publish the frames of the Wiegand captures that are complete.
+    */
+    void publish_wiegand_frames();
+
     /**
     * Socket to write the bus.
     */
@@ -102,6 +115,11 @@ class SysFsGpioModule : public BaseModule
     * General configuration for module
     */
     SysFsGpioConfig *general_cfg_;
+
+    /**
+    * Wiegand captures, decoding pairs of input pins.
+    */
+    std::vector<std::unique_ptr<Hardware::WiegandCapture>> wiegand_captures_;
 };
 }
 }
@@ -0,0 +1,342 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AccessOverviewCache.hpp"
+#include "core/auth/Door_odb.h"
+#include "core/auth/Group_odb.h"
+#include "core/auth/UserGroupMembership_odb.h"
+#include "core/auth/User_odb.h"
+#include "core/credentials/Credential_odb.h"
+#include "tools/ScheduleMapping_odb.h"
+#include "tools/Schedule_odb.h"
+#include "tools/db/OptionalTransaction.hpp"
+#include "tools/log.hpp"
+#include <chrono>
+
+using namespace Leosac;
+using namespace Leosac::Module;
+using namespace Leosac::Module::WebSockAPI;
+
+AccessOverviewCache::AccessOverviewCache(DBPtr database)
+    : database_(database)
+    , loaded_(false)
+    // Start from the current time so that the versions keep increasing
+    // across restarts, and clients' versions remain comparable.
+    , version_(std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count())
+    , base_version_(version_)
+{
+}
+
+AccessOverviewCache::Snapshot AccessOverviewCache::snapshot()
+{
+    return changes_since(0);
+}
+
+AccessOverviewCache::Snapshot AccessOverviewCache::changes_since(uint64_t version)
+{
+    std::shared_lock<std::shared_timed_mutex> shared_lock(mutex_, std::defer_lock);
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_, std::defer_lock);
+    shared_lock.lock();
+    if (!loaded_)
+    {
+        shared_lock.unlock();
+        lock.lock();
+        ensure_loaded();
+    }
+
+    Snapshot snapshot;
+    snapshot.version = version_;
+    snapshot.full    = version < base_version_ || version > version_;
+    for (const auto &door : doors_)
+    {
+        if (snapshot.full || door.second.changed_at > version)
+            snapshot.doors.push_back({door.first, door.second.user_ids});
+    }
+    if (!snapshot.full)
+    {
+        for (const auto &removed : removed_doors_)
+        {
+            if (removed.second > version)
+                snapshot.removed_doors.push_back(removed.first);
+        }
+    }
+    return snapshot;
+}
+
+template <typename Reload>
+void AccessOverviewCache::apply_change(Reload reload)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    // The change will be picked up when the cache is loaded.
+    if (!loaded_)
+        return;
+
+    affected_users_.clear();
+    affected_doors_.clear();
+    try
+    {
+        ++version_;
+        db::OptionalTransaction t(database_->begin());
+        reload();
+        t.commit();
+
+        for (const auto &user_id : affected_users_)
+            update_user(user_id);
+        for (const auto &door_id : affected_doors_)
+        {
+            if (doors_.count(door_id))
+                update_door(door_id, compute_door(door_id));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        WARN("Failed to update the access overview cache, it will be reloaded. "
+             "Error: "
+             << e.what());
+        loaded_ = false;
+    }
+}
+
+void AccessOverviewCache::group_changed(Auth::GroupId group_id)
+{
+    apply_change([&]() {
+        auto group = database_->find<Auth::Group>(group_id);
+        auto &old_members = group_members_[group_id];
+        affected_users_.insert(old_members.begin(), old_members.end());
+
+        if (!group)
+        {
+            group_members_.erase(group_id);
+            for (auto &mapping : mappings_)
+                mapping.second.groups.erase(group_id);
+            return;
+        }
+
+        std::set<Auth::UserId> members;
+        for (const auto &membership : group->user_memberships())
+            members.insert(membership->user_id());
+        affected_users_.insert(members.begin(), members.end());
+        group_members_[group_id] = std::move(members);
+    });
+}
+
+void AccessOverviewCache::credential_changed(Cred::CredentialId credential_id)
+{
+    apply_change([&]() {
+        auto credential = database_->find<Cred::Credential>(credential_id);
+        auto itr        = credential_owners_.find(credential_id);
+        if (itr != credential_owners_.end())
+        {
+            affected_users_.insert(itr->second);
+            credential_owners_.erase(itr);
+        }
+
+        if (!credential)
+        {
+            for (auto &mapping : mappings_)
+                mapping.second.credentials.erase(credential_id);
+        }
+        else if (credential->owner_id())
+        {
+            credential_owners_[credential_id] = credential->owner_id();
+            affected_users_.insert(credential->owner_id());
+        }
+    });
+}
+
+void AccessOverviewCache::schedule_changed(Tools::ScheduleId schedule_id)
+{
+    apply_change([&]() {
+        auto schedule = database_->find<Tools::Schedule>(schedule_id);
+        for (auto itr = mappings_.begin(); itr != mappings_.end();)
+        {
+            if (itr->second.schedule_id == schedule_id)
+            {
+                affected_doors_.insert(itr->second.doors.begin(),
+                                       itr->second.doors.end());
+                itr = mappings_.erase(itr);
+            }
+            else
+                ++itr;
+        }
+
+        if (!schedule)
+            return;
+        for (const auto &mapping_ptr : schedule->mapping())
+        {
+            auto mapping        = make_mapping(*mapping_ptr);
+            mapping.schedule_id = schedule_id;
+            affected_doors_.insert(mapping.doors.begin(), mapping.doors.end());
+            mappings_[mapping_ptr->id()] = std::move(mapping);
+        }
+    });
+}
+
+void AccessOverviewCache::door_changed(Auth::DoorId door_id)
+{
+    apply_change([&]() {
+        auto door = database_->find<Auth::Door>(door_id);
+        if (door)
+        {
+            if (!doors_.count(door_id))
+            {
+                doors_[door_id] = DoorEntry{{}, version_};
+                removed_doors_.erase(door_id);
+            }
+            affected_doors_.insert(door_id);
+            return;
+        }
+
+        if (doors_.erase(door_id))
+            removed_doors_[door_id] = version_;
+        for (auto &mapping : mappings_)
+            mapping.second.doors.erase(door_id);
+    });
+}
+
+void AccessOverviewCache::invalidate()
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    loaded_ = false;
+}
+
+void AccessOverviewCache::ensure_loaded()
+{
+    if (loaded_)
+        return;
+
+    mappings_.clear();
+    group_members_.clear();
+    credential_owners_.clear();
+    doors_.clear();
+    removed_doors_.clear();
+
+    db::OptionalTransaction t(database_->begin());
+    for (const auto &door : database_->query<Auth::Door>())
+        doors_[door.id()];
+    for (const auto &membership : database_->query<Auth::UserGroupMembership>())
+        group_members_[membership.group_id()].insert(membership.user_id());
+    for (const auto &credential : database_->query<Cred::Credential>())
+    {
+        if (credential.owner_id())
+            credential_owners_[credential.id()] = credential.owner_id();
+    }
+    for (const auto &mapping : database_->query<Tools::ScheduleMapping>())
+        mappings_[mapping.id()] = make_mapping(mapping);
+    t.commit();
+
+    ++version_;
+    base_version_ = version_;
+    for (auto &door : doors_)
+        door.second = DoorEntry{compute_door(door.first), version_};
+    loaded_ = true;
+    INFO("Access overview cache loaded: " << doors_.size() << " doors, "
+                                          << mappings_.size() << " mappings.");
+}
+
+std::set<Auth::UserId> AccessOverviewCache::compute_door(Auth::DoorId door_id) const
+{
+    std::set<Auth::UserId> user_ids;
+    for (const auto &id_mapping : mappings_)
+    {
+        const auto &mapping = id_mapping.second;
+        if (!mapping.doors.count(door_id))
+            continue;
+
+        user_ids.insert(mapping.users.begin(), mapping.users.end());
+        for (const auto &group_id : mapping.groups)
+        {
+            auto members = group_members_.find(group_id);
+            if (members != group_members_.end())
+                user_ids.insert(members->second.begin(), members->second.end());
+        }
+        for (const auto &credential_id : mapping.credentials)
+        {
+            auto owner = credential_owners_.find(credential_id);
+            if (owner != credential_owners_.end())
+                user_ids.insert(owner->second);
+        }
+    }
+    return user_ids;
+}
+
+void AccessOverviewCache::update_door(Auth::DoorId door_id,
+                                      std::set<Auth::UserId> user_ids)
+{
+    auto &entry = doors_[door_id];
+    if (entry.user_ids != user_ids)
+    {
+        entry.user_ids   = std::move(user_ids);
+        entry.changed_at = version_;
+    }
+}
+
+void AccessOverviewCache::update_user(Auth::UserId user_id)
+{
+    std::set<Auth::DoorId> door_ids;
+    for (const auto &id_mapping : mappings_)
+    {
+        const auto &mapping = id_mapping.second;
+        bool mapped         = mapping.users.count(user_id) > 0;
+        for (const auto &group_id : mapping.groups)
+        {
+            auto members = group_members_.find(group_id);
+            if (members != group_members_.end() && members->second.count(user_id))
+                mapped = true;
+        }
+        for (const auto &credential_id : mapping.credentials)
+        {
+            auto owner = credential_owners_.find(credential_id);
+            if (owner != credential_owners_.end() && owner->second == user_id)
+                mapped = true;
+        }
+        if (mapped)
+            door_ids.insert(mapping.doors.begin(), mapping.doors.end());
+    }
+
+    for (auto &door : doors_)
+    {
+        bool authorized = door_ids.count(door.first) > 0;
+        if (authorized == (door.second.user_ids.count(user_id) > 0))
+            continue;
+        if (authorized)
+            door.second.user_ids.insert(user_id);
+        else
+            door.second.user_ids.erase(user_id);
+        door.second.changed_at = version_;
+    }
+}
+
+AccessOverviewCache::Mapping
+AccessOverviewCache::make_mapping(const Tools::ScheduleMapping &mapping)
+{
+    Mapping m;
+    m.schedule_id = mapping.schedule_id();
+    for (const auto &user : mapping.users())
+        m.users.insert(user.object_id());
+    for (const auto &group : mapping.groups())
+        m.groups.insert(group.object_id());
+    for (const auto &credential : mapping.credentials())
+        m.credentials.insert(credential.object_id());
+    for (const auto &door : mapping.doors())
+        m.doors.insert(door.object_id());
+    return m;
+}
@@ -0,0 +1,193 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/auth/AuthFwd.hpp"
+#include "core/credentials/CredentialFwd.hpp"
+#include "tools/ToolsFwd.hpp"
+#include "tools/db/db_fwd.hpp"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WebSockAPI
+{
+/**
+ * A materialized view of which users are allowed through which doors.
+ *
+ * The cache holds, in memory, the part of the model that decides access:
+ * schedule mappings, group memberships and credential owners. From those,
+ * it maintains the set of authorized users of each door.
+ *
+ * The cache is loaded from the database on first use. Afterwards, the
+ * code that modifies the model notifies it through the `*_changed()`
+ * methods. Each notification reloads the one entity that changed and
+ * recomputes the doors it affects. Building the overview then requires
+ * no database work.
+ *
+ * Each change bumps a version number. Doors remember the version of their
+ * last change, so that clients can retrieve only the doors that changed
+ * since a version they already know.
+ *
+ * Modifications made without going through the websocket API are not
+ * seen until `invalidate()` is called.
+ *
+ * @note This class is thread-safe.
+ * @note Notifications must happen after the transaction that made
+ *       the change is committed.
+ */
+class AccessOverviewCache
+{
+  public:
+    struct DoorOverview
+    {
+        Auth::DoorId door_id;
+        std::set<Auth::UserId> user_ids;
+    };
+
+    struct Snapshot
+    {
+        /**
+         * Version of the cache this snapshot was taken at.
+         */
+        uint64_t version;
+
+        /**
+         * True if `doors` contains all the doors, false if it contains
+         * only the doors that changed since the requested version.
+         */
+        bool full;
+
+        std::vector<DoorOverview> doors;
+
+        /**
+         * Doors removed since the requested version. Always empty
+         * for a full snapshot.
+         */
+        std::vector<Auth::DoorId> removed_doors;
+    };
+
+    explicit AccessOverviewCache(DBPtr database);
+
+    AccessOverviewCache(const AccessOverviewCache &) = delete;
+    AccessOverviewCache &operator=(const AccessOverviewCache &) = delete;
+
+    /**
+     * Retrieve the overview of all doors.
+     */
+    Snapshot snapshot();
+
+    /**
+     * Retrieve the doors that changed since `version`.
+     *
+     * A full snapshot is returned if the changes since `version`
+     * are not known.
+     */
+    Snapshot changes_since(uint64_t version);
+
+    void group_changed(Auth::GroupId group_id);
+    void credential_changed(Cred::CredentialId credential_id);
+    void schedule_changed(Tools::ScheduleId schedule_id);
+    void door_changed(Auth::DoorId door_id);
+
+    /**
+     * Drop the cache. It is reloaded from the database on next use.
+     */
+    void invalidate();
+
+  private:
+    struct Mapping
+    {
+        Tools::ScheduleId schedule_id;
+        std::set<Auth::UserId> users;
+        std::set<Auth::GroupId> groups;
+        std::set<Cred::CredentialId> credentials;
+        std::set<Auth::DoorId> doors;
+    };
+
+    struct DoorEntry
+    {
+        std::set<Auth::UserId> user_ids;
+        uint64_t changed_at;
+    };
+
+    /**
+     * Load everything from the database, if needed.
+     *
+     * Must be called with an exclusive lock.
+     */
+    void ensure_loaded();
+
+    /**
+     * Run `reload`, that updates the model from the database, then recompute
+     * the doors of the affected users and the affected doors.
+     *
+     * If anything fails, the cache is invalidated.
+     */
+    template <typename Reload>
+    void apply_change(Reload reload);
+
+    /**
+     * Recompute the authorized users of a door from the in-memory model.
+     */
+    std::set<Auth::UserId> compute_door(Auth::DoorId door_id) const;
+
+    /**
+     * Store the new authorized users of a door, bumping its version
+     * if they changed.
+     */
+    void update_door(Auth::DoorId door_id, std::set<Auth::UserId> user_ids);
+
+    void update_user(Auth::UserId user_id);
+
+    static Mapping make_mapping(const Tools::ScheduleMapping &mapping);
+
+    DBPtr database_;
+
+    mutable std::shared_timed_mutex mutex_;
+    bool loaded_;
+    uint64_t version_;
+
+    /**
+     * Changes older than this version are unknown.
+     */
+    uint64_t base_version_;
+
+    std::map<Tools::ScheduleMappingId, Mapping> mappings_;
+    std::map<Auth::GroupId, std::set<Auth::UserId>> group_members_;
+    std::map<Cred::CredentialId, Auth::UserId> credential_owners_;
+    std::map<Auth::DoorId, DoorEntry> doors_;
+    std::map<Auth::DoorId, uint64_t> removed_doors_;
+
+    /**
+     * Set by the reload functions of `apply_change()`.
+     */
+    std::set<Auth::UserId> affected_users_;
+    std::set<Auth::DoorId> affected_doors_;
+};
+}
+}
+}
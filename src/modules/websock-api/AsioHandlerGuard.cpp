@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AsioHandlerGuard.hpp"
+#include "Exceptions.hpp"
+#include "RequestContext.hpp"
+#include <exception>
+
+using namespace Leosac;
+using namespace Leosac::Module::WebSockAPI;
+
+/**
+ * The state of a call, shared with the task posted on the io_service.
+ *
+ * Protected by the guard's mutex.
+ */
+struct AsioHandlerGuard::Call
+{
+    bool started   = false;
+    bool done      = false;
+    bool cancelled = false;
+    boost::optional<nlohmann::json> result;
+    std::exception_ptr error;
+};
+
+AsioHandlerGuard::AsioHandlerGuard()
+    : alive_(true)
+    , in_flight_(0)
+{
+}
+
+boost::optional<nlohmann::json>
+AsioHandlerGuard::invoke(const Handler &handler, const RequestContext &ctx,
+                         boost::asio::io_service &io)
+{
+    auto call = std::make_shared<Call>();
+    auto self = shared_from_this();
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        if (!alive_)
+            throw InvalidCall();
+        ++in_flight_;
+    }
+
+    // `ctx` lives on our stack: the task only uses it if it starts before
+    // the call is cancelled, in which case we wait for it to be done.
+    io.post([self, call, handler, &ctx]() {
+        {
+            std::lock_guard<std::mutex> lg(self->mutex_);
+            if (call->cancelled)
+                return;
+            call->started = true;
+        }
+        try
+        {
+            call->result = handler(ctx);
+        }
+        catch (...)
+        {
+            call->error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lg(self->mutex_);
+            call->done = true;
+        }
+        self->cv_.notify_all();
+    });
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return call->done || (!alive_ && !call->started); });
+    --in_flight_;
+    if (!call->done)
+        call->cancelled = true;
+    lock.unlock();
+    cv_.notify_all();
+
+    if (!call->done)
+        throw InvalidCall();
+    if (call->error)
+        std::rethrow_exception(call->error);
+    return call->result;
+}
+
+void AsioHandlerGuard::shutdown()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    alive_ = false;
+    cv_.notify_all();
+    cv_.wait(lock, [&]() { return in_flight_ == 0; });
+}
@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "WebSockFwd.hpp"
+#include <boost/asio/io_service.hpp>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WebSockAPI
+{
+class AsioHandlerGuard;
+using AsioHandlerGuardPtr = std::shared_ptr<AsioHandlerGuard>;
+
+/**
+ * Tracks the calls to an handler registered with
+ * Service::register_asio_handler(), so it can be unregistered safely.
+ *
+ * Once shutdown() returns, the handler is not running and will never run
+ * again, and its io_service is not referenced anymore.
+ *
+ * @note This class is thread-safe.
+ */
+class AsioHandlerGuard : public std::enable_shared_from_this<AsioHandlerGuard>
+{
+  public:
+    using Handler =
+        std::function<boost::optional<nlohmann::json>(const RequestContext &)>;
+
+    AsioHandlerGuard();
+
+    /**
+     * Post `handler` onto `io`, and wait for its result.
+     *
+     * @throws InvalidCall if the guard is shut down before the handler
+     * starts running.
+     */
+    boost::optional<nlohmann::json> invoke(const Handler &handler,
+                                           const RequestContext &ctx,
+                                           boost::asio::io_service &io);
+
+    /**
+     * Refuse new calls, cancel the calls whose handler did not start yet,
+     * and wait for the running ones.
+     *
+     * The calls are cancelled rather than waited for, so this does not
+     * depend on the io_service running: it may be called from the thread
+     * that runs it, or after it stopped.
+     */
+    void shutdown();
+
+  private:
+    struct Call;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool alive_;
+    int in_flight_;
+};
+}
+}
+}
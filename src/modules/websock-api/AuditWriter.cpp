@@ -0,0 +1,150 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AuditWriter.hpp"
+#include "core/audit/IWSAPICall.hpp"
+#include "tools/db/MultiplexedTransaction.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
+#include <iterator>
+#include <odb/exception.hxx>
+
+using namespace Leosac;
+using namespace Leosac::Module::WebSockAPI;
+
+constexpr size_t AuditWriter::MAX_BATCH_SIZE;
+
+AuditWriter::AuditWriter(DBPtr database)
+    : database_(database)
+    , stopping_(false)
+    , failed_(0)
+{
+    ASSERT_LOG(database_, "No database object passed into AuditWriter.");
+    thread_ = std::thread(&AuditWriter::writer_main, this);
+}
+
+AuditWriter::~AuditWriter()
+{
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void AuditWriter::finalize(Audit::IWSAPICallPtr audit, const std::string &uuid,
+                           const std::string &method, APIStatusCode status_code,
+                           const std::string &status_string,
+                           uint16_t database_operations)
+{
+    ASSERT_LOG(audit, "Cannot finalize a null audit entry.");
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        pending_.push_back(Entry{audit, uuid, method, status_code, status_string,
+                                 database_operations});
+    }
+    cond_.notify_one();
+}
+
+size_t AuditWriter::failed_count() const
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    return failed_;
+}
+
+void AuditWriter::writer_main()
+{
+    std::vector<Entry> entries;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cond_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        // Pending entries are written even when stopping.
+        if (pending_.empty())
+            break;
+
+        // Everything queued while we were writing the previous batch
+        // becomes the next batch.
+        entries.swap(pending_);
+        lock.unlock();
+
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            auto end = it + std::min<size_t>(MAX_BATCH_SIZE, entries.end() - it);
+            std::vector<Entry> batch(std::make_move_iterator(it),
+                                     std::make_move_iterator(end));
+            write_batch(batch);
+            it = end;
+        }
+        entries.clear();
+
+        lock.lock();
+    }
+}
+
+void AuditWriter::write_batch(std::vector<Entry> &batch)
+{
+    try
+    {
+        db::MultiplexedTransaction t(database_->begin());
+        for (const auto &entry : batch)
+            write_entry(entry);
+        t.commit();
+        return;
+    }
+    catch (const odb::exception &e)
+    {
+        WARN("Failed to persist a batch of " << batch.size()
+                                             << " audit entries: " << e.what()
+                                             << ". Retrying one by one.");
+    }
+
+    for (const auto &entry : batch)
+    {
+        try
+        {
+            db::MultiplexedTransaction t(database_->begin());
+            write_entry(entry);
+            t.commit();
+        }
+        catch (const odb::exception &e)
+        {
+            WARN("Failed to persist final audit for request "
+                 << entry.uuid << " (" << entry.method << "): " << e.what());
+            std::lock_guard<std::mutex> lg(mutex_);
+            failed_++;
+        }
+    }
+}
+
+void AuditWriter::write_entry(const Entry &entry)
+{
+    auto &audit = entry.audit;
+    // If something went wrong while processing the request, or if a previous
+    // batch was rolled back, the audit object may need to be reloaded. We
+    // might as well reload it every time.
+    audit->reload();
+    audit->uuid(entry.uuid);
+    audit->method(entry.method);
+    audit->status_code(entry.status_code);
+    audit->status_string(entry.status_string);
+    audit->database_operations(entry.database_operations);
+    audit->finalize();
+}
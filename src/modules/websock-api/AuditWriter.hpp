@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/APIStatusCode.hpp"
+#include "core/audit/AuditFwd.hpp"
+#include "tools/db/db_fwd.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WebSockAPI
+{
+/**
+ * Finalizes WSAPICall audit entries from a dedicated thread.
+ *
+ * The websocket thread hands over the audit entry of a request together
+ * with the final values of the request, and can send the response without
+ * waiting for the database.
+ *
+ * The writer thread finalizes all the entries queued since its previous
+ * pass in a single transaction. If that transaction fails, each entry
+ * of the batch is retried in its own transaction, so that one bad entry
+ * doesn't take the others down with it.
+ *
+ * @note The caller must not touch an audit entry once it has been queued.
+ * @note Pending entries are written before the destructor returns.
+ */
+class AuditWriter
+{
+  public:
+    /**
+     * Maximum number of entries finalized in a single transaction.
+     */
+    static constexpr size_t MAX_BATCH_SIZE = 64;
+
+    explicit AuditWriter(DBPtr database);
+    ~AuditWriter();
+
+    AuditWriter(const AuditWriter &) = delete;
+    AuditWriter &operator=(const AuditWriter &) = delete;
+
+    /**
+     * Queue the finalization of `audit`.
+     *
+     * The values are applied to the entry when it's written, because the
+     * entry is reloaded from the database first.
+     *
+     * @note This method is thread-safe.
+     */
+    void finalize(Audit::IWSAPICallPtr audit, const std::string &uuid,
+                  const std::string &method, APIStatusCode status_code,
+                  const std::string &status_string,
+                  uint16_t database_operations);
+
+    /**
+     * Number of entries that could not be persisted.
+     *
+     * @note This method is thread-safe.
+     */
+    size_t failed_count() const;
+
+  private:
+    struct Entry
+    {
+        Audit::IWSAPICallPtr audit;
+        std::string uuid;
+        std::string method;
+        APIStatusCode status_code;
+        std::string status_string;
+        uint16_t database_operations;
+    };
+
+    void writer_main();
+
+    /**
+     * Finalize the entries of `batch` in a single transaction.
+     *
+     * Fallback to one transaction per entry if that fails.
+     */
+    void write_batch(std::vector<Entry> &batch);
+
+    /**
+     * Update and finalize an entry.
+     *
+     * Must be called with an active transaction.
+     */
+    static void write_entry(const Entry &entry);
+
+    DBPtr database_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Entry> pending_;
+    bool stopping_;
+    size_t failed_;
+
+    std::thread thread_;
+};
+}
+}
+}
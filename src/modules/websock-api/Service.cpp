@@ -28,9 +28,10 @@ namespace WebSockAPI
 {
 
 bool Service::register_typed_handler(const Service::WSHandler &handler,
-                                     const std::string &type)
+                                     const std::string &type,
+                                     AsioHandlerGuardPtr guard)
 {
-    return server_.register_asio_handler(handler, type);
+    return server_.register_asio_handler(handler, type, guard);
 }
 
 void Service::unregister_handler(const std::string &name)
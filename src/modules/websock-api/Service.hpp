@@ -20,6 +20,7 @@
 #pragma once
 
 #include "ActionActionParam.hpp"
+#include "AsioHandlerGuard.hpp"
 #include "LeosacFwd.hpp"
 #include "modules/websock-api/RequestContext.hpp"
 #include "modules/websock-api/WebSockFwd.hpp"
@@ -56,33 +57,29 @@ class Service
      * Register an handler that will be invoked by the io_service `io`.
      *
      * @note This function actually wraps the user-provided handler so that
-     * it can be invoked normally from the websocket thread.
+     * it can be invoked normally from the websocket worker threads.
      */
     template <typename HandlerT>
     bool register_asio_handler(HandlerT &&handler, const std::string &type,
                                boost::asio::io_service &io)
     {
         // We want the `handler` callable to be executed in the current
-        // thread/io_service.
-
-        // We wrap the user handler into a packaged task that will be `post()`ed
-        // onto the io_service (`io`) queue.
-
-        WSHandler wrapped_handler =
-            [&, handler](const RequestContext &req_ctx) -> boost::optional<json> {
-            std::packaged_task<boost::optional<json>(const RequestContext &)> pt(
-                [&](const RequestContext &req_ctx) { return handler(req_ctx); });
-            auto future = pt.get_future();
-            io.post([&]() { pt(req_ctx); });
-            return future.get();
+        // thread/io_service: the guard posts it onto `io` and waits for
+        // the result, until the handler is unregistered.
+        auto guard = std::make_shared<AsioHandlerGuard>();
+        AsioHandlerGuard::Handler user_handler = handler;
+        WSHandler wrapped_handler = [guard, user_handler,
+                                     &io](const RequestContext &req_ctx) {
+            return guard->invoke(user_handler, req_ctx, io);
         };
-        return register_typed_handler(wrapped_handler, type);
+        return register_typed_handler(wrapped_handler, type, guard);
     }
 
     /**
      * Register a handler for a websocket message.
      *
-     * The handler will be invoked as-is in the websocket thread.
+     * The handler will be invoked as-is by one of the websocket worker
+     * threads, and may therefore run concurrently with itself.
      */
     template <typename HandlerT>
     bool register_handler(HandlerT &&handler, const std::string &type)
@@ -103,6 +100,10 @@ class Service
      * scope, the websocket module will attempt to `post()` to a dangling
      * io_service, causing a crash.
      *
+     * Once this returns, the handler is not running anymore. Calls that
+     * were waiting for the module's io_service are cancelled, so this may
+     * be called from the thread that runs it.
+     *
      * @note We assume everyone is nice and module won't remove each-other
      * handler.
      */
@@ -135,10 +136,13 @@ class Service
 
   private:
     /**
-     * Register an handler that is ready to be invoked in the
-     * websocket thread.
+     * Register an handler that is ready to be invoked by the
+     * websocket worker threads.
+     *
+     * `guard`, if any, is shut down when the handler is unregistered.
      */
-    bool register_typed_handler(const WSHandler &handler, const std::string &type);
+    bool register_typed_handler(const WSHandler &handler, const std::string &type,
+                                AsioHandlerGuardPtr guard = nullptr);
 
     WSServer &server_;
 };
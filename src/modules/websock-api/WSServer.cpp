@@ -62,10 +62,10 @@
 #include "exception/PermissionDenied.hpp"
 #include "tools/db/DBService.hpp"
 #include "tools/db/DatabaseTracer.hpp"
-#include "tools/db/MultiplexedTransaction.hpp"
 #include "tools/db/OptionalTransaction.hpp"
 #include "tools/log.hpp"
 #include "tools/registry/ThreadLocalRegistry.hpp"
+#include <algorithm>
 #include <json.hpp>
 #include <odb/session.hxx>
 
@@ -75,9 +75,12 @@ using namespace Leosac::Module::WebSockAPI;
 
 using json = nlohmann::json;
 
-WSServer::WSServer(WebSockAPIModule &module, DBPtr database)
-    : auth_(*this)
+WSServer::WSServer(WebSockAPIModule &module, DBPtr database, size_t nb_workers)
+    : nb_workers_(std::max<size_t>(nb_workers, 1))
+    , auth_(*this, database)
     , dbsrv_(std::make_shared<DBService>(database))
+    , audit_writer_(database)
+    , access_overview_(database)
     , module_(module)
 {
     ASSERT_LOG(database, "No database object passed into WSServer.");
@@ -85,6 +88,7 @@ WSServer::WSServer(WebSockAPIModule &module, DBPtr database)
     using websocketpp::lib::placeholders::_2;
     srv_.init_asio();
 
+    srv_.set_validate_handler(std::bind(&WSServer::on_validate, this, _1));
     srv_.set_open_handler(std::bind(&WSServer::on_open, this, _1));
     srv_.set_close_handler(std::bind(&WSServer::on_close, this, _1));
     srv_.set_message_handler(std::bind(&WSServer::on_message, this, _1, _2));
@@ -101,6 +105,7 @@ WSServer::WSServer(WebSockAPIModule &module, DBPtr database)
     handlers_["authenticate_with_token"] = &APISession::authenticate_with_token;
     handlers_["logout"]                  = &APISession::logout;
     handlers_["system_overview"]         = &APISession::system_overview;
+    handlers_["module_startup_timeline"] = &APISession::module_startup_timeline;
 
     individual_handlers_["audit.get"]                 = &AuditGet::create;
     individual_handlers_["get_logs"]                  = &LogGet::create;
@@ -140,11 +145,31 @@ WSServer::~WSServer()
                "Someone is still using the WSService");
 }
 
+bool WSServer::on_validate(websocketpp::connection_hdl hdl)
+{
+    auto ws_connection_ptr = srv_.get_con_from_hdl(hdl);
+    // Pick the first subprotocol we support, in the client's order of
+    // preference. Unknown subprotocols are ignored rather than rejected.
+    for (const auto &proto : ws_connection_ptr->get_requested_subprotocols())
+    {
+        if (wire_format_from_subprotocol(proto))
+        {
+            ws_connection_ptr->select_subprotocol(proto);
+            break;
+        }
+    }
+    return true;
+}
+
 void WSServer::on_open(websocketpp::connection_hdl hdl)
 {
+    auto ws_connection_ptr = srv_.get_con_from_hdl(hdl);
+    auto format = wire_format_from_subprotocol(ws_connection_ptr->get_subprotocol())
+                      .value_or(WireFormat::JSON_PRETTY);
+
     INFO("New WebSocket connection !");
     connection_session_.insert(
-        std::make_pair(hdl, std::make_shared<APISession>(*this)));
+        std::make_pair(hdl, std::make_shared<APISession>(*this, format)));
 }
 
 void WSServer::on_close(websocketpp::connection_hdl hdl)
@@ -159,45 +184,34 @@ void WSServer::on_message(websocketpp::connection_hdl hdl, Server::message_ptr m
                "Cannot retrieve API pointer from connection handle.");
     auto session_handle = connection_session_.find(hdl)->second;
 
-    // todo maybe parse first so be we can have better error handling.
+    auto ws_connection_ptr = srv_.get_con_from_hdl(hdl);
+    ASSERT_LOG(ws_connection_ptr, "No websocket connection object from handle.");
+    auto endpoint = ws_connection_ptr->get_remote_endpoint();
+
+    bool binary_frame = msg->get_opcode() == websocketpp::frame::opcode::binary;
+    session_handle->strand().post([=]() {
+        process_message(hdl, session_handle, endpoint, msg->get_payload(),
+                        binary_frame);
+    });
+}
+
+void WSServer::process_message(websocketpp::connection_hdl hdl,
+                               APIPtr session_handle, const std::string &endpoint,
+                               const std::string &payload, bool binary_frame)
+{
     auto db_req_counter = dbsrv_->operation_count();
     Audit::IWSAPICallPtr audit;
     boost::optional<ServerMessage> response = ServerMessage();
+    boost::optional<ClientMessage> input_msg;
     json req;
+
+    // Parse first, so that the audit entry is inserted with its request
+    // information in one query.
     try
     {
-        audit = Audit::Factory::WSAPICall(dbsrv_->db());
-    }
-    catch (const odb::exception &e)
-    {
-        WARN("Database Error in WServer::on_message. Aborting request processing. "
-             "Error: "
-             << e.what());
-        response->status_code   = APIStatusCode::DATABASE_ERROR;
-        response->status_string = e.what();
-        send_message(hdl, *response);
-        return;
-    }
-    try
-    {
-        audit->event_mask(Audit::EventType::WSAPI_CALL);
-        audit->author(session_handle->current_user());
-        auto ws_connection_ptr = srv_.get_con_from_hdl(hdl);
-        ASSERT_LOG(ws_connection_ptr, "No websocket connection object from handle.");
-        audit->source_endpoint(ws_connection_ptr->get_remote_endpoint());
-
-        // todo careful potential DDOS as we store the full content without checking
-        // for now.
-        audit->request_content(msg->get_payload());
-        // Parse request, and copy uuid/method into the audit object.
-        req = json::parse(msg->get_payload());
-        INFO("Incoming payload: \n" << req.dump(4));
-
-        ClientMessage input_msg = parse_request(req);
-        audit->uuid(input_msg.uuid);
-        audit->method(input_msg.type);
-        dbsrv_->update(*audit); // update audit with new info
-        response = handle_request(session_handle, input_msg, audit);
+        req = decode(payload, session_handle->wire_format(), binary_frame);
+        DEBUG("Incoming payload: \n" << req.dump(4));
+        input_msg = parse_request(req);
     }
     catch (const std::invalid_argument &e)
     {
@@ -211,12 +225,49 @@ void WSServer::on_message(websocketpp::connection_hdl hdl, Server::message_ptr m
         response->status_string = e.what();
     }
 
+    try
+    {
+        audit = Audit::Factory::WSAPICall(dbsrv_->db(), [&](Audit::IWSAPICall &a) {
+            a.event_mask(Audit::EventType::WSAPI_CALL);
+            a.author(session_handle->current_user());
+            a.source_endpoint(endpoint);
+            // todo careful potential DDOS as we store the full content without
+            // checking for now.
+            // Binary payloads are stored as their JSON equivalent.
+            if (!binary_frame)
+                a.request_content(payload);
+            else if (input_msg)
+                a.request_content(req.dump());
+            if (input_msg)
+            {
+                a.uuid(input_msg->uuid);
+                a.method(input_msg->type);
+            }
+        });
+    }
+    catch (const odb::exception &e)
+    {
+        WARN("Database Error in WServer::on_message. Aborting request processing. "
+             "Error: "
+             << e.what());
+        response->status_code   = APIStatusCode::DATABASE_ERROR;
+        response->status_string = e.what();
+        post_message(hdl, *session_handle, *response);
+        return;
+    }
+
+    if (input_msg)
+        response = handle_request(session_handle, *input_msg, audit);
+
     if (response)
     {
-        audit->database_operations(
+        // The audit entry is finalized by the writer thread: the client
+        // doesn't wait for it. The entry must not be used past this point.
+        audit_writer_.finalize(
+            audit, response->uuid, response->type, response->status_code,
+            response->status_string,
             static_cast<uint16_t>(dbsrv_->operation_count() - db_req_counter));
-        finalize_audit(audit, *response);
-        send_message(hdl, *response);
+        post_message(hdl, *session_handle, *response);
     }
 }
 
@@ -234,7 +285,19 @@ void WSServer::run(const std::string &interface, uint16_t port)
     get_service_registry().register_service<Service>(
         std::make_unique<Service>(*this));
     work_ = std::make_unique<boost::asio::io_service::work>(srv_.get_io_service());
+
+    worker_work_ = std::make_unique<boost::asio::io_service::work>(worker_io_);
+    for (size_t i = 0; i < nb_workers_; ++i)
+        workers_.emplace_back([this]() { worker_io_.run(); });
+    INFO("WebSockAPI executes requests on " << nb_workers_ << " worker threads.");
+
     srv_.run();
+
+    // Let the workers complete the requests they are processing.
+    worker_work_ = nullptr;
+    for (auto &worker : workers_)
+        worker.join();
+    workers_.clear();
     DEBUG("END OF WSServer::run()");
     ASSERT_LOG(get_service_registry().get_service<Service>() == nullptr,
                "Service has not been unregistered");
@@ -270,9 +333,25 @@ boost::optional<json> WSServer::dispatch_request(APIPtr api_handle,
                                                  const ClientMessage &in,
                                                  Audit::IAuditEntryPtr audit)
 {
+    // Permission decisions are only valid for the duration of a request,
+    // whichever handler serves it.
+    api_handle->security_context().reset_cache();
+
+    // Copy the handlers and release the lock before invoking them, or a
+    // running handler would deadlock with unregister_handler(). An asio
+    // handler that is unregistered meanwhile throws InvalidCall.
+    std::shared_lock<std::shared_timed_mutex> handlers_lock(handlers_mutex_);
+    auto asio_handler = find_handler<Service::WSHandler>(asio_handlers_, in.type);
+    auto handler_factory =
+        find_handler<MethodHandler::Factory>(individual_handlers_, in.type);
+    auto handler_method = find_handler<decltype(handlers_)::mapped_type>(
+        handlers_, in.type);
+    auto crud_handler_factory =
+        find_handler<CRUDResourceHandler::Factory>(crud_handlers_, in.type);
+    handlers_lock.unlock();
+
     // Handlers registered by others modules.
-    auto asio_handler = asio_handlers_.find(in.type);
-    if (asio_handler != asio_handlers_.end())
+    if (asio_handler)
     {
         RequestContext ctx{.session      = api_handle,
                            .dbsrv        = dbsrv_,
@@ -281,16 +360,15 @@ boost::optional<json> WSServer::dispatch_request(APIPtr api_handle,
                            .security_ctx = api_handle->security_context(),
                            .audit        = audit};
         // Will block the current thread until the response has been built.
-        return asio_handler->second(ctx);
+        return asio_handler(ctx);
     }
 
     // A request is an "Unit-of-Work" for the application.
     // We create a default database session for the request.
     odb::session database_session;
-    auto handler_factory = individual_handlers_.find(in.type);
     api_handle->hook_before_request();
 
-    if (handler_factory != individual_handlers_.end())
+    if (handler_factory)
     {
         RequestContext ctx{.session      = api_handle,
                            .dbsrv        = dbsrv_,
@@ -299,17 +377,15 @@ boost::optional<json> WSServer::dispatch_request(APIPtr api_handle,
                            .security_ctx = api_handle->security_context(),
                            .audit        = audit};
 
-        MethodHandlerUPtr method_handler = handler_factory->second(ctx);
+        MethodHandlerUPtr method_handler = handler_factory(ctx);
         return method_handler->process(in);
     }
 
-    auto handler_method = handlers_.find(in.type);
-    if (handler_method != handlers_.end())
+    if (handler_method)
     {
         if (api_handle->allowed(in.type))
         {
-            auto method_ptr = handler_method->second;
-            return ((*api_handle).*method_ptr)(in.content);
+            return ((*api_handle).*handler_method)(in.content);
         }
         else
         {
@@ -317,8 +393,7 @@ boost::optional<json> WSServer::dispatch_request(APIPtr api_handle,
         }
     }
 
-    auto crud_handler_factory = crud_handlers_.find(in.type);
-    if (crud_handler_factory == crud_handlers_.end())
+    if (!crud_handler_factory)
         throw InvalidCall();
     else
     {
@@ -329,7 +404,7 @@ boost::optional<json> WSServer::dispatch_request(APIPtr api_handle,
                            .security_ctx = api_handle->security_context(),
                            .audit        = audit};
 
-        CRUDResourceHandlerUPtr crud_handler = crud_handler_factory->second(ctx);
+        CRUDResourceHandlerUPtr crud_handler = crud_handler_factory(ctx);
         return crud_handler->process(in);
     }
 }
@@ -344,8 +419,18 @@ CoreUtilsPtr WSServer::core_utils()
     return module_.core_utils();
 }
 
-void WSServer::send_message(websocketpp::connection_hdl hdl,
-                            const ServerMessage &msg)
+boost::asio::io_service &WSServer::worker_io()
+{
+    return worker_io_;
+}
+
+AccessOverviewCache &WSServer::access_overview()
+{
+    return access_overview_;
+}
+
+void WSServer::post_message(websocketpp::connection_hdl hdl,
+                            const APISession &session, const ServerMessage &msg)
 {
     json json_message;
 
@@ -355,7 +440,32 @@ void WSServer::send_message(websocketpp::connection_hdl hdl,
     json_message["status_string"] = msg.status_string;
     json_message["content"]       = msg.content;
 
-    srv_.send(hdl, json_message.dump(4), websocketpp::frame::opcode::text);
+    // Serialize on the calling thread, to keep the websocket thread
+    // free for I/O.
+    using MessageType = WSServerConfig::message_type;
+    auto format       = session.wire_format();
+    auto payload      = encode(json_message, format);
+    auto opcode       = is_binary(format) ? websocketpp::frame::opcode::binary
+                                          : websocketpp::frame::opcode::text;
+
+    auto out = std::make_shared<MessageType>(MessageType::con_msg_man_ptr(), opcode,
+                                             payload.size());
+    out->append_payload(payload);
+    // Only has an effect if the client negotiated permessage-deflate.
+    out->set_compressed(payload.size() >= COMPRESSION_THRESHOLD);
+
+    srv_.get_io_service().post([this, hdl, out]() { send_message(hdl, out); });
+}
+
+void WSServer::send_message(websocketpp::connection_hdl hdl, Server::message_ptr msg)
+{
+    websocketpp::lib::error_code ec;
+    srv_.send(hdl, msg, ec);
+    if (ec)
+    {
+        // The connection may have been closed while the request was processed.
+        DEBUG("Failed to send websocket message: " << ec.message());
+    }
 }
 
 ClientMessage WSServer::parse_request(const json &req)
@@ -409,34 +519,46 @@ boost::optional<ServerMessage> WSServer::handle_request(APIPtr api_handle,
 
 void WSServer::clear_user_sessions(Auth::UserPtr user, APIPtr exception)
 {
-    db::OptionalTransaction t(dbsrv_->db()->begin());
+    auto user_id = user->id();
+    srv_.get_io_service().post([this, user_id, exception]() {
+        for (const auto &connection_to_session : connection_session_)
+        {
+            auto hdl     = connection_to_session.first;
+            auto session = connection_to_session.second;
+            if (session == exception)
+                continue;
+            // The session state belongs to its strand.
+            session->strand().post([this, hdl, session, user_id]() {
+                if (session->current_user_id() == user_id)
+                    clear_session(hdl, session);
+            });
+        }
+    });
+}
 
-    std::vector<Auth::TokenPtr> tokens_to_remove;
-    for (const auto &connection_to_session : connection_session_)
+void WSServer::clear_session(websocketpp::connection_hdl hdl, APIPtr session)
+{
+    // Invalidate the token.
+    if (auto token = session->current_token())
     {
-        const auto &session = connection_to_session.second;
-        if (session->current_user_id() == user->id() && exception != session)
+        try
         {
-            // Mark the token for invalidation.
-            if (auto token = session->current_token())
-                tokens_to_remove.push_back(token);
-
-            // Clear authentication status from this user.
-            session->abort_session();
-            // Notify them
-            ServerMessage msg;
-            msg.content["reason"] = "Session cleared.";
-            msg.status_code       = APIStatusCode::SUCCESS;
-            msg.type              = "session_closed";
-            send_message(connection_to_session.first, msg);
+            auth_.invalidate_token(token);
+        }
+        catch (const odb::exception &e)
+        {
+            WARN("Failed to invalidate token while clearing session: " << e.what());
         }
     }
 
-    for (const auto &token : tokens_to_remove)
-    {
-        dbsrv_->db()->erase<Auth::Token>(token->id());
-    }
-    t.commit();
+    // Clear authentication status from this user.
+    session->abort_session();
+    // Notify them
+    ServerMessage msg;
+    msg.content["reason"] = "Session cleared.";
+    msg.status_code       = APIStatusCode::SUCCESS;
+    msg.type              = "session_closed";
+    post_message(hdl, *session, msg);
 }
 
 void WSServer::register_crud_handler(const std::string &resource_name,
@@ -445,6 +567,7 @@ void WSServer::register_crud_handler(const std::string &resource_name,
     using namespace Colorize;
     DEBUG("Performing registration of CRUD handler for resource "
           << green(resource_name));
+    std::lock_guard<std::shared_timed_mutex> lg(handlers_mutex_);
     crud_handlers_[resource_name + ".read"]   = factory;
     crud_handlers_[resource_name + ".update"] = factory;
     crud_handlers_[resource_name + ".create"] = factory;
@@ -458,39 +581,14 @@ DBServicePtr WSServer::dbsrv()
 
 bool WSServer::has_handler(const std::string &name) const
 {
+    std::shared_lock<std::shared_timed_mutex> lock(handlers_mutex_);
     return handlers_.count(name) || individual_handlers_.count(name) ||
            crud_handlers_.count(name) || asio_handlers_.count(name);
 }
 
-void WSServer::finalize_audit(const Audit::IWSAPICallPtr &audit, ServerMessage &msg)
-{
-    try
-    {
-        db::MultiplexedTransaction t(dbsrv_->db()->begin());
-        // If something went wrong while processing the request, the audit object
-        // may need to be reload. We might as well reload it every time.
-        audit->reload();
-        // Update audit value.
-        audit->uuid(msg.uuid);
-        audit->method(msg.type);
-        audit->status_code(msg.status_code);
-        audit->status_string(msg.status_string);
-        // audit->response_content(msg.content.dump(4));
-        audit->finalize();
-        t.commit();
-    }
-    catch (const odb::exception &e)
-    {
-        WARN("Database Error in WServer::on_message. Failed to persist final audit: "
-             << e.what());
-        msg.status_code   = APIStatusCode::DATABASE_ERROR;
-        msg.status_string = e.what();
-        return;
-    }
-}
-
 bool WSServer::register_asio_handler(const Service::WSHandler &handler,
-                                     const std::string &name)
+                                     const std::string &name,
+                                     AsioHandlerGuardPtr guard)
 {
     DEBUG("Scheduling ASIO-based-handler registration. (name: " << name << ')');
     std::packaged_task<bool()> pt([=]() {
@@ -498,7 +596,10 @@ bool WSServer::register_asio_handler(const Service::WSHandler &handler,
             return false;
         DEBUG("Performing registration of ASIO-based-handler. (name: " << name
                                                                        << ')');
+        std::lock_guard<std::shared_timed_mutex> lg(handlers_mutex_);
         asio_handlers_[name] = handler;
+        if (guard)
+            asio_guards_[name] = guard;
         return true;
     });
     std::future<bool> future = pt.get_future();
@@ -510,17 +611,29 @@ bool WSServer::register_asio_handler(const Service::WSHandler &handler,
 void WSServer::unregister_handler(const std::string &name)
 {
     DEBUG("Scheduling removal of ASIO-based-handler (name " << name << ')');
-    std::promise<void> p;
+    std::promise<AsioHandlerGuardPtr> p;
 
     srv_.get_io_service().post([&]() {
+        std::lock_guard<std::shared_timed_mutex> lg(handlers_mutex_);
+        AsioHandlerGuardPtr guard;
+        auto it = asio_guards_.find(name);
+        if (it != asio_guards_.end())
+        {
+            guard = it->second;
+            asio_guards_.erase(it);
+        }
         asio_handlers_.erase(name);
         handlers_.erase(name);
         individual_handlers_.erase(name);
         crud_handlers_.erase(name);
-        p.set_value();
+        p.set_value(guard);
     });
 
-    return p.get_future().get();
+    // Wait for the in-flight calls from the calling thread, without
+    // holding the handlers lock.
+    auto guard = p.get_future().get();
+    if (guard)
+        guard->shutdown();
 }
 
 void WSServer::register_crud_handler_external(const std::string &resource_name,
@@ -19,10 +19,13 @@
 
 #pragma once
 
+#include "AccessOverviewCache.hpp"
+#include "AuditWriter.hpp"
 #include "LeosacFwd.hpp"
 #include "Messages.hpp"
 #include "Service.hpp"
 #include "WebSockFwd.hpp"
+#include "WireFormat.hpp"
 #include "api/APIAuth.hpp"
 #include "api/APISession.hpp"
 #include "api/CRUDResourceHandler.hpp"
@@ -32,8 +35,11 @@
 #include "tools/db/db_fwd.hpp"
 #include <boost/optional.hpp>
 #include <set>
+#include <shared_mutex>
+#include <thread>
 #include <type_traits>
 #include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
 #include <websocketpp/server.hpp>
 #include <zmqpp/zmqpp.hpp>
 
@@ -45,6 +51,23 @@ namespace WebSockAPI
 {
 using json = nlohmann::json;
 
+/**
+ * Websocketpp configuration: the asio transport, with the
+ * permessage-deflate extension.
+ *
+ * Compression is only used if the client offers it.
+ */
+struct WSServerConfig : public websocketpp::config::asio
+{
+    struct permessage_deflate_config
+    {
+    };
+
+    using permessage_deflate_type =
+        websocketpp::extensions::permessage_deflate::enabled<
+            permessage_deflate_config>;
+};
+
 /**
  * The implementation class that runs the websocket server.
  * The `run()` method is invoked in its own thread, and from this point on, the
@@ -56,6 +79,11 @@ using json = nlohmann::json;
  * The WebSockAPI::Service class communicates with the WSServer object through
  * the asio loop.
  *
+ * Requests are not executed by the websocket thread but by a pool of worker
+ * threads. Each APISession has a strand on the worker pool: the requests of
+ * a client are processed in order, while slow requests from a client don't
+ * delay the other clients.
+ *
  * @note Unless specified otherwise, the methods in this class ARE NOT thread-safe.
  */
 class WSServer
@@ -64,11 +92,12 @@ class WSServer
     /**
      * @param database A (non-null) pointer to the
      * database.
+     * @param nb_workers Number of threads executing requests.
      */
-    WSServer(WebSockAPIModule &module, DBPtr database);
+    WSServer(WebSockAPIModule &module, DBPtr database, size_t nb_workers);
     ~WSServer();
 
-    using Server           = websocketpp::server<websocketpp::config::asio>;
+    using Server           = websocketpp::server<WSServerConfig>;
     using ConnectionAPIMap = std::map<websocketpp::connection_hdl, APIPtr,
                                       std::owner_less<websocketpp::connection_hdl>>;
 
@@ -93,7 +122,8 @@ class WSServer
      * @note This method is thread-safe.
      */
     bool register_asio_handler(const Service::WSHandler &handler,
-                               const std::string &name);
+                               const std::string &name,
+                               AsioHandlerGuardPtr guard = nullptr);
 
 
     /**
@@ -110,6 +140,9 @@ class WSServer
     /**
      * Remove an Asio based handler.
      *
+     * Once the handler is removed, waits for the in-flight calls to it,
+     * through its AsioHandlerGuard.
+     *
      * @note This method is thread-safe and runs the removal code
      * into the WSServer's io_service.
      */
@@ -135,13 +168,32 @@ class WSServer
      */
     CoreUtilsPtr core_utils();
 
+    /**
+     * The io_service run by the worker threads.
+     */
+    boost::asio::io_service &worker_io();
+
+    /**
+     * The materialized access overview, that CRUD handlers must notify
+     * of their changes.
+     */
+    AccessOverviewCache &access_overview();
+
     /**
      * Deauthenticate all the connections of `user`, except
      * the `exception` APISession.
+     *
+     * @note This method is thread-safe. The sessions are cleared
+     * asynchronously, each from its own strand.
      */
     void clear_user_sessions(Auth::UserPtr user, APIPtr exception);
 
   private:
+    /**
+     * Select the subprotocol, and thus the WireFormat, of a new connection.
+     */
+    bool on_validate(websocketpp::connection_hdl hdl);
+
     void on_open(websocketpp::connection_hdl hdl);
 
     void on_close(websocketpp::connection_hdl hdl);
@@ -161,10 +213,25 @@ class WSServer
      * While this may not be the best performance wise, it's
      * unlikely to be a bottleneck, but it helps keep things clean.
      *
-     * @note This method is responsible for saving the WSAPICall Audit event.
+     * The message is handed to the strand of its session, and processed
+     * by process_message() on a worker thread.
      */
     void on_message(websocketpp::connection_hdl hdl, Server::message_ptr msg);
 
+    /**
+     * Process a message from a client, and post the response to the
+     * websocket thread.
+     *
+     * This runs on a worker thread, through the strand of `session_handle`.
+     *
+     * @note This method is responsible for saving the WSAPICall Audit event.
+     * The entry is inserted before the request is processed, and is
+     * finalized asynchronously by the AuditWriter.
+     */
+    void process_message(websocketpp::connection_hdl hdl, APIPtr session_handle,
+                         const std::string &endpoint, const std::string &payload,
+                         bool binary_frame);
+
     /**
      * Handle a request.
      *
@@ -185,9 +252,31 @@ class WSServer
     /**
      * Send a message over a connection.
      * @param hdl The connection
-     * @param msg The message.
+     * @param msg The message, already encoded.
      */
-    void send_message(websocketpp::connection_hdl hdl, const ServerMessage &msg);
+    void send_message(websocketpp::connection_hdl hdl, Server::message_ptr msg);
+
+    /**
+     * Send a message from any thread, by posting it to the websocket thread.
+     *
+     * The message is encoded by the calling thread, in the format of
+     * `session`. Payloads larger than COMPRESSION_THRESHOLD are compressed,
+     * if the client negotiated permessage-deflate.
+     */
+    void post_message(websocketpp::connection_hdl hdl, const APISession &session,
+                      const ServerMessage &msg);
+
+    /**
+     * Messages smaller than this (in bytes) are not worth compressing.
+     */
+    static constexpr size_t COMPRESSION_THRESHOLD = 1024;
+
+    /**
+     * Invalidate the token of a session and deauthenticate it.
+     *
+     * Must run through the strand of `session`.
+     */
+    void clear_session(websocketpp::connection_hdl hdl, APIPtr session);
 
     /**
      * An internal helper function to register a CRUD resource handler.
@@ -222,15 +311,40 @@ class WSServer
     bool has_handler(const std::string &name) const;
 
     /**
-     * Extract values from the `msg` and finalizes the `audit` object with them.
+     * Returns the handler named `name` in `map`, or nullptr.
+     *
+     * The caller must hold `handlers_mutex_`.
+     */
+    template <typename HandlerT, typename MapT>
+    static HandlerT find_handler(const MapT &map, const std::string &name)
+    {
+        auto it = map.find(name);
+        if (it != map.end())
+            return it->second;
+        return nullptr;
+    }
+
+    size_t nb_workers_;
+
+    /**
+     * The io_service the requests are executed on.
      *
-     * The `msg` may be modified if finalizing the audit object fails.
+     * Declared before the connections, so that it outlives the
+     * strands of the APISession objects.
      */
-    void finalize_audit(const Audit::IWSAPICallPtr &audit, ServerMessage &msg);
+    boost::asio::io_service worker_io_;
+    std::unique_ptr<boost::asio::io_service::work> worker_work_;
+    std::vector<std::thread> workers_;
 
     ConnectionAPIMap connection_session_;
     APIAuth auth_;
 
+    /**
+     * Protects the handlers maps, which are modified by the websocket
+     * thread and read by the workers.
+     */
+    mutable std::shared_timed_mutex handlers_mutex_;
+
     /**
      * This maps (string) command name to API method.
      */
@@ -245,11 +359,24 @@ class WSServer
      */
     std::map<std::string, Service::WSHandler> asio_handlers_;
 
+    /**
+     * Guards of the handlers registered through
+     * Service::register_asio_handler().
+     */
+    std::map<std::string, AsioHandlerGuardPtr> asio_guards_;
+
     /**
      * Database service object.
      */
     DBServicePtr dbsrv_;
 
+    /**
+     * Finalizes the WSAPICall audit entries out of the websocket thread.
+     */
+    AuditWriter audit_writer_;
+
+    AccessOverviewCache access_overview_;
+
     /**
      * A reference to the module.
      *
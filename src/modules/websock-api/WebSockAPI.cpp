@@ -34,8 +34,9 @@ WebSockAPIModule::WebSockAPIModule(zmqpp::context &ctx, zmqpp::socket *pipe,
                                    CoreUtilsPtr utils)
     : BaseModule(ctx, pipe, cfg, utils)
 {
-    port_      = cfg.get<uint16_t>("module_config.port", 8976);
-    interface_ = cfg.get<std::string>("module_config.interface", "127.0.0.1");
+    port_           = cfg.get<uint16_t>("module_config.port", 8976);
+    interface_      = cfg.get<std::string>("module_config.interface", "127.0.0.1");
+    worker_threads_ = cfg.get<size_t>("module_config.worker_threads", 4);
 
     auto endpoint_colorized = Colorize::green(
         Colorize::underline(fmt::format("{}:{}", interface_, port_)));
@@ -45,7 +46,8 @@ WebSockAPIModule::WebSockAPIModule(zmqpp::context &ctx, zmqpp::socket *pipe,
 
 void WebSockAPIModule::run()
 {
-    wssrv_ = std::make_unique<WSServer>(*this, core_utils()->database());
+    wssrv_ = std::make_unique<WSServer>(*this, core_utils()->database(),
+                                        worker_threads_);
     std::thread thread(std::bind(&WSServer::run, wssrv_.get(), interface_, port_));
 
     while (is_running_)
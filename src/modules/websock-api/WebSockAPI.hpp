@@ -70,6 +70,11 @@ class WebSockAPIModule : public BaseModule
      */
     std::string interface_;
 
+    /**
+     * Number of threads executing the API requests.
+     */
+    size_t worker_threads_;
+
     /**
      * Our websocket server object.
      */
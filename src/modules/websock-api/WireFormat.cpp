@@ -0,0 +1,91 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WireFormat.hpp"
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WebSockAPI
+{
+
+boost::optional<WireFormat> wire_format_from_subprotocol(const std::string &proto)
+{
+    if (proto == "leosac.json")
+        return WireFormat::JSON;
+    if (proto == "leosac.cbor")
+        return WireFormat::CBOR;
+    if (proto == "leosac.msgpack")
+        return WireFormat::MSGPACK;
+    return boost::none;
+}
+
+bool is_binary(WireFormat format)
+{
+    return format == WireFormat::CBOR || format == WireFormat::MSGPACK;
+}
+
+std::string encode(const json &message, WireFormat format)
+{
+    switch (format)
+    {
+    case WireFormat::JSON_PRETTY:
+        return message.dump(4);
+    case WireFormat::JSON:
+        return message.dump();
+    case WireFormat::CBOR:
+    {
+        auto bytes = json::to_cbor(message);
+        return std::string(bytes.begin(), bytes.end());
+    }
+    case WireFormat::MSGPACK:
+    {
+        auto bytes = json::to_msgpack(message);
+        return std::string(bytes.begin(), bytes.end());
+    }
+    }
+    return message.dump();
+}
+
+json decode(const std::string &payload, WireFormat format, bool binary_frame)
+{
+    if (!binary_frame)
+        return json::parse(payload);
+
+    if (!is_binary(format))
+        throw std::invalid_argument("Binary frame on a connection without binary "
+                                    "encoding.");
+
+    std::vector<uint8_t> bytes(payload.begin(), payload.end());
+    try
+    {
+        if (format == WireFormat::CBOR)
+            return json::from_cbor(bytes);
+        return json::from_msgpack(bytes);
+    }
+    catch (const std::exception &e)
+    {
+        // Truncated input is reported as something else than invalid_argument.
+        throw std::invalid_argument(e.what());
+    }
+}
+}
+}
+}
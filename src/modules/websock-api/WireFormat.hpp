@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <json.hpp>
+#include <string>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WebSockAPI
+{
+using json = nlohmann::json;
+
+/**
+ * Encoding of the messages exchanged over a websocket connection.
+ *
+ * The client picks one when connecting, by requesting the matching
+ * websocket subprotocol. Without subprotocol, the connection uses
+ * pretty-printed JSON, as it always did.
+ */
+enum class WireFormat
+{
+    /**
+     * Indented JSON, over text frames. No subprotocol.
+     */
+    JSON_PRETTY,
+
+    /**
+     * Compact JSON, over text frames. Subprotocol `leosac.json`.
+     */
+    JSON,
+
+    /**
+     * CBOR, over binary frames. Subprotocol `leosac.cbor`.
+     */
+    CBOR,
+
+    /**
+     * MessagePack, over binary frames. Subprotocol `leosac.msgpack`.
+     */
+    MSGPACK,
+};
+
+/**
+ * Returns the WireFormat matching a websocket subprotocol, if any.
+ */
+boost::optional<WireFormat> wire_format_from_subprotocol(const std::string &proto);
+
+/**
+ * Are messages in this format sent as binary frames?
+ */
+bool is_binary(WireFormat format);
+
+/**
+ * Serialize a message.
+ */
+std::string encode(const json &message, WireFormat format);
+
+/**
+ * Parse a message.
+ *
+ * Binary frames are decoded according to `format`, text frames are
+ * always JSON.
+ *
+ * @throws std::invalid_argument if the payload is not valid.
+ */
+json decode(const std::string &payload, WireFormat format, bool binary_frame);
+}
+}
+}
@@ -41,28 +41,41 @@ using namespace Leosac;
 using namespace Leosac::Module;
 using namespace Leosac::Module::WebSockAPI;
 
-APIAuth::APIAuth(WSServer &srv)
+APIAuth::APIAuth(WSServer &srv, DBPtr database)
     : server_(srv)
+    , token_cache_(database)
 {
 }
 
-void APIAuth::invalidate_token(Auth::TokenPtr token) const
+void APIAuth::invalidate_token(Auth::TokenPtr token)
 {
     ASSERT_LOG(token, "nullptr passed when excepting non-null token.");
 
     using namespace odb;
     using namespace odb::core;
+    token_cache_.erase(token->token());
     odb::transaction t(server_.db()->begin());
     server_.db()->erase<Auth::Token>(token->id());
     t.commit();
 }
 
-Auth::TokenPtr APIAuth::authenticate_token(const std::string &token_str) const
+void APIAuth::forget_user_tokens(Auth::UserId user_id)
+{
+    token_cache_.erase_user(user_id);
+}
+
+Auth::TokenPtr APIAuth::authenticate_token(const std::string &token_str)
 {
     using namespace odb;
     using namespace odb::core;
     using query = odb::query<Auth::Token>;
 
+    if (auto token = token_cache_.use(token_str))
+    {
+        enforce_user_enabled(*token->owner());
+        return token;
+    }
+
     auto db = server_.db();
     transaction t(db->begin());
     db::MultiplexedSession s;
@@ -71,16 +84,37 @@ Auth::TokenPtr APIAuth::authenticate_token(const std::string &token_str) const
     if (token && token->is_valid())
     {
         enforce_user_enabled(*token->owner());
-        token->expire_in(std::chrono::minutes(20));
-        db->update(token);
         t.commit();
+        // The new expiration is written back by the cache.
+        token_cache_.insert(token);
         return token;
     }
     return nullptr;
 }
 
+APIAuth::TokenStatus APIAuth::refresh_token(const Auth::TokenPtr &token)
+{
+    ASSERT_LOG(token, "nullptr passed when excepting non-null token.");
+    if (token_cache_.use(token->token()))
+        return TokenStatus::VALID;
+
+    // Not cached, or expired in the cache. The database has the final say.
+    auto db = server_.db();
+    odb::transaction t(db->begin());
+    db::MultiplexedSession s;
+
+    auto stored_token = db->find<Auth::Token>(token->token());
+    t.commit();
+    if (!stored_token)
+        return TokenStatus::UNKNOWN;
+    if (!stored_token->is_valid())
+        return TokenStatus::EXPIRED;
+    token_cache_.insert(stored_token);
+    return TokenStatus::VALID;
+}
+
 Auth::TokenPtr APIAuth::authenticate_credentials(const std::string &username,
-                                                 const std::string &password) const
+                                                 const std::string &password)
 {
     using namespace odb;
     using namespace odb::core;
@@ -101,6 +135,7 @@ Auth::TokenPtr APIAuth::authenticate_credentials(const std::string &username,
             token->expire_in(std::chrono::minutes(20));
             db->persist(*token);
             t.commit();
+            token_cache_.insert(token);
 
             if (user->username() == "admin")
             {
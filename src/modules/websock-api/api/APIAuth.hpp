@@ -19,8 +19,10 @@
 
 #pragma once
 
+#include "api/TokenCache.hpp"
 #include "core/auth/AuthFwd.hpp"
 #include "core/auth/Token.hpp"
+#include "tools/db/db_fwd.hpp"
 #include <map>
 #include <string>
 #include <vector>
@@ -37,11 +39,24 @@ class WSServer;
  * authentication for Websocket client.
  *
  * The object is instantiated for the lifetime of the WSServer object.
+ *
+ * The tokens in use are kept in a TokenCache, so that authenticated
+ * requests don't need to hit the database.
  */
 class APIAuth
 {
   public:
-    APIAuth(WSServer &srv);
+    enum class TokenStatus
+    {
+        VALID,
+        EXPIRED,
+        /**
+         * The token doesn't exist anymore.
+         */
+        UNKNOWN,
+    };
+
+    APIAuth(WSServer &srv, DBPtr database);
 
     /**
      * Attempt to authenticate with username/password credential
@@ -55,7 +70,7 @@ class APIAuth
      * lower case.
      */
     Auth::TokenPtr authenticate_credentials(const std::string &username,
-                                            const std::string &password) const;
+                                            const std::string &password);
 
     /**
      * Attempt to authenticate with an authentication token.
@@ -67,12 +82,27 @@ class APIAuth
      * Returns the token object matching the token string on success, or nullptr
      * on failure.
      */
-    Auth::TokenPtr authenticate_token(const std::string &token_str) const;
+    Auth::TokenPtr authenticate_token(const std::string &token_str);
+
+    /**
+     * Check that a token in use by a session is still valid, and slide
+     * its expiration.
+     *
+     * This is served from the cache. The database is only queried
+     * if the token is not cached.
+     */
+    TokenStatus refresh_token(const Auth::TokenPtr &token);
 
     /**
      * Invalidate the authentication token, removing it from the database.
      */
-    void invalidate_token(Auth::TokenPtr token) const;
+    void invalidate_token(Auth::TokenPtr token);
+
+    /**
+     * Drop the cached tokens of a user, for example because the user
+     * has been modified.
+     */
+    void forget_user_tokens(Auth::UserId user_id);
 
   private:
     /**
@@ -87,6 +117,8 @@ class APIAuth
      * outlive the APIAuth object.
      */
     WSServer &server_;
+
+    TokenCache token_cache_;
 };
 }
 }
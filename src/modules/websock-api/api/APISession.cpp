@@ -31,7 +31,6 @@
 #include "core/kernel.hpp"
 #include "tools/GenGuid.h"
 #include "tools/LogEntry.hpp"
-#include "tools/db/MultiplexedSession.hpp"
 #include "tools/version.hpp"
 #include <odb/session.hxx>
 
@@ -39,9 +38,11 @@ using namespace Leosac;
 using namespace Leosac::Module;
 using namespace Leosac::Module::WebSockAPI;
 
-APISession::APISession(WSServer &server)
+APISession::APISession(WSServer &server, WireFormat format)
     : server_(server)
     , auth_status_(AuthStatus::NONE)
+    , strand_(server.worker_io())
+    , wire_format_(format)
 {
 }
 
@@ -123,6 +124,31 @@ APISession::json APISession::system_overview(const APISession::json &)
     return rep;
 }
 
+APISession::json APISession::module_startup_timeline(const APISession::json &)
+{
+    json rep;
+    auto core_api = server_.core_utils()->core_api();
+
+    rep["modules"] = json::array();
+    for (const auto &info : core_api.modules_startup_timeline())
+    {
+        json module;
+        module["name"]       = info.name;
+        module["level"]      = info.level;
+        module["load_begin"] = info.load_begin.count();
+        module["load_end"]   = info.load_end.count();
+        module["init_begin"] = nullptr;
+        module["ready"]      = nullptr;
+        if (info.initialized)
+        {
+            module["init_begin"] = info.init_begin.count();
+            module["ready"]      = info.ready.count();
+        }
+        rep["modules"].push_back(module);
+    }
+    return rep;
+}
+
 bool APISession::allowed(const std::string &cmd)
 {
     if (cmd == "get_leosac_version")
@@ -136,29 +162,20 @@ void APISession::hook_before_request()
 {
     if (auth_status_ == AuthStatus::LOGGED_IN)
     {
-        odb::core::transaction t(server_.db()->begin());
-        db::MultiplexedSession s;
-        // Reload token
-        try
+        switch (server_.auth().refresh_token(current_auth_token_))
         {
-            server_.db()->reload(current_auth_token_);
-        }
-        catch (const odb::object_changed &e)
+        case APIAuth::TokenStatus::VALID:
+            break;
+        case APIAuth::TokenStatus::EXPIRED:
         {
-            // Token doesn't exist anymore.
+            auto token = current_auth_token_;
             abort_session();
-            throw SessionAborted(nullptr);
+            throw SessionAborted(token);
         }
-
-        if (!current_auth_token_->is_valid())
-        {
+        case APIAuth::TokenStatus::UNKNOWN:
             abort_session();
-            throw SessionAborted(current_auth_token_);
+            throw SessionAborted(nullptr);
         }
-
-        current_auth_token_->expire_in(std::chrono::minutes(20));
-        server_.db()->update(*current_auth_token_);
-        t.commit();
     }
 }
 
@@ -209,3 +226,13 @@ SecurityContext &APISession::security_context() const
         return *security_.get();
     return sc;
 }
+
+boost::asio::io_service::strand &APISession::strand()
+{
+    return strand_;
+}
+
+WireFormat APISession::wire_format() const
+{
+    return wire_format_;
+}
@@ -19,8 +19,10 @@
 
 #pragma once
 
+#include "WireFormat.hpp"
 #include "core/SecurityContext.hpp"
 #include "core/auth/AuthFwd.hpp"
+#include <boost/asio.hpp>
 #include <json.hpp>
 #include <memory>
 
@@ -53,7 +55,10 @@ class APISession
         LOGGED_IN
     };
 
-    APISession(WSServer &server);
+    /**
+     * @param format Encoding negotiated by the websocket connection.
+     */
+    APISession(WSServer &server, WireFormat format);
     APISession(const APISession &) = delete;
     APISession(APISession &&)      = delete;
 
@@ -151,6 +156,23 @@ class APISession
      */
     json system_overview(const json &req);
 
+    /**
+     * Retrieve the startup timeline of the modules, in initialization order.
+     *
+     * Request:
+     *     + No parameter
+     *
+     * Response:
+     *     + `modules`: List of objects with the following keys. Times are
+     *       in milliseconds since Leosac started.
+     *         + `name`: Name of the module.
+     *         + `level`: Initialization level of the module.
+     *         + `load_begin`, `load_end`: Loading of the shared library.
+     *         + `init_begin`, `ready`: Construction of the module, until
+     *           it was ready. `null` if the module has not been initialized.
+     */
+    json module_startup_timeline(const json &req);
+
     /**
      * A hook that is called before a request processing method
      * will be invoked.
@@ -170,6 +192,23 @@ class APISession
 
     SecurityContext &security_context() const;
 
+    /**
+     * The strand through which the requests of this session are executed.
+     *
+     * Requests of a session run one at a time, and in the order they were
+     * received, while requests of different sessions run concurrently.
+     * The state of the session must only be accessed through this strand.
+     */
+    boost::asio::io_service::strand &strand();
+
+    /**
+     * The encoding of the messages exchanged with this client.
+     *
+     * Fixed when the connection is opened, so this is safe to call
+     * from any thread.
+     */
+    WireFormat wire_format() const;
+
   private:
     void mark_authenticated(Auth::TokenPtr token);
     void clear_authentication();
@@ -186,6 +225,10 @@ class APISession
     Auth::TokenPtr current_auth_token_;
 
     std::unique_ptr<SecurityContext> security_;
+
+    boost::asio::io_service::strand strand_;
+
+    const WireFormat wire_format_;
 };
 }
 }
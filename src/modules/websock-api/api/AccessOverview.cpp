@@ -18,11 +18,7 @@
 */
 
 #include "AccessOverview.hpp"
-#include "core/auth/Door.hpp"
-#include "core/auth/Door_odb.h"
-#include "core/auth/User_odb.h"
-#include "tools/JSONUtils.hpp"
-#include "tools/db/DBService.hpp"
+#include "WSServer.hpp"
 
 using namespace Leosac;
 using namespace Leosac::Module;
@@ -38,52 +34,29 @@ MethodHandlerUPtr AccessOverview::create(RequestContext ctx)
     return std::make_unique<AccessOverview>(ctx);
 }
 
-json AccessOverview::process_impl(const json &)
+json AccessOverview::process_impl(const json &req)
 {
-    json rep;
-    DBPtr db = ctx_.dbsrv->db();
-    odb::transaction t(db->begin());
-
-    // todo: This probably doesn't scale very well...
-
-    auto doors = db->query<Auth::Door>();
-
-    // Since we'll be looping over users multiple time, we cannot use
-    // an odb::result object.
-    auto users_odb = db->query<Auth::User>();
-    // So we'll have to convert this to a vector of User, instead of
-    // odb::result::iterator.
-    std::vector<Auth::UserPtr> users;
-    for (auto itr_odb(users_odb.begin()); itr_odb != users_odb.end(); ++itr_odb)
-        users.push_back(itr_odb.load());
-
-    for (const auto &door : doors)
+    auto &cache = ctx_.server.access_overview();
+    bool delta  = req.is_object() && req.count("since_version");
+    auto snapshot =
+        delta ? cache.changes_since(req.at("since_version").get<uint64_t>())
+              : cache.snapshot();
+
+    json doors = json::array();
+    for (const auto &door : snapshot.doors)
     {
-        std::set<Auth::UserId> unique_user_ids;
-        json door_info = {{"door_id", door.id()}, {"user_ids", json::array()}};
-        for (const auto &lazy_mapping : door.lazy_mapping())
-        {
-            auto mapping = lazy_mapping.load();
-            for (const auto &user_ptr : users)
-            {
-                // Check the std::set in case the user is already authorized to
-                // access the door.
-                if (unique_user_ids.count(user_ptr->id()))
-                {
-                    continue;
-                }
-                if (mapping->has_user_indirect(user_ptr))
-                {
-                    unique_user_ids.insert(user_ptr->id());
-                }
-            }
-        }
-        for (const auto &id : unique_user_ids)
+        json door_info = {{"door_id", door.door_id}, {"user_ids", json::array()}};
+        for (const auto &id : door.user_ids)
             door_info["user_ids"].push_back(id);
-        rep.push_back(door_info);
+        doors.push_back(door_info);
     }
 
-    return rep;
+    if (!delta)
+        return doors;
+    return {{"version", snapshot.version},
+            {"full", snapshot.full},
+            {"doors", doors},
+            {"removed_door_ids", snapshot.removed_doors}};
 }
 
 std::vector<ActionActionParam>
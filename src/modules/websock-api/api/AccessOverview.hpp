@@ -36,15 +36,28 @@ using json = nlohmann::json;
  * The overview is a simple TRUE/FALSE regarding the user permission against
  * a door. It doesn't handle timeframe yet.
  *
+ * The overview is served from the AccessOverviewCache, without
+ * querying the database.
+ *
  * Request:
- *     + No parameter required. This call will return an general overview.
+ *     + `since_version`: Optional. Retrieve only the doors that changed
+ *       since this version. Pass 0 to retrieve all doors along with the
+ *       current version.
  *
- * Response:
+ * Response without `since_version`:
  *     [
  *       {door_id: $SOME_DOOR_ID,
  *       user_ids: [1, 4, 24]
  *     ]
  *
+ * Response with `since_version`:
+ *     {
+ *       version: $CURRENT_VERSION,
+ *       full: $BOOL, // True if `doors` contains all doors.
+ *       doors: [ {door_id: ..., user_ids: [...]} ],
+ *       removed_door_ids: [3, 5]
+ *     }
+ *
  */
 class AccessOverview : public MethodHandler
 {
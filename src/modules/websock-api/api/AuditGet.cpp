@@ -31,6 +31,8 @@
 #include "tools/db/DBService.hpp"
 #include "tools/enforce.hpp"
 #include "tools/log.hpp"
+#include <algorithm>
+#include <boost/optional.hpp>
 #include <odb/pgsql/query.hxx>
 
 using namespace Leosac;
@@ -59,23 +61,47 @@ json AuditGet::process_impl(const json &req)
 
         int page      = extract_with_default(req, "p", 1);
         int page_size = extract_with_default(req, "ps", 20);
+        Audit::AuditEntryId before_id =
+            extract_with_default(req, "before_id", Audit::AuditEntryId{0});
+        Audit::AuditEntryId after_id =
+            extract_with_default(req, "after_id", Audit::AuditEntryId{0});
+        bool keyset = before_id || after_id;
+        std::string count_mode =
+            extract_with_default(req, "count", keyset ? "approximate" : "exact");
 
         LEOSAC_ENFORCE_ARGUMENT(page > 0, page, "Page must be >0");
         LEOSAC_ENFORCE_ARGUMENT(page_size > 0, page_size, "Page size must be >0");
+        LEOSAC_ENFORCE_ARGUMENT(!(before_id && after_id), after_id,
+                                "Cannot use both before_id and after_id");
+        LEOSAC_ENFORCE_ARGUMENT(count_mode == "exact" ||
+                                    count_mode == "approximate" ||
+                                    count_mode == "none",
+                                count_mode,
+                                "Count must be `exact`, `approximate` or `none`");
 
         odb::transaction t(db->begin());
-        Audit::AuditEntryCount view(
-            db->query_value<Audit::AuditEntryCount>(build_in_clause(req)));
-        rep["meta"]["count"] = view.count;
-        if (view.count)
+        auto condition = build_in_clause(req);
+        boost::optional<size_t> count;
+        if (count_mode == "approximate" && condition == "1 = 1")
         {
-            rep["meta"]["total_page"] =
-                (view.count / page_size) + (view.count % page_size ? 1 : 0);
+            count = Audit::AuditEntry::approximate_count(db);
+            rep["meta"]["count_approximate"] = true;
+        }
+        else if (count_mode != "none")
+        {
+            // The approximate count is only available for the whole table:
+            // count exactly when filtering on type.
+            count = db->query_value<Audit::AuditEntryCount>(condition).count;
+        }
+        if (count)
+        {
+            rep["meta"]["count"]      = *count;
+            rep["meta"]["total_page"] = (*count / page_size) +
+                                        (*count % page_size ? 1 : 0);
         }
-        else
-            rep["meta"]["total_page"] = 0;
 
-        auto query  = Query(build_request_string(req, page, page_size));
+        auto query = Query(
+            build_request_string(req, page, page_size, before_id, after_id));
         auto ret    = db->query<Audit::AuditEntry>(query);
         rep["data"] = json::array();
         for (const auto &audit : ret)
@@ -84,6 +110,10 @@ json AuditGet::process_impl(const json &req)
                 audit, security_context());
             rep["data"].push_back(audit_json);
         }
+        // Entries after `after_id` are fetched closest first, but the
+        // response is always sorted from the newest to the oldest.
+        if (after_id)
+            std::reverse(rep["data"].begin(), rep["data"].end());
     }
     else
     {
@@ -102,14 +132,31 @@ std::vector<ActionActionParam> AuditGet::required_permission(const json &) const
 }
 
 std::string AuditGet::build_request_string(const json &req, int page,
-                                           int page_size) const
+                                           int page_size,
+                                           Audit::AuditEntryId before_id,
+                                           Audit::AuditEntryId after_id) const
 {
     std::stringstream request_builder;
 
     request_builder << build_in_clause(req);
-    request_builder << " ORDER BY id DESC";
-    request_builder << " LIMIT " << page_size;
-    request_builder << " OFFSET " << page_size * (page - 1);
+    if (before_id)
+    {
+        request_builder << " AND id < " << before_id;
+        request_builder << " ORDER BY id DESC";
+        request_builder << " LIMIT " << page_size;
+    }
+    else if (after_id)
+    {
+        request_builder << " AND id > " << after_id;
+        request_builder << " ORDER BY id ASC";
+        request_builder << " LIMIT " << page_size;
+    }
+    else
+    {
+        request_builder << " ORDER BY id DESC";
+        request_builder << " LIMIT " << page_size;
+        request_builder << " OFFSET " << page_size * (page - 1);
+    }
     DEBUG("QUERY: " << request_builder.str());
     return request_builder.str();
 }
@@ -132,7 +179,7 @@ std::string AuditGet::build_in_clause(const json &req) const
         req.at("enabled_type").size())
     {
         const auto &enabled_types = req.at("enabled_type");
-        request_builder << "WHERE typeid IN (";
+        request_builder << "typeid IN (";
         for (size_t i = 0; i < enabled_types.size(); ++i)
         {
             auto enabled_type = enabled_types[i].get<std::string>();
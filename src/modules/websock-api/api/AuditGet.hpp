@@ -20,6 +20,7 @@
 #pragma once
 
 #include "MethodHandler.hpp"
+#include "core/audit/AuditFwd.hpp"
 
 namespace Leosac
 {
@@ -42,13 +43,29 @@ using json = nlohmann::json;
  *       If enabled type is not present, returns all types.
  *     + p: Page number
  *     + ps: Page size
+ *     + before_id: Optional. Retrieve the `ps` entries that precede (are
+ *       older than) this entry. `p` is ignored.
+ *     + after_id: Optional. Retrieve the `ps` entries that follow (are
+ *       newer than) this entry. `p` is ignored.
+ *     + count: Optional. How to compute `meta.count`:
+ *           + `exact`: Count the matching entries. This is the default,
+ *             except when paging with `before_id` or `after_id`.
+ *           + `approximate`: Use an incrementally maintained count of all
+ *             the entries. When filtering on type, an exact count is
+ *             done instead.
+ *           + `none`: Don't count.
+ *
+ * Paging with `before_id`/`after_id` (keyset pagination) costs the same
+ * for every page, whereas `p` requires the database to skip all the entries
+ * of the previous pages.
  *
  * Response:
- *     + data: [JSON API data]
- *     + meta:
+ *     + data: [JSON API data], from the newest to the oldest entry.
+ *     + meta: (`count` and `total_page` are omitted with `count: none`.)
  *          + count: The number of entries that match the request.
- *          + totalPage: The number of page for to retrieve all items that match
- *            the request.
+ *          + count_approximate: True if `count` is approximate.
+ *          + total_page: The number of page for to retrieve all items that
+ *            match the request.
  */
 class AuditGet : public MethodHandler
 {
@@ -63,10 +80,12 @@ class AuditGet : public MethodHandler
 
   private:
     virtual json process_impl(const json &req) override;
-    std::string build_request_string(const json &req, int page, int page_size) const;
+    std::string build_request_string(const json &req, int page, int page_size,
+                                     Audit::AuditEntryId before_id,
+                                     Audit::AuditEntryId after_id) const;
 
     /**
-     * Build the "WHERE typeid IN (...)" string based on the enabled types.
+     * Build the "typeid IN (...)" condition based on the enabled types.
      */
     std::string build_in_clause(const json &req) const;
 
@@ -18,6 +18,7 @@
 */
 
 #include "api/CredentialCRUD.hpp"
+#include "WSServer.hpp"
 #include "core/audit/AuditFactory.hpp"
 #include "core/audit/ICredentialEvent.hpp"
 #include "core/credentials/Credential.hpp"
@@ -115,6 +116,7 @@ boost::optional<json> CredentialCRUD::create_impl(const json &req)
                                                                  security_context());
 
     t.commit();
+    ctx_.server.access_overview().credential_changed(new_cred->id());
     return rep;
 }
 
@@ -177,6 +179,7 @@ boost::optional<json> CredentialCRUD::update_impl(const json &req)
         *cred, SystemSecurityContext::instance()));
     audit->finalize();
     t.commit();
+    ctx_.server.access_overview().credential_changed(cid);
     return rep;
 }
 
@@ -199,6 +202,7 @@ boost::optional<json> CredentialCRUD::delete_impl(const json &req)
         audit->finalize();
         db->erase<Cred::Credential>(cred->id());
         t.commit();
+        ctx_.server.access_overview().credential_changed(cid);
     }
     return json{};
 }
@@ -19,6 +19,7 @@
 
 #include "api/DoorCRUD.hpp"
 #include "Exceptions.hpp"
+#include "WSServer.hpp"
 #include "api/APISession.hpp"
 #include "core/audit/AuditFactory.hpp"
 #include "core/audit/IDoorEvent.hpp"
@@ -69,6 +70,7 @@ boost::optional<json> DoorCRUD::create_impl(const json &req)
 
     rep["data"] = DoorJSONSerializer::serialize(*new_door, security_context());
     t.commit();
+    ctx_.server.access_overview().door_changed(new_door->id());
     return rep;
 }
 
@@ -155,6 +157,7 @@ boost::optional<json> DoorCRUD::delete_impl(const json &req)
     audit->finalize();
     db->erase(door_odb);
     t.commit();
+    ctx_.server.access_overview().door_changed(did);
 
     return json{};
 }
@@ -19,6 +19,7 @@
 
 #include "api/GroupCRUD.hpp"
 #include "Exceptions.hpp"
+#include "WSServer.hpp"
 #include "api/APISession.hpp"
 #include "core/audit/AuditFactory.hpp"
 #include "core/audit/IGroupEvent.hpp"
@@ -79,6 +80,8 @@ boost::optional<json> GroupCRUD::create_impl(const json &req)
     // Send the model back to the client, so it knows the ID.
     rep["data"] = GroupJSONSerializer::serialize(*new_group, security_context());
     t.commit();
+    // The creator is already a member of the new group.
+    ctx_.server.access_overview().group_changed(new_group->id());
     return rep;
 }
 
@@ -157,6 +160,7 @@ boost::optional<json> GroupCRUD::delete_impl(const json &req)
     audit->finalize();
     db->erase(group);
     t.commit();
+    ctx_.server.access_overview().group_changed(gid);
 
     return json{};
 }
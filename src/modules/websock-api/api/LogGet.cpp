@@ -20,9 +20,11 @@
 #include "LogGet.hpp"
 #include "Exceptions.hpp"
 #include "api/APISession.hpp"
+#include "exception/InvalidArgument.hpp"
 #include "tools/JSONUtils.hpp"
 #include "tools/LogEntry_odb.h"
 #include "tools/db/DBService.hpp"
+#include "tools/enforce.hpp"
 
 using namespace Leosac;
 using namespace Leosac::Module;
@@ -51,10 +53,26 @@ json LogGet::process_impl(const json &req)
         std::string sort = extract_with_default(req, "sort", "desc");
         int p            = extract_with_default(req, "p", 0);   // page
         int ps           = extract_with_default(req, "ps", 20); // page size
+        auto before_id   = extract_with_default(req, "before_id", 0ul);
+        auto after_id    = extract_with_default(req, "after_id", 0ul);
         if (ps <= 0)
             ps = 1;
+        LEOSAC_ENFORCE_ARGUMENT(!(before_id && after_id), after_id,
+                                "Cannot use both before_id and after_id");
+
+        LogEntry::QueryResult result;
+        if (before_id || after_id)
+        {
+            result.entries = LogEntry::retrieve_keyset(db, before_id, after_id, ps,
+                                                       sort == "asc");
+            result.total = LogEntry::approximate_count(db);
+            result.last  = result.total / ps;
+            result.first = 0;
+            rep["meta"]["total_approximate"] = true;
+        }
+        else
+            result = LogEntry::retrieve(db, p, ps, sort == "asc");
 
-        LogEntry::QueryResult result = LogEntry::retrieve(db, p, ps, sort == "asc");
         for (Tools::LogEntry &entry : result.entries)
         {
             auto timestamp = boost::posix_time::to_time_t(entry.timestamp_);
@@ -65,8 +83,9 @@ json LogGet::process_impl(const json &req)
                   {{"message", entry.msg_}, {"timestamp", timestamp}}}});
         }
 
-        rep["meta"] = {
-            {"total", result.total}, {"last", result.last}, {"first", result.first}};
+        rep["meta"]["total"] = result.total;
+        rep["meta"]["last"]  = result.last;
+        rep["meta"]["first"] = result.first;
         rep["status"] = 0;
     }
     else
@@ -37,9 +37,19 @@ using json = nlohmann::json;
  *     + `p`: The page number. Starts at 0.
  *     + `ps`: Page size: the number of item per page. Default to 20.
  *     + `sort`: Either 'asc' or 'desc'.
+ *     + `before_id`: Optional. Retrieve the `ps` entries whose id precede
+ *       this one. `p` is ignored.
+ *     + `after_id`: Optional. Retrieve the `ps` entries whose id follow
+ *       this one. `p` is ignored.
+ *
+ * Paging with `before_id`/`after_id` (keyset pagination) costs the same
+ * for every page. In that case the `total` is an approximation, maintained
+ * incrementally instead of counting the entries on each call.
  *
  * Response:
- *     + ...
+ *     + `data`: The log entries.
+ *     + `meta`: `total`, `first`, `last`, and `total_approximate` when the
+ *       total is approximated.
  */
 class LogGet : public MethodHandler
 {
@@ -18,6 +18,7 @@
 */
 
 #include "api/ScheduleCRUD.hpp"
+#include "WSServer.hpp"
 #include "core/audit/AuditFactory.hpp"
 #include "core/audit/IDoorEvent.hpp"
 #include "core/audit/IScheduleEvent.hpp"
@@ -98,6 +99,7 @@ boost::optional<json> ScheduleCRUD::create_impl(const json &req)
     rep["data"] =
         Tools::ScheduleJSONSerializer::serialize(*schedule, security_context());
     t.commit();
+    ctx_.server.access_overview().schedule_changed(schedule->id());
     return rep;
 }
 
@@ -210,6 +212,7 @@ boost::optional<json> ScheduleCRUD::update_impl(const json &req)
     rep["data"] =
         Tools::ScheduleJSONSerializer::serialize(*schedule, security_context());
     t.commit();
+    ctx_.server.access_overview().schedule_changed(sid);
     return rep;
 }
 
@@ -238,6 +241,7 @@ boost::optional<json> ScheduleCRUD::delete_impl(const json &req)
         audit->finalize();
         db->erase<Tools::Schedule>(schedule->id());
         t.commit();
+        ctx_.server.access_overview().schedule_changed(sid);
     }
     return json{};
 }
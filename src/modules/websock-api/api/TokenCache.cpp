@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TokenCache.hpp"
+#include "core/auth/Token.hpp"
+#include "core/auth/Token_odb.h"
+#include "core/auth/User.hpp"
+#include "tools/db/MultiplexedTransaction.hpp"
+#include "tools/log.hpp"
+#include <odb/exception.hxx>
+#include <vector>
+
+using namespace Leosac;
+using namespace Leosac::Module::WebSockAPI;
+
+constexpr std::chrono::minutes TokenCache::TOKEN_LIFETIME;
+constexpr std::chrono::seconds TokenCache::WRITE_BACK_INTERVAL;
+
+TokenCache::TokenCache(DBPtr database)
+    : database_(database)
+    , stopping_(false)
+{
+    ASSERT_LOG(database_, "No database object passed into TokenCache.");
+    thread_ = std::thread(&TokenCache::writer_main, this);
+}
+
+TokenCache::~TokenCache()
+{
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+Auth::TokenPtr TokenCache::use(const std::string &token_str)
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    auto itr = entries_.find(token_str);
+    if (itr == entries_.end())
+        return nullptr;
+
+    auto current_time = now();
+    if (itr->second.expiration <= current_time)
+    {
+        entries_.erase(itr);
+        return nullptr;
+    }
+    itr->second.expiration =
+        current_time + boost::posix_time::minutes(TOKEN_LIFETIME.count());
+    return itr->second.token;
+}
+
+void TokenCache::insert(Auth::TokenPtr token)
+{
+    ASSERT_LOG(token, "Cannot cache a null token.");
+    std::lock_guard<std::mutex> lg(mutex_);
+    auto &entry    = entries_[token->token()];
+    entry.token    = token;
+    entry.owner_id = token->owner()->id();
+    entry.expiration = now() + boost::posix_time::minutes(TOKEN_LIFETIME.count());
+    entry.persisted_expiration = token->expiration();
+}
+
+void TokenCache::erase(const std::string &token_str)
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    entries_.erase(token_str);
+}
+
+void TokenCache::erase_user(Auth::UserId user_id)
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    for (auto itr = entries_.begin(); itr != entries_.end();)
+    {
+        if (itr->second.owner_id == user_id)
+            itr = entries_.erase(itr);
+        else
+            ++itr;
+    }
+}
+
+void TokenCache::flush()
+{
+    write_back();
+}
+
+boost::posix_time::ptime TokenCache::now()
+{
+    // Same clock as Auth::Token.
+    return boost::posix_time::second_clock::local_time();
+}
+
+void TokenCache::writer_main()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        cond_.wait_for(lock, WRITE_BACK_INTERVAL, [this]() { return stopping_; });
+        lock.unlock();
+        write_back();
+        lock.lock();
+    }
+}
+
+void TokenCache::write_back()
+{
+    using Query = odb::query<Auth::Token>;
+    std::vector<std::pair<std::string, boost::posix_time::ptime>> expirations;
+    auto current_time = now();
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        auto interval = boost::posix_time::seconds(WRITE_BACK_INTERVAL.count());
+        for (auto itr = entries_.begin(); itr != entries_.end();)
+        {
+            auto &entry = itr->second;
+            if (entry.expiration <= current_time)
+            {
+                itr = entries_.erase(itr);
+                continue;
+            }
+            // Write back when the stored expiration lags too much, or when
+            // it would lapse before the next pass: the token would then be
+            // purged from the database while still in use.
+            auto lag = entry.expiration - entry.persisted_expiration;
+            if (lag >= interval ||
+                (lag.total_seconds() > 0 &&
+                 entry.persisted_expiration <= current_time + interval))
+            {
+                expirations.emplace_back(itr->first, entry.expiration);
+                // Assume success. On failure, the next use of the
+                // token will schedule a new write.
+                entry.persisted_expiration = entry.expiration;
+            }
+            ++itr;
+        }
+    }
+
+    try
+    {
+        db::MultiplexedTransaction t(database_->begin());
+        for (const auto &token_expiration : expirations)
+        {
+            auto token = database_->find<Auth::Token>(token_expiration.first);
+            if (!token)
+                continue;
+            auto remaining = token_expiration.second - current_time;
+            token->expire_in(std::chrono::seconds(remaining.total_seconds()));
+            database_->update(token);
+        }
+        database_->erase_query<Auth::Token>(Query::expiration < current_time);
+        t.commit();
+    }
+    catch (const odb::exception &e)
+    {
+        WARN("Failed to write back the expiration of " << expirations.size()
+                                                       << " tokens: " << e.what());
+    }
+}
@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/auth/AuthFwd.hpp"
+#include "tools/db/db_fwd.hpp"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WebSockAPI
+{
+/**
+ * An in-memory cache of the authentication tokens in use.
+ *
+ * Using a token slides its expiration. The cache records the new
+ * expiration in memory only. A background thread writes it back to the
+ * database, at most once per WRITE_BACK_INTERVAL for a given token. The
+ * same thread removes expired tokens, from the cache and from the database.
+ *
+ * Because of the coalesced write-back, the expiration stored in the
+ * database may lag behind by up to twice WRITE_BACK_INTERVAL. The only
+ * effect is that a token could expire that much sooner after a restart.
+ *
+ * The cache doesn't see tokens removed from the database by another
+ * process. Within the process, tokens must be removed through `erase()`.
+ *
+ * @note This class is thread-safe.
+ */
+class TokenCache
+{
+  public:
+    /**
+     * How long a token remains valid after its last use.
+     */
+    static constexpr std::chrono::minutes TOKEN_LIFETIME{20};
+
+    static constexpr std::chrono::seconds WRITE_BACK_INTERVAL{60};
+
+    explicit TokenCache(DBPtr database);
+    ~TokenCache();
+
+    TokenCache(const TokenCache &) = delete;
+    TokenCache &operator=(const TokenCache &) = delete;
+
+    /**
+     * Retrieve a cached token and slide its expiration.
+     *
+     * Returns nullptr if the token is not cached or has expired.
+     */
+    Auth::TokenPtr use(const std::string &token_str);
+
+    /**
+     * Add a token loaded from, or persisted into, the database
+     * and slide its expiration.
+     */
+    void insert(Auth::TokenPtr token);
+
+    /**
+     * Drop a token from the cache.
+     */
+    void erase(const std::string &token_str);
+
+    /**
+     * Drop all the tokens of a user from the cache. They will be reloaded
+     * from the database when next used.
+     */
+    void erase_user(Auth::UserId user_id);
+
+    /**
+     * Write back the pending expirations now.
+     */
+    void flush();
+
+  private:
+    struct Entry
+    {
+        Auth::TokenPtr token;
+        Auth::UserId owner_id;
+        boost::posix_time::ptime expiration;
+        boost::posix_time::ptime persisted_expiration;
+    };
+
+    static boost::posix_time::ptime now();
+
+    void writer_main();
+
+    /**
+     * Persist the expiration of the entries that changed enough, and
+     * remove the expired tokens.
+     *
+     * Must be called without holding the mutex.
+     */
+    void write_back();
+
+    DBPtr database_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::map<std::string, Entry> entries_;
+    bool stopping_;
+
+    std::thread thread_;
+};
+}
+}
+}
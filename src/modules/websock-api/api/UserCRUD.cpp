@@ -19,6 +19,7 @@
 
 #include "api/UserCRUD.hpp"
 #include "Exceptions.hpp"
+#include "WSServer.hpp"
 #include "api/APISession.hpp"
 #include "core/audit/AuditFactory.hpp"
 #include "core/audit/UserEvent.hpp"
@@ -135,6 +136,9 @@ boost::optional<json> UserCRUD::update_impl(const json &req)
         *user, SystemSecurityContext::instance()));
     audit->finalize();
     t.commit();
+    // Cached tokens hold the previous state of the user, which is
+    // checked when authenticating with a token.
+    ctx_.server.auth().forget_user_tokens(uid);
     return rep;
 }
 
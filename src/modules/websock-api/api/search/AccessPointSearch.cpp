@@ -20,8 +20,11 @@
 #include "api/search/AccessPointSearch.hpp"
 #include "Exceptions.hpp"
 #include "api/APISession.hpp"
+#include "api/search/SearchBase.hpp"
 #include "core/auth/AccessPoint.hpp"
 #include "core/auth/AccessPoint_odb.h"
+#include "core/auth/AccessPoint_odb_pgsql.h"
+#include "core/auth/AccessPoint_odb_sqlite.h"
 #include "tools/db/DBService.hpp"
 #include "tools/log.hpp"
 
@@ -39,53 +42,11 @@ MethodHandlerUPtr AccessPointSearch::create(RequestContext ctx)
     return std::make_unique<AccessPointSearch>(ctx);
 }
 
-struct AccessPointComparator
-{
-    bool operator()(const Auth::AccessPoint &ap1, const Auth::AccessPoint &ap2)
-    {
-        ASSERT_LOG(ap1.id(), "g1 has no id.");
-        ASSERT_LOG(ap2.id(), "g2 has no id.");
-        return ap1.id() < ap2.id();
-    }
-};
-
 json AccessPointSearch::process_impl(const json &req)
 {
-    json rep = json::array();
-    DBPtr db = ctx_.dbsrv->db();
-    odb::transaction t(db->begin());
-    using Query              = odb::query<Auth::AccessPoint>;
-    std::string partial_name = req.at("partial_name");
-    std::set<Auth::AccessPoint, AccessPointComparator> access_points;
-
-    // todo fix me performance
-
-    for (auto i = 0u; i < partial_name.length(); ++i)
-    {
-        auto partial_name_copy = partial_name;
-        partial_name_copy[i]   = std::toupper(partial_name[i]);
-        Query q(Query::alias.like("%" + partial_name_copy + "%"));
-        auto results = db->query(q);
-        for (const auto &ap : results)
-        {
-            access_points.insert(ap);
-        }
-    }
-
-    Query q(Query::alias.like("%" + partial_name + "%"));
-    auto results = db->query(q);
-    for (const auto &ap : results)
-    {
-        access_points.insert(ap);
-    }
-
-    for (const auto &ap : access_points)
-    {
-        json result_json = {{"id", ap.id()}, {"alias", ap.alias()}};
-        rep.push_back(result_json);
-    }
-
-    return rep;
+    return EntitySearchTool<Auth::AccessPoint, use_alias_tag>().search_json(
+        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>(),
+        search_limit(req));
 }
 
 std::vector<ActionActionParam>
@@ -20,7 +20,10 @@
 #include "api/search/CredentialSearch.hpp"
 #include "Exceptions.hpp"
 #include "api/APISession.hpp"
+#include "api/search/SearchBase.hpp"
 #include "core/credentials/Credential_odb.h"
+#include "core/credentials/Credential_odb_pgsql.h"
+#include "core/credentials/Credential_odb_sqlite.h"
 #include "tools/db/DBService.hpp"
 #include "tools/log.hpp"
 #include <core/credentials/serializers/PolymorphicCredentialSerializer.hpp>
@@ -39,57 +42,20 @@ MethodHandlerUPtr CredentialSearch::create(RequestContext ctx)
     return std::make_unique<CredentialSearch>(ctx);
 }
 
-struct CredentialComparator
-{
-    bool operator()(const Cred::CredentialPtr &c1, const Cred::CredentialPtr &c2)
-    {
-        ASSERT_LOG(c1, "Credential c1 is null");
-        ASSERT_LOG(c2, "Credential c2 is null");
-        ASSERT_LOG(c1->id(), "c1 has no id.");
-        ASSERT_LOG(c2->id(), "c2 has no id.");
-        return c1->id() < c2->id();
-    }
-};
-
 json CredentialSearch::process_impl(const json &req)
 {
     json rep = json::array();
     DBPtr db = ctx_.dbsrv->db();
     odb::transaction t(db->begin());
-    using Query              = odb::query<Cred::Credential>;
     std::string partial_name = req.at("partial_name");
-    std::set<Cred::CredentialPtr, CredentialComparator> creds;
-
-    // We want a case insensitive search. However, there is no portable
-    // way to do this. So for now we'll rely on a naive, potentially slow
-    // bruteforce-style implementation.
-    // todo: fixme
-
-    for (auto i = 0u; i < partial_name.length(); ++i)
-    {
-        auto partial_name_copy = partial_name;
-        partial_name_copy[i]   = std::toupper(partial_name[i]);
-        Query q(Query::alias.like("%" + partial_name_copy + "%"));
-        auto results = db->query(q);
-        for (const auto &cred : results)
-        {
-            // We want shared_ptr to store in set. Call load, this should load from
-            // the cache anyway.
-            creds.insert(db->load<Cred::Credential>(cred.id()));
-        }
-    }
-
-    Query q(Query::alias.like("%" + partial_name + "%"));
-    auto results = db->query(q);
-    for (const auto &cred : results)
-    {
-        // We want shared_ptr to store in set. Call load, this should load from the
-        // cache anyway.
-        creds.insert(db->load<Cred::Credential>(cred.id()));
-    }
 
-    for (const auto &cred : creds)
+    auto results = search_entities<Cred::Credential, use_alias_tag>(
+        db, partial_name, search_limit(req));
+    for (const auto &result : results)
     {
+        // We want the most derived type to serialize the credential type.
+        // Call load, this should load from the cache anyway.
+        auto cred = db->load<Cred::Credential>(result.id());
         ASSERT_LOG(cred, "Credential is null.");
         json result_json = {
             {"id", cred->id()},
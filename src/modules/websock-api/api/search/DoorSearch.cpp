@@ -20,8 +20,11 @@
 #include "api/search/DoorSearch.hpp"
 #include "Exceptions.hpp"
 #include "api/APISession.hpp"
+#include "api/search/SearchBase.hpp"
 #include "core/auth/Door.hpp"
 #include "core/auth/Door_odb.h"
+#include "core/auth/Door_odb_pgsql.h"
+#include "core/auth/Door_odb_sqlite.h"
 #include "tools/db/DBService.hpp"
 #include "tools/log.hpp"
 
@@ -39,56 +42,11 @@ MethodHandlerUPtr DoorSearch::create(RequestContext ctx)
     return std::make_unique<DoorSearch>(ctx);
 }
 
-struct DoorComparator
-{
-    bool operator()(const Auth::Door &d1, const Auth::Door &d2)
-    {
-        ASSERT_LOG(d1.id(), "d1 has no id.");
-        ASSERT_LOG(d2.id(), "d2 has no id.");
-        return d1.id() < d2.id();
-    }
-};
-
 json DoorSearch::process_impl(const json &req)
 {
-    json rep = json::array();
-    DBPtr db = ctx_.dbsrv->db();
-    odb::transaction t(db->begin());
-    using Query              = odb::query<Auth::Door>;
-    std::string partial_name = req.at("partial_name");
-    std::set<Auth::Door, DoorComparator> doors;
-
-    // We want a case insensitive search. However, there is no portable
-    // way to do this. So for now we'll rely on a naive, potentially slow
-    // bruteforce-style implementation.
-    // todo: fixme
-
-    for (auto i = 0u; i < partial_name.length(); ++i)
-    {
-        auto partial_name_copy = partial_name;
-        partial_name_copy[i]   = std::toupper(partial_name[i]);
-        Query q(Query::alias.like("%" + partial_name_copy + "%"));
-        auto results = db->query(q);
-        for (const auto &door : results)
-        {
-            doors.insert(door);
-        }
-    }
-
-    Query q(Query::alias.like("%" + partial_name + "%"));
-    auto results = db->query(q);
-    for (const auto &door : results)
-    {
-        doors.insert(door);
-    }
-
-    for (const auto &door : doors)
-    {
-        json result_json = {{"id", door.id()}, {"alias", door.alias()}};
-        rep.push_back(result_json);
-    }
-
-    return rep;
+    return EntitySearchTool<Auth::Door, use_alias_tag>().search_json(
+        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>(),
+        search_limit(req));
 }
 
 std::vector<ActionActionParam> DoorSearch::required_permission(const json &) const
@@ -20,6 +20,8 @@
 #include "api/search/ScheduleSearch.hpp"
 #include "api/search/SearchBase.hpp"
 #include "tools/Schedule_odb.h"
+#include "tools/Schedule_odb_pgsql.h"
+#include "tools/Schedule_odb_sqlite.h"
 
 
 using namespace Leosac;
@@ -39,7 +41,8 @@ MethodHandlerUPtr ScheduleSearch::create(RequestContext ctx)
 json ScheduleSearch::process_impl(const json &req)
 {
     return EntitySearchTool<Tools::Schedule, use_name_tag>().search_json(
-        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>());
+        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>(),
+        search_limit(req));
 }
 
 std::vector<ActionActionParam>
@@ -35,6 +35,10 @@ using json = nlohmann::json;
  *
  * Request:
  *     + 'partial_name': A part of the name we are looking for.
+ *     + 'limit': Optional. Maximum number of results (default 50, max 500).
+ *
+ * The search is case-insensitive. Results are ranked: exact matches first,
+ * then prefix matches, then other matches.
  *
  * Response:
  *     A list of {id,name} for doors that match the partial name.
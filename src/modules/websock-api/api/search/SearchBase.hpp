@@ -19,9 +19,14 @@
 
 #pragma once
 
+#include "tools/JSONUtils.hpp"
 #include "tools/db/DBService.hpp"
+#include "tools/db/database.hpp"
 #include "tools/log.hpp"
+#include <algorithm>
 #include <json.hpp>
+#include <odb/pgsql/database.hxx>
+#include <odb/sqlite/database.hxx>
 
 namespace Leosac
 {
@@ -30,6 +35,45 @@ namespace Module
 namespace WebSockAPI
 {
 
+/**
+ * Number of results returned by `search.*` endpoints when the request
+ * doesn't specify a `limit`.
+ */
+static constexpr int SEARCH_DEFAULT_LIMIT = 50;
+
+/**
+ * Upper bound for the `limit` parameter of `search.*` endpoints.
+ */
+static constexpr int SEARCH_MAX_LIMIT = 500;
+
+/**
+ * Extract the optional `limit` parameter of a search request, clamped
+ * to [1, SEARCH_MAX_LIMIT].
+ */
+inline int search_limit(const json &req)
+{
+    int limit =
+        JSONUtil::extract_with_default(req, "limit", SEARCH_DEFAULT_LIMIT);
+    return std::min(std::max(limit, 1), SEARCH_MAX_LIMIT);
+}
+
+/**
+ * Escape the LIKE wildcards (and the escape character itself) so that
+ * `partial` is matched literally. The escape character is `\`.
+ */
+inline std::string escape_like_pattern(const std::string &partial)
+{
+    std::string escaped;
+    escaped.reserve(partial.size());
+    for (char c : partial)
+    {
+        if (c == '%' || c == '_' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
 /**
  * Use this tag to search for entities with an "alias" field
  */
@@ -52,86 +96,110 @@ struct use_username_tag
 };
 
 /**
- * This is a templated class that perform case-insensitive database
- * search against entities.
- *
- * It can be used to implemented the various `search.*` API endpoints.
+ * Retrieve the column of `Query` that is searched for a given tag.
  */
-template <typename DatabaseEntity, typename AliasOrName>
-struct EntitySearchTool
+template <typename Query>
+const auto &search_column(use_alias_tag)
 {
+    return Query::alias;
+}
 
-    using Query = odb::query<DatabaseEntity>;
-
-    struct DatabaseEntityComparator
-    {
-        bool operator()(const DatabaseEntity &e1, const DatabaseEntity &e2)
-        {
-            static_assert(std::is_integral<decltype(e1.id())>::value,
-                          "Id is not an integral type.");
-            ASSERT_LOG(e1.id(), "entity1 has no id.");
-            ASSERT_LOG(e2.id(), "entity2 has no id.");
-            return e1.id() < e2.id();
-        }
-    };
+template <typename Query>
+const auto &search_column(use_name_tag)
+{
+    return Query::name;
+}
 
-    using EntitySet = std::set<DatabaseEntity, DatabaseEntityComparator>;
+template <typename Query>
+const auto &search_column(use_username_tag)
+{
+    return Query::username;
+}
 
-  private:
-    template <typename T>
-    std::enable_if_t<std::is_same<T, use_alias_tag>::value, Query>
-    build_query(const std::string &partial)
-    {
-        Query q(Query::alias.like("%" + partial + "%"));
-        return std::move(q);
-    }
+/**
+ * Build a database specific query that performs a ranked, case-insensitive
+ * search of `partial` in the alias, name or username of the entity.
+ *
+ * Both sides of the comparison go through the `lower()` SQL function, which
+ * exists on both SQLite and PostgreSQL, so the whole search is a single query.
+ *
+ * Exact matches come first, then prefix matches, then other matches. Ties
+ * are ordered by value, then by id. At most `limit` entities are selected.
+ */
+template <typename NativeQuery, typename AliasOrName>
+NativeQuery build_search_query(const std::string &partial, int limit)
+{
+    const auto &column = search_column<NativeQuery>(AliasOrName{});
+    auto escaped       = escape_like_pattern(partial);
+
+    NativeQuery q("lower(" + column + ") LIKE lower(" +
+                  NativeQuery::_val("%" + escaped + "%") + ") ESCAPE '\\'");
+    q += "ORDER BY CASE WHEN lower(" + column + ") = lower(" +
+         NativeQuery::_val(partial) + ") THEN 0";
+    q += "WHEN lower(" + column + ") LIKE lower(" +
+         NativeQuery::_val(escaped + "%") + ") ESCAPE '\\' THEN 1 ELSE 2 END";
+    q += "," + column + "," + NativeQuery::id;
+    q += "LIMIT" + NativeQuery::_val(limit);
+    return q;
+}
 
-    template <typename T>
-    std::enable_if_t<std::is_same<T, use_name_tag>::value, Query>
-    build_query(const std::string &partial)
+/**
+ * Run a ranked, case-insensitive search for entities of type `DatabaseEntity`.
+ *
+ * @see build_search_query()
+ */
+template <typename DatabaseEntity, typename AliasOrName>
+odb::result<DatabaseEntity> search_entities(DBPtr db, const std::string &partial,
+                                            int limit)
+{
+    // Bound values outside of a column comparison need to be database specific.
+    if (db->id() == odb::database_id::id_sqlite)
     {
-        Query q(Query::name.like("%" + partial + "%"));
-        return std::move(q);
+        using SQLiteQuery = odb::sqlite::query<DatabaseEntity>;
+        auto sl_db        = std::static_pointer_cast<odb::sqlite::database>(db);
+        return sl_db->query<DatabaseEntity>(
+            build_search_query<SQLiteQuery, AliasOrName>(partial, limit));
     }
-
-    template <typename T>
-    std::enable_if_t<std::is_same<T, use_username_tag>::value, Query>
-    build_query(const std::string &partial)
+    else if (db->id() == odb::database_id::id_pgsql)
     {
-        Query q(Query::username.like("%" + partial + "%"));
-        return std::move(q);
+        using PGSQLQuery = odb::pgsql::query<DatabaseEntity>;
+        auto pg_db       = std::static_pointer_cast<odb::pgsql::database>(db);
+        return pg_db->query<DatabaseEntity>(
+            build_search_query<PGSQLQuery, AliasOrName>(partial, limit));
     }
+    return odb::result<DatabaseEntity>();
+}
 
-    void search_and_append(DBPtr db, EntitySet &entities, const std::string &partial)
-    {
-        Query q(build_query<AliasOrName>(partial));
-        auto results = db->query(q);
-        for (const auto &ap : results)
-        {
-            entities.insert(ap);
-        }
-    };
-
+/**
+ * This is a templated class that perform case-insensitive database
+ * search against entities.
+ *
+ * It can be used to implemented the various `search.*` API endpoints.
+ */
+template <typename DatabaseEntity, typename AliasOrName>
+struct EntitySearchTool
+{
   public:
+    /**
+     * Search for entities whose alias, name or username contains
+     * `partial_name_or_alias`, ignoring case.
+     *
+     * The returned entities are ranked, best match first.
+     */
     std::vector<DatabaseEntity> search(DBPtr db,
-                                       const std::string &partial_name_or_alias)
+                                       const std::string &partial_name_or_alias,
+                                       int limit = SEARCH_DEFAULT_LIMIT)
     {
         odb::transaction t(db->begin());
-        EntitySet entities;
+        std::vector<DatabaseEntity> entities;
 
-        search_and_append(db, entities, partial_name_or_alias);
-
-        // Attempt to convert each letter to CAPS so the search is
-        // a not too much case sensitive.
-        // Todo: This needs to be improved.
-        for (auto i = 0u; i < partial_name_or_alias.length(); ++i)
+        auto results = search_entities<DatabaseEntity, AliasOrName>(
+            db, partial_name_or_alias, limit);
+        for (const auto &entity : results)
         {
-            auto partial_name_copy = partial_name_or_alias;
-            partial_name_copy[i]   = std::toupper(partial_name_or_alias[i]);
-            search_and_append(db, entities, partial_name_copy);
+            entities.push_back(entity);
         }
-
-        return std::vector<DatabaseEntity>(entities.begin(), entities.end());
+        return entities;
     }
 
   private:
@@ -161,17 +229,19 @@ struct EntitySearchTool
 
   public:
     /**
-     * Returns a JSON array with the result from the search.
+     * Returns a JSON array with the result from the search, best
+     * match first.
      *
      * The JSON looks like this:
      *     [ {id: ${ENTITY_ID}},
      *       {name|alias|username: ${ENTITY_NAME_OR_ALIAS}}
      *     ]
      */
-    json search_json(DBPtr db, const std::string &partial)
+    json search_json(DBPtr db, const std::string &partial,
+                     int limit = SEARCH_DEFAULT_LIMIT)
     {
-        auto entities = search(db, partial);
-        json rep;
+        auto entities = search(db, partial, limit);
+        json rep = json::array();
         for (const auto &entity : entities)
         {
             rep.push_back(build_json_entry<AliasOrName>(entity));
@@ -19,6 +19,8 @@
 
 #include "api/search/UserSearch.hpp"
 #include "core/auth/User_odb.h"
+#include "core/auth/User_odb_pgsql.h"
+#include "core/auth/User_odb_sqlite.h"
 #include "modules/websock-api/api/search/SearchBase.hpp"
 
 
@@ -39,7 +41,8 @@ MethodHandlerUPtr UserSearch::create(RequestContext ctx)
 json UserSearch::process_impl(const json &req)
 {
     return EntitySearchTool<Auth::User, use_username_tag>().search_json(
-        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>());
+        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>(),
+        search_limit(req));
 }
 
 std::vector<ActionActionParam> UserSearch::required_permission(const json &) const
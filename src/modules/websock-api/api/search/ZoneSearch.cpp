@@ -20,6 +20,8 @@
 #include "api/search/ZoneSearch.hpp"
 #include "api/search/SearchBase.hpp"
 #include "core/auth/Zone_odb.h"
+#include "core/auth/Zone_odb_pgsql.h"
+#include "core/auth/Zone_odb_sqlite.h"
 
 
 using namespace Leosac;
@@ -39,7 +41,8 @@ MethodHandlerUPtr ZoneSearch::create(RequestContext ctx)
 json ZoneSearch::process_impl(const json &req)
 {
     return EntitySearchTool<Auth::Zone, use_alias_tag>().search_json(
-        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>());
+        ctx_.dbsrv->db(), req.at("partial_name").get<std::string>(),
+        search_limit(req));
 }
 
 std::vector<ActionActionParam> ZoneSearch::required_permission(const json &) const
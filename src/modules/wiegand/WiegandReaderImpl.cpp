@@ -18,6 +18,7 @@
 */
 
 #include "WiegandReaderImpl.hpp"
+#include "hardware/WiegandCapture.hpp"
 #include "strategies/WiegandStrategy.hpp"
 #include "tools/log.hpp"
 #include <core/auth/Auth.hpp>
@@ -28,13 +29,16 @@ using namespace Leosac::Module::Wiegand::Strategy;
 using namespace Leosac::Hardware;
 using namespace Leosac::Auth;
 
+constexpr std::chrono::milliseconds WiegandReaderImpl::DEFAULT_FRAME_GAP;
+
 WiegandReaderImpl::WiegandReaderImpl(zmqpp::context &ctx,
                                      const std::string &reader_name,
                                      const std::string &data_high_pin,
                                      const std::string &data_low_pin,
                                      const std::string &green_led_name,
                                      const std::string &buzzer_name,
-                                     std::unique_ptr<WiegandStrategy> strategy)
+                                     std::unique_ptr<WiegandStrategy> strategy,
+                                     std::chrono::milliseconds frame_gap)
     : bus_sub_(ctx, zmqpp::socket_type::sub)
     , sock_(ctx, zmqpp::socket_type::rep)
     , bus_push_(ctx, zmqpp::socket_type::push)
@@ -43,17 +47,21 @@ WiegandReaderImpl::WiegandReaderImpl(zmqpp::context &ctx,
     , green_led_(nullptr)
     , buzzer_(nullptr)
     , strategy_(std::move(strategy))
+    , frame_gap_(frame_gap)
+    , input_start_(TimePoint::max())
 {
     bus_sub_.connect("inproc://zmq-bus-pub");
     bus_push_.connect("inproc://zmq-bus-pull");
 
     sock_.bind("inproc://" + name_);
 
-    topic_high_ = "S_INT:" + data_high_pin;
-    topic_low_  = "S_INT:" + data_low_pin;
+    topic_high_  = "S_INT:" + data_high_pin;
+    topic_low_   = "S_INT:" + data_low_pin;
+    topic_frame_ = Hardware::WiegandCapture::topic(data_high_pin, data_low_pin);
 
     bus_sub_.subscribe(topic_high_);
     bus_sub_.subscribe(topic_low_);
+    bus_sub_.subscribe(topic_frame_);
 
     std::fill(buffer_.begin(), buffer_.end(), 0);
 
@@ -74,9 +82,14 @@ WiegandReaderImpl::WiegandReaderImpl(WiegandReaderImpl &&o)
     , bus_push_(std::move(o.bus_push_))
     , name_(std::move(o.name_))
     , strategy_(std::move(o.strategy_))
+    , frame_gap_(o.frame_gap_)
+    , last_bit_(o.last_bit_)
+    , input_start_(o.input_start_)
+    , latency_(o.latency_)
 {
-    topic_high_ = o.topic_high_;
-    topic_low_  = o.topic_low_;
+    topic_high_  = o.topic_high_;
+    topic_low_   = o.topic_low_;
+    topic_frame_ = o.topic_frame_;
 
     buffer_  = o.buffer_;
     counter_ = o.counter_;
@@ -90,8 +103,20 @@ WiegandReaderImpl::WiegandReaderImpl(WiegandReaderImpl &&o)
 
 void WiegandReaderImpl::handle_bus_msg()
 {
+    zmqpp::message bus_msg;
     std::string msg;
-    bus_sub_.receive(msg);
+    bus_sub_.receive(bus_msg);
+    bus_msg >> msg;
+
+    if (msg == topic_frame_)
+    {
+        handle_frame(bus_msg);
+        return;
+    }
+
+    last_bit_ = std::chrono::system_clock::now();
+    if (input_start_ == TimePoint::max())
+        input_start_ = last_bit_;
 
     if (counter_ < 128)
     {
@@ -114,6 +139,33 @@ void WiegandReaderImpl::handle_bus_msg()
     }
 }
 
+void WiegandReaderImpl::handle_frame(zmqpp::message &msg)
+{
+    int32_t nb_bits;
+    std::string bits;
+    int64_t first_bit_us;
+    msg >> nb_bits >> bits >> first_bit_us;
+
+    if (nb_bits <= 0 || nb_bits > 128 ||
+        bits.size() != static_cast<size_t>((nb_bits + 7) / 8))
+    {
+        WARN("Received an invalid Wiegand frame (" << nb_bits << " bits).");
+        return;
+    }
+
+    read_reset();
+    std::copy(bits.begin(), bits.end(), buffer_.begin());
+    counter_ = nb_bits;
+
+    last_bit_ = std::chrono::system_clock::now();
+    if (input_start_ == TimePoint::max())
+        input_start_ = TimePoint(std::chrono::microseconds(first_bit_us));
+
+    // The GPIO module only publishes a frame once the inter-frame
+    // gap elapsed: there is no need to wait any longer.
+    timeout();
+}
+
 void WiegandReaderImpl::timeout()
 {
     assert(strategy_);
@@ -125,7 +177,28 @@ void WiegandReaderImpl::timeout()
         // and authentication attempt by signaling the application.
         strategy_->signal(bus_push_);
         strategy_->reset();
+        if (input_start_ != TimePoint::max())
+            latency_.record(std::chrono::system_clock::now() - input_start_);
+        input_start_ = TimePoint::max();
     }
+    else if (!counter_ && strategy_->next_deadline() == TimePoint::max())
+    {
+        // Nothing pending: the input was incomplete or invalid.
+        input_start_ = TimePoint::max();
+    }
+}
+
+WiegandReaderImpl::TimePoint WiegandReaderImpl::next_timeout() const
+{
+    if (counter_)
+        return last_bit_ + frame_gap_;
+    return strategy_->next_deadline();
+}
+
+const Leosac::Tools::LatencyHistogram &
+WiegandReaderImpl::latency_histogram() const
+{
+    return latency_;
 }
 
 void WiegandReaderImpl::handle_request()
@@ -23,6 +23,7 @@
 #include "hardware/facades/FBuzzer.hpp"
 #include "hardware/facades/FLED.hpp"
 #include "modules/wiegand/strategies/WiegandStrategy.hpp"
+#include "tools/LatencyHistogram.hpp"
 #include "zmqpp/zmqpp.hpp"
 #include <chrono>
 #include <string>
@@ -41,6 +42,14 @@ namespace Wiegand
 class WiegandReaderImpl
 {
   public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    /**
+    * Default duration of inactivity on the data lines after which a frame
+    * is complete.
+    */
+    static constexpr std::chrono::milliseconds DEFAULT_FRAME_GAP{50};
+
     /**
     * Create a new implementation of a Wiegand Reader.
     * @param ctx ZMQ context.
@@ -49,13 +58,15 @@ class WiegandReaderImpl
     * @param green_led_name name of the "green led" LED device.
     * @param buzzer_name name of the buzzer device. -- no buzzer module yet.
     * @param strategy strategy (mode implementation) the reader is using
+    * @param frame_gap duration of inactivity after which a frame is complete.
     */
     WiegandReaderImpl(zmqpp::context &ctx, const std::string &reader_name,
                       const std::string &data_high_pin,
                       const std::string &data_low_pin,
                       const std::string &green_led_name,
                       const std::string &buzzer_name,
-                      std::unique_ptr<Strategy::WiegandStrategy> strategy);
+                      std::unique_ptr<Strategy::WiegandStrategy> strategy,
+                      std::chrono::milliseconds frame_gap = DEFAULT_FRAME_GAP);
 
     ~WiegandReaderImpl();
 
@@ -87,12 +98,24 @@ class WiegandReaderImpl
 
     /**
     * Timeout (no more data burst to handle). The WiegandModule call this when
-    * polling on any wiegand reader times out.
+    * the reader's deadline (see `next_timeout()`) is reached.
     * The reader shall publish an event if it received any meaningful message since
     * the last timeout.
     */
     void timeout();
 
+    /**
+    * Time point at which `timeout()` must be called: the end of the current
+    * frame if bits are pending, or the strategy's own deadline otherwise.
+    */
+    TimePoint next_timeout() const;
+
+    /**
+    * Latency between the first bit of a credential and the moment it is
+    * signaled to the application.
+    */
+    const Tools::LatencyHistogram &latency_histogram() const;
+
     /**
     * Reset the "read state" of the reader, effectively cleaning the
     * wiegand-bit-buffer
@@ -135,6 +158,17 @@ class WiegandReaderImpl
     */
     std::string topic_low_;
 
+    /**
+    * ZMQ topic-string of complete frames, when the GPIO module decodes the
+    * Wiegand data lines itself (see Hardware::WiegandCapture).
+    */
+    std::string topic_frame_;
+
+    /**
+    * Load a complete frame published by a GPIO module.
+    */
+    void handle_frame(zmqpp::message &msg);
+
     /**
     * Buffer to store incoming bits from high and low gpios.
     */
@@ -164,6 +198,21 @@ class WiegandReaderImpl
     * Concrete implementation of the reader mode.
     */
     std::unique_ptr<Strategy::WiegandStrategy> strategy_;
+
+    std::chrono::milliseconds frame_gap_;
+
+    /**
+    * Time point of the last received bit.
+    */
+    TimePoint last_bit_;
+
+    /**
+    * Time point of the first bit of the credential being read, or
+    * `TimePoint::max()` if the reader is idle.
+    */
+    TimePoint input_start_;
+
+    Tools::LatencyHistogram latency_;
 };
 }
 }
@@ -100,7 +100,7 @@ void Autodetect::check_timeout()
 
     if (reading_pin_)
     {
-        if (elapsed_ms_pin > delay_)
+        if (elapsed_ms_pin >= delay_)
         {
             read_pin_strategy_->timeout();
             DEBUG("PIN READING TIMEOUT");
@@ -111,10 +111,18 @@ void Autodetect::check_timeout()
                 reading_pin_ = false;
                 reader_->read_reset();
             }
+            else
+            {
+                // Nothing usable was typed: give up on the PIN, a previously
+                // read card may still be validated on its own.
+                DEBUG("Abort PIN reading");
+                reading_pin_ = false;
+                read_pin_strategy_->reset();
+            }
         }
     }
     // 2 sec of total inactivity and we valid card.
-    if (elapsed_ms > delay_ && elapsed_ms_pin > delay_)
+    if (elapsed_ms >= delay_ && elapsed_ms_pin >= delay_)
     {
         if (read_card_strategy_->completed() && read_card_strategy_->get_nb_bits())
         {
@@ -125,6 +133,25 @@ void Autodetect::check_timeout()
     }
 }
 
+WiegandStrategy::TimePoint Autodetect::next_deadline() const
+{
+    auto deadline = TimePoint::max();
+    if (ready_)
+        return deadline;
+
+    if (reading_pin_ && read_pin_strategy_)
+    {
+        deadline = std::max(last_pin_read_ + delay_,
+                            read_pin_strategy_->next_deadline());
+    }
+    if (read_card_strategy_->completed() && read_card_strategy_->get_nb_bits())
+    {
+        deadline =
+            std::min(deadline, std::max(time_card_read_, last_pin_read_) + delay_);
+    }
+    return deadline;
+}
+
 bool Autodetect::completed() const
 {
     return ready_;
@@ -56,6 +56,12 @@ class Autodetect : public WiegandStrategy
 
     virtual void timeout() override;
 
+    /**
+    * Wake up to flush a PIN code after `delay` of inactivity, or to
+    * submit a card alone when no PIN code was typed after `delay`.
+    */
+    virtual TimePoint next_deadline() const override;
+
     virtual bool completed() const override;
 
     virtual void signal(zmqpp::socket &sock) override;
@@ -91,7 +97,6 @@ class Autodetect : public WiegandStrategy
     PinReadingUPtr read_pin_strategy_;
 
     std::chrono::milliseconds delay_;
-    using TimePoint = std::chrono::system_clock::time_point;
     TimePoint time_card_read_;
     TimePoint last_pin_read_;
 
@@ -58,7 +58,7 @@ void WiegandCardAndPin::timeout()
     }
     else
     {
-        if (elapsed_ms > delay_)
+        if (elapsed_ms >= delay_)
         {
             DEBUG("Too slow to enter pin code. Aborting.");
             reset();
@@ -74,6 +74,13 @@ void WiegandCardAndPin::timeout()
     }
 }
 
+WiegandStrategy::TimePoint WiegandCardAndPin::next_deadline() const
+{
+    if (reading_card_)
+        return read_card_strategy_->next_deadline();
+    return std::min(time_card_read_ + delay_, read_pin_strategy_->next_deadline());
+}
+
 bool WiegandCardAndPin::completed() const
 {
     return ready_;
@@ -52,6 +52,12 @@ class WiegandCardAndPin : public WiegandStrategy
 
     virtual void timeout() override;
 
+    /**
+    * Once the card was read, the PIN code must be typed before `delay`
+    * elapses.
+    */
+    virtual TimePoint next_deadline() const override;
+
     virtual bool completed() const override;
 
     virtual void signal(zmqpp::socket &sock) override;
@@ -70,7 +76,6 @@ class WiegandCardAndPin : public WiegandStrategy
     PinReadingUPtr read_pin_strategy_;
 
     std::chrono::milliseconds delay_;
-    using TimePoint = std::chrono::system_clock::time_point;
     TimePoint time_card_read_;
 
     bool reading_card_;
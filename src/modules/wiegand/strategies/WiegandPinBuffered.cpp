@@ -57,6 +57,7 @@ void WiegandPinBuffered::timeout()
     {
         // per HID documentation.
         WARN("Invalid Pin Code");
+        reset();
         return;
     }
     pin_   = std::to_string(n);
@@ -78,7 +78,7 @@ void WiegandPinNBitsOnly<NbBits>::timeout()
 
     if (!reader_->counter())
     {
-        if (elapsed_ms > pin_timeout_)
+        if (elapsed_ms >= pin_timeout_)
             end_of_input();
         return;
     }
@@ -102,6 +102,15 @@ void WiegandPinNBitsOnly<NbBits>::timeout()
     reader_->read_reset();
 }
 
+template <unsigned int NbBits>
+typename WiegandPinNBitsOnly<NbBits>::TimePoint
+WiegandPinNBitsOnly<NbBits>::next_deadline() const
+{
+    if (inputs_.empty() || ready_)
+        return TimePoint::max();
+    return last_update_ + pin_timeout_;
+}
+
 template <unsigned int NbBits>
 void WiegandPinNBitsOnly<NbBits>::end_of_input()
 {
@@ -52,6 +52,12 @@ class WiegandPinNBitsOnly : public PinReading
     // we reset the counter_ and buffer_ for each key.
     virtual void timeout() override;
 
+    /**
+    * Once a key was pressed, the PIN code is flushed `pin_timeout` after
+    * the last key press.
+    */
+    virtual TimePoint next_deadline() const override;
+
     virtual bool completed() const override;
 
     virtual void signal(zmqpp::socket &sock) override;
@@ -77,7 +83,6 @@ class WiegandPinNBitsOnly : public PinReading
     std::chrono::milliseconds pin_timeout_;
     char pin_end_key_;
 
-    using TimePoint = std::chrono::system_clock::time_point;
     TimePoint last_update_;
 
     /**
@@ -50,6 +50,8 @@ using WiegandStrategyUPtr = std::unique_ptr<WiegandStrategy>;
 class WiegandStrategy
 {
   public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
     WiegandStrategy(WiegandReaderImpl *reader)
         : reader_(reader)
     {
@@ -58,10 +60,25 @@ class WiegandStrategy
     virtual ~WiegandStrategy() = default;
 
     /**
-    * This is called when the module detect a timeout. (2 ms of inactivity).
+    * This is called when the reader completed a frame (no data received during
+    * the frame gap), and when the deadline returned by `next_deadline()` is
+    * reached.
     */
     virtual void timeout() = 0;
 
+    /**
+    * Time point at which the strategy wants `timeout()` to be called even
+    * if no data is received. For example, to flush a PIN code after some
+    * inactivity.
+    *
+    * The default implementation returns `TimePoint::max()`: the strategy
+    * only reacts to received frames.
+    */
+    virtual TimePoint next_deadline() const
+    {
+        return TimePoint::max();
+    }
+
     /**
     * Did the strategy gather needed data?
     * If this function returns true, that means that the strategy implementation
@@ -18,6 +18,7 @@
 */
 
 #include "modules/wiegand/wiegand.hpp"
+#include "core/CoreUtils.hpp"
 #include "core/Scheduler.hpp"
 #include "core/kernel.hpp"
 #include "hardware/Buzzer.hpp"
@@ -61,12 +62,16 @@ WiegandReaderModule::WiegandReaderModule(zmqpp::context &ctx, zmqpp::socket *pip
 {
     process_config();
 
-    for (auto &reader : readers_)
+    for (size_t idx = 0; idx < readers_.size(); ++idx)
     {
-        reactor_.add(reader.bus_sub_,
-                     std::bind(&WiegandReaderImpl::handle_bus_msg, &reader));
+        auto &reader = readers_[idx];
+        reactor_.add(reader.bus_sub_, [this, idx]() {
+            readers_[idx].handle_bus_msg();
+            schedule_timeout(idx);
+        });
         reactor_.add(reader.sock_,
                      std::bind(&WiegandReaderImpl::handle_request, &reader));
+        schedule_timeout(idx);
     }
 }
 
@@ -78,6 +83,71 @@ WiegandReaderModule::~WiegandReaderModule()
         hwd_service->unregister_serializer<WiegandReaderConfig>();
 }
 
+void WiegandReaderModule::schedule_timeout(size_t reader_idx)
+{
+    auto deadline = readers_[reader_idx].next_timeout();
+    if (deadline != TimePoint::max())
+        deadlines_.emplace(deadline, reader_idx);
+}
+
+void WiegandReaderModule::process_timeouts()
+{
+    auto now = std::chrono::system_clock::now();
+    while (!deadlines_.empty() && deadlines_.top().first <= now)
+    {
+        Deadline deadline = deadlines_.top();
+        deadlines_.pop();
+
+        auto &reader = readers_[deadline.second];
+        // Outdated entry: the reader deadline moved since it was pushed,
+        // and a newer entry exists.
+        if (reader.next_timeout() > deadline.first)
+            continue;
+
+        reader.timeout();
+        auto next = reader.next_timeout();
+        if (next == TimePoint::max())
+            continue;
+        // Strategies reset their pending state once their deadline is handled.
+        // A deadline still in the past is dropped rather than re-armed: it
+        // would make us spin.
+        if (next <= now)
+        {
+            WARN("Dropping stale timeout for wiegand reader " << reader.name());
+            continue;
+        }
+        deadlines_.emplace(next, deadline.second);
+    }
+}
+
+int WiegandReaderModule::next_poll_timeout() const
+{
+    using namespace std::chrono;
+    if (deadlines_.empty())
+        return -1;
+
+    auto remaining = deadlines_.top().first - system_clock::now();
+    if (remaining <= system_clock::duration::zero())
+        return 0;
+    // Round up, so we don't wake up right before the deadline.
+    return duration_cast<milliseconds>(remaining + milliseconds(1) -
+                                       system_clock::duration(1))
+        .count();
+}
+
+bool WiegandReaderModule::handle_control_request(const std::string &request,
+                                                 zmqpp::message &)
+{
+    if (request != "LATENCY_HISTOGRAM")
+        return false;
+
+    nlohmann::json histograms = nlohmann::json::object();
+    for (const auto &reader : readers_)
+        histograms[reader.name()] = reader.latency_histogram().to_json();
+    control_.send(histograms.dump());
+    return true;
+}
+
 void WiegandReaderModule::process_config()
 {
     boost::property_tree::ptree module_config = config_.get_child("module_config");
@@ -96,6 +166,9 @@ void WiegandReaderModule::process_config()
         load_xml_config(module_config);
     }
 
+    auto frame_gap = std::chrono::milliseconds(module_config.get<int>(
+        "frame_gap", WiegandReaderImpl::DEFAULT_FRAME_GAP.count()));
+
     // Now we process the configuration object.
     for (const auto &reader_config : wiegand_config_->readers())
     {
@@ -112,7 +185,8 @@ void WiegandReaderModule::process_config()
         WiegandReaderImpl reader(
             ctx_, reader_config->name(), reader_config->gpio_high_name(),
             reader_config->gpio_low_name(), reader_config->green_led_name(),
-            reader_config->buzzer_name(), create_strategy(*reader_config, &reader));
+            reader_config->buzzer_name(), create_strategy(*reader_config, &reader),
+            frame_gap);
         utils_->config_checker().register_object(reader.name(),
                                                  ConfigChecker::ObjectType::READER);
         readers_.push_back(std::move(reader));
@@ -128,12 +202,17 @@ void WiegandReaderModule::run()
     }
     while (is_running_)
     {
-        if (!reactor_.poll(50))
-        {
-            for (auto &reader : readers_)
-                reader.timeout();
-        }
+        reactor_.poll(next_poll_timeout());
+        process_timeouts();
+    }
+
+    for (const auto &reader : readers_)
+    {
+        if (reader.latency_histogram().count())
+            INFO("Wiegand reader " << reader.name() << " latency: "
+                                   << reader.latency_histogram().to_json().dump());
     }
+
     auto ws_service = get_service_registry().get_service<WebSockAPI::Service>();
     if (ws_service && ws_helper_thread_)
         ws_helper_thread_->unregister_ws_handlers(*ws_service);
@@ -201,22 +280,27 @@ void WiegandReaderModule::load_db_config()
     auto db = utils_->database();
 
     // First we load or update database schema if needed.
-    schema_version v = db->schema_version("module_wiegand");
-    schema_version cv(schema_catalog::current_version(*db, "module_wiegand"));
-    if (v == 0)
-    {
-        transaction t(db->begin());
-        INFO("Attempt to create module_wiegand SQL schema.");
-        schema_catalog::create_schema(*db, "module_wiegand");
-        t.commit();
-    }
-    else if (v < cv)
     {
-        INFO("Wiegand Module performing database migration. Going from version "
-             << v << " to version " << cv);
-        transaction t(db->begin());
-        schema_catalog::migrate(*db, cv, "module_wiegand");
-        t.commit();
+        // Schema creation and migration must not run concurrently.
+        std::lock_guard<std::mutex> guard(utils_->setup_mutex());
+        schema_version v = db->schema_version("module_wiegand");
+        schema_version cv(schema_catalog::current_version(*db, "module_wiegand"));
+        if (v == 0)
+        {
+            transaction t(db->begin());
+            INFO("Attempt to create module_wiegand SQL schema.");
+            schema_catalog::create_schema(*db, "module_wiegand");
+            t.commit();
+        }
+        else if (v < cv)
+        {
+            INFO("Wiegand Module performing database migration. Going from "
+                 "version "
+                 << v << " to version " << cv);
+            transaction t(db->begin());
+            schema_catalog::migrate(*db, cv, "module_wiegand");
+            t.commit();
+        }
     }
 
     // Create empty configuration object...
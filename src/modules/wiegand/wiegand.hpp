@@ -24,6 +24,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <modules/BaseModule.hpp>
 #include <modules/wiegand/strategies/WiegandStrategy.hpp>
+#include <queue>
 
 namespace Leosac
 {
@@ -58,7 +59,39 @@ class WiegandReaderModule : public BaseModule
     */
     virtual void run() override;
 
+  protected:
+    /**
+    * Handle the `LATENCY_HISTOGRAM` request.
+    *
+    * The response is a JSON object mapping each reader name to its
+    * swipe-to-signal latency histogram.
+    */
+    bool handle_control_request(const std::string &request,
+                                zmqpp::message &msg) override;
+
   private:
+    using TimePoint = WiegandReaderImpl::TimePoint;
+
+    /**
+    * A reader's deadline: time point, and index of the reader in `readers_`.
+    */
+    using Deadline = std::pair<TimePoint, size_t>;
+
+    /**
+    * Push the current deadline of a reader in the `deadlines_` heap.
+    */
+    void schedule_timeout(size_t reader_idx);
+
+    /**
+    * Call `timeout()` on each reader whose deadline is reached.
+    */
+    void process_timeouts();
+
+    /**
+    * Number of milliseconds until the next deadline, or -1.
+    */
+    int next_poll_timeout() const;
+
     /**
     * Create wiegand reader instances based on configuration.
     */
@@ -94,6 +127,16 @@ class WiegandReaderModule : public BaseModule
     std::unique_ptr<WiegandConfig> wiegand_config_;
 
     std::unique_ptr<WSHelperThread> ws_helper_thread_;
+
+    /**
+    * Min-heap of readers' deadlines.
+    *
+    * Entries are never updated in place: a new entry is pushed each time
+    * a reader's deadline changes, and outdated entries are skipped when
+    * they reach the top.
+    */
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>
+        deadlines_;
 };
 }
 }
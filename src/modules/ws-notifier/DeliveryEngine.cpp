@@ -0,0 +1,387 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DeliveryEngine.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
+#include <cassert>
+#include <curl/curl.h>
+#include <deque>
+#include <json.hpp>
+
+using namespace Leosac;
+using namespace Leosac::Module;
+using namespace Leosac::Module::WSNotifier;
+
+constexpr std::chrono::milliseconds DeliveryEngine::MAX_RETRY_DELAY;
+
+/**
+ * State of a target.
+ *
+ * The queue and the counters are protected by the engine's mutex. The
+ * rest is only used by the delivery thread.
+ */
+struct DeliveryEngine::Target
+{
+    TargetInfo info;
+    CURL *easy;
+    curl_slist *json_headers;
+
+    std::deque<PendingEvent> queue;
+
+    /**
+     * Events of the request in flight, or waiting to be retried.
+     */
+    std::vector<PendingEvent> batch;
+    bool in_flight;
+    unsigned attempt;
+    Clock::time_point retry_at;
+
+    /**
+     * Request body. curl doesn't copy it.
+     */
+    std::string body;
+
+    Stats stats;
+    Clock::duration total_latency;
+};
+
+static CURLM *multi_handle(void *multi)
+{
+    return static_cast<CURLM *>(multi);
+}
+
+/**
+ * We don't care about getting the resulting page from the webservice.
+ *
+ * We use this function as a callback for CURL.
+ */
+static size_t write_callback(char * /*ptr*/, size_t size, size_t nmemb,
+                             void * /*userdata*/)
+{
+    return size * nmemb;
+}
+
+/**
+ * Build the body of a request.
+ *
+ * A single event is sent as form fields, which is what the webservices
+ * expected before batching was introduced.
+ */
+static std::string build_body(CURL *easy, const std::vector<CardEvent> &events,
+                              bool as_json)
+{
+    if (!as_json)
+    {
+        assert(events.size() == 1);
+        const auto &event = events.front();
+        const auto &src   = event.auth_source;
+        char *source =
+            curl_easy_escape(easy, src.c_str(), static_cast<int>(src.size()));
+        std::string body = "card_id=" + std::to_string(event.card_id) +
+                           "&auth_source=" + (source ? source : "") +
+                           "&card_id_raw=" + std::to_string(event.card_id_raw);
+        curl_free(source);
+        return body;
+    }
+
+    nlohmann::json body = nlohmann::json::array();
+    for (const auto &event : events)
+    {
+        body.push_back({{"card_id", event.card_id},
+                        {"auth_source", event.auth_source},
+                        {"card_id_raw", event.card_id_raw}});
+    }
+    return body.dump();
+}
+
+DeliveryEngine::DeliveryEngine(const std::vector<TargetInfo> &targets)
+    : multi_(curl_multi_init())
+    , stopping_(false)
+{
+    if (!multi_)
+        throw std::runtime_error("Cannot initialize curl_multi.");
+
+    for (const auto &info : targets)
+    {
+        auto target           = std::make_unique<Target>();
+        target->info          = info;
+        target->easy          = curl_easy_init();
+        target->json_headers  = nullptr;
+        target->in_flight     = false;
+        target->attempt       = 0;
+        target->stats         = Stats{};
+        target->stats.url     = info.url_;
+        target->total_latency = Clock::duration::zero();
+        if (!target->easy)
+            throw std::runtime_error("Cannot initialize curl_easy.");
+
+        CURL *curl = target->easy;
+        curl_easy_setopt(curl, CURLOPT_URL, info.url_.c_str());
+        if (!info.CA_info_file_.empty())
+            curl_easy_setopt(curl, CURLOPT_CAINFO, info.CA_info_file_.c_str());
+        if (!info.verify_host_)
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        if (!info.verify_peer_)
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+
+        // timeouts
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS,
+                         static_cast<long>(info.connect_timeout_));
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS,
+                         static_cast<long>(info.request_timeout_));
+
+        // Card reads may be minutes apart: keep the idle connection alive.
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, nullptr);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &write_callback);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, target.get());
+
+        if (info.batch_size_ > 1)
+        {
+            target->json_headers =
+                curl_slist_append(nullptr, "Content-Type: application/json");
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, target->json_headers);
+        }
+        targets_.push_back(std::move(target));
+    }
+
+    thread_ = std::thread(&DeliveryEngine::run, this);
+}
+
+DeliveryEngine::~DeliveryEngine()
+{
+    stopping_ = true;
+    wakeup_.notify();
+    thread_.join();
+
+    for (auto &target : targets_)
+    {
+        size_t lost = target->queue.size() + target->batch.size();
+        if (lost)
+        {
+            WARN("WS-Notifier: " << lost << " event(s) for " << target->info.url_
+                                 << " were not delivered.");
+        }
+        if (target->in_flight)
+            curl_multi_remove_handle(multi_handle(multi_), target->easy);
+        curl_easy_cleanup(target->easy);
+        curl_slist_free_all(target->json_headers);
+    }
+    curl_multi_cleanup(multi_handle(multi_));
+}
+
+void DeliveryEngine::post(const CardEvent &event)
+{
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        auto now = Clock::now();
+        for (auto &target : targets_)
+        {
+            if (target->queue.size() >= target->info.max_queue_size_)
+            {
+                ++target->stats.dropped;
+                WARN("WS-Notifier: queue for " << target->info.url_
+                                               << " is full. Dropping event.");
+                continue;
+            }
+            target->queue.push_back(PendingEvent{event, now});
+            target->stats.max_queue_depth =
+                std::max(target->stats.max_queue_depth, target->queue.size());
+        }
+    }
+    wakeup_.notify();
+}
+
+std::vector<DeliveryEngine::Stats> DeliveryEngine::stats() const
+{
+    using namespace std::chrono;
+    std::lock_guard<std::mutex> lg(mutex_);
+    std::vector<Stats> result;
+
+    for (const auto &target : targets_)
+    {
+        Stats s           = target->stats;
+        s.queue_depth     = target->queue.size();
+        s.average_latency = microseconds(0);
+        if (s.delivered)
+        {
+            s.average_latency =
+                duration_cast<microseconds>(target->total_latency / s.delivered);
+        }
+        result.push_back(std::move(s));
+    }
+    return result;
+}
+
+void DeliveryEngine::run()
+{
+    curl_waitfd wakeup_fd;
+    wakeup_fd.fd      = wakeup_.fd();
+    wakeup_fd.events  = CURL_WAIT_POLLIN;
+    wakeup_fd.revents = 0;
+
+    while (!stopping_)
+    {
+        start_requests();
+
+        int running;
+        curl_multi_perform(multi_handle(multi_), &running);
+        complete_requests();
+
+        // Requests that completed immediately may let others start.
+        start_requests();
+
+        curl_multi_wait(multi_handle(multi_), &wakeup_fd, 1,
+                        static_cast<int>(next_timeout().count()), nullptr);
+        wakeup_.drain();
+    }
+}
+
+void DeliveryEngine::start_requests()
+{
+    auto now = Clock::now();
+    for (auto &target : targets_)
+    {
+        if (target->in_flight)
+            continue;
+
+        if (target->batch.empty())
+        {
+            std::lock_guard<std::mutex> lg(mutex_);
+            auto batch_size = std::max<size_t>(1, target->info.batch_size_);
+            while (!target->queue.empty() && target->batch.size() < batch_size)
+            {
+                target->batch.push_back(std::move(target->queue.front()));
+                target->queue.pop_front();
+            }
+            if (target->batch.empty())
+                continue;
+            target->attempt = 0;
+        }
+        else if (now < target->retry_at)
+            continue;
+
+        if (target->attempt == 0)
+        {
+            std::vector<CardEvent> events;
+            for (const auto &pending : target->batch)
+                events.push_back(pending.event);
+            target->body =
+                build_body(target->easy, events, target->info.batch_size_ > 1);
+        }
+
+        curl_easy_setopt(target->easy, CURLOPT_POSTFIELDS, target->body.c_str());
+        curl_easy_setopt(target->easy, CURLOPT_POSTFIELDSIZE,
+                         static_cast<long>(target->body.size()));
+        curl_multi_add_handle(multi_handle(multi_), target->easy);
+        target->in_flight = true;
+
+        std::lock_guard<std::mutex> lg(mutex_);
+        ++target->stats.requests;
+        if (target->attempt)
+            ++target->stats.retries;
+    }
+}
+
+void DeliveryEngine::complete_requests()
+{
+    CURLMsg *msg;
+    int remaining;
+    while ((msg = curl_multi_info_read(multi_handle(multi_), &remaining)))
+    {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+
+        CURL *easy     = msg->easy_handle;
+        CURLcode res   = msg->data.result;
+        Target *target = nullptr;
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, &target);
+        assert(target);
+        long http_code = 0;
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_multi_remove_handle(multi_handle(multi_), easy);
+        target->in_flight = false;
+
+        bool success   = res == CURLE_OK && http_code < 400;
+        bool retryable = res != CURLE_OK || http_code >= 500;
+        if (res != CURLE_OK)
+        {
+            WARN("WS-Notifier: request to " << target->info.url_ << " failed: "
+                                            << curl_easy_strerror(res));
+        }
+        else if (!success)
+        {
+            WARN("WS-Notifier: " << target->info.url_ << " replied with HTTP "
+                                 << http_code);
+        }
+
+        if (!success && retryable && target->attempt < target->info.max_retries_)
+        {
+            auto factor = 1 << std::min(target->attempt, 16u);
+            auto delay  = target->info.retry_delay_ * factor;
+            ++target->attempt;
+            target->retry_at = Clock::now() + std::min(delay, MAX_RETRY_DELAY);
+            continue;
+        }
+
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lg(mutex_);
+        for (const auto &pending : target->batch)
+        {
+            if (success)
+            {
+                auto latency = now - pending.posted_at;
+                ++target->stats.delivered;
+                target->total_latency += latency;
+                target->stats.max_latency =
+                    std::max(target->stats.max_latency,
+                             std::chrono::duration_cast<std::chrono::microseconds>(
+                                 latency));
+            }
+            else
+                ++target->stats.failed;
+        }
+        target->batch.clear();
+    }
+}
+
+std::chrono::milliseconds DeliveryEngine::next_timeout() const
+{
+    using namespace std::chrono;
+    // Upper bound, so that curl gets to run its own timers.
+    milliseconds timeout(1000);
+
+    long curl_timeout = -1;
+    curl_multi_timeout(multi_handle(multi_), &curl_timeout);
+    if (curl_timeout >= 0)
+        timeout = std::min(timeout, milliseconds(curl_timeout));
+
+    auto now = Clock::now();
+    for (const auto &target : targets_)
+    {
+        if (target->in_flight || target->batch.empty())
+            continue;
+        auto remaining = duration_cast<milliseconds>(target->retry_at - now);
+        timeout        = std::min(timeout, std::max(remaining, milliseconds(0)));
+    }
+    return timeout;
+}
@@ -0,0 +1,255 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "tools/EventFD.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Leosac
+{
+namespace Module
+{
+namespace WSNotifier
+{
+/**
+ * Some information for each webservice target.
+ */
+struct TargetInfo
+{
+    TargetInfo()
+        : connect_timeout_(7000)
+        , request_timeout_(7000)
+        , verify_host_(true)
+        , verify_peer_(true)
+        , max_queue_size_(1024)
+        , batch_size_(1)
+        , max_retries_(3)
+        , retry_delay_(500)
+    {
+    }
+
+    std::string url_;
+    int connect_timeout_;
+    int request_timeout_;
+    /**
+     * If SSL is enabled, do we perform certificate hostname validation ?
+     */
+    bool verify_host_;
+    /**
+     * If SSL is enabled, do we perform certificate validation ?
+     */
+    bool verify_peer_;
+    /**
+     * Path to a CA bundle file.
+     */
+    std::string CA_info_file_;
+
+    /**
+     * Maximum number of events waiting to be sent to the target.
+     * Events are dropped when the queue is full.
+     */
+    size_t max_queue_size_;
+
+    /**
+     * Maximum number of events per request. When greater than 1, requests
+     * carry a JSON array instead of form fields.
+     */
+    size_t batch_size_;
+
+    /**
+     * How many times a failed request is retried before its events
+     * are given up on.
+     */
+    unsigned max_retries_;
+
+    /**
+     * Delay before the first retry. It doubles after each failed attempt.
+     */
+    std::chrono::milliseconds retry_delay_;
+};
+
+/**
+ * A card read, as sent to the webservices.
+ */
+struct CardEvent
+{
+    std::string auth_source;
+    uint64_t card_id;
+    uint64_t card_id_raw;
+};
+
+/**
+ * Deliver CardEvent to webservice targets, from a background thread.
+ *
+ * All targets are driven by a single curl multi handle. Each target
+ * reuses the same easy handle for all its requests, so its connection
+ * (including the TLS session) is kept alive between card reads.
+ *
+ * Each target has its own bounded queue, and at most one request in
+ * flight: events are delivered in order, and a slow or unreachable
+ * target doesn't delay the other ones.
+ *
+ * Failed requests (transport error or HTTP 5xx) are retried with an
+ * exponential backoff.
+ */
+class DeliveryEngine
+{
+  public:
+    /**
+     * Activity counters of one target.
+     */
+    struct Stats
+    {
+        std::string url;
+
+        /**
+         * Number of events waiting to be sent, excluding the events
+         * of the request in flight.
+         */
+        size_t queue_depth;
+
+        /**
+         * Highest value of `queue_depth` ever observed.
+         */
+        size_t max_queue_depth;
+
+        /**
+         * Number of events successfully delivered.
+         */
+        uint64_t delivered;
+
+        /**
+         * Number of events given up on after the last retry.
+         */
+        uint64_t failed;
+
+        /**
+         * Number of events refused because the queue was full.
+         */
+        uint64_t dropped;
+
+        /**
+         * Number of HTTP requests issued, and how many of them were retries.
+         */
+        uint64_t requests;
+        uint64_t retries;
+
+        /**
+         * Average and maximum time between the moment an event is posted
+         * and its successful delivery.
+         */
+        std::chrono::microseconds average_latency;
+        std::chrono::microseconds max_latency;
+    };
+
+    /**
+     * Start the delivery thread.
+     *
+     * curl must have been globally initialized, and must outlive the engine.
+     */
+    explicit DeliveryEngine(const std::vector<TargetInfo> &targets);
+
+    /**
+     * Stop the delivery thread. Events that are still queued are lost.
+     */
+    ~DeliveryEngine();
+
+    DeliveryEngine(const DeliveryEngine &) = delete;
+    DeliveryEngine &operator=(const DeliveryEngine &) = delete;
+
+    /**
+     * Queue an event for all targets.
+     *
+     * This never blocks on the network.
+     *
+     * @note This method is thread-safe.
+     */
+    void post(const CardEvent &event);
+
+    /**
+     * Counters for each target, in the order the targets were given.
+     *
+     * @note This method is thread-safe.
+     */
+    std::vector<Stats> stats() const;
+
+    /**
+     * Upper bound of the delay between two attempts.
+     */
+    static constexpr std::chrono::milliseconds MAX_RETRY_DELAY{30000};
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingEvent
+    {
+        CardEvent event;
+        Clock::time_point posted_at;
+    };
+
+    struct Target;
+
+    void run();
+
+    /**
+     * Start a request for each idle target that has queued events.
+     */
+    void start_requests();
+
+    /**
+     * Process the requests that curl reports as done.
+     */
+    void complete_requests();
+
+    /**
+     * Time the thread may sleep before it has something to do, unless
+     * curl or post() wakes it up.
+     */
+    std::chrono::milliseconds next_timeout() const;
+
+    std::vector<std::unique_ptr<Target>> targets_;
+
+    void *multi_;
+
+    /**
+     * Wakes the delivery thread up when an event is posted, or when
+     * stopping.
+     */
+    Tools::EventFD wakeup_;
+
+    /**
+     * Protects the queues and the counters.
+     */
+    mutable std::mutex mutex_;
+
+    std::atomic<bool> stopping_;
+
+    std::thread thread_;
+};
+}
+}
+}
@@ -18,9 +18,11 @@
 */
 
 #include "WebServiceNotifier.hpp"
+#include "core/CoreUtils.hpp"
 #include "core/auth/Auth.hpp"
 #include "core/credentials/RFIDCard.hpp"
 #include <curl/curl.h>
+#include <json.hpp>
 
 using namespace Leosac;
 using namespace Leosac::Module;
@@ -37,10 +39,14 @@ WebServiceNotifier::WebServiceNotifier(zmqpp::context &ctx, zmqpp::socket *pipe,
 
     if (config_.get<bool>("module_config.want_ssl", true))
         flags |= CURL_GLOBAL_SSL;
-    if ((ret = curl_global_init(flags)) != 0)
     {
-        throw std::runtime_error("Failed to initialize curl: return code: " +
-                                 std::to_string(ret));
+        // curl_global_init() is not thread-safe.
+        std::lock_guard<std::mutex> guard(utils_->setup_mutex());
+        if ((ret = curl_global_init(flags)) != 0)
+        {
+            throw std::runtime_error("Failed to initialize curl: return code: " +
+                                     std::to_string(ret));
+        }
     }
     bus_sub_.connect("inproc://zmq-bus-pub");
     process_config();
@@ -49,6 +55,9 @@ WebServiceNotifier::WebServiceNotifier(zmqpp::context &ctx, zmqpp::socket *pipe,
 
 WebServiceNotifier::~WebServiceNotifier()
 {
+    // The engine uses curl: stop it first.
+    engine_ = nullptr;
+    std::lock_guard<std::mutex> guard(utils_->setup_mutex());
     curl_global_cleanup();
 }
 
@@ -93,6 +102,14 @@ void WebServiceNotifier::process_config()
         target.verify_host_     = itr.second.get<bool>("verify_host", true);
         target.verify_peer_     = itr.second.get<bool>("verify_peer", true);
         target.CA_info_file_    = itr.second.get<std::string>("ca_file", "");
+        target.max_queue_size_ =
+            itr.second.get<size_t>("max_queue_size", target.max_queue_size_);
+        target.batch_size_ =
+            itr.second.get<size_t>("batch_size", target.batch_size_);
+        target.max_retries_ =
+            itr.second.get<unsigned>("max_retries", target.max_retries_);
+        target.retry_delay_ = std::chrono::milliseconds(itr.second.get<int64_t>(
+            "retry_delay", target.retry_delay_.count()));
 
         INFO("WS-Notifier remote target: "
              << Colorize::green(target.url_)
@@ -100,9 +117,12 @@ void WebServiceNotifier::process_config()
              << ", request_timeout: " << Colorize::green(target.request_timeout_)
              << ", verify_host: " << Colorize::green(target.verify_host_)
              << ", verify_peer: " << Colorize::green(target.verify_peer_)
-             << ", ca_info: " << Colorize::green(target.CA_info_file_) << ")");
+             << ", ca_info: " << Colorize::green(target.CA_info_file_)
+             << ", batch_size: " << Colorize::green(target.batch_size_)
+             << ", max_retries: " << Colorize::green(target.max_retries_) << ")");
         targets_.push_back(std::move(target));
     }
+    engine_ = std::make_unique<DeliveryEngine>(targets_);
 }
 
 void WebServiceNotifier::send_card_info_to_remote(const std::string &auth_source,
@@ -113,61 +133,28 @@ void WebServiceNotifier::send_card_info_to_remote(const std::string &auth_source
     card.card_id(card_hex);
     card.nb_bits(nb_bits);
 
-    for (const auto &target : targets_)
-    {
-        auto curl = curl_easy_init();
-        if (curl)
-        {
-            if (!target.CA_info_file_.empty())
-                curl_easy_setopt(curl, CURLOPT_CAINFO, target.CA_info_file_.c_str());
-            if (!target.verify_host_)
-                curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-            if (!target.verify_peer_)
-                curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            send_to_target(curl, auth_source, card, target);
-            curl_easy_cleanup(curl);
-        }
-        else
-        {
-            ERROR("Cannot initialize curl_easy.");
-        }
-    }
+    engine_->post(CardEvent{auth_source, card.to_int(), card.to_raw_int()});
 }
 
-/**
- * We don't care about getting the resulting page from the webservice.
- *
- * We use this function as a callback for CURL.
- */
-static size_t write_callback(char * /*ptr*/, size_t size, size_t nmemb,
-                             void * /*userdata*/)
+bool WebServiceNotifier::handle_control_request(const std::string &request,
+                                                zmqpp::message &)
 {
-    return size * nmemb;
-}
-
-void WebServiceNotifier::send_to_target(
-    void *curl, const std::string &auth_source, const Cred::RFIDCard &card,
-    const WebServiceNotifier::TargetInfo &target) noexcept
-{
-    assert(curl);
-
-    std::string post_fields =
-        fmt::format("card_id={}&auth_source={}&card_id_raw={}", card.to_int(),
-                    auth_source, card.to_raw_int());
-
-    curl_easy_setopt(curl, CURLOPT_URL, target.url_.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_fields.c_str());
-
-    // timeouts
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, target.connect_timeout_);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, target.request_timeout_);
-
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, nullptr);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &write_callback);
+    if (request != "DELIVERY_STATS")
+        return false;
 
-    auto res = curl_easy_perform(curl);
-    if (res != CURLE_OK)
+    nlohmann::json stats = nlohmann::json::object();
+    for (const auto &s : engine_->stats())
     {
-        WARN("curl_easy_perform() failed: " << curl_easy_strerror(res));
+        stats[s.url] = {{"queue_depth", s.queue_depth},
+                        {"max_queue_depth", s.max_queue_depth},
+                        {"delivered", s.delivered},
+                        {"failed", s.failed},
+                        {"dropped", s.dropped},
+                        {"requests", s.requests},
+                        {"retries", s.retries},
+                        {"average_latency_us", s.average_latency.count()},
+                        {"max_latency_us", s.max_latency.count()}};
     }
+    control_.send(stats.dump());
+    return true;
 }
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "DeliveryEngine.hpp"
 #include "core/auth/AuthFwd.hpp"
 #include "modules/BaseModule.hpp"
 #include <core/credentials/RFIDCard.hpp>
@@ -37,6 +38,14 @@ class WebServiceNotifier : public BaseModule
 
     ~WebServiceNotifier();
 
+  protected:
+    /**
+     * Supports the `DELIVERY_STATS` request, that returns the
+     * DeliveryEngine counters of each target as JSON.
+     */
+    bool handle_control_request(const std::string &request,
+                                zmqpp::message &msg) override;
+
   private:
     /**
      * Process a message that was read on the bus.
@@ -49,45 +58,23 @@ class WebServiceNotifier : public BaseModule
     void process_config();
 
     /**
-     * Send an HTTP request to the remote webservice
-     * to let it know a card was read.
+     * Queue an HTTP request to the remote webservices
+     * to let them know a card was read.
      */
     void send_card_info_to_remote(const std::string &auth_source,
                                   const std::string &card, int nb_bits);
 
-
     /**
      * Read internal message bus.
      */
     zmqpp::socket bus_sub_;
 
-    /**
-     * Some information for each webservice target.
-     */
-    struct TargetInfo
-    {
-        std::string url_;
-        int connect_timeout_;
-        int request_timeout_;
-        /**
-         * If SSL is enabled, do we perform certificate hostname validation ?
-         */
-        bool verify_host_;
-        /**
-         * If SSL is enabled, do we perform certificate validation ?
-         */
-        bool verify_peer_;
-        /**
-         * Path to a CA bundle file.
-         */
-        std::string CA_info_file_;
-    };
-
     std::vector<TargetInfo> targets_;
 
-    void send_to_target(void *curl, const std::string &auth_source,
-                        const Cred::RFIDCard &card,
-                        const TargetInfo &target) noexcept;
+    /**
+     * Sends the requests, away from the module's thread.
+     */
+    std::unique_ptr<DeliveryEngine> engine_;
 };
 }
 }
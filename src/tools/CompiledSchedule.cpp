@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/CompiledSchedule.hpp"
+#include "tools/SingleTimeFrame.hpp"
+#include <ctime>
+
+using namespace Leosac::Tools;
+
+constexpr uint16_t CompiledSchedule::MINUTES_PER_DAY;
+constexpr uint16_t CompiledSchedule::MINUTES_PER_WEEK;
+
+CompiledSchedule::CompiledSchedule(const std::vector<SingleTimeFrame> &timeframes)
+{
+    for (const auto &tf : timeframes)
+        add_timeframe(tf);
+}
+
+void CompiledSchedule::add_timeframe(const SingleTimeFrame &tf)
+{
+    if (tf.day < 0 || tf.day > 6)
+        return;
+
+    // Both bounds are inclusive, at the minute granularity. This
+    // matches SingleTimeFrame::is_in_timeframe().
+    int start = tf.start_hour * 60 + tf.start_min;
+    int end   = tf.end_hour * 60 + tf.end_min;
+    if (start < 0)
+        start = 0;
+    if (end >= MINUTES_PER_DAY)
+        end = MINUTES_PER_DAY - 1;
+
+    const int day_offset = tf.day * MINUTES_PER_DAY;
+    for (int minute = start; minute <= end; ++minute)
+        minutes_.set(day_offset + minute);
+}
+
+bool CompiledSchedule::is_in_schedule(uint16_t minute_of_week) const
+{
+    if (minute_of_week >= MINUTES_PER_WEEK)
+        return false;
+    return minutes_.test(minute_of_week);
+}
+
+uint16_t
+CompiledSchedule::minute_of_week(const std::chrono::system_clock::time_point &tp)
+{
+    std::time_t time_temp = std::chrono::system_clock::to_time_t(tp);
+    std::tm time_out;
+    localtime_r(&time_temp, &time_out);
+
+    return time_out.tm_wday * MINUTES_PER_DAY + time_out.tm_hour * 60 +
+           time_out.tm_min;
+}
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "tools/ToolsFwd.hpp"
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Leosac
+{
+namespace Tools
+{
+/**
+ * A compiled, read-only, representation of a set of SingleTimeFrame.
+ *
+ * The week is split into minutes, and each minute is represented by
+ * one bit that is set if the minute belongs to at least one timeframe.
+ * Checking a time point then costs a single bit lookup, instead of one
+ * broken-down time conversion per timeframe.
+ *
+ * The minute of the week of a time point is computed by `minute_of_week()`.
+ * It can be computed once and reused to check many schedules.
+ */
+class CompiledSchedule
+{
+  public:
+    static constexpr uint16_t MINUTES_PER_DAY  = 24 * 60;
+    static constexpr uint16_t MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+
+    CompiledSchedule() = default;
+
+    explicit CompiledSchedule(const std::vector<SingleTimeFrame> &timeframes);
+
+    /**
+     * Add a timeframe to the compiled schedule.
+     *
+     * Timeframes with an invalid day are ignored.
+     */
+    void add_timeframe(const SingleTimeFrame &tf);
+
+    /**
+     * Is the minute part of the schedule ?
+     *
+     * @param minute_of_week A value returned by `minute_of_week()`.
+     */
+    bool is_in_schedule(uint16_t minute_of_week) const;
+
+    /**
+     * Convert a time point to the minute of the week it belongs to, in
+     * local time.
+     *
+     * Minute 0 is sunday, 00:00, to match the `day` field of SingleTimeFrame.
+     */
+    static uint16_t minute_of_week(const std::chrono::system_clock::time_point &tp);
+
+  private:
+    std::bitset<MINUTES_PER_WEEK> minutes_;
+};
+}
+}
@@ -19,46 +19,205 @@
 
 #include "DatabaseLogSink.hpp"
 #include "GenGuid.h"
+#include "exception/leosacexception.hpp"
 #include "log.hpp"
 #include "tools/DateTimeConverter.hpp"
 #include "tools/LogEntry_odb.h"
 #include "tools/db/MultiplexedTransaction.hpp"
 #include "tools/db/database.hpp"
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
 
 using namespace Leosac;
 using namespace Leosac::Tools;
 
-DatabaseLogSink::DatabaseLogSink(DBPtr database)
+constexpr std::chrono::milliseconds DatabaseLogSink::DEFAULT_FLUSH_INTERVAL;
+constexpr size_t DatabaseLogSink::DEFAULT_BUFFER_SIZE;
+
+/**
+ * Is the current thread the writer thread of a DatabaseLogSink ?
+ */
+static thread_local bool is_writer_thread = false;
+
+DatabaseLogSink::DatabaseLogSink(DBPtr database,
+                                 std::chrono::milliseconds flush_interval,
+                                 size_t buffer_size, OverflowPolicy overflow)
     : database_(database)
+    , flush_interval_(flush_interval)
+    , overflow_(overflow)
+    , ring_(std::max<size_t>(buffer_size, 1))
+    , head_(0)
+    , size_(0)
+    , queued_seq_(0)
+    , written_seq_(0)
+    , flush_requested_(false)
+    , stopping_(false)
+    , dropped_(0)
 {
     std::cout << "ENABLING SQL DATABASE LOGGER." << std::endl;
     ASSERT_LOG(database_, "No database object.");
     // Generate a "run id"
     run_id_ = Leosac::gen_uuid();
+    writer_ = std::thread(&DatabaseLogSink::writer_main, this);
+}
+
+DatabaseLogSink::~DatabaseLogSink()
+{
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        stopping_ = true;
+    }
+    entries_available_.notify_one();
+    slot_available_.notify_all();
+    writer_.join();
 }
 
 void DatabaseLogSink::log(const spdlog::details::log_msg &msg)
 {
-    LogEntry entry;
+    if (is_writer_thread)
+        return;
+
+    PendingEntry entry;
+    entry.level     = msg.level;
+    entry.msg       = msg.formatted.str();
+    entry.thread_id = msg.thread_id;
+    entry.timestamp = time_point_ptime(msg.time);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (is_full())
+    {
+        if (overflow_ == OverflowPolicy::DROP)
+        {
+            dropped_++;
+            return;
+        }
+        entries_available_.notify_one();
+        slot_available_.wait(lock, [this]() { return stopping_ || !is_full(); });
+        if (stopping_)
+        {
+            dropped_++;
+            return;
+        }
+    }
+
+    ring_[(head_ + size_) % ring_.size()] = std::move(entry);
+    size_++;
+    queued_seq_++;
+    // Don't wait for the flush interval if the buffer is filling up.
+    if (size_ == ring_.size() / 2 + 1)
+        entries_available_.notify_one();
+}
+
+void DatabaseLogSink::flush()
+{
+    if (is_writer_thread)
+        return;
 
-    entry.level_     = msg.level;
-    entry.msg_       = msg.formatted.str();
-    entry.thread_id_ = msg.thread_id;
-    entry.timestamp_ = time_point_ptime(msg.time);
-    entry.run_id_    = run_id_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto target      = queued_seq_;
+    flush_requested_ = true;
+    entries_available_.notify_one();
+    written_.wait(lock, [&]() { return stopping_ || written_seq_ >= target; });
+}
 
+size_t DatabaseLogSink::dropped_count() const
+{
+    std::lock_guard<std::mutex> lg(mutex_);
+    return dropped_;
+}
+
+DatabaseLogSink::OverflowPolicy
+DatabaseLogSink::overflow_policy_from_string(const std::string &str)
+{
+    auto lower = boost::algorithm::to_lower_copy(str);
+    if (lower == "drop")
+        return OverflowPolicy::DROP;
+    if (lower == "block")
+        return OverflowPolicy::BLOCK;
+    throw LEOSACException("Invalid log overflow policy: " + str +
+                          ". Expected `drop` or `block`.");
+}
+
+bool DatabaseLogSink::is_full() const
+{
+    return size_ == ring_.size();
+}
+
+void DatabaseLogSink::writer_main()
+{
+    is_writer_thread = true;
+    std::vector<PendingEntry> batch;
+    size_t last_dropped = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        entries_available_.wait_for(lock, flush_interval_, [this]() {
+            return stopping_ || flush_requested_ || size_ > ring_.size() / 2;
+        });
+
+        batch.clear();
+        batch.reserve(size_);
+        for (; size_; size_--)
+        {
+            batch.push_back(std::move(ring_[head_]));
+            head_ = (head_ + 1) % ring_.size();
+        }
+        auto batch_seq   = queued_seq_;
+        auto dropped     = dropped_;
+        bool stop        = stopping_;
+        flush_requested_ = false;
+        lock.unlock();
+        slot_available_.notify_all();
+
+        if (dropped != last_dropped)
+        {
+            std::cerr << "DatabaseLogSink buffer is full: dropped "
+                      << dropped - last_dropped << " log entries." << std::endl;
+            last_dropped = dropped;
+        }
+        bool written = batch.empty() || write_batch(batch);
+
+        lock.lock();
+        if (!written)
+        {
+            dropped_ += batch.size();
+            last_dropped += batch.size();
+        }
+        written_seq_ = batch_seq;
+        written_.notify_all();
+        // Entries queued before stopping_ was set have been written.
+        if (stop)
+            break;
+    }
+}
+
+bool DatabaseLogSink::write_batch(const std::vector<PendingEntry> &batch)
+{
     try
     {
         using namespace odb;
         using namespace odb::core;
         db::MultiplexedTransaction t(database_->begin());
 
-        database_->persist(entry);
+        for (const auto &pending : batch)
+        {
+            LogEntry entry;
+            entry.level_     = pending.level;
+            entry.msg_       = pending.msg;
+            entry.thread_id_ = pending.thread_id;
+            entry.timestamp_ = pending.timestamp;
+            entry.run_id_    = run_id_;
+            database_->persist(entry);
+        }
         t.commit();
+        LogEntry::record_persisted(batch.size());
+        return true;
     }
     catch (const odb::exception &e)
     {
         std::cerr << "DatabaseLogSink encountered odb::exception: " << e.what()
-                  << std::endl;
+                  << ". Lost " << batch.size() << " log entries." << std::endl;
+        return false;
     }
 }
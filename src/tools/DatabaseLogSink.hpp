@@ -20,7 +20,13 @@
 #pragma once
 
 #include "tools/db/db_fwd.hpp"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <spdlog/sinks/sink.h>
+#include <thread>
+#include <vector>
 
 namespace Leosac
 {
@@ -28,27 +34,126 @@ namespace Tools
 {
 /**
  * A custom sink that write LogEntry object
- * to a SQLite database.
+ * to a SQL database.
+ *
+ * Entries are not written by the thread that logs them: they are queued
+ * into a fixed size ring buffer, and a background thread writes them
+ * in batches, one transaction per batch.
+ *
+ * The buffer is flushed every `flush_interval`, or sooner when it is
+ * half full. When the buffer is full, new entries are either dropped
+ * (and counted), or the logging thread blocks until there is room again,
+ * depending on the overflow policy.
+ *
+ * @note Messages logged by the writer thread itself (eg SQL tracing of
+ * the inserts) are not stored, so that the sink doesn't feed on its own
+ * output.
  */
 class DatabaseLogSink : public spdlog::sinks::sink
 {
   public:
     /**
-     * Construct a SQLite backed log sink.
+     * What to do with a new entry when the buffer is full.
+     */
+    enum class OverflowPolicy
+    {
+        DROP,
+        BLOCK
+    };
+
+    static constexpr std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL{1000};
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 4096;
+
+    /**
+     * Construct a database backed log sink.
      * @param database A non null pointer to a ODB database object.
+     * @param flush_interval Maximum delay before a queued entry is written.
+     * @param buffer_size Maximum number of entries waiting to be written.
+     * @param overflow What to do when the buffer is full.
      */
-    DatabaseLogSink(DBPtr database);
+    DatabaseLogSink(
+        DBPtr database,
+        std::chrono::milliseconds flush_interval = DEFAULT_FLUSH_INTERVAL,
+        size_t buffer_size                       = DEFAULT_BUFFER_SIZE,
+        OverflowPolicy overflow                  = OverflowPolicy::DROP);
+
+    /**
+     * Write the pending entries, then stop the writer thread.
+     */
+    ~DatabaseLogSink();
 
     virtual void log(const spdlog::details::log_msg &msg) override;
 
-    virtual void flush() override
-    {
-        // Noop as writing to a SQL database is transactional.
-    }
+    /**
+     * Block until the entries logged before the call are written.
+     */
+    virtual void flush() override;
+
+    /**
+     * Number of entries dropped because the buffer was full, or because
+     * they could not be written to the database.
+     */
+    size_t dropped_count() const;
+
+    /**
+     * Parse an overflow policy: "drop" or "block".
+     *
+     * Throws on invalid input.
+     */
+    static OverflowPolicy overflow_policy_from_string(const std::string &str);
 
   private:
+    /**
+     * What we keep of a spdlog message until it is written.
+     */
+    struct PendingEntry
+    {
+        uint8_t level;
+        std::string msg;
+        size_t thread_id;
+        boost::posix_time::ptime timestamp;
+    };
+
+    void writer_main();
+
+    /**
+     * Persist the entries of `batch` in a single transaction.
+     *
+     * Returns false if the batch could not be written.
+     */
+    bool write_batch(const std::vector<PendingEntry> &batch);
+
+    bool is_full() const;
+
     DBPtr database_;
     std::string run_id_;
+    std::chrono::milliseconds flush_interval_;
+    OverflowPolicy overflow_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable entries_available_;
+    std::condition_variable slot_available_;
+    std::condition_variable written_;
+
+    /**
+     * Ring buffer of pending entries. `head_` is the oldest entry.
+     */
+    std::vector<PendingEntry> ring_;
+    size_t head_;
+    size_t size_;
+
+    /**
+     * Sequence number of the last queued entry, and of the last entry
+     * that went through the writer. Used to implement flush().
+     */
+    uint64_t queued_seq_;
+    uint64_t written_seq_;
+
+    bool flush_requested_;
+    bool stopping_;
+    size_t dropped_;
+
+    std::thread writer_;
 };
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/EventFD.hpp"
+#include "exception/leosacexception.hpp"
+#include "tools/unixsyscall.hpp"
+#include <cerrno>
+#include <cstdint>
+
+extern "C" {
+#include <sys/eventfd.h>
+#include <unistd.h>
+}
+
+using namespace Leosac::Tools;
+
+EventFD::EventFD()
+{
+    if ((fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+        throw LEOSACException(UnixSyscall::getErrorString("eventfd", errno));
+}
+
+EventFD::~EventFD()
+{
+    close(fd_);
+}
+
+void EventFD::notify() noexcept
+{
+    // Preserve errno: this may be called from a signal handler.
+    int saved_errno = errno;
+    uint64_t one    = 1;
+    // Only fails (EAGAIN) if the counter would overflow, in which case
+    // the descriptor is readable anyway.
+    ssize_t ret = write(fd_, &one, sizeof(one));
+    (void)ret;
+    errno = saved_errno;
+}
+
+void EventFD::drain() noexcept
+{
+    uint64_t count;
+    ssize_t ret = read(fd_, &count, sizeof(count));
+    (void)ret;
+}
+
+int EventFD::fd() const
+{
+    return fd_;
+}
@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+namespace Leosac
+{
+namespace Tools
+{
+/**
+ * A thin wrapper around a Linux `eventfd` used to wake up a thread
+ * that is blocked in `poll()`.
+ *
+ * The file descriptor is non-blocking and readable whenever `notify()`
+ * has been called since the last `drain()`.
+ */
+class EventFD
+{
+  public:
+    /**
+     * Create the eventfd.
+     *
+     * @throws LEOSACException if the syscall fails.
+     */
+    EventFD();
+
+    ~EventFD();
+
+    EventFD(const EventFD &) = delete;
+    EventFD &operator=(const EventFD &) = delete;
+
+    /**
+     * Make the file descriptor readable.
+     *
+     * @note This function is thread-safe and async-signal-safe.
+     */
+    void notify() noexcept;
+
+    /**
+     * Reset the file descriptor to its non-readable state.
+     */
+    void drain() noexcept;
+
+    /**
+     * The file descriptor to poll for readability.
+     */
+    int fd() const;
+
+  private:
+    int fd_;
+};
+}
+}
@@ -19,6 +19,7 @@
 
 #include "tools/ToolsFwd.hpp"
 #include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -59,6 +60,16 @@ class ISchedule : public std::enable_shared_from_this<ISchedule>
     virtual bool
     is_in_schedule(const std::chrono::system_clock::time_point &tp) const = 0;
 
+    /**
+    * Check whether or not the given minute of the week is part of the schedule.
+    *
+    * This is cheaper than checking a time point when multiple schedules
+    * have to be checked against the same time point.
+    *
+    * @see CompiledSchedule::minute_of_week()
+    */
+    virtual bool is_in_schedule(uint16_t minute_of_week) const = 0;
+
     /**
     * Add the given timeframe to this schedule;
     */
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/LatencyHistogram.hpp"
+#include <algorithm>
+
+using namespace Leosac::Tools;
+
+constexpr size_t LatencyHistogram::NB_BOUNDS;
+constexpr size_t LatencyHistogram::NB_BUCKETS;
+constexpr std::array<int64_t, LatencyHistogram::NB_BOUNDS>
+    LatencyHistogram::BUCKET_BOUNDS;
+
+LatencyHistogram::LatencyHistogram()
+    : count_(0)
+    , total_(0)
+    , max_(0)
+{
+    buckets_.fill(0);
+}
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration latency)
+{
+    using namespace std::chrono;
+    int64_t latency_ms = duration_cast<milliseconds>(latency).count();
+    auto bound =
+        std::upper_bound(BUCKET_BOUNDS.begin(), BUCKET_BOUNDS.end(), latency_ms);
+    buckets_[bound - BUCKET_BOUNDS.begin()]++;
+
+    count_++;
+    total_ += latency;
+    max_ = std::max(max_, latency);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return count_;
+}
+
+std::chrono::microseconds LatencyHistogram::max() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(max_);
+}
+
+std::chrono::microseconds LatencyHistogram::average() const
+{
+    if (!count_)
+        return std::chrono::microseconds(0);
+    return std::chrono::duration_cast<std::chrono::microseconds>(total_ / count_);
+}
+
+const std::array<uint64_t, LatencyHistogram::NB_BUCKETS> &
+LatencyHistogram::buckets() const
+{
+    return buckets_;
+}
+
+nlohmann::json LatencyHistogram::to_json() const
+{
+    return {{"count", count_},
+            {"average_us", average().count()},
+            {"max_us", max().count()},
+            {"bounds_ms", BUCKET_BOUNDS},
+            {"buckets", buckets_}};
+}
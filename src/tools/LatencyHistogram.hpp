@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <json.hpp>
+
+namespace Leosac
+{
+namespace Tools
+{
+/**
+ * A latency histogram with fixed, roughly logarithmic, buckets.
+ *
+ * Bucket `i` counts the samples lower than `BUCKET_BOUNDS[i]` milliseconds
+ * (and not lower than the previous bound). The last bucket counts
+ * everything else.
+ *
+ * @note This class is not thread-safe.
+ */
+class LatencyHistogram
+{
+  public:
+    static constexpr size_t NB_BOUNDS  = 12;
+    static constexpr size_t NB_BUCKETS = NB_BOUNDS + 1;
+    static constexpr std::array<int64_t, NB_BOUNDS> BUCKET_BOUNDS{
+        {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000}};
+
+    LatencyHistogram();
+
+    void record(std::chrono::steady_clock::duration latency);
+
+    uint64_t count() const;
+
+    std::chrono::microseconds max() const;
+
+    std::chrono::microseconds average() const;
+
+    const std::array<uint64_t, NB_BUCKETS> &buckets() const;
+
+    /**
+     * Serialize the histogram.
+     *
+     * The object contains `count`, `average_us`, `max_us`, `bounds_ms` and
+     * `buckets`.
+     */
+    nlohmann::json to_json() const;
+
+  private:
+    std::array<uint64_t, NB_BUCKETS> buckets_;
+    uint64_t count_;
+    std::chrono::steady_clock::duration total_;
+    std::chrono::steady_clock::duration max_;
+};
+}
+}
@@ -22,7 +22,10 @@
 #include "tools/LogEntry_odb.h"
 #include "tools/LogEntry_odb_pgsql.h"
 #include "tools/LogEntry_odb_sqlite.h"
+#include "tools/db/ApproximateRowCount.hpp"
 #include "tools/db/database.hpp"
+#include "tools/log.hpp"
+#include <algorithm>
 #include <odb/pgsql/database.hxx>
 #include <odb/sqlite/database.hxx>
 
@@ -33,29 +36,56 @@ LogEntry::LogEntry()
     : version_(0)
 {
 }
-using Query  = odb::query<Tools::LogEntry>;
 using Result = odb::result<Tools::LogEntry>;
 
-static Result fetch_sqlite(DBPtr database, const std::string &order_by,
-                           int page_size, int offset)
+static db::ApproximateRowCount &log_row_count()
 {
-    using SQLiteQuery = odb::sqlite::query<Tools::LogEntry>;
-    auto sl_db        = std::static_pointer_cast<odb::sqlite::database>(database);
-    odb::sqlite::query<Tools::LogEntry> sl_q("ORDER BY" + Query::id + order_by +
-                                             "LIMIT" + SQLiteQuery::_val(page_size) +
-                                             "OFFSET" + SQLiteQuery::_val(offset));
-    return sl_db->query<Tools::LogEntry>(sl_q);
+    static db::ApproximateRowCount count;
+    return count;
 }
 
-static Result fetch_pgsql(DBPtr database, const std::string &order_by, int page_size,
-                          int offset)
+/**
+ * Build the database specific part of a page query.
+ *
+ * With a `cursor`, the `page_size` entries closest to the cursor are
+ * selected, in the direction given by `order_by`, and `offset` is ignored.
+ */
+template <typename NativeQuery>
+static NativeQuery page_query(unsigned long cursor, const std::string &order_by,
+                              int page_size, int offset)
 {
-    using PGSQLQuery = odb::pgsql::query<Tools::LogEntry>;
-    auto pg_db       = std::static_pointer_cast<odb::pgsql::database>(database);
-    odb::pgsql::query<Tools::LogEntry> pg_q("ORDER BY" + Query::id + order_by +
-                                            "LIMIT" + PGSQLQuery::_val(page_size) +
-                                            "OFFSET" + PGSQLQuery::_val(offset));
-    return pg_db->query<Tools::LogEntry>(pg_q);
+    NativeQuery q;
+    if (cursor && order_by == "ASC")
+        q = NativeQuery::id > cursor;
+    else if (cursor)
+        q = NativeQuery::id < cursor;
+
+    q += "ORDER BY" + NativeQuery::id + order_by + "LIMIT" +
+         NativeQuery::_val(page_size);
+    if (!cursor)
+        q += "OFFSET" + NativeQuery::_val(offset);
+    return q;
+}
+
+static Result fetch(DBPtr database, unsigned long cursor,
+                    const std::string &order_by, int page_size, int offset)
+{
+    // LIMIT needs to be database specific.
+    if (database->id() == odb::database_id::id_sqlite)
+    {
+        using SQLiteQuery = odb::sqlite::query<Tools::LogEntry>;
+        auto sl_db = std::static_pointer_cast<odb::sqlite::database>(database);
+        return sl_db->query<Tools::LogEntry>(
+            page_query<SQLiteQuery>(cursor, order_by, page_size, offset));
+    }
+    else if (database->id() == odb::database_id::id_pgsql)
+    {
+        using PGSQLQuery = odb::pgsql::query<Tools::LogEntry>;
+        auto pg_db       = std::static_pointer_cast<odb::pgsql::database>(database);
+        return pg_db->query<Tools::LogEntry>(
+            page_query<PGSQLQuery>(cursor, order_by, page_size, offset));
+    }
+    return Result();
 }
 
 LogEntry::QueryResult LogEntry::retrieve(DBPtr database, int page_number,
@@ -69,17 +99,8 @@ LogEntry::QueryResult LogEntry::retrieve(DBPtr database, int page_number,
 
         int offset           = page_number * page_size;
         std::string order_by = order_asc ? "ASC" : "DESC";
-        Result res;
+        Result res           = fetch(database, 0, order_by, page_size, offset);
 
-        // LIMIT needs to be database specific.
-        if (database->id() == odb::database_id::id_sqlite)
-        {
-            res = fetch_sqlite(database, order_by, page_size, offset);
-        }
-        else if (database->id() == odb::database_id::id_pgsql)
-        {
-            res = fetch_pgsql(database, order_by, page_size, offset);
-        }
         Tools::LogView view(database->query_value<Tools::LogView>());
         for (Tools::LogEntry &entry : res)
         {
@@ -93,3 +114,45 @@ LogEntry::QueryResult LogEntry::retrieve(DBPtr database, int page_number,
     }
     return {};
 }
+
+std::vector<LogEntry> LogEntry::retrieve_keyset(DBPtr database,
+                                                unsigned long before_id,
+                                                unsigned long after_id,
+                                                int page_size, bool order_asc)
+{
+    std::vector<LogEntry> entries;
+    ASSERT_LOG(!before_id || !after_id, "Both before_id and after_id are set.");
+
+    if (database)
+    {
+        odb::transaction t(database->begin());
+
+        // Fetch the entries closest to the cursor first.
+        auto cursor = before_id ? before_id : after_id;
+        Result res  = fetch(database, cursor, before_id ? "DESC" : "ASC",
+                           page_size, 0);
+        for (Tools::LogEntry &entry : res)
+        {
+            entries.push_back(entry);
+        }
+        // Then present them in the requested order.
+        if (order_asc == static_cast<bool>(before_id))
+            std::reverse(entries.begin(), entries.end());
+    }
+    return entries;
+}
+
+size_t LogEntry::approximate_count(DBPtr database)
+{
+    return log_row_count().get([&]() -> size_t {
+        if (!database)
+            return 0;
+        odb::transaction t(database->begin());
+        return database->query_value<Tools::LogView>().count;
+    });
+}
+
+void LogEntry::record_persisted(size_t nb_entries)
+{
+    log_row_count().add(nb_entries);
+}
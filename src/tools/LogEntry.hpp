@@ -81,6 +81,33 @@ class LogEntry
     static QueryResult retrieve(DBPtr database, int page_number, int page_size,
                                 bool order_asc);
 
+    /**
+     * Retrieve the `page_size` entries that precede `before_id`, or that
+     * follow `after_id` (exactly one of them must be non-zero).
+     *
+     * Unlike `retrieve()`, the cost doesn't depend on the position of the
+     * page, and no `count()` is performed.
+     *
+     * Entries are sorted according to `order_asc`.
+     */
+    static std::vector<LogEntry> retrieve_keyset(DBPtr database,
+                                                 unsigned long before_id,
+                                                 unsigned long after_id,
+                                                 int page_size, bool order_asc);
+
+    /**
+     * Approximate number of log entries in the database.
+     *
+     * It is seeded with a `count()` the first time it is needed, and
+     * is then updated through `record_persisted()`.
+     */
+    static size_t approximate_count(DBPtr database);
+
+    /**
+     * Must be called after `nb_entries` entries have been persisted.
+     */
+    static void record_persisted(size_t nb_entries);
+
   private:
     friend class odb::access;
 
@@ -21,6 +21,7 @@
 #include "AssertCast.hpp"
 #include "exception/ModelException.hpp"
 #include "tools/log.hpp"
+#include <atomic>
 
 using namespace Leosac::Tools;
 
@@ -32,17 +33,18 @@ Schedule::Schedule(const std::string &sched_name)
 
 bool Schedule::is_in_schedule(const std::chrono::system_clock::time_point &tp) const
 {
-    for (const auto &tf : timeframes_)
-    {
-        if (tf.is_in_timeframe(tp))
-            return true;
-    }
-    return false;
+    return is_in_schedule(CompiledSchedule::minute_of_week(tp));
+}
+
+bool Schedule::is_in_schedule(uint16_t minute_of_week) const
+{
+    return compiled()->is_in_schedule(minute_of_week);
 }
 
 void Schedule::add_timeframe(const SingleTimeFrame &tf)
 {
     timeframes_.push_back(tf);
+    invalidate_compiled();
 }
 
 const std::string &Schedule::name() const
@@ -84,6 +86,7 @@ void Schedule::description(const std::string &desc)
 void Schedule::clear_timeframes()
 {
     timeframes_.clear();
+    invalidate_compiled();
 }
 
 void Schedule::add_mapping(const ScheduleMappingPtr &map)
@@ -103,6 +106,30 @@ std::vector<ScheduleMappingPtr> Schedule::mapping() const
     return mapping_;
 }
 
+void Schedule::odb_callback(odb::callback_event e, odb::database &) const
+{
+    if (e == odb::callback_event::post_load)
+        invalidate_compiled();
+}
+
+std::shared_ptr<const CompiledSchedule> Schedule::compiled() const
+{
+    auto compiled = std::atomic_load(&compiled_);
+    if (!compiled)
+    {
+        // Concurrent callers may both compile the schedule. This is harmless
+        // as they would build the same thing.
+        compiled = std::make_shared<const CompiledSchedule>(timeframes_);
+        std::atomic_store(&compiled_, compiled);
+    }
+    return compiled;
+}
+
+void Schedule::invalidate_compiled() const
+{
+    std::atomic_store(&compiled_, std::shared_ptr<const CompiledSchedule>());
+}
+
 void ScheduleValidator::validate(const ISchedule &sched)
 {
     validate_name(sched.name());
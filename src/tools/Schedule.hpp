@@ -20,12 +20,14 @@
 #pragma once
 
 #include "LeosacFwd.hpp"
+#include "tools/CompiledSchedule.hpp"
 #include "tools/ISchedule.hpp"
 #include "tools/ScheduleMapping.hpp"
 #include "tools/SingleTimeFrame.hpp"
 #include "tools/ToolsFwd.hpp"
 #include "tools/db/database.hpp"
 #include <chrono>
+#include <odb/callback.hxx>
 #include <string>
 #include <vector>
 
@@ -36,8 +38,11 @@ namespace Tools
 /**
 * A schedule is simply a list of time frame (SingleTimeFrame) with
 * a name.
+*
+* The timeframes are compiled into a CompiledSchedule the first time
+* the schedule is checked, and recompiled when they change.
 */
-#pragma db object optimistic
+#pragma db object optimistic callback(odb_callback)
 class Schedule : public virtual ISchedule
 {
   public:
@@ -50,6 +55,8 @@ class Schedule : public virtual ISchedule
     bool
     is_in_schedule(const std::chrono::system_clock::time_point &tp) const override;
 
+    bool is_in_schedule(uint16_t minute_of_week) const override;
+
     void add_timeframe(const SingleTimeFrame &tf) override;
 
     const std::string &description() const override;
@@ -72,7 +79,24 @@ class Schedule : public virtual ISchedule
 
     size_t odb_version() const override;
 
+    /**
+     * ODB callback: invalidate the compiled schedule when the timeframes
+     * are (re)loaded from the database.
+     */
+    void odb_callback(odb::callback_event e, odb::database &) const;
+
   private:
+    /**
+     * Returns the compiled version of the timeframes, compiling them
+     * if needed.
+     */
+    std::shared_ptr<const CompiledSchedule> compiled() const;
+
+    /**
+     * Drop the compiled schedule. It will be rebuilt on next use.
+     */
+    void invalidate_compiled() const;
+
     friend class odb::access;
     friend class ::Leosac::TestAccess;
 
@@ -92,6 +116,13 @@ class Schedule : public virtual ISchedule
 
 #pragma db version
     size_t odb_version_;
+
+    /**
+     * Lazily built from `timeframes_`. Accessed atomically because
+     * schedules are shared between threads.
+     */
+#pragma db transient
+    mutable std::shared_ptr<const CompiledSchedule> compiled_;
 };
 
 class ScheduleValidator
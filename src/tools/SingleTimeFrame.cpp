@@ -18,6 +18,7 @@
 */
 
 #include "tools/SingleTimeFrame.hpp"
+#include <ctime>
 #include <tuple>
 
 namespace Leosac
@@ -46,8 +47,9 @@ SingleTimeFrame::SingleTimeFrame()
 bool SingleTimeFrame::is_in_timeframe(
     const std::chrono::system_clock::time_point &tp) const
 {
-    std::time_t time_temp   = std::chrono::system_clock::to_time_t(tp);
-    std::tm const *time_out = std::localtime(&time_temp);
+    std::time_t time_temp = std::chrono::system_clock::to_time_t(tp);
+    std::tm time_buf;
+    std::tm const *time_out = localtime_r(&time_temp, &time_buf);
 
     if (this->day != time_out->tm_wday)
         return false;
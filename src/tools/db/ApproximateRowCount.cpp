@@ -0,0 +1,58 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/db/ApproximateRowCount.hpp"
+#include <algorithm>
+
+using namespace Leosac;
+using namespace Leosac::db;
+
+ApproximateRowCount::ApproximateRowCount()
+    : seeded_(false)
+    , base_(0)
+    , delta_(0)
+{
+}
+
+size_t ApproximateRowCount::get(const SeedFunction &seed)
+{
+    if (!seeded_)
+    {
+        std::lock_guard<std::mutex> lg(seed_mutex_);
+        if (!seeded_)
+        {
+            // Changes recorded while the seed query runs may be counted
+            // twice. This is fine for an approximation.
+            auto delta = delta_.load();
+            base_      = static_cast<int64_t>(seed()) - delta;
+            seeded_    = true;
+        }
+    }
+    return static_cast<size_t>(std::max<int64_t>(base_ + delta_, 0));
+}
+
+void ApproximateRowCount::add(size_t n)
+{
+    delta_ += static_cast<int64_t>(n);
+}
+
+void ApproximateRowCount::remove(size_t n)
+{
+    delta_ -= static_cast<int64_t>(n);
+}
@@ -0,0 +1,80 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace Leosac
+{
+namespace db
+{
+/**
+ * An approximate row count for a table, maintained incrementally.
+ *
+ * The count is seeded once with an exact (and potentially expensive) count,
+ * then updated by the code that inserts or removes rows. Rows inserted by a
+ * rolled back transaction, or by another process, make it drift: it is
+ * meant for hints such as a total number of pages, not for logic.
+ *
+ * @note This class is thread-safe.
+ */
+class ApproximateRowCount
+{
+  public:
+    using SeedFunction = std::function<size_t()>;
+
+    ApproximateRowCount();
+
+    /**
+     * Retrieve the approximate count, calling `seed` to get an exact
+     * count the first time.
+     */
+    size_t get(const SeedFunction &seed);
+
+    /**
+     * Record that `n` rows were inserted.
+     */
+    void add(size_t n);
+
+    /**
+     * Record that `n` rows were removed.
+     */
+    void remove(size_t n);
+
+  private:
+    std::mutex seed_mutex_;
+    std::atomic<bool> seeded_;
+
+    /**
+     * Exact count at seeding time, minus the changes recorded before.
+     */
+    std::atomic<int64_t> base_;
+
+    /**
+     * Changes recorded since the object was created.
+     */
+    std::atomic<int64_t> delta_;
+};
+}
+}
@@ -53,7 +53,7 @@ size_t DBService::operation_count() const
     if (database_->tracer())
     {
         auto tracer = assert_cast<db::DatabaseTracer *>(database_->tracer());
-        return tracer->count();
+        return tracer->thread_count();
     }
     return 0;
 }
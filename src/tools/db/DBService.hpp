@@ -47,7 +47,8 @@ class DBService
     DBPtr db() const;
 
     /**
-     * Return the number of operation against the database.
+     * Return the number of operation against the database made by
+     * the calling thread.
      */
     size_t operation_count() const;
 
@@ -39,6 +39,12 @@ class DatabaseTracer : public odb::tracer
      * Return the number of statement that have been traced.
      */
     virtual size_t count() const = 0;
+
+    /**
+     * Return the number of statement that have been traced on the
+     * calling thread.
+     */
+    virtual size_t thread_count() const = 0;
 };
 }
 }
@@ -23,8 +23,14 @@
 using namespace Leosac;
 using namespace Leosac::db;
 
+/**
+ * Statements traced by the current thread.
+ */
+static thread_local size_t thread_statement_count = 0;
+
 PGSQLTracer::PGSQLTracer(bool count_only)
-    : count_only_(count_only)
+    : count_(0)
+    , count_only_(count_only)
 {
 }
 
@@ -33,9 +39,15 @@ void PGSQLTracer::execute(odb::connection &, const char *statement)
     if (!count_only_)
         DEBUG("SQL: " << statement);
     ++count_;
+    ++thread_statement_count;
 }
 
 size_t PGSQLTracer::count() const
 {
     return count_;
 }
+
+size_t PGSQLTracer::thread_count() const
+{
+    return thread_statement_count;
+}
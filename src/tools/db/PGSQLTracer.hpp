@@ -20,6 +20,7 @@
 #pragma once
 
 #include "DatabaseTracer.hpp"
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <odb/pgsql/tracer.hxx>
@@ -43,8 +44,13 @@ class PGSQLTracer : public DatabaseTracer
 
     virtual size_t count() const override;
 
+    virtual size_t thread_count() const override;
+
   private:
-    size_t count_;
+    /**
+     * The database is shared by multiple threads.
+     */
+    std::atomic<size_t> count_;
     bool count_only_;
 };
 }
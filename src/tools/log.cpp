@@ -31,24 +31,62 @@ namespace
  */
 std::string remove_ascii_format(const std::string &in)
 {
-    boost::regex regex;
-    regex.assign("\033\\[.+m(.*)\033\\[0m");
+    static const boost::regex regex("\033\\[.+m(.*)\033\\[0m");
     std::ostringstream t(std::ios::out | std::ios::binary);
     std::ostream_iterator<char, char> oi(t);
     boost::regex_replace(oi, in.begin(), in.end(), regex, "\\1",
                          boost::match_default | boost::format_sed);
     return t.str();
 }
+
+/**
+ * Loggers registered through LogHelper::set_loggers().
+ *
+ * Always accessed through std::atomic_load() / std::atomic_store().
+ */
+std::shared_ptr<spdlog::logger> cached_console;
+std::shared_ptr<spdlog::logger> cached_syslog;
 }
 
 namespace LogHelper
 {
+namespace detail
+{
+std::atomic<int> runtime_min_level{LogLevel::DEBUG};
+}
+
+void set_loggers(std::shared_ptr<spdlog::logger> console,
+                 std::shared_ptr<spdlog::logger> syslog)
+{
+    // Without logger, messages go to stderr: keep everything.
+    int min_level = LogLevel::DEBUG;
+    if (console || syslog)
+    {
+        min_level = LogLevel::CRIT;
+        for (const auto &logger : {console, syslog})
+        {
+            if (logger)
+                min_level = std::min<int>(min_level, logger->level());
+        }
+    }
+
+    std::atomic_store(&cached_console, console);
+    std::atomic_store(&cached_syslog, syslog);
+    detail::runtime_min_level.store(min_level, std::memory_order_relaxed);
+}
 
 void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
          const char * /*fileName*/, LogLevel level)
 {
-    auto console = spdlog::get("console");
-    auto syslog  = spdlog::get("syslog");
+    auto console = std::atomic_load(&cached_console);
+    auto syslog  = std::atomic_load(&cached_syslog);
+    if (!console && !syslog)
+    {
+        // Loggers may have been registered in spdlog without going
+        // through set_loggers().
+        console = spdlog::get("console");
+        syslog  = spdlog::get("syslog");
+    }
     if (!console && !syslog)
     {
         std::cerr << "Logger not set-up yet ! Will display log message as is."
@@ -62,37 +100,44 @@ void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
     ss << "[" << Leosac::gettid() << "] " << log_msg;
     std::string log_msg_with_thread_id = ss.str();
 
+    // Stripping the formatting is costly, only do it if syslog wants the message.
+    if (syslog && static_cast<int>(level) < syslog->level())
+        syslog = nullptr;
+    std::string syslog_msg;
+    if (syslog)
+        syslog_msg = remove_ascii_format(log_msg_with_thread_id);
+
     switch (level)
     {
     case LogLevel::DEBUG:
         if (console)
             console->debug(log_msg_with_thread_id);
         if (syslog)
-            syslog->debug(remove_ascii_format(log_msg_with_thread_id));
+            syslog->debug(syslog_msg);
         break;
     case LogLevel::INFO:
         if (console)
             console->info(log_msg_with_thread_id);
         if (syslog)
-            syslog->info(remove_ascii_format(log_msg_with_thread_id));
+            syslog->info(syslog_msg);
         break;
     case LogLevel::WARN:
         if (console)
             console->warn(log_msg_with_thread_id);
         if (syslog)
-            syslog->warn(remove_ascii_format(log_msg_with_thread_id));
+            syslog->warn(syslog_msg);
         break;
     case LogLevel::ERROR:
         if (console)
             console->error(log_msg_with_thread_id);
         if (syslog)
-            syslog->error(remove_ascii_format(log_msg_with_thread_id));
+            syslog->error(syslog_msg);
         break;
     case LogLevel::CRIT:
         if (console)
             console->critical(log_msg_with_thread_id);
         if (syslog)
-            syslog->critical(remove_ascii_format(log_msg_with_thread_id));
+            syslog->critical(syslog_msg);
         break;
     }
 }
@@ -19,9 +19,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <csignal>
 #include <iostream>
+#include <memory>
 #include <spdlog/spdlog.h>
 #include <sstream>
 #include <string>
@@ -35,10 +37,50 @@ enum LogLevel
     DEBUG = spdlog::level::debug,
 };
 
+/**
+ * Log statements below this level are compiled out.
+ *
+ * Set at configure time with `-DLEOSAC_MIN_LOG_LEVEL=INFO` (or `WARN`, ...).
+ */
+#ifndef LEOSAC_MIN_LOG_LEVEL
+#define LEOSAC_MIN_LOG_LEVEL DEBUG
+#endif
+
 namespace LogHelper
 {
+constexpr LogLevel COMPILE_TIME_MIN_LEVEL = LogLevel::LEOSAC_MIN_LOG_LEVEL;
+
+namespace detail
+{
+/**
+ * Lowest level accepted by at least one of the registered loggers.
+ */
+extern std::atomic<int> runtime_min_level;
+}
+
 LogLevel log_level_from_string(const std::string &level);
 
+/**
+ * Register the loggers used by the logging macros.
+ *
+ * The loggers are cached so that logging a message doesn't go through
+ * spdlog's registry. This must be called again whenever the loggers are
+ * replaced or their level changes.
+ */
+void set_loggers(std::shared_ptr<spdlog::logger> console,
+                 std::shared_ptr<spdlog::logger> syslog);
+
+/**
+ * Would a message of level `level` be written anywhere?
+ *
+ * The logging macros check this before formatting their message.
+ */
+inline bool is_enabled(LogLevel level)
+{
+    return level >= COMPILE_TIME_MIN_LEVEL &&
+           level >= detail::runtime_min_level.load(std::memory_order_relaxed);
+}
+
 void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
          const char * /*fileName*/, LogLevel level);
 };
@@ -67,20 +109,27 @@ void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
         return logger_macro_ss__.str();                                             \
     }()
 
+/**
+* Internal macro.
+* Format and log `msg`, but only if `level` is enabled: the message
+* parameters are not evaluated otherwise.
+*/
+#define LEOSAC_LOG(msg, level)                                                      \
+    (LogHelper::is_enabled(level)                                                   \
+         ? LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,  \
+                          level)                                                    \
+         : (void)0)
+
 
 /**
 * See "Internal macros documentation"
 */
-#define DEBUG_0(msg)                                                                \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::DEBUG)
+#define DEBUG_0(msg) LEOSAC_LOG(msg, LogLevel::DEBUG)
 
 /**
 * See "Internal macros documentation"
 */
-#define DEBUG_1(msg, loggers)                                                       \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::DEBUG, loggers)
+#define DEBUG_1(msg, loggers) LEOSAC_LOG(msg, LogLevel::DEBUG)
 
 /**
 * See "Internal macros documentation"
@@ -99,16 +148,12 @@ void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
 /**
 * See "Internal macros documentation"
 */
-#define INFO_0(msg)                                                                 \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::INFO)
+#define INFO_0(msg) LEOSAC_LOG(msg, LogLevel::INFO)
 
 /**
 * See "Internal macros documentation"
 */
-#define INFO_1(msg, loggers)                                                        \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::INFO, loggers)
+#define INFO_1(msg, loggers) LEOSAC_LOG(msg, LogLevel::INFO)
 
 /**
 * See "Internal macros documentation"
@@ -127,16 +172,12 @@ void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
 /**
 * See "Internal macros documentation"
 */
-#define WARN_0(msg)                                                                 \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::WARN)
+#define WARN_0(msg) LEOSAC_LOG(msg, LogLevel::WARN)
 
 /**
 * See "Internal macros documentation"
 */
-#define WARN_1(msg, loggers)                                                        \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::WARN)
+#define WARN_1(msg, loggers) LEOSAC_LOG(msg, LogLevel::WARN)
 
 /**
 * See "Internal macros documentation"
@@ -155,16 +196,12 @@ void log(const std::string &log_msg, int /*line*/, const char * /*funcName*/,
 /**
 * See "Internal macros documentation"
 */
-#define ERROR_0(msg)                                                                \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::ERROR)
+#define ERROR_0(msg) LEOSAC_LOG(msg, LogLevel::ERROR)
 
 /**
 * See "Internal macros documentation"
 */
-#define ERROR_1(msg, loggers)                                                       \
-    LogHelper::log(BUILD_STR(msg), __LINE__, FUNCTION_NAME_MACRO, __FILE__,         \
-                   LogLevel::ERROR)
+#define ERROR_1(msg, loggers) LEOSAC_LOG(msg, LogLevel::ERROR)
 
 /**
 * See "Internal macros documentation"
@@ -33,6 +33,8 @@ extern "C" {
 #include "exception/fsexception.hpp"
 #include "tools/log.hpp"
 #include "tools/unixsyscall.hpp"
+#include <boost/filesystem/path.hpp>
+#include <set>
 
 using namespace Leosac::Tools;
 
@@ -68,9 +70,13 @@ void UnixFileWatcher::stop()
     _isRunning = false;
     INFO("inotify stop");
     _thread.join();
-    for (auto watch : _watches)
+    // Files of a same directory share its watch descriptor.
+    std::set<UnixFd> wds;
+    for (const auto &watch : _watches)
+        wds.insert(watch.second->wd);
+    for (auto wd : wds)
     {
-        if (inotify_rm_watch(_inotifyFd, watch.first) == -1)
+        if (inotify_rm_watch(_inotifyFd, wd) == -1)
             throw(
                 FsException(UnixSyscall::getErrorString("inotify_rm_watch", errno)));
     }
@@ -79,38 +85,34 @@ void UnixFileWatcher::stop()
 
 void UnixFileWatcher::watchFile(const std::string &path)
 {
-    std::uint32_t mask = IN_CLOSE_WRITE;
-    WatchParams params;
+    // IN_MOVED_TO reports the file being replaced by a rename.
+    std::uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+    boost::filesystem::path file(path);
+    auto directory = file.parent_path();
+    if (directory.empty())
+        directory = ".";
     UnixFd watch;
 
-    if ((watch = inotify_add_watch(_inotifyFd, path.c_str(), mask)) == -1)
+    if ((watch = inotify_add_watch(_inotifyFd, directory.c_str(), mask)) == -1)
         throw(FsException(UnixSyscall::getErrorString("inotify_add_watch", errno)));
-    params.path     = path;
-    params.mask     = 0;
-    _watches[watch] = params;
+    auto params  = std::make_unique<WatchParams>();
+    params->wd   = watch;
+    params->name = file.filename().string();
+    params->mask = 0;
+    _watches[path] = std::move(params);
 }
 
-bool UnixFileWatcher::fileHasChanged(const std::string &path) const
+void UnixFileWatcher::setChangeCallback(std::function<void()> callback)
 {
-    for (auto &param : _watches)
-    {
-        if (param.second.path == path)
-            return ((param.second.mask & IN_CLOSE_WRITE) > 0);
-    }
-    throw(FsException("no registered watch for path:" + path));
+    _onChange = std::move(callback);
 }
 
-void UnixFileWatcher::fileReset(const std::string &path)
+bool UnixFileWatcher::consumeFileChange(const std::string &path)
 {
-    for (auto &param : _watches)
-    {
-        if (param.second.path == path)
-        {
-            param.second.mask = 0;
-            return;
-        }
-    }
-    throw(FsException("no registered watch for path:" + path));
+    auto watch = _watches.find(path);
+    if (watch == _watches.end())
+        throw(FsException("no registered watch for path:" + path));
+    return watch->second->mask.exchange(0) != 0;
 }
 
 std::size_t UnixFileWatcher::size() const
@@ -160,9 +162,18 @@ void UnixFileWatcher::run()
                 {
                     event = reinterpret_cast<inotify_event *>(
                         &buf[i]); // NOTE Alignment should not be an issue here
-                    _watches.at(event->wd).mask |= event->mask;
+                    // Events of the directory itself have no name.
+                    for (auto &watch : _watches)
+                    {
+                        auto &params = *watch.second;
+                        if (event->len && params.wd == event->wd &&
+                            params.name == event->name)
+                            params.mask |= event->mask;
+                    }
                     i += sizeof(inotify_event) + event->len;
                 }
+                if (_onChange)
+                    _onChange();
             }
         }
     }
@@ -27,7 +27,10 @@
 #define UNIXFILEWATCHER_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <thread>
 
@@ -36,15 +39,37 @@ namespace Leosac
 namespace Tools
 {
 
+/**
+ * Watch files for modifications, from a dedicated thread.
+ *
+ * The parent directory of each file is watched rather than the file
+ * itself, so that replacing the file (write to a temporary file, then
+ * rename it over the original) is reported like an in-place write.
+ *
+ * Files must be registered before start().
+ */
 class UnixFileWatcher
 {
     using UnixFd = int;
     struct WatchParams
     {
-        std::string path;
-        int mask;
+        /**
+         * Watch descriptor of the parent directory.
+         */
+        UnixFd wd;
+
+        /**
+         * Name of the file in that directory.
+         */
+        std::string name;
+
+        /**
+         * inotify events seen since the last call to consumeFileChange().
+         * Set by the watcher thread.
+         */
+        std::atomic<std::uint32_t> mask;
     };
-    using Watches = std::map<UnixFd, WatchParams>;
+    using Watches = std::map<std::string, std::unique_ptr<WatchParams>>;
 
     static const long DefaultTimeoutMs = 2000;
 
@@ -65,9 +90,19 @@ class UnixFileWatcher
   public:
     void watchFile(const std::string &path);
 
-    bool fileHasChanged(const std::string &path) const;
+    /**
+     * Set a callback invoked, from the watcher thread, each time a watched
+     * file changes. Must be called before start().
+     */
+    void setChangeCallback(std::function<void()> callback);
 
-    void fileReset(const std::string &path);
+    /**
+     * Returns true if the file was written to, or replaced, since the
+     * previous call.
+     *
+     * @note This method is thread-safe.
+     */
+    bool consumeFileChange(const std::string &path);
 
     std::size_t size() const;
 
@@ -79,6 +114,7 @@ class UnixFileWatcher
     std::atomic<bool> _isRunning;
     UnixFd _inotifyFd;
     Watches _watches;
+    std::function<void()> _onChange;
 };
 }
 }
@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/db/ApproximateRowCount.hpp"
+#include "gtest/gtest.h"
+
+using namespace Leosac;
+
+namespace Leosac
+{
+namespace Test
+{
+
+TEST(TestApproximateRowCount, seed_once)
+{
+    db::ApproximateRowCount count;
+    int nb_seed = 0;
+    auto seed   = [&]() {
+        ++nb_seed;
+        return size_t{42};
+    };
+
+    ASSERT_EQ(42u, count.get(seed));
+    ASSERT_EQ(42u, count.get(seed));
+    ASSERT_EQ(1, nb_seed);
+}
+
+TEST(TestApproximateRowCount, changes_after_seed)
+{
+    db::ApproximateRowCount count;
+    ASSERT_EQ(10u, count.get([]() { return size_t{10}; }));
+    count.add(5);
+    count.remove(2);
+    ASSERT_EQ(13u, count.get([]() { return size_t{0}; }));
+}
+
+TEST(TestApproximateRowCount, changes_before_seed)
+{
+    // The seed function counts rows that were already recorded.
+    db::ApproximateRowCount count;
+    count.add(3);
+    ASSERT_EQ(10u, count.get([]() { return size_t{10}; }));
+    count.add(1);
+    ASSERT_EQ(11u, count.get([]() { return size_t{0}; }));
+}
+}
+}
@@ -0,0 +1,475 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/audit/AuditFactory.hpp"
+#include "core/audit/ICredentialEvent.hpp"
+#include "core/audit/IGroupEvent.hpp"
+#include "core/audit/IScheduleEvent.hpp"
+#include "core/audit/IUserEvent.hpp"
+#include "core/audit/IUserGroupMembershipEvent.hpp"
+#include "core/audit/IWSAPICall.hpp"
+#include "core/auth/Door.hpp"
+#include "core/auth/Door_odb.h"
+#include "core/auth/Group.hpp"
+#include "core/auth/Group_odb.h"
+#include "core/auth/User.hpp"
+#include "core/auth/UserGroupMembership.hpp"
+#include "core/auth/UserGroupMembership_odb.h"
+#include "core/auth/User_odb.h"
+#include "core/credentials/Credential_odb.h"
+#include "core/credentials/PinCode.hpp"
+#include "core/credentials/PinCode_odb.h"
+#include "core/credentials/RFIDCard.hpp"
+#include "core/credentials/RFIDCard_odb.h"
+#include "core/credentials/RFIDCardPin.hpp"
+#include "helper/TestDatabase.hpp"
+#include "modules/auth/auth-db/AuthDBCache.hpp"
+#include "tools/Schedule.hpp"
+#include "tools/ScheduleMapping.hpp"
+#include "tools/ScheduleMapping_odb.h"
+#include "tools/Schedule_odb.h"
+#include "tools/SingleTimeFrame.hpp"
+#include "gtest/gtest.h"
+#include <ctime>
+
+using namespace Leosac;
+using namespace Leosac::Module::Auth;
+
+namespace Leosac
+{
+namespace Test
+{
+
+/**
+ * The database contains a door mapped, during office hours, to:
+ *     + alice, directly;
+ *     + the "staff" group, of which bob is a member;
+ *     + a card and a PIN code that have no owner.
+ *
+ * Eve is not mapped. She shares her PIN code with alice.
+ */
+class AuthDBCacheTest : public ::testing::Test
+{
+  public:
+    AuthDBCacheTest()
+        : cache_(db_.db())
+    {
+        // Monday 3rd November 2014, 10:00 local time.
+        std::tm date = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        date.tm_year  = 114;
+        date.tm_mon   = 10;
+        date.tm_mday  = 3;
+        date.tm_hour  = 10;
+        date.tm_isdst = -1;
+        office_hours_ = std::chrono::system_clock::from_time_t(std::mktime(&date));
+        evening_      = office_hours_ + std::chrono::hours(10);
+
+        auto db = db_.db();
+        odb::transaction t(db->begin());
+        alice_ = make_user("alice");
+        bob_   = make_user("bob");
+        eve_   = make_user("eve");
+
+        staff_ = std::make_shared<Auth::Group>();
+        staff_->name("staff");
+        staff_->member_add(bob_);
+        db->persist(staff_);
+
+        alice_card_   = make_card("00:00:00:01", alice_);
+        bob_card_     = make_card("00:00:00:02", bob_);
+        eve_card_     = make_card("00:00:00:03", eve_);
+        unowned_card_ = make_card("00:00:00:04", nullptr);
+        make_pin_code("1234", alice_);
+        make_pin_code("5678", bob_);
+        make_pin_code("1234", eve_);
+        unowned_pin_ = make_pin_code("0000", nullptr);
+
+        door_ = std::make_shared<Auth::Door>();
+        door_->alias("door");
+        db->persist(door_);
+        other_door_ = std::make_shared<Auth::Door>();
+        other_door_->alias("other door");
+        db->persist(other_door_);
+
+        auto mapping = std::make_shared<Tools::ScheduleMapping>();
+        mapping->alias("office");
+        mapping->add_user(alice_);
+        mapping->add_group(staff_);
+        mapping->add_credential(unowned_card_);
+        mapping->add_credential(unowned_pin_);
+        mapping->add_door(door_);
+        db->persist(mapping);
+
+        schedule_ = std::make_shared<Tools::Schedule>("office hours");
+        schedule_->add_timeframe(Tools::SingleTimeFrame(1, 8, 0, 18, 0));
+        schedule_->add_mapping(mapping);
+        db->persist(schedule_);
+        t.commit();
+    }
+
+    Auth::UserPtr make_user(const std::string &username)
+    {
+        auto user = std::make_shared<Auth::User>(username);
+        db_.db()->persist(user);
+        return user;
+    }
+
+    Cred::RFIDCardPtr make_card(const std::string &card_id, Auth::UserPtr owner)
+    {
+        auto card = std::make_shared<Cred::RFIDCard>(card_id, 32);
+        if (owner)
+            card->owner(owner);
+        db_.db()->persist(card);
+        return card;
+    }
+
+    Cred::PinCodePtr make_pin_code(const std::string &code, Auth::UserPtr owner)
+    {
+        auto pin = std::make_shared<Cred::PinCode>();
+        pin->pin_code(code);
+        if (owner)
+            pin->owner(owner);
+        db_.db()->persist(pin);
+        return pin;
+    }
+
+    /**
+     * A websocket request, the parent of the audit entries of its changes.
+     */
+    Audit::IAuditEntryPtr request()
+    {
+        return Audit::Factory::WSAPICall(db_.db());
+    }
+
+    Auth::ValidityInfo disabled() const
+    {
+        Auth::ValidityInfo validity;
+        validity.set_enabled(false);
+        return validity;
+    }
+
+    /**
+     * Give the credential event `id` the id `new_id`.
+     *
+     * This is what a transaction that commits late looks like: its entry
+     * shows up below entries that sync() already read.
+     */
+    void renumber_credential_event(Audit::AuditEntryId id,
+                                   Audit::AuditEntryId new_id)
+    {
+        auto from = std::to_string(id);
+        auto to   = std::to_string(new_id);
+        auto db   = db_.db();
+
+        odb::transaction t(db->begin());
+        db->execute("PRAGMA defer_foreign_keys = ON");
+        db->execute("UPDATE \"AuditEntry\" SET \"id\" = " + to +
+                    " WHERE \"id\" = " + from);
+        db->execute("UPDATE \"CredentialEvent\" SET \"id\" = " + to +
+                    " WHERE \"id\" = " + from);
+        db->execute("UPDATE \"AuditEntry_children\" SET \"value\" = " + to +
+                    " WHERE \"value\" = " + from);
+        t.commit();
+    }
+
+    AuthDBCache::Decision check_card(const std::string &card_id) const
+    {
+        return cache_.check(Cred::RFIDCard(card_id, 32), door_->id(), office_hours_);
+    }
+
+    AuthDBCache::Decision check_pin_code(const std::string &code) const
+    {
+        Cred::PinCode pin;
+        pin.pin_code(code);
+        return cache_.check(pin, door_->id(), office_hours_);
+    }
+
+    AuthDBCache::Decision check_card_and_pin_code(const std::string &card_id,
+                                                  const std::string &code) const
+    {
+        auto pin = std::make_shared<Cred::PinCode>();
+        pin->pin_code(code);
+        Cred::RFIDCardPin card_pin(std::make_shared<Cred::RFIDCard>(card_id, 32),
+                                   pin);
+        return cache_.check(card_pin, door_->id(), office_hours_);
+    }
+
+    Helper::TestDatabase db_;
+    AuthDBCache cache_;
+
+    std::chrono::system_clock::time_point office_hours_;
+    std::chrono::system_clock::time_point evening_;
+
+    Auth::UserPtr alice_;
+    Auth::UserPtr bob_;
+    Auth::UserPtr eve_;
+    Auth::GroupPtr staff_;
+    Cred::RFIDCardPtr alice_card_;
+    Cred::RFIDCardPtr bob_card_;
+    Cred::RFIDCardPtr eve_card_;
+    Cred::RFIDCardPtr unowned_card_;
+    Cred::PinCodePtr unowned_pin_;
+    Auth::DoorPtr door_;
+    Auth::DoorPtr other_door_;
+    Tools::SchedulePtr schedule_;
+};
+
+TEST_F(AuthDBCacheTest, empty_before_load)
+{
+    ASSERT_FALSE(check_card("00:00:00:01").granted);
+    ASSERT_FALSE(check_pin_code("1234").granted);
+}
+
+TEST_F(AuthDBCacheTest, card)
+{
+    cache_.load();
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+    ASSERT_TRUE(check_card("00:00:00:02").granted);
+    ASSERT_FALSE(check_card("00:00:00:03").granted);
+    ASSERT_TRUE(check_card("00:00:00:04").granted);
+    ASSERT_FALSE(check_card("00:00:00:05").granted);
+
+    auto decision = check_card("00:00:00:01");
+    ASSERT_EQ(alice_->id(), decision.user_id);
+    ASSERT_EQ("alice", decision.username);
+
+    ASSERT_FALSE(cache_.check(Cred::RFIDCard("00:00:00:01", 32), door_->id(),
+                              evening_)
+                     .granted);
+    ASSERT_FALSE(cache_.check(Cred::RFIDCard("00:00:00:01", 32),
+                              other_door_->id(), office_hours_)
+                     .granted);
+}
+
+TEST_F(AuthDBCacheTest, pin_code)
+{
+    cache_.load();
+    ASSERT_TRUE(check_pin_code("5678").granted);
+    ASSERT_EQ(bob_->id(), check_pin_code("5678").user_id);
+    ASSERT_TRUE(check_pin_code("0000").granted);
+    ASSERT_FALSE(check_pin_code("9999").granted);
+}
+
+TEST_F(AuthDBCacheTest, shared_pin_code)
+{
+    cache_.load();
+    // Alice is allowed through, eve is not.
+    ASSERT_TRUE(check_pin_code("1234").granted);
+    ASSERT_EQ(alice_->id(), check_pin_code("1234").user_id);
+
+    // Once alice is disabled, no owner of the PIN code is allowed through.
+    {
+        odb::transaction t(db_.db()->begin());
+        auto alice = db_.db()->load<Auth::User>(alice_->id());
+        alice->validity(disabled());
+        db_.db()->update(alice);
+        Audit::Factory::UserEvent(db_.db(), alice, request());
+        t.commit();
+    }
+    cache_.sync();
+    ASSERT_FALSE(check_pin_code("1234").granted);
+}
+
+TEST_F(AuthDBCacheTest, card_and_pin_code)
+{
+    cache_.load();
+    ASSERT_TRUE(check_card_and_pin_code("00:00:00:01", "1234").granted);
+    ASSERT_TRUE(check_card_and_pin_code("00:00:00:02", "5678").granted);
+
+    // The PIN code must belong to the owner of the card.
+    ASSERT_FALSE(check_card_and_pin_code("00:00:00:01", "5678").granted);
+    ASSERT_FALSE(check_card_and_pin_code("00:00:00:03", "1234").granted);
+    ASSERT_FALSE(check_card_and_pin_code("00:00:00:05", "1234").granted);
+}
+
+TEST_F(AuthDBCacheTest, unowned_card_and_pin_code)
+{
+    cache_.load();
+    ASSERT_TRUE(check_card("00:00:00:04").granted);
+    ASSERT_TRUE(check_pin_code("0000").granted);
+
+    // Two credentials without owner do not belong to the same person.
+    ASSERT_FALSE(check_card_and_pin_code("00:00:00:04", "0000").granted);
+}
+
+TEST_F(AuthDBCacheTest, removed_owner)
+{
+    cache_.load();
+    {
+        odb::transaction t(db_.db()->begin());
+        auto card = db_.db()->load<Cred::Credential>(alice_card_->id());
+        card->owner(Auth::UserLPtr());
+        db_.db()->update(card);
+        Audit::Factory::CredentialEventPtr(db_.db(), card, request());
+        t.commit();
+    }
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+
+    ASSERT_EQ(2u, cache_.sync());
+    ASSERT_FALSE(check_card("00:00:00:01").granted);
+    ASSERT_FALSE(check_card_and_pin_code("00:00:00:01", "1234").granted);
+    // The PIN code of alice is still hers.
+    ASSERT_TRUE(check_pin_code("1234").granted);
+}
+
+TEST_F(AuthDBCacheTest, sync_without_change)
+{
+    cache_.load();
+    ASSERT_EQ(0u, cache_.sync());
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+}
+
+TEST_F(AuthDBCacheTest, sync_user)
+{
+    cache_.load();
+    {
+        odb::transaction t(db_.db()->begin());
+        auto alice = db_.db()->load<Auth::User>(alice_->id());
+        alice->validity(disabled());
+        db_.db()->update(alice);
+        Audit::Factory::UserEvent(db_.db(), alice, request());
+        t.commit();
+    }
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+
+    ASSERT_EQ(2u, cache_.sync());
+    ASSERT_FALSE(check_card("00:00:00:01").granted);
+    ASSERT_FALSE(check_card_and_pin_code("00:00:00:01", "1234").granted);
+    ASSERT_TRUE(check_card("00:00:00:02").granted);
+}
+
+TEST_F(AuthDBCacheTest, sync_group)
+{
+    cache_.load();
+    {
+        odb::transaction t(db_.db()->begin());
+        auto staff = db_.db()->load<Auth::Group>(staff_->id());
+        auto bob   = db_.db()->load<Auth::User>(bob_->id());
+        for (const auto &membership : staff->user_memberships())
+            db_.db()->erase(membership);
+        Audit::Factory::UserGroupMembershipEvent(db_.db(), staff, bob, request());
+        t.commit();
+    }
+    ASSERT_TRUE(check_card("00:00:00:02").granted);
+    cache_.sync();
+    ASSERT_FALSE(check_card("00:00:00:02").granted);
+
+    {
+        odb::transaction t(db_.db()->begin());
+        auto staff = db_.db()->load<Auth::Group>(staff_->id());
+        staff->member_add(db_.db()->load<Auth::User>(eve_->id()));
+        db_.db()->update(staff);
+        Audit::Factory::GroupEvent(db_.db(), staff, request());
+        t.commit();
+    }
+    ASSERT_FALSE(check_card("00:00:00:03").granted);
+    cache_.sync();
+    ASSERT_TRUE(check_card("00:00:00:03").granted);
+    ASSERT_FALSE(check_card("00:00:00:02").granted);
+}
+
+TEST_F(AuthDBCacheTest, sync_credential)
+{
+    cache_.load();
+    {
+        odb::transaction t(db_.db()->begin());
+        auto card = db_.db()->load<Cred::Credential>(alice_card_->id());
+        card->validity(disabled());
+        db_.db()->update(card);
+        Audit::Factory::CredentialEventPtr(db_.db(), card, request());
+
+        auto new_card = make_card("00:00:00:05", bob_);
+        Audit::Factory::CredentialEventPtr(db_.db(), new_card, request());
+        t.commit();
+    }
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+    ASSERT_FALSE(check_card("00:00:00:05").granted);
+
+    cache_.sync();
+    ASSERT_FALSE(check_card("00:00:00:01").granted);
+    ASSERT_TRUE(check_card("00:00:00:05").granted);
+
+    {
+        odb::transaction t(db_.db()->begin());
+        auto card = db_.db()->load<Cred::Credential>(bob_card_->id());
+        Audit::Factory::CredentialEventPtr(db_.db(), card, request());
+        db_.db()->erase(card);
+        t.commit();
+    }
+    cache_.sync();
+    ASSERT_FALSE(check_card("00:00:00:02").granted);
+    ASSERT_TRUE(check_card("00:00:00:05").granted);
+}
+
+TEST_F(AuthDBCacheTest, sync_schedule)
+{
+    cache_.load();
+    {
+        odb::transaction t(db_.db()->begin());
+        auto schedule = db_.db()->load<Tools::Schedule>(schedule_->id());
+        schedule->clear_timeframes();
+        schedule->add_timeframe(Tools::SingleTimeFrame(1, 19, 0, 21, 0));
+        db_.db()->update(schedule);
+        Audit::Factory::ScheduleEvent(db_.db(), schedule, request());
+        t.commit();
+    }
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+
+    cache_.sync();
+    ASSERT_FALSE(check_card("00:00:00:01").granted);
+    ASSERT_TRUE(cache_.check(Cred::RFIDCard("00:00:00:01", 32), door_->id(),
+                             evening_)
+                    .granted);
+}
+
+TEST_F(AuthDBCacheTest, out_of_order_audit)
+{
+    cache_.load();
+    Audit::AuditEntryId first;
+    {
+        odb::transaction t(db_.db()->begin());
+        first =
+            Audit::Factory::CredentialEventPtr(db_.db(), bob_card_, request())->id();
+        t.commit();
+    }
+    // Leave room for entries whose transactions have not committed yet.
+    renumber_credential_event(first, first + 5);
+    ASSERT_EQ(2u, cache_.sync());
+
+    Audit::AuditEntryId late;
+    {
+        odb::transaction t(db_.db()->begin());
+        auto card = db_.db()->load<Cred::Credential>(alice_card_->id());
+        card->validity(disabled());
+        db_.db()->update(card);
+        late = Audit::Factory::CredentialEventPtr(db_.db(), card, request())->id();
+        t.commit();
+    }
+    renumber_credential_event(late, first + 2);
+    ASSERT_TRUE(check_card("00:00:00:01").granted);
+
+    // The late entry and its parent.
+    ASSERT_EQ(2u, cache_.sync());
+    ASSERT_FALSE(check_card("00:00:00:01").granted);
+
+    // It is applied only once.
+    ASSERT_EQ(0u, cache_.sync());
+}
+}
+}
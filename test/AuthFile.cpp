@@ -529,6 +529,102 @@ TEST_F(AuthFileMapperTest, TestReservedUserID)
         ModuleException);
     // Nested exception. The original type is a ConfigException.
 }
+
+/**
+ * Reloading an unchanged file does not produce a new mapper.
+ */
+TEST_F(AuthFileMapperTest, ReloadUnchanged)
+{
+    FileAuthSourceMapper mapper(gl_data_path + "AuthFile-1.xml");
+    ASSERT_FALSE(mapper.reload());
+}
+
+/**
+ * Changing a PIN code is applied incrementally: the new mapper only knows
+ * the new code, the previous mapper is left untouched.
+ */
+TEST_F(AuthFileMapperTest, IncrementalPinChange)
+{
+    FileAuthSourceMapper mapper(gl_data_path + "AuthFile-1.xml");
+    auto data = std::make_shared<AuthFileData>(
+        AuthFileData::from_xml(gl_data_path + "AuthFile-1.xml"));
+    data->credentials[2].pin = "4321";
+
+    auto updated = mapper.update(data);
+    ASSERT_TRUE(updated);
+
+    updated->mapToUser(my_pin_);
+    ASSERT_FALSE(my_pin_->owner().get());
+
+    auto new_pin = std::make_shared<Cred::PinCode>();
+    new_pin->pin_code("4321");
+    updated->mapToUser(new_pin);
+    ASSERT_TRUE(new_pin->owner().get());
+    ASSERT_EQ("my_user", new_pin->owner()->username());
+    auto profile = updated->buildProfile(new_pin);
+    ASSERT_TRUE(profile);
+    ASSERT_TRUE(profile->isAccessGranted(date_monday_12_00, doorA_));
+    ASSERT_FALSE(profile->isAccessGranted(date_wednesday_23_42, doorA_));
+
+    mapper.mapToUser(my_pin_);
+    ASSERT_TRUE(my_pin_->owner().get());
+}
+
+/**
+ * Disabling a user is applied incrementally, and its credentials
+ * point to the new user object.
+ */
+TEST_F(AuthFileMapperTest, IncrementalUserChange)
+{
+    FileAuthSourceMapper mapper(gl_data_path + "AuthFile-1.xml");
+    auto data = std::make_shared<AuthFileData>(
+        AuthFileData::from_xml(gl_data_path + "AuthFile-1.xml"));
+    ASSERT_EQ("Toto", data->users[1].name);
+    data->users[1].validity.enabled = false;
+
+    auto updated = mapper.update(data);
+    ASSERT_TRUE(updated);
+
+    updated->mapToUser(my_card2_);
+    ASSERT_TRUE(my_card2_->owner().get());
+    ASSERT_FALSE(my_card2_->owner()->is_valid());
+    ASSERT_FALSE(updated->buildProfile(my_card2_));
+
+    auto card = std::make_shared<Cred::RFIDCard>();
+    card->card_id("cc:dd:ee:ff");
+    card->nb_bits(32);
+    mapper.mapToUser(card);
+    ASSERT_TRUE(card->owner()->is_valid());
+    auto profile = mapper.buildProfile(card);
+    ASSERT_TRUE(profile);
+    ASSERT_TRUE(profile->isAccessGranted(date_sunday_18_50, doorA_));
+}
+
+/**
+ * A new user with its own card is known to the updated mapper.
+ */
+TEST_F(AuthFileMapperTest, IncrementalAddUser)
+{
+    FileAuthSourceMapper mapper(gl_data_path + "AuthFile-1.xml");
+    auto data = std::make_shared<AuthFileData>(
+        AuthFileData::from_xml(gl_data_path + "AuthFile-1.xml"));
+    AuthFileData::User user = data->users[1];
+    user.name               = "Bob";
+    data->users.push_back(user);
+    AuthFileData::Credential cred = data->credentials[0];
+    cred.owner                    = "Bob";
+    cred.card_id                  = "00:00:00:00";
+    data->credentials.push_back(cred);
+
+    auto updated = mapper.update(data);
+    ASSERT_TRUE(updated);
+
+    updated->mapToUser(unknown_card_);
+    ASSERT_TRUE(unknown_card_->owner().get());
+    ASSERT_EQ("bob", unknown_card_->owner()->username());
+    // Bob is not mapped to any schedule.
+    ASSERT_FALSE(updated->buildProfile(unknown_card_));
+}
 }
 }
 
@@ -0,0 +1,249 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "modules/auth/auth-file/AuthFileCache.hpp"
+#include "gtest/gtest.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/stat.h>
+}
+
+/**
+* Path to test-data file.
+* this come from command line (see CMakeLists.txt)
+*/
+static std::string gl_data_path;
+
+using namespace Leosac::Module::Auth;
+
+namespace Leosac
+{
+namespace Test
+{
+
+static void expect_equal(const AuthFileData &a, const AuthFileData &b)
+{
+    ASSERT_EQ(a.users.size(), b.users.size());
+    for (size_t i = 0; i < a.users.size(); ++i)
+    {
+        ASSERT_EQ(a.users[i].name, b.users[i].name);
+        ASSERT_EQ(a.users[i].email, b.users[i].email);
+        ASSERT_EQ(a.users[i].validity.enabled, b.users[i].validity.enabled);
+    }
+    ASSERT_EQ(a.groups.size(), b.groups.size());
+    for (size_t i = 0; i < a.groups.size(); ++i)
+    {
+        ASSERT_EQ(a.groups[i].name, b.groups[i].name);
+        ASSERT_EQ(a.groups[i].members, b.groups[i].members);
+    }
+    ASSERT_EQ(a.credentials.size(), b.credentials.size());
+    for (size_t i = 0; i < a.credentials.size(); ++i)
+    {
+        ASSERT_EQ(a.credentials[i].type, b.credentials[i].type);
+        ASSERT_EQ(a.credentials[i].owner, b.credentials[i].owner);
+        ASSERT_EQ(a.credentials[i].card_id, b.credentials[i].card_id);
+        ASSERT_EQ(a.credentials[i].bits, b.credentials[i].bits);
+        ASSERT_EQ(a.credentials[i].pin, b.credentials[i].pin);
+    }
+    ASSERT_EQ(a.schedules.size(), b.schedules.size());
+    for (size_t i = 0; i < a.schedules.size(); ++i)
+    {
+        ASSERT_EQ(a.schedules[i].name, b.schedules[i].name);
+        ASSERT_EQ(a.schedules[i].timeframes.size(),
+                  b.schedules[i].timeframes.size());
+        for (size_t j = 0; j < a.schedules[i].timeframes.size(); ++j)
+        {
+            const auto &ta = a.schedules[i].timeframes[j];
+            const auto &tb = b.schedules[i].timeframes[j];
+            ASSERT_EQ(ta.day, tb.day);
+            ASSERT_EQ(ta.start_hour, tb.start_hour);
+            ASSERT_EQ(ta.start_min, tb.start_min);
+            ASSERT_EQ(ta.end_hour, tb.end_hour);
+            ASSERT_EQ(ta.end_min, tb.end_min);
+        }
+    }
+    ASSERT_EQ(a.mappings.size(), b.mappings.size());
+    for (size_t i = 0; i < a.mappings.size(); ++i)
+    {
+        ASSERT_EQ(a.mappings[i].door, b.mappings[i].door);
+        ASSERT_EQ(a.mappings[i].schedules, b.mappings[i].schedules);
+        ASSERT_EQ(a.mappings[i].users, b.mappings[i].users);
+        ASSERT_EQ(a.mappings[i].groups, b.mappings[i].groups);
+        ASSERT_EQ(a.mappings[i].credentials, b.mappings[i].credentials);
+    }
+}
+
+class AuthFileCacheTest : public ::testing::Test
+{
+  public:
+    AuthFileCacheTest()
+    {
+        dir_ = (boost::filesystem::temp_directory_path() /
+                boost::filesystem::unique_path())
+                   .string();
+        boost::filesystem::create_directories(dir_);
+        source_ = dir_ + "/auth.xml";
+        cache_  = dir_ + "/auth.cache";
+        boost::filesystem::copy_file(gl_data_path + "AuthFile-1.xml", source_);
+    }
+
+    ~AuthFileCacheTest()
+    {
+        boost::filesystem::remove_all(dir_);
+    }
+
+  protected:
+    std::string read_file(const std::string &path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(ifs),
+                           std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * Overwrite `path` with `content` and set its modification time.
+     */
+    void write_file(const std::string &path, const std::string &content,
+                    const struct timespec &mtime)
+    {
+        {
+            std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+            ofs << content;
+        }
+        struct timespec times[2] = {mtime, mtime};
+        ASSERT_EQ(0, utimensat(AT_FDCWD, path.c_str(), times, 0));
+    }
+
+    struct timespec mtime_of(const std::string &path)
+    {
+        struct stat st;
+        stat(path.c_str(), &st);
+        return st.st_mtim;
+    }
+
+    std::string dir_;
+    std::string source_;
+    std::string cache_;
+};
+
+TEST_F(AuthFileCacheTest, round_trip)
+{
+    auto reference = AuthFileData::from_xml(source_);
+
+    ASSERT_FALSE(boost::filesystem::exists(cache_));
+    expect_equal(reference, AuthFileCache(cache_).load(source_));
+    ASSERT_TRUE(boost::filesystem::exists(cache_));
+
+    // Second time, the data come from the cache.
+    expect_equal(reference, AuthFileCache(cache_).load(source_));
+}
+
+TEST_F(AuthFileCacheTest, trusts_unchanged_size_and_mtime)
+{
+    AuthFileCache(cache_).load(source_);
+
+    // Rename a user without changing the file size nor its mtime:
+    // the cache cannot tell, which proves it is used.
+    auto content = read_file(source_);
+    auto mtime   = mtime_of(source_);
+    auto pos     = content.find("MY_USER");
+    ASSERT_NE(std::string::npos, pos);
+    content.replace(pos, 7, "XY_USER");
+    write_file(source_, content, mtime);
+
+    auto data = AuthFileCache(cache_).load(source_);
+    ASSERT_EQ("MY_USER", data.users[0].name);
+}
+
+TEST_F(AuthFileCacheTest, rebuilds_when_content_changes)
+{
+    AuthFileCache(cache_).load(source_);
+
+    auto content = read_file(source_);
+    auto mtime   = mtime_of(source_);
+    content.replace(content.find("MY_USER"), 7, "XY_USER");
+    mtime.tv_sec += 10;
+    write_file(source_, content, mtime);
+
+    auto data = AuthFileCache(cache_).load(source_);
+    ASSERT_EQ("XY_USER", data.users[0].name);
+    expect_equal(AuthFileData::from_xml(source_), data);
+
+    // The cache was rewritten with the new content.
+    expect_equal(data, AuthFileCache(cache_).load(source_));
+}
+
+TEST_F(AuthFileCacheTest, survives_touch)
+{
+    auto reference = AuthFileCache(cache_).load(source_);
+
+    auto mtime = mtime_of(source_);
+    mtime.tv_sec += 10;
+    write_file(source_, read_file(source_), mtime);
+
+    expect_equal(reference, AuthFileCache(cache_).load(source_));
+    expect_equal(reference, AuthFileCache(cache_).load(source_));
+}
+
+TEST_F(AuthFileCacheTest, ignores_corrupted_cache)
+{
+    auto reference = AuthFileCache(cache_).load(source_);
+    auto cache     = read_file(cache_);
+
+    // Truncated body.
+    {
+        std::ofstream ofs(cache_, std::ios::binary | std::ios::trunc);
+        ofs << cache.substr(0, cache.size() - 10);
+    }
+    expect_equal(reference, AuthFileCache(cache_).load(source_));
+    ASSERT_EQ(cache, read_file(cache_));
+
+    // Garbage.
+    {
+        std::ofstream ofs(cache_, std::ios::binary | std::ios::trunc);
+        ofs << "not a cache";
+    }
+    expect_equal(reference, AuthFileCache(cache_).load(source_));
+    ASSERT_EQ(cache, read_file(cache_));
+}
+
+TEST_F(AuthFileCacheTest, invalid_source_throws)
+{
+    using boost::filesystem::copy_option;
+    boost::filesystem::copy_file(gl_data_path + "AuthFile-2.xml", source_,
+                                 copy_option::overwrite_if_exists);
+    ASSERT_ANY_THROW(AuthFileCache(cache_).load(source_));
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    // gtest shall leave us with our arguments.
+    // argv[1] shall be the path to test data file
+    assert(argc == 2);
+    gl_data_path = std::string(argv[1]) + '/';
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "modules/auth/auth-file/AuthFileDiff.hpp"
+#include "gtest/gtest.h"
+
+/**
+* Path to test-data file.
+* this come from command line (see CMakeLists.txt)
+*/
+static std::string gl_data_path;
+
+using namespace Leosac::Module::Auth;
+
+namespace Leosac
+{
+namespace Test
+{
+
+/**
+ * Diff AuthFile-1.xml against an altered copy of itself.
+ */
+class AuthFileDiffTest : public ::testing::Test
+{
+  public:
+    AuthFileDiffTest()
+        : from_(AuthFileData::from_xml(gl_data_path + "AuthFile-1.xml"))
+        , to_(from_)
+    {
+    }
+
+    AuthFileData from_;
+    AuthFileData to_;
+};
+
+TEST_F(AuthFileDiffTest, Identical)
+{
+    AuthFileDiff diff(from_, to_);
+    ASSERT_TRUE(diff.empty());
+    ASSERT_TRUE(diff.incremental);
+}
+
+TEST_F(AuthFileDiffTest, ChangedPin)
+{
+    ASSERT_EQ(AuthFileData::Credential::Type::PIN_CODE, to_.credentials[2].type);
+    to_.credentials[2].pin = "4321";
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_FALSE(diff.empty());
+    ASSERT_TRUE(diff.incremental);
+    ASSERT_EQ(1, diff.removed_credentials.size());
+    ASSERT_EQ("1234", diff.removed_credentials[0]->pin);
+    ASSERT_EQ(1, diff.added_credentials.size());
+    ASSERT_EQ("4321", diff.added_credentials[0]->pin);
+    ASSERT_TRUE(diff.added_users.empty());
+    ASSERT_TRUE(diff.modified_users.empty());
+    ASSERT_TRUE(diff.removed_users.empty());
+}
+
+TEST_F(AuthFileDiffTest, ModifiedCredential)
+{
+    // Same lookup key, different validity: replaced.
+    to_.credentials[0].validity.enabled = !to_.credentials[0].validity.enabled;
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_TRUE(diff.incremental);
+    ASSERT_EQ(1, diff.removed_credentials.size());
+    ASSERT_EQ(&from_.credentials[0], diff.removed_credentials[0]);
+    ASSERT_EQ(1, diff.added_credentials.size());
+    ASSERT_EQ(&to_.credentials[0], diff.added_credentials[0]);
+}
+
+TEST_F(AuthFileDiffTest, ModifiedUser)
+{
+    to_.users[1].email = "toto@example.com";
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_TRUE(diff.incremental);
+    ASSERT_EQ(1, diff.modified_users.size());
+    ASSERT_EQ("Toto", diff.modified_users[0]->name);
+    ASSERT_TRUE(diff.added_credentials.empty());
+    ASSERT_TRUE(diff.removed_credentials.empty());
+}
+
+TEST_F(AuthFileDiffTest, AddedUser)
+{
+    AuthFileData::User user = to_.users[1];
+    user.name               = "Bob";
+    to_.users.push_back(user);
+
+    AuthFileData::Credential card = to_.credentials[0];
+    card.owner                    = "Bob";
+    card.card_id                  = "12:34:56:78";
+    to_.credentials.push_back(card);
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_TRUE(diff.incremental);
+    ASSERT_EQ(1, diff.added_users.size());
+    ASSERT_EQ("Bob", diff.added_users[0]->name);
+    ASSERT_EQ(1, diff.added_credentials.size());
+    ASSERT_EQ("12:34:56:78", diff.added_credentials[0]->card_id);
+}
+
+TEST_F(AuthFileDiffTest, RemovedMappedUser)
+{
+    // Toto is referenced by a schedule mapping.
+    to_.users.pop_back();
+    to_.credentials.pop_back();
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_FALSE(diff.empty());
+    ASSERT_FALSE(diff.incremental);
+}
+
+TEST_F(AuthFileDiffTest, RemovedUserOwningCredentials)
+{
+    AuthFileData::User user = to_.users[1];
+    user.name               = "Bob";
+    from_.users.push_back(user);
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_TRUE(diff.incremental);
+    ASSERT_EQ(1, diff.removed_users.size());
+
+    // Bob is removed, but a credential still refers to him.
+    to_.credentials[0].owner = "Bob";
+    ASSERT_FALSE(AuthFileDiff(from_, to_).incremental);
+}
+
+TEST_F(AuthFileDiffTest, ChangedSchedule)
+{
+    to_.schedules[0].timeframes[0].end_hour = 12;
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_FALSE(diff.empty());
+    ASSERT_FALSE(diff.incremental);
+}
+
+TEST_F(AuthFileDiffTest, DuplicatedCredential)
+{
+    to_.credentials.push_back(to_.credentials[0]);
+
+    AuthFileDiff diff(from_, to_);
+    ASSERT_FALSE(diff.incremental);
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    // gtest shall leave us with our arguments.
+    // argv[1] shall be the path to test data file
+    assert(argc == 2);
+    gl_data_path = std::string(argv[1]) + '/';
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,191 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/credentials/CardTable.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+using namespace Leosac::Cred;
+
+namespace Leosac
+{
+namespace Test
+{
+
+TEST(TestCardKey, from_card_id)
+{
+    auto key = CardKey::from_card_id("aa:BB:01");
+    ASSERT_TRUE(key);
+    ASSERT_EQ(0xaabb01u, key->value);
+    ASSERT_EQ(24, key->bits);
+    ASSERT_EQ(*key, *CardKey::from_card_id("AA:bb:01"));
+
+    // Leading zeros are significant.
+    ASSERT_NE(*key, *CardKey::from_card_id("00:aa:bb:01"));
+
+    auto widest = CardKey::from_card_id("ff:ff:ff:ff:ff:ff:ff:ff");
+    ASSERT_TRUE(widest);
+    ASSERT_EQ(UINT64_MAX, widest->value);
+    ASSERT_EQ(64, widest->bits);
+
+    ASSERT_FALSE(CardKey::from_card_id(""));
+    ASSERT_FALSE(CardKey::from_card_id("aa:zz"));
+    ASSERT_FALSE(CardKey::from_card_id("01:02:03:04:05:06:07:08:09"));
+}
+
+TEST(TestCardTable, insert_and_find)
+{
+    CardTable<int> table;
+    for (int i = 0; i < 1000; ++i)
+        table[CardKey{static_cast<uint64_t>(i), 32}] = i;
+    table["aa:bb:cc:dd"] = 42;
+    // Wider than 64 bits.
+    table["01:02:03:04:05:06:07:08:09:0a"] = 43;
+
+    ASSERT_EQ(1002u, table.size());
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto value = table.find(CardKey{static_cast<uint64_t>(i), 32});
+        ASSERT_TRUE(value);
+        ASSERT_EQ(i, *value);
+    }
+    ASSERT_FALSE(table.find(CardKey{1, 24}));
+    ASSERT_FALSE(table.find(CardKey{1000, 32}));
+
+    ASSERT_EQ(42, *table.find("AA:BB:CC:DD"));
+    ASSERT_EQ(43, *table.find("01:02:03:04:05:06:07:08:09:0A"));
+    ASSERT_FALSE(table.find("01:02:03:04:05:06:07:08:09:0b"));
+
+    table["aa:bb:cc:dd"] = 44;
+    ASSERT_EQ(44, *table.find("aa:bb:cc:dd"));
+    ASSERT_EQ(1002u, table.size());
+
+    int sum = 0;
+    table.for_each([&](int value) { sum += value; });
+    ASSERT_EQ(999 * 1000 / 2 + 44 + 43, sum);
+}
+
+static size_t allocated_bytes = 0;
+
+/**
+ * Keep track of the memory used by a standard container.
+ */
+template <typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U> &) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U> &) const
+    {
+        return false;
+    }
+};
+
+/**
+ * Compare the card table with the string keyed map it replaces, with
+ * one million 32 bits cards.
+ * Disabled by default, see `--gtest_also_run_disabled_tests`.
+ */
+TEST(TestCardTable, DISABLED_benchmark_1M_cards)
+{
+    constexpr size_t nb_cards = 1000000;
+    using Clock               = std::chrono::steady_clock;
+
+    std::vector<std::string> card_ids;
+    card_ids.reserve(nb_cards);
+    for (uint32_t i = 0; i < nb_cards; ++i)
+    {
+        // Odd multiplier: the card numbers are distinct, but not sequential.
+        uint32_t n = i * 2654435761u;
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x", n >> 24, (n >> 16) & 0xff,
+                 (n >> 8) & 0xff, n & 0xff);
+        card_ids.emplace_back(buf);
+    }
+
+    using StringMap = std::unordered_map<
+        std::string, uint64_t, std::hash<std::string>, std::equal_to<std::string>,
+        CountingAllocator<std::pair<const std::string, uint64_t>>>;
+    StringMap string_map;
+    CardTable<uint64_t> table;
+    for (size_t i = 0; i < nb_cards; ++i)
+    {
+        string_map[card_ids[i]] = i;
+        table[card_ids[i]]      = i;
+    }
+    ASSERT_EQ(nb_cards, table.size());
+
+    std::vector<std::string> lookups = card_ids;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(42));
+
+    auto measure = [&](const std::function<bool(const std::string &)> &find) {
+        auto start   = Clock::now();
+        size_t found = 0;
+        for (const auto &card_id : lookups)
+            found += find(card_id);
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start);
+        EXPECT_EQ(nb_cards, found);
+        return elapsed.count() / nb_cards;
+    };
+    auto map_ns = measure([&](const std::string &card_id) {
+        return string_map.find(card_id) != string_map.end();
+    });
+    auto table_ns = measure(
+        [&](const std::string &card_id) { return table.find(card_id) != nullptr; });
+
+    std::cout << "1M cards, string map: " << map_ns << "ns/lookup, "
+              << allocated_bytes / (1024 * 1024) << "MB" << std::endl;
+    std::cout << "1M cards, card table: " << table_ns << "ns/lookup, "
+              << table.memory_usage() / (1024 * 1024) << "MB" << std::endl;
+}
+}
+}
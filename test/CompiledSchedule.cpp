@@ -0,0 +1,145 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/CompiledSchedule.hpp"
+#include "tools/SingleTimeFrame.hpp"
+#include "gtest/gtest.h"
+#include <iostream>
+
+using namespace Leosac;
+using namespace Leosac::Tools;
+
+namespace Leosac
+{
+namespace Test
+{
+
+class CompiledScheduleTest : public ::testing::Test
+{
+  public:
+    CompiledScheduleTest()
+    {
+        timeframes_.emplace_back(0, 0, 0, 23, 59);   // full sunday
+        timeframes_.emplace_back(1, 8, 30, 12, 0);   // monday morning
+        timeframes_.emplace_back(1, 13, 45, 17, 15); // monday afternoon
+        timeframes_.emplace_back(3, 23, 0, 23, 59);  // wednesday night
+        timeframes_.emplace_back(5, 12, 0, 12, 0);   // a single minute
+        timeframes_.emplace_back(6, 18, 0, 10, 0);   // empty: end < start
+
+        // Monday 3rd November 2014, 00:00 local time.
+        std::tm date = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        date.tm_year  = 114;
+        date.tm_mon   = 10;
+        date.tm_mday  = 3;
+        date.tm_isdst = -1;
+        monday_ = std::chrono::system_clock::from_time_t(std::mktime(&date));
+    }
+
+    bool naive_is_in_schedule(const std::chrono::system_clock::time_point &tp)
+    {
+        for (const auto &tf : timeframes_)
+        {
+            if (tf.is_in_timeframe(tp))
+                return true;
+        }
+        return false;
+    }
+
+    std::vector<SingleTimeFrame> timeframes_;
+    std::chrono::system_clock::time_point monday_;
+};
+
+TEST_F(CompiledScheduleTest, minute_of_week)
+{
+    ASSERT_EQ(CompiledSchedule::MINUTES_PER_DAY,
+              CompiledSchedule::minute_of_week(monday_));
+    ASSERT_EQ(CompiledSchedule::MINUTES_PER_DAY + 8 * 60 + 30,
+              CompiledSchedule::minute_of_week(monday_ + std::chrono::hours(8) +
+                                               std::chrono::minutes(30) +
+                                               std::chrono::seconds(59)));
+}
+
+/**
+ * The compiled schedule must give the same answer than the timeframes
+ * for every minute of the week.
+ */
+TEST_F(CompiledScheduleTest, same_as_timeframes)
+{
+    CompiledSchedule compiled(timeframes_);
+
+    for (int minute = 0; minute < 7 * 24 * 60; ++minute)
+    {
+        auto tp = monday_ + std::chrono::minutes(minute);
+        ASSERT_EQ(naive_is_in_schedule(tp),
+                  compiled.is_in_schedule(CompiledSchedule::minute_of_week(tp)))
+            << "Mismatch at minute " << minute;
+    }
+}
+
+TEST_F(CompiledScheduleTest, invalid_input)
+{
+    CompiledSchedule compiled;
+    compiled.add_timeframe(SingleTimeFrame(7, 0, 0, 23, 59));
+    compiled.add_timeframe(SingleTimeFrame(-1, 0, 0, 23, 59));
+
+    for (uint16_t minute = 0; minute < CompiledSchedule::MINUTES_PER_WEEK; ++minute)
+        ASSERT_FALSE(compiled.is_in_schedule(minute));
+    ASSERT_FALSE(compiled.is_in_schedule(CompiledSchedule::MINUTES_PER_WEEK));
+}
+
+/**
+ * Not a real benchmark, but gives an idea of the gain compared to
+ * checking each timeframe.
+ * Disabled: run it with `--gtest_also_run_disabled_tests`.
+ */
+TEST_F(CompiledScheduleTest, DISABLED_compare_speed)
+{
+    using Clock = std::chrono::steady_clock;
+    CompiledSchedule compiled(timeframes_);
+    const int iterations = 100000;
+    int naive_hits       = 0;
+    int compiled_hits    = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+        naive_hits += naive_is_in_schedule(monday_ + std::chrono::minutes(i));
+    auto naive_duration = Clock::now() - start;
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto tp  = monday_ + std::chrono::minutes(i);
+        auto mow = CompiledSchedule::minute_of_week(tp);
+        compiled_hits += compiled.is_in_schedule(mow);
+    }
+    auto compiled_duration = Clock::now() - start;
+
+    ASSERT_EQ(naive_hits, compiled_hits);
+    std::cout << "Timeframes: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                     naive_duration)
+                     .count()
+              << "us, compiled: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                     compiled_duration)
+                     .count()
+              << "us for " << iterations << " checks." << std::endl;
+}
+}
+}
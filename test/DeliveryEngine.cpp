@@ -0,0 +1,321 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "modules/ws-notifier/DeliveryEngine.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <curl/curl.h>
+#include <functional>
+#include <json.hpp>
+#include <map>
+#include <mutex>
+#include <thread>
+
+extern "C" {
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace Leosac::Module::WSNotifier;
+
+namespace Leosac
+{
+namespace Test
+{
+
+/**
+ * A minimal HTTP/1.1 server, listening on localhost.
+ *
+ * It records the body of each request, and replies with the next status
+ * code of `statuses` (200 once they are exhausted). Connections are kept
+ * alive.
+ */
+class HTTPStub
+{
+  public:
+    explicit HTTPStub(std::vector<int> statuses = {})
+        : statuses_(statuses)
+        , nb_connections_(0)
+        , stopping_(false)
+    {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+        socklen_t len        = sizeof(addr);
+        bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), len);
+        listen(listen_fd_, 8);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~HTTPStub()
+    {
+        stopping_ = true;
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    std::string url() const
+    {
+        return "http://127.0.0.1:" + std::to_string(port_) + "/card";
+    }
+
+    std::vector<std::string> bodies() const
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        return bodies_;
+    }
+
+    int nb_connections() const
+    {
+        return nb_connections_;
+    }
+
+  private:
+    void run()
+    {
+        std::map<int, std::string> clients;
+        while (!stopping_)
+        {
+            std::vector<pollfd> fds{{listen_fd_, POLLIN, 0}};
+            for (const auto &client : clients)
+                fds.push_back({client.first, POLLIN, 0});
+            if (poll(fds.data(), fds.size(), 10) <= 0)
+                continue;
+
+            if (fds[0].revents & POLLIN)
+            {
+                clients[accept(listen_fd_, nullptr, nullptr)];
+                ++nb_connections_;
+            }
+            for (size_t i = 1; i < fds.size(); ++i)
+            {
+                if (!fds[i].revents)
+                    continue;
+                char buf[4096];
+                auto n = read(fds[i].fd, buf, sizeof(buf));
+                if (n <= 0)
+                {
+                    close(fds[i].fd);
+                    clients.erase(fds[i].fd);
+                    continue;
+                }
+                auto &pending = clients[fds[i].fd];
+                pending.append(buf, n);
+                while (handle_request(fds[i].fd, pending))
+                    ;
+            }
+        }
+        for (const auto &client : clients)
+            close(client.first);
+    }
+
+    /**
+     * Reply to the request at the beginning of `pending`, if it has been
+     * fully received.
+     */
+    bool handle_request(int fd, std::string &pending)
+    {
+        auto header_end = pending.find("\r\n\r\n");
+        if (header_end == std::string::npos)
+            return false;
+        size_t content_length = 0;
+        auto cl               = pending.find("Content-Length: ");
+        if (cl != std::string::npos && cl < header_end)
+            content_length = std::stoul(pending.substr(cl + 16));
+        if (pending.size() < header_end + 4 + content_length)
+            return false;
+
+        int status = 200;
+        {
+            std::lock_guard<std::mutex> lg(mutex_);
+            bodies_.push_back(pending.substr(header_end + 4, content_length));
+            if (!statuses_.empty())
+            {
+                status = statuses_.front();
+                statuses_.erase(statuses_.begin());
+            }
+        }
+        pending.erase(0, header_end + 4 + content_length);
+
+        std::string response = "HTTP/1.1 " + std::to_string(status) +
+                               " Stub\r\nContent-Length: 0\r\n\r\n";
+        auto ret = write(fd, response.c_str(), response.size());
+        (void)ret;
+        return true;
+    }
+
+    int listen_fd_;
+    uint16_t port_;
+    mutable std::mutex mutex_;
+    std::vector<int> statuses_;
+    std::vector<std::string> bodies_;
+    std::atomic<int> nb_connections_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+class DeliveryEngineTest : public ::testing::Test
+{
+  public:
+    DeliveryEngineTest()
+    {
+        curl_global_init(0);
+    }
+
+    ~DeliveryEngineTest()
+    {
+        curl_global_cleanup();
+    }
+
+    /**
+     * Wait until `pred` is true for the stats of the first target.
+     */
+    bool wait_for(DeliveryEngine &engine,
+                  const std::function<bool(const DeliveryEngine::Stats &)> &pred)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            if (pred(engine.stats().front()))
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+
+    static CardEvent event(uint64_t card_id)
+    {
+        return CardEvent{"MY_WIEGAND_1", card_id, card_id};
+    }
+};
+
+TEST_F(DeliveryEngineTest, delivers_in_order_over_one_connection)
+{
+    HTTPStub stub;
+    TargetInfo target;
+    target.url_ = stub.url();
+    DeliveryEngine engine({target});
+
+    for (uint64_t i = 1; i <= 5; ++i)
+        engine.post(event(i));
+    ASSERT_TRUE(wait_for(engine, [](const DeliveryEngine::Stats &s) {
+        return s.delivered == 5;
+    }));
+
+    auto bodies = stub.bodies();
+    ASSERT_EQ(5u, bodies.size());
+    for (uint64_t i = 1; i <= 5; ++i)
+    {
+        auto expected = "card_id=" + std::to_string(i) +
+                        "&auth_source=MY_WIEGAND_1&card_id_raw=" + std::to_string(i);
+        ASSERT_EQ(expected, bodies[i - 1]);
+    }
+    ASSERT_EQ(1, stub.nb_connections());
+
+    auto stats = engine.stats().front();
+    ASSERT_EQ(5u, stats.requests);
+    ASSERT_EQ(0u, stats.retries);
+    ASSERT_EQ(0u, stats.queue_depth);
+}
+
+TEST_F(DeliveryEngineTest, retries_then_batches)
+{
+    HTTPStub stub({500});
+    TargetInfo target;
+    target.url_         = stub.url();
+    target.batch_size_  = 10;
+    target.retry_delay_ = std::chrono::milliseconds(300);
+    DeliveryEngine engine({target});
+
+    engine.post(event(1));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (stub.bodies().empty() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Queued while the first request waits for its retry.
+    for (uint64_t i = 2; i <= 5; ++i)
+        engine.post(event(i));
+
+    ASSERT_TRUE(wait_for(engine, [](const DeliveryEngine::Stats &s) {
+        return s.delivered == 5;
+    }));
+    auto stats = engine.stats().front();
+    ASSERT_EQ(3u, stats.requests);
+    ASSERT_EQ(1u, stats.retries);
+    ASSERT_EQ(0u, stats.failed);
+
+    auto bodies = stub.bodies();
+    ASSERT_EQ(3u, bodies.size());
+    ASSERT_EQ(bodies[0], bodies[1]);
+    auto batch = nlohmann::json::parse(bodies[2]);
+    ASSERT_EQ(4u, batch.size());
+    ASSERT_EQ(2u, batch[0]["card_id"].get<uint64_t>());
+    ASSERT_EQ("MY_WIEGAND_1", batch[3]["auth_source"].get<std::string>());
+}
+
+TEST_F(DeliveryEngineTest, gives_up_after_max_retries)
+{
+    HTTPStub stub({503, 503, 503});
+    TargetInfo target;
+    target.url_         = stub.url();
+    target.max_retries_ = 2;
+    target.retry_delay_ = std::chrono::milliseconds(10);
+    DeliveryEngine engine({target});
+
+    engine.post(event(1));
+    ASSERT_TRUE(wait_for(engine, [](const DeliveryEngine::Stats &s) {
+        return s.failed == 1;
+    }));
+    auto stats = engine.stats().front();
+    ASSERT_EQ(3u, stats.requests);
+    ASSERT_EQ(2u, stats.retries);
+    ASSERT_EQ(0u, stats.delivered);
+}
+
+TEST_F(DeliveryEngineTest, drops_when_queue_is_full)
+{
+    HTTPStub stub({500});
+    TargetInfo target;
+    target.url_            = stub.url();
+    target.max_queue_size_ = 2;
+    target.retry_delay_    = std::chrono::seconds(10);
+    DeliveryEngine engine({target});
+
+    // The first event stays in the engine, waiting for its retry.
+    engine.post(event(1));
+    ASSERT_TRUE(wait_for(engine, [](const DeliveryEngine::Stats &s) {
+        return s.requests == 1 && s.queue_depth == 0;
+    }));
+    for (uint64_t i = 2; i <= 5; ++i)
+        engine.post(event(i));
+
+    auto stats = engine.stats().front();
+    ASSERT_EQ(2u, stats.queue_depth);
+    ASSERT_EQ(2u, stats.dropped);
+}
+}
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tools/log.hpp"
+#include "gtest/gtest.h"
+#include <spdlog/sinks/ostream_sink.h>
+
+namespace Leosac
+{
+namespace Test
+{
+
+class LogHelperTest : public ::testing::Test
+{
+  public:
+    LogHelperTest()
+        : sink_(std::make_shared<spdlog::sinks::ostream_sink_mt>(output_))
+        , logger_(std::make_shared<spdlog::logger>("test-console", sink_))
+    {
+    }
+
+    ~LogHelperTest()
+    {
+        LogHelper::set_loggers(nullptr, nullptr);
+    }
+
+  protected:
+    std::ostringstream output_;
+    std::shared_ptr<spdlog::sinks::ostream_sink_mt> sink_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+TEST_F(LogHelperTest, disabled_level_is_not_formatted)
+{
+    int nb_eval = 0;
+    auto count  = [&]() { return ++nb_eval; };
+
+    logger_->set_level(spdlog::level::warn);
+    LogHelper::set_loggers(logger_, nullptr);
+
+    DEBUG("debug " << count());
+    INFO("info " << count());
+    ASSERT_EQ(0, nb_eval);
+
+    WARN("warn " << count());
+    ASSERT_EQ(1, nb_eval);
+    ASSERT_NE(std::string::npos, output_.str().find("warn 1"));
+    ASSERT_EQ(std::string::npos, output_.str().find("info"));
+}
+
+TEST_F(LogHelperTest, runtime_level_follows_loggers)
+{
+    auto syslog = std::make_shared<spdlog::logger>("test-syslog", sink_);
+
+    logger_->set_level(spdlog::level::err);
+    syslog->set_level(spdlog::level::info);
+    LogHelper::set_loggers(logger_, syslog);
+    ASSERT_FALSE(LogHelper::is_enabled(LogLevel::DEBUG));
+    ASSERT_TRUE(LogHelper::is_enabled(LogLevel::INFO));
+
+    LogHelper::set_loggers(logger_, nullptr);
+    ASSERT_FALSE(LogHelper::is_enabled(LogLevel::WARN));
+    ASSERT_TRUE(LogHelper::is_enabled(LogLevel::ERROR));
+
+    // Without logger, everything goes to stderr.
+    LogHelper::set_loggers(nullptr, nullptr);
+    ASSERT_TRUE(LogHelper::is_enabled(LogLevel::DEBUG));
+}
+}
+}
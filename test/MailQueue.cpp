@@ -0,0 +1,364 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "modules/smtp/MailQueue.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <curl/curl.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+extern "C" {
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace Leosac::Module::SMTP;
+
+namespace Leosac
+{
+namespace Test
+{
+
+/**
+ * A minimal SMTP server, listening on localhost.
+ *
+ * It records the content of each mail it accepts. The first
+ * `nb_rejections` transactions are refused with a transient error.
+ */
+class SMTPSink
+{
+  public:
+    explicit SMTPSink(int nb_rejections = 0)
+        : nb_rejections_(nb_rejections)
+        , nb_connections_(0)
+        , stopping_(false)
+    {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+        socklen_t len        = sizeof(addr);
+        bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), len);
+        listen(listen_fd_, 8);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~SMTPSink()
+    {
+        stopping_ = true;
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    SMTPServerInfo server() const
+    {
+        SMTPServerInfo server;
+        server.url        = "smtp://127.0.0.1:" + std::to_string(port_);
+        server.from       = "leosac@leosac.com";
+        server.ms_timeout = 5000;
+        return server;
+    }
+
+    std::vector<std::string> mails() const
+    {
+        std::lock_guard<std::mutex> lg(mutex_);
+        return mails_;
+    }
+
+    int nb_connections() const
+    {
+        return nb_connections_;
+    }
+
+  private:
+    struct Client
+    {
+        std::string pending;
+        bool in_data;
+    };
+
+    void run()
+    {
+        std::map<int, Client> clients;
+        while (!stopping_)
+        {
+            std::vector<pollfd> fds{{listen_fd_, POLLIN, 0}};
+            for (const auto &client : clients)
+                fds.push_back({client.first, POLLIN, 0});
+            if (poll(fds.data(), fds.size(), 10) <= 0)
+                continue;
+
+            if (fds[0].revents & POLLIN)
+            {
+                int fd      = accept(listen_fd_, nullptr, nullptr);
+                clients[fd] = Client{"", false};
+                ++nb_connections_;
+                reply(fd, "220 sink ESMTP");
+            }
+            for (size_t i = 1; i < fds.size(); ++i)
+            {
+                if (!fds[i].revents)
+                    continue;
+                char buf[4096];
+                auto n = read(fds[i].fd, buf, sizeof(buf));
+                if (n <= 0)
+                {
+                    close(fds[i].fd);
+                    clients.erase(fds[i].fd);
+                    continue;
+                }
+                auto &client = clients[fds[i].fd];
+                client.pending.append(buf, n);
+                while (handle_input(fds[i].fd, client))
+                    ;
+            }
+        }
+        for (const auto &client : clients)
+            close(client.first);
+    }
+
+    /**
+     * Process the command, or the mail content, at the beginning of the
+     * client's pending input, if it has been fully received.
+     */
+    bool handle_input(int fd, Client &client)
+    {
+        if (client.in_data)
+        {
+            auto end = client.pending.find("\r\n.\r\n");
+            if (end == std::string::npos)
+                return false;
+            {
+                std::lock_guard<std::mutex> lg(mutex_);
+                mails_.push_back(client.pending.substr(0, end));
+            }
+            client.pending.erase(0, end + 5);
+            client.in_data = false;
+            reply(fd, "250 queued");
+            return true;
+        }
+
+        auto eol = client.pending.find("\r\n");
+        if (eol == std::string::npos)
+            return false;
+        auto command = client.pending.substr(0, 4);
+        client.pending.erase(0, eol + 2);
+
+        if (command == "MAIL" && nb_rejections_ > 0)
+        {
+            --nb_rejections_;
+            reply(fd, "451 try again later");
+        }
+        else if (command == "DATA")
+        {
+            client.in_data = true;
+            reply(fd, "354 go ahead");
+        }
+        else if (command == "QUIT")
+            reply(fd, "221 bye");
+        else
+            reply(fd, "250 ok");
+        return true;
+    }
+
+    static void reply(int fd, const std::string &line)
+    {
+        auto data = line + "\r\n";
+        auto ret  = write(fd, data.c_str(), data.size());
+        (void)ret;
+    }
+
+    int listen_fd_;
+    uint16_t port_;
+    mutable std::mutex mutex_;
+    std::vector<std::string> mails_;
+    int nb_rejections_;
+    std::atomic<int> nb_connections_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+class MailQueueTest : public ::testing::Test
+{
+  public:
+    MailQueueTest()
+    {
+        curl_global_init(0);
+        spool_dir_ = (boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path())
+                         .string();
+    }
+
+    ~MailQueueTest()
+    {
+        boost::filesystem::remove_all(spool_dir_);
+        curl_global_cleanup();
+    }
+
+    /**
+     * Wait until `pred` is true for the stats of the queue.
+     */
+    bool wait_for(MailQueue &queue,
+                  const std::function<bool(const MailQueue::Stats &)> &pred)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            if (pred(queue.stats()))
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+
+    static MailInfo mail(const std::string &title, const std::string &body)
+    {
+        return MailInfo{{"admin@leosac.com"}, title, body};
+    }
+
+    size_t spooled_files() const
+    {
+        return std::distance(boost::filesystem::directory_iterator(spool_dir_),
+                             boost::filesystem::directory_iterator());
+    }
+
+  protected:
+    std::string spool_dir_;
+};
+
+TEST_F(MailQueueTest, delivers_over_one_connection)
+{
+    SMTPSink sink;
+    MailQueue queue(MailQueue::Config{}, {sink.server()});
+
+    for (int i = 1; i <= 3; ++i)
+        queue.enqueue(mail("Mail " + std::to_string(i), "Body"));
+    ASSERT_TRUE(wait_for(queue, [](const MailQueue::Stats &s) {
+        return s.sent == 3;
+    }));
+
+    auto mails = sink.mails();
+    ASSERT_EQ(3u, mails.size());
+    ASSERT_NE(std::string::npos, mails[0].find("Subject: Mail 1\r\n"));
+    ASSERT_NE(std::string::npos, mails[2].find("Subject: Mail 3\r\n"));
+    ASSERT_EQ(1, sink.nb_connections());
+
+    auto stats = queue.stats();
+    ASSERT_EQ(1u, stats.connections);
+    ASSERT_EQ(0u, stats.queue_depth);
+    ASSERT_EQ(0u, stats.retries);
+}
+
+TEST_F(MailQueueTest, coalesces_into_digest)
+{
+    SMTPSink sink;
+    MailQueue::Config config;
+    config.digest_window = std::chrono::milliseconds(300);
+    MailQueue queue(config, {sink.server()});
+
+    for (int i = 1; i <= 5; ++i)
+        queue.enqueue(mail("Door forced", "Alert " + std::to_string(i)));
+    queue.enqueue(mail("Door held open", "Alert 6"));
+    ASSERT_EQ(2u, queue.stats().queue_depth);
+
+    ASSERT_TRUE(wait_for(queue, [](const MailQueue::Stats &s) {
+        return s.sent == 2;
+    }));
+    auto stats = queue.stats();
+    ASSERT_EQ(4u, stats.coalesced);
+    ASSERT_LE(std::chrono::microseconds(300000), stats.max_latency);
+
+    auto mails = sink.mails();
+    ASSERT_EQ(2u, mails.size());
+    ASSERT_NE(std::string::npos,
+              mails[0].find("Subject: Door forced (5 alerts)\r\n"));
+    ASSERT_NE(std::string::npos, mails[0].find("Alert 1"));
+    ASSERT_NE(std::string::npos, mails[0].find("Alert 5"));
+    ASSERT_NE(std::string::npos, mails[1].find("Subject: Door held open\r\n"));
+}
+
+TEST_F(MailQueueTest, retries_failed_delivery)
+{
+    SMTPSink sink(1);
+    MailQueue::Config config;
+    config.retry_delay = std::chrono::milliseconds(10);
+    MailQueue queue(config, {sink.server()});
+
+    queue.enqueue(mail("Retried", "Body"));
+    ASSERT_TRUE(wait_for(queue, [](const MailQueue::Stats &s) {
+        return s.sent == 1;
+    }));
+    auto stats = queue.stats();
+    ASSERT_EQ(1u, stats.retries);
+    ASSERT_EQ(0u, stats.failed);
+    ASSERT_EQ(1u, sink.mails().size());
+}
+
+TEST_F(MailQueueTest, spooled_mails_survive_restart)
+{
+    MailQueue::Config config;
+    config.spool_dir   = spool_dir_;
+    config.retry_delay = std::chrono::seconds(10);
+    {
+        // No server: mails stay queued.
+        MailQueue queue(config, {});
+        queue.enqueue(mail("First", "Body 1"));
+        queue.enqueue(mail("Second", "Body 2"));
+        ASSERT_EQ(2u, spooled_files());
+    }
+    ASSERT_EQ(2u, spooled_files());
+
+    SMTPSink sink;
+    MailQueue queue(config, {sink.server()});
+    ASSERT_TRUE(wait_for(queue, [](const MailQueue::Stats &s) {
+        return s.sent == 2;
+    }));
+    ASSERT_EQ(0u, spooled_files());
+
+    auto mails = sink.mails();
+    ASSERT_EQ(2u, mails.size());
+    ASSERT_NE(std::string::npos, mails[0].find("Subject: First\r\n"));
+    ASSERT_NE(std::string::npos, mails[1].find("Subject: Second\r\n"));
+}
+
+TEST_F(MailQueueTest, send_reports_result)
+{
+    MailQueue queue(MailQueue::Config{}, {});
+    ASSERT_FALSE(queue.send(mail("Test", "Body")).get());
+
+    SMTPSink sink;
+    queue.set_servers({sink.server()});
+    ASSERT_TRUE(queue.send(mail("Test", "Body")).get());
+    ASSERT_EQ(1u, sink.mails().size());
+    ASSERT_EQ(1u, queue.stats().failed);
+}
+}
+}
@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/MessageBus.hpp"
+#include "helper/TestHelper.hpp"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+namespace Leosac
+{
+namespace Test
+{
+
+class MessageBusTest : public ::testing::Test
+{
+  public:
+    MessageBusTest()
+        : bus_(ctx_)
+        , push_(ctx_, zmqpp::socket_type::push)
+    {
+        push_.connect("inproc://zmq-bus-pull");
+    }
+
+    /**
+     * Create a SUB socket subscribed to `topic`.
+     *
+     * Subscriptions propagate asynchronously to the bus: publish
+     * until the subscriber receives something, then flush.
+     */
+    std::unique_ptr<zmqpp::socket> subscribe(const std::string &topic)
+    {
+        auto sub = std::make_unique<zmqpp::socket>(ctx_, zmqpp::socket_type::sub);
+        sub->connect("inproc://zmq-bus-pub");
+        sub->subscribe(topic);
+
+        zmqpp::poller poller;
+        poller.add(*sub);
+        do
+        {
+            push_.send(zmqpp::message() << topic << "SYNC");
+        } while (!poller.poll(5));
+
+        push_.send(zmqpp::message() << topic << "SYNC_DONE");
+        std::string content;
+        do
+        {
+            zmqpp::message msg;
+            sub->receive(msg);
+            content = msg.get(1);
+        } while (content != "SYNC_DONE");
+        return sub;
+    }
+
+    /**
+     * Topic of the reader `idx`.
+     */
+    static std::string reader_topic(int idx)
+    {
+        std::stringstream ss;
+        ss << "S_READER_" << std::setw(2) << std::setfill('0') << idx;
+        return ss.str();
+    }
+
+    zmqpp::context ctx_;
+    MessageBus bus_;
+    zmqpp::socket push_;
+};
+
+TEST_F(MessageBusTest, topic_filtering)
+{
+    auto sub_a = subscribe("S_A");
+    auto sub_b = subscribe("S_B");
+
+    push_.send(zmqpp::message() << "S_A"
+                                << "1");
+    push_.send(zmqpp::message() << "S_B"
+                                << "2"
+                                << "3");
+    push_.send(zmqpp::message() << "S_A"
+                                << "4");
+
+    ASSERT_TRUE(Helper::bus_read(*sub_a, "S_A", "1"));
+    ASSERT_TRUE(Helper::bus_read(*sub_a, "S_A", "4"));
+    ASSERT_TRUE(Helper::bus_read(*sub_b, "S_B", "2", "3"));
+
+    zmqpp::message msg;
+    ASSERT_FALSE(sub_a->receive(msg, true));
+    ASSERT_FALSE(sub_b->receive(msg, true));
+}
+
+/**
+ * Simulate a site with 64 readers. Each reader has its own subscriber
+ * (think LED or door module) and a single subscriber receives everything
+ * (think auth or logging module).
+ *
+ * Each round, every reader publishes one message.
+ *
+ * This is a benchmark, disabled by default. Run it with
+ * `--gtest_also_run_disabled_tests`.
+ */
+TEST_F(MessageBusTest, DISABLED_benchmark_64_readers)
+{
+    constexpr int nb_readers = 64;
+    constexpr int nb_rounds  = 500;
+    using Clock              = std::chrono::steady_clock;
+
+    std::vector<std::unique_ptr<zmqpp::socket>> readers;
+    for (int i = 0; i < nb_readers; ++i)
+        readers.push_back(subscribe(reader_topic(i)));
+    auto all = subscribe("S_");
+
+    Clock::duration total_latency(0);
+    Clock::duration max_latency(0);
+    auto start = Clock::now();
+    for (int round = 0; round < nb_rounds; ++round)
+    {
+        auto sent_at = Clock::now();
+        for (int i = 0; i < nb_readers; ++i)
+            push_.send(zmqpp::message() << reader_topic(i) << "DATA" << round);
+
+        for (int i = 0; i < nb_readers; ++i)
+        {
+            zmqpp::message msg;
+            readers[i]->receive(msg);
+            auto latency = Clock::now() - sent_at;
+            total_latency += latency;
+            max_latency = std::max(max_latency, latency);
+            ASSERT_EQ(reader_topic(i), msg.get(0));
+
+            all->receive(msg);
+            ASSERT_EQ(reader_topic(i), msg.get(0));
+        }
+    }
+    auto duration = Clock::now() - start;
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    auto nb_messages = nb_readers * nb_rounds;
+    long long duration_us = duration_cast<microseconds>(duration).count();
+    std::cout << "Bus: " << nb_messages << " messages in " << duration_us
+              << "us (" << nb_messages * 1000000LL / std::max(duration_us, 1LL)
+              << " msg/s). Latency: average "
+              << duration_cast<microseconds>(total_latency / nb_messages).count()
+              << "us, max " << duration_cast<microseconds>(max_latency).count()
+              << "us" << std::endl;
+}
+}
+}
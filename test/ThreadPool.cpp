@@ -0,0 +1,163 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/Scheduler.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/tasks/GenericTask.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <poll.h>
+
+using namespace Leosac;
+
+namespace Leosac
+{
+namespace Test
+{
+
+TEST(TestThreadPool, run_tasks)
+{
+    std::atomic<int> counter(0);
+    std::vector<std::shared_future<bool>> futures;
+    {
+        ThreadPool pool(4, 0);
+        ASSERT_EQ(4u, pool.size());
+        for (int i = 0; i < 100; ++i)
+        {
+            auto t = Tasks::GenericTask::build([&]() {
+                counter++;
+                return true;
+            });
+            futures.push_back(t->get_future());
+            pool.enqueue(t, TaskPriority::NORMAL);
+        }
+        for (auto &f : futures)
+            ASSERT_TRUE(f.get());
+        // A task's future is ready before the worker counts it as completed.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (pool.stats().completed < 100 &&
+               std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+        ASSERT_EQ(100u, pool.stats().completed);
+    }
+    ASSERT_EQ(100, counter);
+}
+
+TEST(TestThreadPool, future_holds_exception)
+{
+    ThreadPool pool(1, 0);
+    auto t = Tasks::GenericTask::build([]() -> bool {
+        throw std::runtime_error("task failure");
+    });
+    pool.enqueue(t, TaskPriority::NORMAL);
+    ASSERT_THROW(t->get_future().get(), std::runtime_error);
+}
+
+/**
+ * With a single thread busy on a blocking task, queued tasks
+ * shall start by order of priority, then by order of insertion.
+ */
+TEST(TestThreadPool, priority)
+{
+    std::promise<void> unblock;
+    std::shared_future<void> unblocked = unblock.get_future().share();
+    std::vector<int> order;
+    std::mutex order_mutex;
+
+    auto make_task = [&](int id) {
+        return Tasks::GenericTask::build([&, id]() {
+            std::lock_guard<std::mutex> lg(order_mutex);
+            order.push_back(id);
+            return true;
+        });
+    };
+
+    {
+        ThreadPool pool(1, 0);
+        auto blocker = Tasks::GenericTask::build([=]() {
+            unblocked.wait();
+            return true;
+        });
+        pool.enqueue(blocker, TaskPriority::HIGH);
+        // Wait for the blocker to be running.
+        while (pool.stats().queue_depth)
+            std::this_thread::yield();
+
+        pool.enqueue(make_task(1), TaskPriority::LOW);
+        pool.enqueue(make_task(2), TaskPriority::NORMAL);
+        pool.enqueue(make_task(3), TaskPriority::HIGH);
+        pool.enqueue(make_task(4), TaskPriority::NORMAL);
+        unblock.set_value();
+    }
+    ASSERT_EQ(std::vector<int>({3, 2, 4, 1}), order);
+}
+
+TEST(TestThreadPool, bounded_queue)
+{
+    std::promise<void> unblock;
+    std::shared_future<void> unblocked = unblock.get_future().share();
+    auto blocker = [=]() {
+        unblocked.wait();
+        return true;
+    };
+
+    ThreadPool pool(1, 2);
+    pool.enqueue(Tasks::GenericTask::build(blocker), TaskPriority::NORMAL);
+    while (pool.stats().queue_depth)
+        std::this_thread::yield();
+
+    ASSERT_TRUE(pool.try_enqueue(Tasks::GenericTask::build(blocker),
+                                 TaskPriority::NORMAL));
+    ASSERT_TRUE(pool.try_enqueue(Tasks::GenericTask::build(blocker),
+                                 TaskPriority::NORMAL));
+    ASSERT_FALSE(pool.try_enqueue(Tasks::GenericTask::build(blocker),
+                                  TaskPriority::NORMAL));
+    ASSERT_EQ(2u, pool.stats().queue_depth);
+    ASSERT_EQ(1u, pool.stats().rejected);
+
+    unblock.set_value();
+}
+static bool is_readable(int fd)
+{
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 1;
+}
+
+TEST(TestThreadPool, main_task_wakes_up_main_thread)
+{
+    Scheduler sched(nullptr, 1, 0);
+    auto &wakeup = sched.main_thread_wakeup();
+    ASSERT_FALSE(is_readable(wakeup.fd()));
+
+    // POOL tasks do not wake the main thread up.
+    sched.enqueue([]() { return true; }, TargetThread::POOL).wait();
+    ASSERT_FALSE(is_readable(wakeup.fd()));
+
+    auto f = sched.enqueue([]() { return true; }, TargetThread::MAIN);
+    ASSERT_TRUE(is_readable(wakeup.fd()));
+
+    wakeup.drain();
+    ASSERT_FALSE(is_readable(wakeup.fd()));
+    sched.update(TargetThread::MAIN);
+    ASSERT_TRUE(f.get());
+}
+}
+}
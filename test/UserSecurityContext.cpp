@@ -0,0 +1,134 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/UserSecurityContext.hpp"
+#include "core/auth/Group.hpp"
+#include "core/auth/Group_odb.h"
+#include "core/auth/User.hpp"
+#include "core/auth/UserGroupMembership.hpp"
+#include "core/auth/UserGroupMembership_odb.h"
+#include "core/auth/User_odb.h"
+#include "helper/TestDatabase.hpp"
+#include "gtest/gtest.h"
+
+using namespace Leosac;
+
+namespace Leosac
+{
+namespace Test
+{
+
+/**
+ * The context memoizes permission decisions until reset_cache() is called,
+ * which the websocket server does before each request.
+ */
+class UserSecurityContextTest : public ::testing::Test
+{
+  public:
+    UserSecurityContextTest()
+    {
+        odb::transaction t(db_.db()->begin());
+        user_ = std::make_shared<Auth::User>();
+        user_->username("user");
+        user_->rank(Auth::UserRank::ADMIN);
+        db_.db()->persist(user_);
+
+        group_ = std::make_shared<Auth::Group>();
+        group_->name("group");
+        membership_ = group_->member_add(user_, Auth::GroupRank::ADMIN);
+        db_.db()->persist(group_);
+        t.commit();
+    }
+
+    /**
+     * Change the rank of `user_` in `group_`.
+     */
+    void set_group_rank(Auth::GroupRank rank)
+    {
+        odb::transaction t(db_.db()->begin());
+        auto membership =
+            db_.db()->load<Auth::UserGroupMembership>(membership_->id());
+        membership->rank(rank);
+        db_.db()->update(membership);
+        t.commit();
+    }
+
+    void set_user_rank(Auth::UserRank rank)
+    {
+        odb::transaction t(db_.db()->begin());
+        auto user = db_.db()->load<Auth::User>(user_->id());
+        user->rank(rank);
+        db_.db()->update(user);
+        t.commit();
+    }
+
+    bool can_update_group(const SecurityContext &ctx) const
+    {
+        SecurityContext::ActionParam ap;
+        ap.group.group_id = group_->id();
+        return ctx.check_permission(SecurityContext::Action::GROUP_UPDATE, ap);
+    }
+
+    Helper::TestDatabase db_;
+    Auth::UserPtr user_;
+    Auth::GroupPtr group_;
+    Auth::UserGroupMembershipPtr membership_;
+};
+
+TEST_F(UserSecurityContextTest, user_rank_change_between_requests)
+{
+    UserSecurityContext ctx(db_.dbsrv(), user_->id());
+    ASSERT_TRUE(ctx.check_permission(SecurityContext::Action::SMTP_SENDMAIL));
+
+    set_user_rank(Auth::UserRank::USER);
+    ctx.reset_cache();
+    ASSERT_FALSE(ctx.check_permission(SecurityContext::Action::SMTP_SENDMAIL));
+}
+
+TEST_F(UserSecurityContextTest, group_rank_change_between_requests)
+{
+    set_user_rank(Auth::UserRank::USER);
+    UserSecurityContext ctx(db_.dbsrv(), user_->id());
+    ASSERT_TRUE(can_update_group(ctx));
+
+    set_group_rank(Auth::GroupRank::MEMBER);
+    ctx.reset_cache();
+    ASSERT_FALSE(can_update_group(ctx));
+
+    set_group_rank(Auth::GroupRank::ADMIN);
+    ctx.reset_cache();
+    ASSERT_TRUE(can_update_group(ctx));
+}
+
+TEST_F(UserSecurityContextTest, removed_membership)
+{
+    set_user_rank(Auth::UserRank::USER);
+    UserSecurityContext ctx(db_.dbsrv(), user_->id());
+    ASSERT_TRUE(can_update_group(ctx));
+
+    {
+        odb::transaction t(db_.db()->begin());
+        db_.db()->erase<Auth::UserGroupMembership>(membership_->id());
+        t.commit();
+    }
+    ctx.reset_cache();
+    ASSERT_FALSE(can_update_group(ctx));
+}
+}
+}
@@ -19,10 +19,12 @@
 
 #include "core/Scheduler.hpp"
 #include "core/auth/Auth.hpp"
+#include "hardware/WiegandCapture.hpp"
 #include "helper/TestHelper.hpp"
 #include "modules/wiegand/wiegand.hpp"
 #include "modules/wiegand/WiegandConfig.hpp"
 #include "tools/runtimeoptions.hpp"
+#include <json.hpp>
 
 using namespace Leosac::Module::Wiegand;
 using namespace Leosac::Test::Helper;
@@ -95,5 +97,38 @@ TEST_F(WiegandReaderTest, readCard)
                          Leosac::Auth::SourceType::SIMPLE_WIEGAND, "00:00:00:ff",
                          32));
 }
+TEST_F(WiegandReaderTest, latencyHistogram)
+{
+    for (int i = 0; i < 32; i++)
+        high_.interrupt();
+    ASSERT_TRUE(bus_read(bus_sub_, "S_WIEGAND_1",
+                         Leosac::Auth::SourceType::SIMPLE_WIEGAND, "ff:ff:ff:ff",
+                         32));
+
+    zmqpp::socket control(ctx_, zmqpp::socket_type::req);
+    control.connect("inproc://module-WIEGAND_READER");
+    control.send("LATENCY_HISTOGRAM");
+
+    std::string response;
+    control.receive(response);
+    auto histogram = nlohmann::json::parse(response).at("WIEGAND_1");
+    ASSERT_EQ(1, histogram.at("count").get<int>());
+    // The card is signaled once the frame gap (50ms) elapsed.
+    ASSERT_GE(histogram.at("max_us").get<int>(), 50000);
+}
+
+TEST_F(WiegandReaderTest, readFrame)
+{
+    // The GPIO module decodes the data lines and publishes the whole frame.
+    Hardware::WiegandCapture capture("GPIO_HIGH", "GPIO_LOW");
+    for (int i = 0; i < 32; i++)
+        capture.push_bit(i >= 24);
+
+    auto msg = capture.take_frame();
+    bus_push_.send(msg);
+    ASSERT_TRUE(bus_read(bus_sub_, "S_WIEGAND_1",
+                         Leosac::Auth::SourceType::SIMPLE_WIEGAND, "00:00:00:ff",
+                         32));
+}
 }
 }
@@ -0,0 +1,266 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "modules/auth/auth-file/AuthFileData.hpp"
+#include "modules/auth/auth-file/XmlRecordStream.hpp"
+#include "tools/XmlPropertyTree.hpp"
+#include "gtest/gtest.h"
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <tuple>
+
+extern "C" {
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+/**
+* Path to test-data file.
+* this come from command line (see CMakeLists.txt)
+*/
+static std::string gl_data_path;
+
+using namespace Leosac::Module::Auth;
+using boost::property_tree::ptree;
+
+namespace Leosac
+{
+namespace Test
+{
+using Record = std::tuple<std::vector<std::string>, std::string, ptree>;
+
+/**
+ * Records of `path`, as found in the tree built by propertyTreeFromXmlFile().
+ */
+static std::vector<Record> records_from_tree(const std::string &path)
+{
+    std::vector<Record> records;
+    auto tree = Tools::propertyTreeFromXmlFile(path);
+    for (const auto &root : tree)
+    {
+        for (const auto &section : root.second)
+        {
+            for (const auto &record : section.second)
+            {
+                records.emplace_back(
+                    std::vector<std::string>{root.first, section.first},
+                    record.first, record.second);
+            }
+        }
+    }
+    return records;
+}
+
+static std::vector<Record> records_from_stream(const std::string &path)
+{
+    std::vector<Record> records;
+    streamXmlRecords(path, 3, [&](const std::vector<std::string> &ancestors,
+                                  const std::string &name, const ptree &record) {
+        records.emplace_back(ancestors, name, record);
+    });
+    return records;
+}
+
+class XmlRecordStreamTest : public ::testing::Test
+{
+  public:
+    XmlRecordStreamTest()
+    {
+        dir_ = (boost::filesystem::temp_directory_path() /
+                boost::filesystem::unique_path())
+                   .string();
+        boost::filesystem::create_directories(dir_);
+    }
+
+    ~XmlRecordStreamTest()
+    {
+        boost::filesystem::remove_all(dir_);
+    }
+
+  protected:
+    std::string write_file(const std::string &name, const std::string &content)
+    {
+        std::string path = dir_ + "/" + name;
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << content;
+        return path;
+    }
+
+    std::string dir_;
+};
+
+TEST_F(XmlRecordStreamTest, same_records_as_property_tree)
+{
+    for (int i = 1; i <= 9; ++i)
+    {
+        std::string path = gl_data_path + "AuthFile-" + std::to_string(i) + ".xml";
+        if (i == 2) // Malformed.
+        {
+            ASSERT_ANY_THROW(records_from_stream(path));
+            continue;
+        }
+        ASSERT_EQ(records_from_tree(path), records_from_stream(path)) << path;
+    }
+}
+
+TEST_F(XmlRecordStreamTest, same_layout_as_property_tree)
+{
+    auto path = write_file("layout.xml", R"(<?xml version="1.0"?>
+<root>
+    <!-- comment -->
+    <section>
+        <record a="1" b="two">
+            <!-- comment -->
+            <name>  some
+                    name  </name>
+            <empty/>
+            <mixed>before <inner>x</inner> after</mixed>
+            <escaped>&lt;&amp;&gt;</escaped>
+            <cdata><![CDATA[<raw>]]></cdata>
+            <deep><deeper><deepest>42</deepest></deeper></deep>
+        </record>
+        <record>text</record>
+    </section>
+    <other><record/></other>
+</root>
+)");
+    auto expected = records_from_tree(path);
+    ASSERT_EQ(3, expected.size());
+    ASSERT_EQ(expected, records_from_stream(path));
+}
+
+TEST_F(XmlRecordStreamTest, handler_exception_stops_parsing)
+{
+    auto path = write_file("stop.xml", "<root><s><a/><b/><c/></s></root>");
+    int calls = 0;
+    ASSERT_THROW(streamXmlRecords(path, 3,
+                                  [&](const std::vector<std::string> &,
+                                      const std::string &name, const ptree &) {
+                                      ++calls;
+                                      if (name == "b")
+                                          throw std::runtime_error("stop");
+                                  }),
+                 std::runtime_error);
+    ASSERT_EQ(2, calls);
+}
+
+/**
+ * Peak RSS, in kilobytes, of a child process running `fct`.
+ */
+template <typename Callable>
+static long peak_rss_kb(Callable fct)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        try
+        {
+            fct();
+        }
+        catch (...)
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    int status;
+    struct rusage usage;
+    EXPECT_EQ(pid, wait4(pid, &status, 0, &usage));
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Time and peak memory of both parsers on 20k users. Disabled by default:
+ * run it with `--gtest_also_run_disabled_tests`.
+ */
+TEST_F(XmlRecordStreamTest, DISABLED_benchmark_20k_users)
+{
+    using Clock = std::chrono::steady_clock;
+    std::string path = dir_ + "/big.xml";
+    {
+        std::ofstream ofs(path);
+        ofs << "<root>\n<users>\n";
+        for (int i = 0; i < 20000; ++i)
+        {
+            ofs << "<user><name>user_" << i << "</name><firstname>First" << i
+                << "</firstname><lastname>Last" << i
+                << "</lastname><email>user" << i
+                << "@example.com</email></user>\n";
+        }
+        ofs << "</users>\n<credentials>\n";
+        for (int i = 0; i < 20000; ++i)
+        {
+            ofs << "<map><user>user_" << i << "</user><WiegandCard><id>card_" << i
+                << "</id><card_id>" << std::hex << 0x10000000 + i << std::dec
+                << "</card_id><bits>32</bits></WiegandCard></map>\n";
+        }
+        ofs << "</credentials>\n<schedules_mapping>\n";
+        for (int i = 0; i < 20000; ++i)
+        {
+            ofs << "<map><schedule>sched</schedule><door>door" << i % 16
+                << "</door><user>user_" << i << "</user></map>\n";
+        }
+        ofs << "</schedules_mapping>\n</root>\n";
+    }
+    auto file_kb = boost::filesystem::file_size(path) / 1024;
+
+    auto baseline_kb = peak_rss_kb([]() {});
+    auto tree_kb =
+        peak_rss_kb([&]() { Tools::propertyTreeFromXmlFile(path); }) - baseline_kb;
+    auto stream_kb =
+        peak_rss_kb([&]() { AuthFileData::from_xml(path); }) - baseline_kb;
+
+    auto start = Clock::now();
+    Tools::propertyTreeFromXmlFile(path);
+    auto tree_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       Clock::now() - start)
+                       .count();
+
+    start          = Clock::now();
+    auto data      = AuthFileData::from_xml(path);
+    auto stream_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         Clock::now() - start)
+                         .count();
+    ASSERT_EQ(20000, data.users.size());
+    ASSERT_EQ(20000, data.credentials.size());
+    ASSERT_EQ(20000, data.mappings.size());
+
+    std::cout << "Auth file of " << file_kb << "KB" << std::endl;
+    std::cout << "property tree (parsing only): " << tree_ms << "ms, peak +"
+              << tree_kb << "KB" << std::endl;
+    std::cout << "streamed AuthFileData: " << stream_ms << "ms, peak +" << stream_kb
+              << "KB" << std::endl;
+    ASSERT_LT(stream_kb, tree_kb);
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    // gtest shall leave us with our arguments.
+    // argv[1] shall be the path to test data file
+    assert(argc == 2);
+    gl_data_path = std::string(argv[1]) + '/';
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2014-2016 Leosac
+
+    This file is part of Leosac.
+
+    Leosac is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leosac is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "tools/db/DBService.hpp"
+#include "tools/db/database.hpp"
+#include <boost/filesystem.hpp>
+#include <odb/schema-catalog.hxx>
+#include <odb/sqlite/database.hxx>
+#include <odb/transaction.hxx>
+
+namespace Leosac
+{
+namespace Test
+{
+namespace Helper
+{
+/**
+* A SQLite database with the core schema, in a temporary file that is
+* removed on destruction.
+*
+* Schemas of modules can be created with create_schema().
+*/
+class TestDatabase
+{
+  public:
+    TestDatabase()
+        : path_((boost::filesystem::temp_directory_path() /
+                 boost::filesystem::unique_path("leosac-test-%%%%-%%%%.sqlite"))
+                    .string())
+    {
+        db_ = std::make_shared<odb::sqlite::database>(
+            path_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+        create_schema("core");
+        dbsrv_ = std::make_shared<DBService>(db_);
+    }
+
+    ~TestDatabase()
+    {
+        dbsrv_ = nullptr;
+        db_    = nullptr;
+        boost::system::error_code ec;
+        boost::filesystem::remove(path_, ec);
+    }
+
+    TestDatabase(const TestDatabase &) = delete;
+    TestDatabase &operator=(const TestDatabase &) = delete;
+
+    void create_schema(const std::string &name)
+    {
+        odb::transaction t(db_->begin());
+        odb::schema_catalog::create_schema(*db_, name);
+        t.commit();
+    }
+
+    DBPtr db() const
+    {
+        return db_;
+    }
+
+    DBServicePtr dbsrv() const
+    {
+        return dbsrv_;
+    }
+
+  private:
+    std::string path_;
+    DBPtr db_;
+    DBServicePtr dbsrv_;
+};
+}
+}
+}